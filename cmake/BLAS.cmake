@@ -0,0 +1,110 @@
+#
+# Copyright 2018 The StatsLabs Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Select the BLAS/LAPACK backend
+#
+#   MKL     : Intel(R) MKL (see MKL.cmake)
+#   CBLAS   : any CBLAS + LAPACKE implementation, e.g. OpenBLAS or BLIS
+#   BUILTIN : the portable kernels shipped in include/slab/matrix
+#   AUTO    : the first of MKL, CBLAS and BUILTIN that is found
+#
+# Sets MATRIX_BLAS_DEFINITIONS, MATRIX_BLAS_INCLUDE_DIRS and BLAS_LINKER_LIBS,
+# to be set on the targets rather than on the directory, so that they are
+# exported with the targets.
+#===============================================================================
+
+if(BLAS_cmake_included)
+    return()
+endif()
+set(BLAS_cmake_included true)
+
+set(MATRIX_BLAS_BACKEND "AUTO" CACHE STRING
+    "BLAS/LAPACK backend: AUTO, MKL, CBLAS or BUILTIN")
+set_property(CACHE MATRIX_BLAS_BACKEND PROPERTY STRINGS AUTO MKL CBLAS BUILTIN)
+
+set(MATRIX_BLAS_DEFINITIONS)
+set(MATRIX_BLAS_INCLUDE_DIRS)
+set(BLAS_LINKER_LIBS)
+
+function(detect_cblas)
+    find_path(CBLASINC cblas.h PATH_SUFFIXES openblas blis)
+    find_path(LAPACKEINC lapacke.h PATH_SUFFIXES openblas)
+    find_library(CBLASLIB NAMES openblas blis cblas blas)
+    if(NOT CBLASINC OR NOT LAPACKEINC OR NOT CBLASLIB)
+        return()
+    endif()
+
+    # OpenBLAS bundles LAPACKE, other implementations need it separately
+    set(__libs ${CBLASLIB})
+    include(CheckSymbolExists)
+    set(CMAKE_REQUIRED_LIBRARIES ${CBLASLIB})
+    check_symbol_exists(LAPACKE_dgetrf "" CBLAS_HAS_LAPACKE)
+    unset(CMAKE_REQUIRED_LIBRARIES)
+    if(NOT CBLAS_HAS_LAPACKE)
+        find_library(LAPACKELIB lapacke)
+        find_library(LAPACKLIB lapack)
+        if(NOT LAPACKELIB OR NOT LAPACKLIB)
+            return()
+        endif()
+        list(APPEND __libs ${LAPACKELIB} ${LAPACKLIB})
+    endif()
+
+    set(HAVE_CBLAS TRUE PARENT_SCOPE)
+    set(CBLAS_INCLUDE_DIRS ${CBLASINC} ${LAPACKEINC} PARENT_SCOPE)
+    set(CBLAS_LIBS ${__libs} PARENT_SCOPE)
+endfunction()
+
+string(TOUPPER "${MATRIX_BLAS_BACKEND}" __backend)
+
+if(__backend STREQUAL "MKL" OR __backend STREQUAL "AUTO")
+    if(__backend STREQUAL "MKL")
+        set(FAIL_WITHOUT_MKL ON)
+    endif()
+    include("cmake/MKL.cmake")
+    if(HAVE_MKL)
+        set(__backend "MKL")
+        list(APPEND MATRIX_BLAS_DEFINITIONS USE_MKL USE_CBLAS)
+        list(APPEND BLAS_LINKER_LIBS ${MKL_LINKER_LIBS})
+    endif()
+endif()
+
+if(__backend STREQUAL "CBLAS" OR __backend STREQUAL "AUTO")
+    detect_cblas()
+    if(HAVE_CBLAS)
+        set(__backend "CBLAS")
+        list(APPEND MATRIX_BLAS_DEFINITIONS USE_CBLAS)
+        list(APPEND BLAS_LINKER_LIBS ${CBLAS_LIBS})
+        list(APPEND MATRIX_BLAS_INCLUDE_DIRS ${CBLAS_INCLUDE_DIRS})
+        message(STATUS "CBLAS/LAPACKE: include ${CBLAS_INCLUDE_DIRS}")
+        message(STATUS "CBLAS/LAPACKE: libs ${CBLAS_LIBS}")
+    elseif(__backend STREQUAL "CBLAS")
+        message(FATAL_ERROR "MATRIX_BLAS_BACKEND=CBLAS, but no CBLAS and "
+            "LAPACKE headers and libraries were found")
+    endif()
+endif()
+
+if(__backend STREQUAL "AUTO")
+    set(__backend "BUILTIN")
+endif()
+
+if(__backend STREQUAL "BUILTIN")
+    message(STATUS "BLAS backend: built-in portable kernels")
+elseif(NOT __backend STREQUAL "MKL" AND NOT __backend STREQUAL "CBLAS")
+    message(FATAL_ERROR "Unknown MATRIX_BLAS_BACKEND: ${MATRIX_BLAS_BACKEND}")
+else()
+    message(STATUS "BLAS backend: ${__backend}")
+endif()
+set(MATRIX_BLAS_BACKEND_SELECTED ${__backend})
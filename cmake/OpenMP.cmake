@@ -22,7 +22,7 @@ if(OpenMP_cmake_included)
 endif()
 set(OpenMP_cmake_included true)
 
-include("cmake/MKL.cmake")
+include("cmake/BLAS.cmake")
 
 if(WIN32 AND ${CMAKE_CXX_COMPILER_ID} STREQUAL MSVC)
     add_definitions(/Qpar)
@@ -0,0 +1,33 @@
+//
+// Measures the GEMM thresholds of this machine and saves them to the profile
+// read by matmul(): $SLAB_GEMM_PROFILE, or $HOME/.slab_gemm_profile.
+//
+// usage: gemm_tune [max_size [profile]]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "slab/matrix.h"
+
+int main(int argc, char **argv) {
+  const std::size_t max_size = argc > 1 ? std::atoi(argv[1]) : 512;
+  const std::string path = argc > 2 ? argv[2] : slab::gemm_profile_path();
+
+  const slab::GemmProfile profile = slab::gemm_tune(path, max_size);
+
+  printf(" threads: %d\n", profile.threads);
+  printf(" %-8s %14s %16s %16s\n", "type", "small_max",
+         "sequential_max", "work_per_thread");
+  printf(" %-8s %14.0f %16.0f %16.0f\n", "float",
+         profile.single_precision.small_max,
+         profile.single_precision.sequential_max,
+         profile.single_precision.work_per_thread);
+  printf(" %-8s %14.0f %16.0f %16.0f\n", "double",
+         profile.double_precision.small_max,
+         profile.double_precision.sequential_max,
+         profile.double_precision.work_per_thread);
+  printf(" saved to %s\n", path.c_str());
+
+  return 0;
+}
@@ -22,20 +22,40 @@
 
 #include <cassert>
 #include <cstddef> // std::size_t
+#include <cmath>
 #include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <complex>
+#include <fstream>
 #include <initializer_list>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric> // std::inner_product
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits> // std::enable_if/is_convertible
+#include <utility>
 #include <vector>
 
-#include "mkl.h"
-// #include "slab/matrix/config.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "slab/matrix/config.h"
 
 namespace slab {
 
@@ -49,13 +69,37 @@ template<typename T, std::size_t N>
 using MatrixInitializer = typename matrix_impl::MatrixInit<T, N>::type;
 
 #include "slab/matrix/matrix_slice.h"
+#include "slab/matrix/broadcast.h"
 #include "slab/matrix/matrix_ref.h"
 #include "slab/matrix/matrix.h"
 
 #include "slab/matrix/blas_interface.h"
+#include "slab/matrix/workspace.h"
 #include "slab/matrix/lapack_interface.h"
+#include "slab/matrix/lu.h"
+#include "slab/matrix/cholesky.h"
+#include "slab/matrix/qr.h"
+#include "slab/matrix/eig_sym.h"
+#include "slab/matrix/svd.h"
+#include "slab/matrix/packed_matrix.h"
+#include "slab/matrix/solve.h"
+#include "slab/matrix/band_matrix.h"
+#include "slab/matrix/gemm_kernel.h"
+#include "slab/matrix/gemm_dispatch.h"
+#include "slab/matrix/sparse_matrix.h"
+#include "slab/matrix/krylov.h"
 
 #include "slab/matrix/matrix_ops.h"
+#include "slab/matrix/reduction.h"
+#include "slab/matrix/covariance.h"
+#include "slab/matrix/running_stats.h"
+#include "slab/matrix/random.h"
+#include "slab/matrix/elementwise.h"
+#include "slab/matrix/sort.h"
+#include "slab/matrix/quantile.h"
+#include "slab/matrix/histogram.h"
+#include "slab/matrix/indexing.h"
+#include "slab/matrix/mask.h"
 
 #include "slab/matrix/type_alias.h"
  
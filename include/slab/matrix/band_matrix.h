@@ -0,0 +1,368 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file band_matrix.h
+/// @brief Band matrices, their products and solvers
+///
+/// A band matrix with kl sub-diagonals and ku super-diagonals is stored in
+/// the LAPACK band format: (kl + ku + 1) x n elements, column by column, so
+/// that memory and the cost of a solve grow linearly with n. Products run
+/// gbmv, general systems gbtrf/gbtrs (BandLU) and symmetric positive
+/// definite ones pbtrf/pbtrs (BandCholesky).
+
+#ifndef SLAB_MATRIX_BAND_MATRIX_H_
+#define SLAB_MATRIX_BAND_MATRIX_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/lapack_interface.h"
+#include "slab/matrix/solve.h"
+
+/// @addtogroup band_matrix BAND MATRICES
+/// @{
+
+/// @brief A square band matrix in LAPACK band storage
+///
+/// A(i, j) is stored at data()[ku + i - j + j * ldab()] for
+/// max(0, j - ku) <= i <= min(n - 1, j + kl).
+template<typename T>
+class BandMatrix {
+ public:
+  using value_type = T;
+
+  BandMatrix() = default;
+  BandMatrix(BandMatrix &&) = default;
+  BandMatrix &operator=(BandMatrix &&) = default;
+  BandMatrix(BandMatrix const &) = default;
+  BandMatrix &operator=(BandMatrix const &) = default;
+  ~BandMatrix() = default;
+
+  /// @brief An n x n band matrix of zeros, with kl sub-diagonals and ku
+  /// super-diagonals
+  BandMatrix(std::size_t n, std::size_t kl, std::size_t ku)
+      : elems_(n * (kl + ku + 1)), n_(n), kl_(kl), ku_(ku) {}
+
+  /// @brief The band of a square matrix; the elements outside are ignored
+  BandMatrix(const Matrix<T, 2> &a, std::size_t kl, std::size_t ku);
+
+  std::size_t n() const { return n_; }
+  std::size_t n_rows() const { return n_; }
+  std::size_t n_cols() const { return n_; }
+  /// @brief The number of sub-diagonals
+  std::size_t kl() const { return kl_; }
+  /// @brief The number of super-diagonals
+  std::size_t ku() const { return ku_; }
+  /// @brief The leading dimension of the band storage, kl + ku + 1
+  std::size_t ldab() const { return kl_ + ku_ + 1; }
+  /// @brief The number of stored elements
+  std::size_t size() const { return elems_.size(); }
+
+  /// @brief True if (i, j) is within the band
+  bool in_band(std::size_t i, std::size_t j) const {
+    return i <= j + kl_ && j <= i + ku_;
+  }
+
+  /// @brief The element (i, j), within the band
+  T &operator()(std::size_t i, std::size_t j) {
+    assert(i < n_ && j < n_ && in_band(i, j));
+    return elems_[ku_ + i - j + j * ldab()];
+  }
+  /// @brief The element (i, j), zero outside of the band
+  T operator()(std::size_t i, std::size_t j) const {
+    assert(i < n_ && j < n_);
+    return in_band(i, j) ? elems_[ku_ + i - j + j * ldab()] : T(0);
+  }
+
+  T *data() { return elems_.data(); }
+  const T *data() const { return elems_.data(); }
+
+  /// @brief The dense matrix, with zeros outside of the band
+  Matrix<T, 2> dense() const;
+
+ private:
+  std::vector<T> elems_;
+  std::size_t n_ = 0;
+  std::size_t kl_ = 0;
+  std::size_t ku_ = 0;
+};
+
+template<typename T>
+BandMatrix<T>::BandMatrix(const Matrix<T, 2> &a, std::size_t kl,
+                          std::size_t ku)
+    : BandMatrix(a.n_rows(), kl, ku) {
+  assert(a.n_rows() == a.n_cols());
+  for (std::size_t j = 0; j != n_; ++j) {
+    const std::size_t i0 = (j > ku_) ? j - ku_ : 0;
+    const std::size_t i1 = std::min(n_, j + kl_ + 1);
+    for (std::size_t i = i0; i != i1; ++i) (*this)(i, j) = a(i, j);
+  }
+}
+
+template<typename T>
+Matrix<T, 2> BandMatrix<T>::dense() const {
+  Matrix<T, 2> a(n_, n_);
+  for (std::size_t j = 0; j != n_; ++j) {
+    const std::size_t i0 = (j > ku_) ? j - ku_ : 0;
+    const std::size_t i1 = std::min(n_, j + kl_ + 1);
+    for (std::size_t i = i0; i != i1; ++i) a(i, j) = (*this)(i, j);
+  }
+  return a;
+}
+
+/// @brief y := alpha * op(A) * x + beta * y, with A a band matrix (gbmv)
+template<typename T>
+void blas_gbmv(const T &alpha, const BandMatrix<T> &a, const Matrix<T, 1> &x,
+               const T &beta, Matrix<T, 1> &y,
+               blas_trans trans = blas_trans::no_trans) {
+  assert(a.n() == x.size());
+  assert(a.n() == y.size());
+  if (a.n() == 0) return;
+  blas_impl::gbmv(CblasColMajor, static_cast<CBLAS_TRANSPOSE>(trans), a.n(),
+                  a.n(), a.kl(), a.ku(), alpha, a.data(), a.ldab(), x.data(),
+                  1, beta, y.data(), 1);
+}
+
+/// @brief The product of a band matrix and a vector
+template<typename T>
+Matrix<T, 1> matmul(const BandMatrix<T> &a, const Matrix<T, 1> &x) {
+  Matrix<T, 1> y(a.n());
+  blas_gbmv(T(1), a, x, T(0), y);
+  return y;
+}
+
+namespace matrix_impl {
+
+// Runs solve(b, ldb) on the row-major n x nrhs right-hand sides b, which
+// LAPACK takes as a column-major array
+template<typename T, typename F>
+int solve_col_major(int n, int nrhs, T *b, F solve) {
+  if (nrhs == 1) return solve(b, n);
+
+  WorkspaceScope scope;
+  T *bt = scope.get<T>(std::size_t(n) * nrhs);
+  transpose_copy(n, nrhs, b, bt);
+  const int info = solve(bt, n);
+  transpose_copy(nrhs, n, bt, b);
+  return info;
+}
+
+} // namespace matrix_impl
+
+/// @brief The LU factorization with partial pivoting of a band matrix
+/// (gbtrf), reusable for any number of solves
+///
+/// The factors take (2 * kl + ku + 1) x n elements: U has kl + ku
+/// super-diagonals because of the row interchanges.
+template<typename T>
+class BandLU {
+ public:
+  BandLU() : n_(0), kl_(0), ku_(0), info_(0) {}
+  explicit BandLU(const BandMatrix<T> &a) { factor(a); }
+
+  /// @brief Factors a, returns info() (0 on success, i > 0 if U(i,i) is
+  /// exactly zero)
+  int factor(const BandMatrix<T> &a);
+
+  int info() const { return info_; }
+  /// @brief True if the factorization can be used to solve
+  bool ok() const { return info_ == 0; }
+  std::size_t n() const { return n_; }
+
+  /// @brief Solves op(A) * x = b
+  ///
+  /// @return 0 on success, info() if A is singular.
+  int solve(const Matrix<T, 1> &b, Matrix<T, 1> &x,
+            blas_trans trans = blas_trans::no_trans) const;
+  /// @brief Solves op(A) * X = B for all the columns of B in one call
+  int solve(const Matrix<T, 2> &b, Matrix<T, 2> &x,
+            blas_trans trans = blas_trans::no_trans) const;
+
+  /// @brief The solution of A * x = b, an empty matrix if A is singular
+  template<std::size_t N>
+  Matrix<T, N> solve(const Matrix<T, N> &b) const {
+    Matrix<T, N> x;
+    if (solve(b, x) != 0) x.clear();
+    return x;
+  }
+
+ private:
+  template<std::size_t N>
+  int solve_in_place(Matrix<T, N> &x, blas_trans trans) const;
+
+  std::vector<T> ab_;
+  std::vector<int> ipiv_;
+  int n_, kl_, ku_;
+  int info_;
+};
+
+template<typename T>
+int BandLU<T>::factor(const BandMatrix<T> &a) {
+  n_ = a.n();
+  kl_ = a.kl();
+  ku_ = a.ku();
+  const std::size_t ldab = 2 * kl_ + ku_ + 1;
+
+  // the band goes below the kl rows that receive the fill-in
+  ab_.assign(ldab * n_, T(0));
+  for (int j = 0; j < n_; ++j)
+    std::copy(a.data() + j * a.ldab(), a.data() + (j + 1) * a.ldab(),
+              ab_.data() + j * ldab + kl_);
+  ipiv_.resize(std::max(1, n_));
+
+  info_ = (n_ == 0) ? 0 : lapack_impl::gbtrf(n_, n_, kl_, ku_, ab_.data(),
+                                             ldab, ipiv_.data());
+  return info_;
+}
+
+template<typename T>
+template<std::size_t N>
+int BandLU<T>::solve_in_place(Matrix<T, N> &x, blas_trans trans) const {
+  const int nrhs = (N == 1) ? 1 : x.extent(N - 1);
+  if (n_ == 0 || nrhs == 0) return 0;
+
+  const char t = (trans == blas_trans::no_trans) ? 'N' : 'T';
+  return matrix_impl::solve_col_major(n_, nrhs, x.data(), [&](T *b, int ldb) {
+    return lapack_impl::gbtrs(t, n_, kl_, ku_, nrhs, ab_.data(),
+                              2 * kl_ + ku_ + 1, ipiv_.data(), b, ldb);
+  });
+}
+
+template<typename T>
+int BandLU<T>::solve(const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                     blas_trans trans) const {
+  assert(b.size() == n());
+  if (info_ != 0) return info_;
+  x = b;
+  return solve_in_place(x, trans);
+}
+
+template<typename T>
+int BandLU<T>::solve(const Matrix<T, 2> &b, Matrix<T, 2> &x,
+                     blas_trans trans) const {
+  assert(b.n_rows() == n());
+  if (info_ != 0) return info_;
+  x = b;
+  return solve_in_place(x, trans);
+}
+
+/// @brief The Cholesky factorization A = L * L' of a symmetric positive
+/// definite band matrix (pbtrf), reusable for any number of solves
+///
+/// Only the kd = kl() sub-diagonals of A are read.
+template<typename T>
+class BandCholesky {
+ public:
+  BandCholesky() : n_(0), kd_(0), info_(0) {}
+  explicit BandCholesky(const BandMatrix<T> &a) { factor(a); }
+
+  /// @brief Factors a, returns info() (0 on success, i > 0 if the leading
+  /// minor of order i is not positive definite)
+  int factor(const BandMatrix<T> &a);
+
+  int info() const { return info_; }
+  /// @brief True if the factorization can be used to solve
+  bool ok() const { return info_ == 0; }
+  std::size_t n() const { return n_; }
+
+  /// @brief Solves A * x = b
+  ///
+  /// @return 0 on success, info() if A is not positive definite.
+  int solve(const Matrix<T, 1> &b, Matrix<T, 1> &x) const;
+  /// @brief Solves A * X = B for all the columns of B in one call
+  int solve(const Matrix<T, 2> &b, Matrix<T, 2> &x) const;
+
+  /// @brief The solution of A * x = b, an empty matrix if A is not positive
+  /// definite
+  template<std::size_t N>
+  Matrix<T, N> solve(const Matrix<T, N> &b) const {
+    Matrix<T, N> x;
+    if (solve(b, x) != 0) x.clear();
+    return x;
+  }
+
+ private:
+  template<std::size_t N>
+  int solve_in_place(Matrix<T, N> &x) const;
+
+  std::vector<T> ab_;  // L in LAPACK lower band storage
+  int n_, kd_;
+  int info_;
+};
+
+template<typename T>
+int BandCholesky<T>::factor(const BandMatrix<T> &a) {
+  n_ = a.n();
+  kd_ = a.kl();
+  const std::size_t ldab = kd_ + 1;
+
+  // column j of the lower band starts at the diagonal, row ku() of a
+  ab_.resize(ldab * n_);
+  for (int j = 0; j < n_; ++j) {
+    const T *aj = a.data() + j * a.ldab() + a.ku();
+    std::copy(aj, aj + ldab, ab_.data() + j * ldab);
+  }
+
+  info_ = (n_ == 0) ? 0 : lapack_impl::pbtrf('L', n_, kd_, ab_.data(), ldab);
+  return info_;
+}
+
+template<typename T>
+template<std::size_t N>
+int BandCholesky<T>::solve_in_place(Matrix<T, N> &x) const {
+  const int nrhs = (N == 1) ? 1 : x.extent(N - 1);
+  if (n_ == 0 || nrhs == 0) return 0;
+
+  return matrix_impl::solve_col_major(n_, nrhs, x.data(), [&](T *b, int ldb) {
+    return lapack_impl::pbtrs('L', n_, kd_, nrhs, ab_.data(), kd_ + 1, b, ldb);
+  });
+}
+
+template<typename T>
+int BandCholesky<T>::solve(const Matrix<T, 1> &b, Matrix<T, 1> &x) const {
+  assert(b.size() == n());
+  if (info_ != 0) return info_;
+  x = b;
+  return solve_in_place(x);
+}
+
+template<typename T>
+int BandCholesky<T>::solve(const Matrix<T, 2> &b, Matrix<T, 2> &x) const {
+  assert(b.n_rows() == n());
+  if (info_ != 0) return info_;
+  x = b;
+  return solve_in_place(x);
+}
+
+/// @brief Solves the band system A * x = b (gbsv, or pbsv with
+/// solve_method::cholesky)
+///
+/// @param method lu, or cholesky for a symmetric positive definite A, whose
+///               sub-diagonals only are read; mixed_precision is solved as lu.
+/// @return 0 on success, i > 0 if A is singular, or not positive definite
+///         with solve_method::cholesky.
+template<typename T, std::size_t N>
+int solve(const BandMatrix<T> &a, const Matrix<T, N> &b, Matrix<T, N> &x,
+          solve_method method = solve_method::lu) {
+  static_assert(N == 1 || N == 2, "solve: b must be a vector or a matrix");
+
+  if (method == solve_method::cholesky)
+    return BandCholesky<T>(a).solve(b, x);
+  return BandLU<T>(a).solve(b, x);
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_BAND_MATRIX_H_
@@ -29,232 +29,339 @@ enum class blas_trans {
   conj_trans = CblasConjTrans
 };
 
+namespace blas_impl {
+
+// Overloads of the CBLAS level 1 routines on the element type, so that the
+// wrappers below pick the routine at compile time.
+
+inline float asum(int n, const float *x, int incx) {
+  return cblas_sasum(n, x, incx);
+}
+inline double asum(int n, const double *x, int incx) {
+  return cblas_dasum(n, x, incx);
+}
+inline float asum(int n, const std::complex<float> *x, int incx) {
+  return cblas_scasum(n, x, incx);
+}
+inline double asum(int n, const std::complex<double> *x, int incx) {
+  return cblas_dzasum(n, x, incx);
+}
+
+inline void axpy(int n, float a, const float *x, int incx, float *y, int incy) {
+  cblas_saxpy(n, a, x, incx, y, incy);
+}
+inline void axpy(int n, double a, const double *x, int incx, double *y, int incy) {
+  cblas_daxpy(n, a, x, incx, y, incy);
+}
+inline void axpy(int n, std::complex<float> a, const std::complex<float> *x,
+                 int incx, std::complex<float> *y, int incy) {
+  cblas_caxpy(n, &a, x, incx, y, incy);
+}
+inline void axpy(int n, std::complex<double> a, const std::complex<double> *x,
+                 int incx, std::complex<double> *y, int incy) {
+  cblas_zaxpy(n, &a, x, incx, y, incy);
+}
+
+inline void copy(int n, const float *x, int incx, float *y, int incy) {
+  cblas_scopy(n, x, incx, y, incy);
+}
+inline void copy(int n, const double *x, int incx, double *y, int incy) {
+  cblas_dcopy(n, x, incx, y, incy);
+}
+inline void copy(int n, const std::complex<float> *x, int incx,
+                 std::complex<float> *y, int incy) {
+  cblas_ccopy(n, x, incx, y, incy);
+}
+inline void copy(int n, const std::complex<double> *x, int incx,
+                 std::complex<double> *y, int incy) {
+  cblas_zcopy(n, x, incx, y, incy);
+}
+
+inline float dot(int n, const float *x, int incx, const float *y, int incy) {
+  return cblas_sdot(n, x, incx, y, incy);
+}
+inline double dot(int n, const double *x, int incx, const double *y, int incy) {
+  return cblas_ddot(n, x, incx, y, incy);
+}
+
+inline float nrm2(int n, const float *x, int incx) {
+  return cblas_snrm2(n, x, incx);
+}
+inline double nrm2(int n, const double *x, int incx) {
+  return cblas_dnrm2(n, x, incx);
+}
+inline float nrm2(int n, const std::complex<float> *x, int incx) {
+  return cblas_scnrm2(n, x, incx);
+}
+inline double nrm2(int n, const std::complex<double> *x, int incx) {
+  return cblas_dznrm2(n, x, incx);
+}
+
+inline void scal(int n, float a, float *x, int incx) {
+  cblas_sscal(n, a, x, incx);
+}
+inline void scal(int n, double a, double *x, int incx) {
+  cblas_dscal(n, a, x, incx);
+}
+inline void scal(int n, float a, std::complex<float> *x, int incx) {
+  cblas_csscal(n, a, x, incx);
+}
+inline void scal(int n, double a, std::complex<double> *x, int incx) {
+  cblas_zdscal(n, a, x, incx);
+}
+inline void scal(int n, std::complex<float> a, std::complex<float> *x, int incx) {
+  cblas_cscal(n, &a, x, incx);
+}
+inline void scal(int n, std::complex<double> a, std::complex<double> *x, int incx) {
+  cblas_zscal(n, &a, x, incx);
+}
+
+inline void swap(int n, float *x, int incx, float *y, int incy) {
+  cblas_sswap(n, x, incx, y, incy);
+}
+inline void swap(int n, double *x, int incx, double *y, int incy) {
+  cblas_dswap(n, x, incx, y, incy);
+}
+inline void swap(int n, std::complex<float> *x, int incx,
+                 std::complex<float> *y, int incy) {
+  cblas_cswap(n, x, incx, y, incy);
+}
+inline void swap(int n, std::complex<double> *x, int incx,
+                 std::complex<double> *y, int incy) {
+  cblas_zswap(n, x, incx, y, incy);
+}
+
+inline std::size_t iamax(int n, const float *x, int incx) {
+  return cblas_isamax(n, x, incx);
+}
+inline std::size_t iamax(int n, const double *x, int incx) {
+  return cblas_idamax(n, x, incx);
+}
+inline std::size_t iamax(int n, const std::complex<float> *x, int incx) {
+  return cblas_icamax(n, x, incx);
+}
+inline std::size_t iamax(int n, const std::complex<double> *x, int incx) {
+  return cblas_izamax(n, x, incx);
+}
+
+inline void gemm(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE transa,
+                 CBLAS_TRANSPOSE transb, int m, int n, int k, float alpha,
+                 const float *a, int lda, const float *b, int ldb,
+                 float beta, float *c, int ldc) {
+  cblas_sgemm(layout, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+              beta, c, ldc);
+}
+inline void gemm(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE transa,
+                 CBLAS_TRANSPOSE transb, int m, int n, int k, double alpha,
+                 const double *a, int lda, const double *b, int ldb,
+                 double beta, double *c, int ldc) {
+  cblas_dgemm(layout, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+              beta, c, ldc);
+}
+
+inline void trsm(CBLAS_LAYOUT layout, CBLAS_SIDE side, CBLAS_UPLO uplo,
+                 CBLAS_TRANSPOSE transa, CBLAS_DIAG diag, int m, int n,
+                 float alpha, const float *a, int lda, float *b, int ldb) {
+  cblas_strsm(layout, side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+}
+inline void trsm(CBLAS_LAYOUT layout, CBLAS_SIDE side, CBLAS_UPLO uplo,
+                 CBLAS_TRANSPOSE transa, CBLAS_DIAG diag, int m, int n,
+                 double alpha, const double *a, int lda, double *b, int ldb) {
+  cblas_dtrsm(layout, side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+}
+
+inline void gemv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n,
+                 float alpha, const float *a, int lda, const float *x,
+                 int incx, float beta, float *y, int incy) {
+  cblas_sgemv(layout, trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+}
+
+inline void gemv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n,
+                 double alpha, const double *a, int lda, const double *x,
+                 int incx, double beta, double *y, int incy) {
+  cblas_dgemv(layout, trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+}
+
+inline void syrk(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 int n, int k, float alpha, const float *a, int lda, float beta,
+                 float *c, int ldc) {
+  cblas_ssyrk(layout, uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+}
+
+inline void syrk(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 int n, int k, double alpha, const double *a, int lda,
+                 double beta, double *c, int ldc) {
+  cblas_dsyrk(layout, uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+}
+
+inline void gbmv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n,
+                 int kl, int ku, float alpha, const float *a, int lda,
+                 const float *x, int incx, float beta, float *y, int incy) {
+  cblas_sgbmv(layout, trans, m, n, kl, ku, alpha, a, lda, x, incx, beta, y,
+               incy);
+}
+
+inline void gbmv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n,
+                 int kl, int ku, double alpha, const double *a, int lda,
+                 const double *x, int incx, double beta, double *y, int incy) {
+  cblas_dgbmv(layout, trans, m, n, kl, ku, alpha, a, lda, x, incx, beta, y,
+               incy);
+}
+
+inline void tpmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 CBLAS_DIAG diag, int n, const float *ap, float *x, int incx) {
+  cblas_stpmv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+inline void tpsv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 CBLAS_DIAG diag, int n, const float *ap, float *x, int incx) {
+  cblas_stpsv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+inline void spmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, float alpha,
+                 const float *ap, const float *x, int incx, float beta, float *y,
+                 int incy) {
+  cblas_sspmv(layout, uplo, n, alpha, ap, x, incx, beta, y, incy);
+}
+inline void spr(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, float alpha,
+                const float *x, int incx, float *ap) {
+  cblas_sspr(layout, uplo, n, alpha, x, incx, ap);
+}
+
+inline void tpmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 CBLAS_DIAG diag, int n, const double *ap, double *x, int incx) {
+  cblas_dtpmv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+inline void tpsv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+                 CBLAS_DIAG diag, int n, const double *ap, double *x, int incx) {
+  cblas_dtpsv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+inline void spmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, double alpha,
+                 const double *ap, const double *x, int incx, double beta, double *y,
+                 int incy) {
+  cblas_dspmv(layout, uplo, n, alpha, ap, x, incx, beta, y, incy);
+}
+inline void spr(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, double alpha,
+                const double *x, int incx, double *ap) {
+  cblas_dspr(layout, uplo, n, alpha, x, incx, ap);
+}
+
+// The first element and the increment of a vector: a Matrix<T, 1>, or a
+// MatrixRef<T, 1> such as a row, a column or a strided slice of a matrix.
+template<typename M>
+auto first(M &&x) -> decltype(x.data()) {
+  return x.data() + x.descriptor().start;
+}
+
+template<typename M>
+int inc(const M &x) {
+  return static_cast<int>(x.descriptor().strides[0]);
+}
+
+// The destination of blas_copy: a Matrix is resized to fit, a MatrixRef must
+// already have the right size.
+template<typename T>
+void fit(Matrix<T, 1> &y, std::size_t n) {
+  if (y.size() != n) y = Matrix<T, 1>(n);
+}
+
+template<typename T>
+void fit(const MatrixRef<T, 1> &y, std::size_t n) {
+  assert(y.size() == n);
+}
+
+} // namespace blas_impl
+
 /// @addtogroup blas_interface BLAS INTERFACE
 /// @{
 
 /// @addtogroup blas_level1 BLAS Level 1
+///
+/// The level 1 routines take any vector: a Matrix<T, 1>, or a MatrixRef<T, 1>
+/// such as a row, a column or a strided slice of a matrix, which is used in
+/// place. The CBLAS routine is chosen at compile time from the element type:
+/// float, double, std::complex<float> or std::complex<double>.
 /// @{
 
 /// @brief Computes the sum of magnitudes of the vector elements
 /// @param x a vector.
-template<typename T>
-T blas_asum(const Matrix<T, 1> &x) {
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-
-  T res;
-  if (is_double<T>::value) {
-    res = cblas_dasum(
-        n,
-        (const double *) x.data(),
-        incx
-    );
-  } else if (is_float<T>::value) {
-    res = cblas_sasum(
-        n,
-        (const float *) x.data(),
-        incx
-    );
-  } else if (is_complex_double<T>::value) {
-    res = cblas_dzasum(
-        n,
-        (const std::complex<double> *) x.data(),
-        incx
-    );
-  } else if (is_complex_float<T>::value) {
-    res = cblas_scasum(
-        n,
-        (const std::complex<float> *) x.data(),
-        incx
-    );
-  }
-
-  return res;
+template<typename X>
+Enable_if<Vector_type<X>(),
+          decltype(std::abs(std::declval<Element_type<X>>()))>
+blas_asum(const X &x) {
+  return blas_impl::asum(x.size(), blas_impl::first(x), blas_impl::inc(x));
 }
 
 /// @brief Computes a vector-scalar product and adds the result to a vector
-template<typename T>
-void blas_axpy(const T &a, const MatrixBase<T, 1> &x, MatrixBase<T, 1> &y) {
+///
+/// y = a * x + y
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), void>
+blas_axpy(const Element_type<Y> &a, const X &x, Y &&y) {
+  static_assert(Same<Element_type<X>, Element_type<Y>>(),
+                "blas_axpy: incompatible element types");
   assert(x.size() == y.size());
 
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-  const int incy = y.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    cblas_daxpy(
-        n,
-        a,
-        (const double *) (x.data() + x.descriptor().start),
-        incx,
-        (double *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_float<T>::value) {
-    cblas_saxpy(
-        n,
-        a,
-        (const float *) (x.data() + x.descriptor().start),
-        incx,
-        (float *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_double<T>::value) {
-    cblas_zaxpy(
-        n,
-        &a,
-        (const std::complex<double> *) (x.data() + x.descriptor().start),
-        incx,
-        (std::complex<double> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_float<T>::value) {
-    cblas_caxpy(
-        n,
-        &a,
-        (const std::complex<float> *) (x.data() + x.descriptor().start),
-        incx,
-        (std::complex<float> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  }
+  blas_impl::axpy(x.size(), a, blas_impl::first(x), blas_impl::inc(x),
+                  blas_impl::first(y), blas_impl::inc(y));
 }
 
 /// @brief Copies vector to another vector
-template<typename T>
-void blas_copy(const Matrix<T, 1> &x, Matrix<T, 1> &y) {
-  y.clear();
-  y = Matrix<T, 1>(x.size());
-
-  const int incx = x.descriptor().strides[0];
-  const int incy = y.descriptor().strides[0];
-
-  if (is_double<T>::value)
-    cblas_dcopy(
-        x.size(),
-        (const double *) (x.data() + x.descriptor().start),
-        incx,
-        (double *) (y.data() + y.descriptor().start),
-        incy
-    );
-  else if (is_float<T>::value) {
-    cblas_scopy(
-        x.size(),
-        (const float *) (x.data() + x.descriptor().start),
-        incx,
-        (float *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_double<T>::value) {
-    cblas_zcopy(
-        x.size(),
-        (const std::complex<double> *) (x.data() + x.descriptor().start),
-        incx,
-        (std::complex<double> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_float<T>::value) {
-    cblas_ccopy(
-        x.size(),
-        (const std::complex<float> *) (x.data() + x.descriptor().start),
-        incx,
-        (std::complex<float> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  }
+///
+/// A Matrix<T, 1> destination is resized to the size of x.
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), void>
+blas_copy(const X &x, Y &&y) {
+  static_assert(Same<Element_type<X>, Element_type<Y>>(),
+                "blas_copy: incompatible element types");
+  blas_impl::fit(y, x.size());
+
+  blas_impl::copy(x.size(), blas_impl::first(x), blas_impl::inc(x),
+                  blas_impl::first(y), blas_impl::inc(y));
 }
 
 /// @brief Computes a vector-vector dot product
-template<typename T>
-T blas_dot(const Matrix<T, 1> &x, const Matrix<T, 1> &y) {
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), Element_type<X>>
+blas_dot(const X &x, const Y &y) {
+  static_assert(Same<Element_type<X>, Element_type<Y>>(),
+                "blas_dot: incompatible element types");
   assert(x.size() == y.size());
 
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-  const int incy = y.descriptor().strides[0];
-
-  T res = 0.0;
-  if (is_double<T>::value) {
-    res = cblas_ddot(
-        n,
-        (const double *) (x.data() + x.descriptor().start),
-        incx,
-        (const double *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_float<T>::value) {
-    res = cblas_sdot(
-        n,
-        (const float *) (x.data() + x.descriptor().start),
-        incx,
-        (const float *) (y.data() + y.descriptor().start),
-        incy
-    );
-  }
-
-  return res;
+  return blas_impl::dot(x.size(), blas_impl::first(x), blas_impl::inc(x),
+                        blas_impl::first(y), blas_impl::inc(y));
 }
 
 /// @brief Computes a vector-vector dot product with double precision
-float blas_sdsdot(const float sb, const Matrix<float, 1> &sx,
-                  const Matrix<float, 1> &sy) {
+///
+/// sb + x * y, with the products accumulated in double precision
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), float>
+blas_sdsdot(const float sb, const X &sx, const Y &sy) {
+  static_assert(Same<Element_type<X>, float>() && Same<Element_type<Y>, float>(),
+                "blas_sdsdot: single precision vectors expected");
   assert(sx.size() == sy.size());
 
-  const int n = sx.size();
-  const int incx = sx.descriptor().strides[0];
-  const int incy = sy.descriptor().strides[0];
-
-  return cblas_sdsdot(n, sb, sx.data() + sx.descriptor().start, incx,
-                      sy.data() + sy.descriptor().start, incy);
+  return cblas_sdsdot(sx.size(), sb, blas_impl::first(sx), blas_impl::inc(sx),
+                      blas_impl::first(sy), blas_impl::inc(sy));
 }
 
 /// @brief Computes a vector-vector dot product with double precision
-double blas_dsdot(const Matrix<float, 1> &sx, const Matrix<float, 1> &sy) {
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), double>
+blas_dsdot(const X &sx, const Y &sy) {
+  static_assert(Same<Element_type<X>, float>() && Same<Element_type<Y>, float>(),
+                "blas_dsdot: single precision vectors expected");
   assert(sx.size() == sy.size());
 
-  const int n = sx.size();
-  const int incx = sx.descriptor().strides[0];
-  const int incy = sy.descriptor().strides[0];
-
-  return cblas_dsdot(n, sx.data() + sx.descriptor().start, incx,
-                     sy.data() + sy.descriptor().start, incy);
+  return cblas_dsdot(sx.size(), blas_impl::first(sx), blas_impl::inc(sx),
+                     blas_impl::first(sy), blas_impl::inc(sy));
 }
 
 /// @brief Computes the Euclidean norm of a vector
-template<typename T>
-double blas_nrm2(const Matrix<T, 1> &x) {
-  double res = 0.0;
-
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    res = cblas_dnrm2(
-        n,
-        (const double *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_float<T>::value) {
-    res = cblas_snrm2(
-        n,
-        (const float *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_double<T>::value) {
-    res = cblas_dznrm2(
-        n,
-        (const std::complex<double> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_float<T>::value) {
-    res = cblas_scnrm2(
-        n,
-        (const std::complex<float> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  }
-
-  return res;
+template<typename X>
+Enable_if<Vector_type<X>(),
+          decltype(std::abs(std::declval<Element_type<X>>()))>
+blas_nrm2(const X &x) {
+  return blas_impl::nrm2(x.size(), blas_impl::first(x), blas_impl::inc(x));
 }
 
 // Computes the parameters for a Givens rotation
@@ -277,143 +384,34 @@ double blas_nrm2(const Matrix<T, 1> &x) {
 //}
 
 /// @brief Computes the product of a vector by a scalar
-template<typename T>
-void blas_scal(const T a, Matrix<T, 1> &x) {
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    cblas_dscal(
-        n,
-        (const double) a,
-        (double *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_float<T>::value) {
-    cblas_sscal(
-        n,
-        (const float) a,
-        (float *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_double<T>::value) {
-    cblas_zdscal(
-        n,
-        (const double) a,
-        (std::complex<double> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_float<T>::value) {
-    cblas_csscal(
-        n,
-        (const float) a,
-        (std::complex<float> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  }
-}
-
-template<typename T>
-void blas_scal(const std::complex<T> &a, Matrix<std::complex<T>, 1> &x) {
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    cblas_zscal(
-        n,
-        (const std::complex<double> *) &a,
-        (std::complex<double> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_float<T>::value) {
-    cblas_cscal(
-        n,
-        (const std::complex<float> *) &a,
-        (std::complex<float> *) (x.data() + x.descriptor().start),
-        incx);
-  }
+///
+/// A complex vector can be scaled by a real or a complex scalar.
+template<typename S, typename X>
+Enable_if<Vector_type<X>(), void>
+blas_scal(const S a, X &&x) {
+  blas_impl::scal(x.size(), a, blas_impl::first(x), blas_impl::inc(x));
 }
 
 /// @brief Swaps a vector with another vector.
 ///
 /// @param x a vector.
 /// @param y another vector.
-template<typename T>
-void blas_swap(Matrix<T, 1> &x, Matrix<T, 1> &y) {
+template<typename X, typename Y>
+Enable_if<Vector_type<X>() && Vector_type<Y>(), void>
+blas_swap(X &&x, Y &&y) {
+  static_assert(Same<Element_type<X>, Element_type<Y>>(),
+                "blas_swap: incompatible element types");
   assert(x.size() == y.size());
 
-  const int n = x.size();
-  const int incx = x.descriptor().strides[0];
-  const int incy = y.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    cblas_dswap(
-        n,
-        (double *) (x.data() + x.descriptor().start),
-        incx,
-        (double *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_float<T>::value) {
-    cblas_sswap(
-        n,
-        (float *) (x.data() + x.descriptor().start),
-        incx,
-		(float *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_double<T>::value) {
-    cblas_zswap(
-        n,
-        (std::complex<double> *) (x.data() + x.descriptor().start),
-		incx,
-        (std::complex<double> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  } else if (is_complex_float<T>::value) {
-    cblas_cswap(
-        n,
-        (std::complex<float> *) (x.data() + x.descriptor().start),
-        incx,
-        (std::complex<float> *) (y.data() + y.descriptor().start),
-        incy
-    );
-  }
+  blas_impl::swap(x.size(), blas_impl::first(x), blas_impl::inc(x),
+                  blas_impl::first(y), blas_impl::inc(y));
 }
 
 /// @brief Finds the index of the element with maximum absolute value
-template<typename T>
-std::size_t blas_iamax(const Matrix<T, 1> &x) {
-  std::size_t res = 0;
-  std::size_t incx = x.descriptor().strides[0];
-
-  if (is_double<T>::value) {
-    res = cblas_idamax(
-        x.size(),
-        (const double *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_float<T>::value) {
-    res = cblas_isamax(
-        x.size(),
-        (const float *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_double<T>::value) {
-    res = cblas_izamax(
-        x.size(),
-        (const std::complex<double> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  } else if (is_complex_float<T>::value) {
-    res = cblas_icamax(
-        x.size(),
-        (const std::complex<float> *) (x.data() + x.descriptor().start),
-        incx
-    );
-  }
-
-  return res;
+template<typename X>
+Enable_if<Vector_type<X>(), std::size_t>
+blas_iamax(const X &x) {
+  return blas_impl::iamax(x.size(), blas_impl::first(x), blas_impl::inc(x));
 }
 /// @}
 
@@ -0,0 +1,177 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file broadcast.h
+/// @brief Broadcasting of element-wise operations, as in NumPy
+///
+/// The extents of two operands are aligned on their last axes. Along each
+/// axis they must be equal or one of them 1, and the missing leading axes of
+/// the operand of lower order count as 1. An operand is repeated along its
+/// axes of extent 1 by reading it with a stride of 0 there, so that the
+/// expanded operand is never stored: e.g. a vector is added to every row of
+/// a matrix in the same pass over the matrix.
+
+#ifndef SLAB_MATRIX_BROADCAST_H_
+#define SLAB_MATRIX_BROADCAST_H_
+
+namespace matrix_impl {
+
+// The extents of the broadcast of a and b, of order N >= K, L
+template<std::size_t N, std::size_t K, std::size_t L>
+std::array<std::size_t, N> broadcast_extents(const MatrixSlice<K> &a,
+                                             const MatrixSlice<L> &b) {
+  static_assert(K <= N && L <= N, "broadcast_extents: order too small");
+  std::array<std::size_t, N> exts;
+  for (std::size_t k = 0; k != N; ++k) {
+    const std::size_t ea = k < K ? a.extents[K - 1 - k] : 1;
+    const std::size_t eb = k < L ? b.extents[L - 1 - k] : 1;
+    assert(ea == eb || ea == 1 || eb == 1);  // incompatible extents
+    exts[N - 1 - k] = ea == 1 ? eb : ea;
+  }
+  return exts;
+}
+
+// The strides with which the elements of d are read over the extents exts:
+// those of d along its axes of the same extent, and 0 along its axes of
+// extent 1 and the missing leading axes
+template<std::size_t N, std::size_t K>
+std::array<std::size_t, N> broadcast_strides(
+    const std::array<std::size_t, N> &exts, const MatrixSlice<K> &d) {
+  static_assert(K <= N, "broadcast_strides: the operand has a higher order");
+  std::array<std::size_t, N> strides;
+  strides.fill(0);
+  for (std::size_t k = 0; k != K; ++k) {
+    const std::size_t e = d.extents[K - 1 - k];
+    assert(e == exts[N - 1 - k] || e == 1);  // the operand does not broadcast
+    if (e != 1) strides[N - 1 - k] = d.strides[K - 1 - k];
+  }
+  return strides;
+}
+
+// f(z, x, y) for the elements z, x, y of three operands over the extents
+// exts, read with the strides zs, xs and ys, which may be 0. If parallel,
+// the lines along the last axis of large operands are distributed over the
+// threads, so f must then not depend on the order of the calls. Unit-stride
+// loops handle the common cases of operands read contiguously or repeated.
+template<std::size_t N, typename Z, typename X, typename Y, typename F>
+void broadcast_apply(const std::array<std::size_t, N> &exts,
+                     Z *z, const std::array<std::size_t, N> &zs,
+                     const X *x, const std::array<std::size_t, N> &xs,
+                     const Y *y, const std::array<std::size_t, N> &ys,
+                     bool parallel, F f) {
+  static_assert(N > 0, "broadcast_apply: no axis");
+  const std::size_t len = exts[N - 1];
+  std::size_t lines = 1;
+  for (std::size_t k = 0; k + 1 < N; ++k) lines *= exts[k];
+  if (len == 0 || lines == 0) return;
+  const std::size_t z1 = zs[N - 1], x1 = xs[N - 1], y1 = ys[N - 1];
+  const std::ptrdiff_t nl = lines;
+#pragma omp parallel for schedule(static) \
+    if(parallel && lines > 1 && lines * len > 65536)
+  for (std::ptrdiff_t l = 0; l < nl; ++l) {
+    std::size_t r = l, zo = 0, xo = 0, yo = 0;
+    for (std::size_t k = N - 1; k-- > 0;) {
+      const std::size_t i = r % exts[k];
+      r /= exts[k];
+      zo += i * zs[k];
+      xo += i * xs[k];
+      yo += i * ys[k];
+    }
+    Z *zl = z + zo;
+    const X *xl = x + xo;
+    const Y *yl = y + yo;
+    if (z1 == 1 && x1 == 1 && y1 == 1) {
+      for (std::size_t i = 0; i != len; ++i) f(zl[i], xl[i], yl[i]);
+    } else if (z1 == 1 && x1 == 1 && y1 == 0) {
+      const Y v = *yl;
+      for (std::size_t i = 0; i != len; ++i) f(zl[i], xl[i], v);
+    } else if (z1 == 1 && x1 == 0 && y1 == 1) {
+      const X v = *xl;
+      for (std::size_t i = 0; i != len; ++i) f(zl[i], v, yl[i]);
+    } else {
+      for (std::size_t i = 0; i != len; ++i)
+        f(zl[i * z1], xl[i * x1], yl[i * y1]);
+    }
+  }
+}
+
+// The Matrix of order N of f(a, b) for the elements of a and b broadcast
+// together, in one pass
+template<typename T, std::size_t N, typename A, typename B, typename F>
+Matrix<T, N> broadcast_binary(const A &a, const B &b, F f) {
+  const std::array<std::size_t, N> exts =
+      broadcast_extents<N>(a.descriptor(), b.descriptor());
+  Matrix<T, N> res(exts);
+  broadcast_apply(exts, res.data(), res.descriptor().strides,
+                  a.data() + a.descriptor().start,
+                  broadcast_strides(exts, a.descriptor()),
+                  b.data() + b.descriptor().start,
+                  broadcast_strides(exts, b.descriptor()), true,
+                  [&](T &r, const Value_type<A> &x, const Value_type<B> &y) {
+                    r = f(x, y);
+                  });
+  return res;
+}
+
+// The offset of the last element of d from its first, which is at start
+template<std::size_t N>
+std::size_t last_offset(const MatrixSlice<N> &d) {
+  std::size_t off = 0;
+  for (std::size_t k = 0; k != N; ++k) off += (d.extents[k] - 1) * d.strides[k];
+  return off;
+}
+
+// Whether the elements of a matrix of descriptor a at p and those of a
+// matrix of descriptor b at q lie in overlapping ranges of memory
+template<typename P, std::size_t K, typename Q, std::size_t L>
+bool may_overlap(const P *p, const MatrixSlice<K> &a, const Q *q,
+                 const MatrixSlice<L> &b) {
+  if (a.size == 0 || b.size == 0) return false;
+  const P *pa = p + a.start;
+  const Q *qb = q + b.start;
+  const char *a0 = reinterpret_cast<const char *>(pa);
+  const char *a1 = reinterpret_cast<const char *>(pa + last_offset(a) + 1);
+  const char *b0 = reinterpret_cast<const char *>(qb);
+  const char *b1 = reinterpret_cast<const char *>(qb + last_offset(b) + 1);
+  std::less<const char *> less;
+  return less(a0, b1) && less(b0, a1);
+}
+
+// f(z, b) for the elements z of the matrix of descriptor d at z and the
+// elements b of m broadcast to its extents, in parallel if parallel. An m
+// that shares memory with the elements of z, other than each element with
+// itself, is copied first, so that f sees the values of m before the call.
+template<typename T, std::size_t N, typename M, typename F>
+void broadcast_update(T *z, const MatrixSlice<N> &d, const M &m,
+                      bool parallel, F f) {
+  const MatrixSlice<M::order_> &md = m.descriptor();
+  const std::array<std::size_t, N> ms = broadcast_strides(d.extents, md);
+  const Value_type<M> *y = m.data() + md.start;
+  if (may_overlap(z, d, m.data(), md) &&
+      !(static_cast<const void *>(z + d.start) ==
+            static_cast<const void *>(y) && ms == d.strides)) {
+    const Matrix<Element_type<M>, M::order_> copy(m);
+    broadcast_update(z, d, copy, parallel, f);
+    return;
+  }
+  broadcast_apply(d.extents, z + d.start, d.strides, z + d.start, d.strides,
+                  y, ms, parallel,
+                  [&](T &a, const T &, const Value_type<M> &b) { f(a, b); });
+}
+
+} // namespace matrix_impl
+
+#endif // SLAB_MATRIX_BROADCAST_H_
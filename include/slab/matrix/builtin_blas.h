@@ -0,0 +1,777 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file builtin_blas.h
+/// @brief Portable implementation of the CBLAS routines used by the library
+///
+/// This header is only included when no BLAS library was selected at
+/// configure time (see config.h). It provides the subset of the CBLAS API
+/// that the wrappers call, with the same names and argument conventions, so
+/// the rest of the library is unaware of which backend it runs on.
+
+#ifndef SLAB_MATRIX_BUILTIN_BLAS_H_
+#define SLAB_MATRIX_BUILTIN_BLAS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum CBLAS_LAYOUT { CblasRowMajor = 101, CblasColMajor = 102 };
+enum CBLAS_TRANSPOSE { CblasNoTrans = 111, CblasTrans = 112, CblasConjTrans = 113 };
+enum CBLAS_UPLO { CblasUpper = 121, CblasLower = 122 };
+enum CBLAS_DIAG { CblasNonUnit = 131, CblasUnit = 132 };
+enum CBLAS_SIDE { CblasLeft = 141, CblasRight = 142 };
+
+typedef enum CBLAS_LAYOUT CBLAS_ORDER;
+typedef std::size_t CBLAS_INDEX;
+
+namespace slab {
+namespace builtin {
+
+// number of threads the level 3 kernels may use, 0 means "all available"
+inline int &num_threads() {
+  static thread_local int n = 0;
+  return n;
+}
+
+inline int team_size() {
+#ifdef _OPENMP
+  return num_threads() > 0 ? num_threads() : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// offset of the first element of a BLAS vector with a possibly negative
+// increment
+inline std::ptrdiff_t first(int n, int inc) {
+  return inc < 0 ? std::ptrdiff_t(1 - n) * inc : 0;
+}
+
+template<typename T>
+inline T abs1(const T &x) { return std::abs(x); }
+
+template<typename T>
+inline T abs1(const std::complex<T> &x) {
+  return std::abs(x.real()) + std::abs(x.imag());
+}
+
+template<typename T, typename R>
+R asum(int n, const T *x, int incx) {
+  R res = 0;
+  x += first(n, incx);
+  for (int i = 0; i < n; ++i, x += incx) res += abs1(*x);
+  return res;
+}
+
+template<typename T>
+void axpy(int n, T a, const T *x, int incx, T *y, int incy) {
+  x += first(n, incx);
+  y += first(n, incy);
+  for (int i = 0; i < n; ++i, x += incx, y += incy) *y += a * *x;
+}
+
+template<typename T>
+void copy(int n, const T *x, int incx, T *y, int incy) {
+  x += first(n, incx);
+  y += first(n, incy);
+  for (int i = 0; i < n; ++i, x += incx, y += incy) *y = *x;
+}
+
+template<typename T, typename R>
+R dot(int n, const T *x, int incx, const T *y, int incy) {
+  R res = 0;
+  x += first(n, incx);
+  y += first(n, incy);
+  for (int i = 0; i < n; ++i, x += incx, y += incy) res += R(*x) * R(*y);
+  return res;
+}
+
+// scaled sum of squares, as in the reference xNRM2, to avoid overflow
+template<typename T, typename R>
+R nrm2(int n, const T *x, int incx) {
+  R scale = 0, ssq = 1;
+  auto update = [&](R v) {
+    if (v != 0) {
+      const R a = std::abs(v);
+      if (scale < a) {
+        ssq = 1 + ssq * (scale / a) * (scale / a);
+        scale = a;
+      } else {
+        ssq += (a / scale) * (a / scale);
+      }
+    }
+  };
+  x += first(n, incx);
+  for (int i = 0; i < n; ++i, x += incx) {
+    update(std::real(*x));
+    update(std::imag(*x));
+  }
+  return scale * std::sqrt(ssq);
+}
+
+template<typename T, typename S>
+void scal(int n, S a, T *x, int incx) {
+  if (incx <= 0) return;
+  for (int i = 0; i < n; ++i, x += incx) *x *= a;
+}
+
+template<typename T>
+void swap(int n, T *x, int incx, T *y, int incy) {
+  x += first(n, incx);
+  y += first(n, incy);
+  for (int i = 0; i < n; ++i, x += incx, y += incy) std::swap(*x, *y);
+}
+
+template<typename T>
+CBLAS_INDEX iamax(int n, const T *x, int incx) {
+  if (n < 1 || incx <= 0) return 0;
+  CBLAS_INDEX res = 0;
+  auto max = abs1(*x);
+  x += incx;
+  for (int i = 1; i < n; ++i, x += incx) {
+    if (abs1(*x) > max) {
+      max = abs1(*x);
+      res = i;
+    }
+  }
+  return res;
+}
+
+// y = alpha * op(A) * x + beta * y, A row-major m x n
+template<typename T>
+void gemv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n, T alpha,
+          const T *a, int lda, const T *x, int incx, T beta, T *y, int incy) {
+  // a column-major matrix is the transpose of a row-major one
+  bool t = (trans != CblasNoTrans);
+  if (layout == CblasColMajor) {
+    t = !t;
+    std::swap(m, n);
+  }
+
+  const int leny = t ? n : m;
+  const int lenx = t ? m : n;
+  x += first(lenx, incx);
+  y += first(leny, incy);
+
+  for (int i = 0; i < leny; ++i)
+    y[i * incy] = (beta == T(0)) ? T(0) : beta * y[i * incy];
+  if (alpha == T(0)) return;
+
+  if (!t) {
+    for (int i = 0; i < m; ++i) {
+      const T *ai = a + std::ptrdiff_t(i) * lda;
+      T s = 0;
+      for (int j = 0; j < n; ++j) s += ai[j] * x[j * incx];
+      y[i * incy] += alpha * s;
+    }
+  } else {
+    for (int i = 0; i < m; ++i) {
+      const T *ai = a + std::ptrdiff_t(i) * lda;
+      const T s = alpha * x[i * incx];
+      for (int j = 0; j < n; ++j) y[j * incy] += s * ai[j];
+    }
+  }
+}
+
+// y = alpha * op(A) * x + beta * y, A an m x n band matrix with kl sub- and
+// ku super-diagonals in BLAS band storage
+template<typename T>
+void gbmv(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int m, int n, int kl,
+          int ku, T alpha, const T *a, int lda, const T *x, int incx, T beta,
+          T *y, int incy) {
+  // the row-major band storage of A is the column-major one of A'
+  bool t = (trans != CblasNoTrans);
+  if (layout == CblasRowMajor) {
+    t = !t;
+    std::swap(m, n);
+    std::swap(kl, ku);
+  }
+
+  const int leny = t ? n : m;
+  const int lenx = t ? m : n;
+  x += first(lenx, incx);
+  y += first(leny, incy);
+
+  for (int i = 0; i < leny; ++i)
+    y[i * incy] = (beta == T(0)) ? T(0) : beta * y[i * incy];
+  if (alpha == T(0)) return;
+
+  // A(i, j) is a[ku + i - j + j * lda], column j holding rows j - ku to j + kl
+  for (int j = 0; j < n; ++j) {
+    const T *aj = a + std::ptrdiff_t(j) * lda + ku - j;
+    const int i0 = std::max(0, j - ku), i1 = std::min(m, j + kl + 1);
+    if (!t) {
+      const T s = alpha * x[j * incx];
+      for (int i = i0; i < i1; ++i) y[i * incy] += s * aj[i];
+    } else {
+      T s = T(0);
+      for (int i = i0; i < i1; ++i) s += aj[i] * x[i * incx];
+      y[j * incy] += alpha * s;
+    }
+  }
+}
+
+// The position of element (i, j) of the uplo triangle of a packed n x n
+// matrix. The column-major packing of a triangle is the row-major packing of
+// its transpose.
+inline std::size_t packed_index(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n,
+                                int i, int j) {
+  if (layout == CblasColMajor) {
+    std::swap(i, j);
+    uplo = (uplo == CblasLower) ? CblasUpper : CblasLower;
+  }
+  if (uplo == CblasLower) return std::size_t(i) * (i + 1) / 2 + j;
+  return std::size_t(i) * (2 * std::size_t(n) - i + 1) / 2 + (j - i);
+}
+
+// x := op(A) * x, with A triangular and packed
+template<typename T>
+void tpmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+          CBLAS_DIAG diag, int n, const T *ap, T *x, int incx) {
+  const bool t = (trans != CblasNoTrans);
+  const bool lower = (uplo == CblasLower) != t;
+  const bool unit = (diag == CblasUnit);
+  auto a = [&](int i, int j) {
+    return t ? ap[packed_index(layout, uplo, n, j, i)]
+             : ap[packed_index(layout, uplo, n, i, j)];
+  };
+  x += first(n, incx);
+
+  // x(i) only depends on the elements of x that are yet to be overwritten
+  for (int r = 0; r < n; ++r) {
+    const int i = lower ? n - 1 - r : r;
+    const int j0 = lower ? 0 : i + 1, j1 = lower ? i : n;
+    T s = unit ? x[i * incx] : a(i, i) * x[i * incx];
+    for (int j = j0; j < j1; ++j) s += a(i, j) * x[j * incx];
+    x[i * incx] = s;
+  }
+}
+
+// Solves op(A) * x = b in place, with A triangular and packed
+template<typename T>
+void tpsv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans,
+          CBLAS_DIAG diag, int n, const T *ap, T *x, int incx) {
+  const bool t = (trans != CblasNoTrans);
+  const bool lower = (uplo == CblasLower) != t;
+  const bool unit = (diag == CblasUnit);
+  auto a = [&](int i, int j) {
+    return t ? ap[packed_index(layout, uplo, n, j, i)]
+             : ap[packed_index(layout, uplo, n, i, j)];
+  };
+  x += first(n, incx);
+
+  for (int r = 0; r < n; ++r) {
+    const int i = lower ? r : n - 1 - r;
+    const int j0 = lower ? 0 : i + 1, j1 = lower ? i : n;
+    T s = x[i * incx];
+    for (int j = j0; j < j1; ++j) s -= a(i, j) * x[j * incx];
+    x[i * incx] = unit ? s : s / a(i, i);
+  }
+}
+
+// y = alpha * A * x + beta * y, with A symmetric and packed
+template<typename T>
+void spmv(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, T alpha, const T *ap,
+          const T *x, int incx, T beta, T *y, int incy) {
+  x += first(n, incx);
+  y += first(n, incy);
+
+  for (int i = 0; i < n; ++i)
+    y[i * incy] = (beta == T(0)) ? T(0) : beta * y[i * incy];
+  if (alpha == T(0)) return;
+
+  // the stored triangle of row i, and its reflection in column i
+  const bool lower = (uplo == CblasLower);
+  for (int i = 0; i < n; ++i) {
+    const int j0 = lower ? 0 : i, j1 = lower ? i + 1 : n;
+    const T xi = alpha * x[i * incx];
+    T s = T(0);
+    for (int j = j0; j < j1; ++j) {
+      const T aij = ap[packed_index(layout, uplo, n, i, j)];
+      s += aij * x[j * incx];
+      if (j != i) y[j * incy] += aij * xi;
+    }
+    y[i * incy] += alpha * s;
+  }
+}
+
+// A := alpha * x * x' + A, with A symmetric and packed
+template<typename T>
+void spr(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, int n, T alpha, const T *x,
+         int incx, T *ap) {
+  x += first(n, incx);
+  const bool lower = (uplo == CblasLower);
+  for (int i = 0; i < n; ++i) {
+    const T xi = alpha * x[i * incx];
+    if (xi == T(0)) continue;
+    const int j0 = lower ? 0 : i, j1 = lower ? i + 1 : n;
+    for (int j = j0; j < j1; ++j)
+      ap[packed_index(layout, uplo, n, i, j)] += xi * x[j * incx];
+  }
+}
+
+// C = alpha * op(A) * op(B) + beta * C, all row-major
+template<typename T>
+void gemm_row_major(bool ta, bool tb, int m, int n, int k, T alpha,
+                    const T *a, int lda, const T *b, int ldb,
+                    T beta, T *c, int ldc) {
+  const bool parallel = (double(m) * n * k > 32768.0);
+
+#pragma omp parallel for if(parallel) num_threads(team_size()) schedule(static)
+  for (int i = 0; i < m; ++i) {
+    T *ci = c + std::ptrdiff_t(i) * ldc;
+    for (int j = 0; j < n; ++j)
+      ci[j] = (beta == T(0)) ? T(0) : beta * ci[j];
+    if (alpha == T(0)) continue;
+
+    for (int p = 0; p < k; ++p) {
+      const T aip = alpha * (ta ? a[std::ptrdiff_t(p) * lda + i]
+                                : a[std::ptrdiff_t(i) * lda + p]);
+      if (aip == T(0)) continue;
+      if (!tb) {
+        const T *bp = b + std::ptrdiff_t(p) * ldb;
+        for (int j = 0; j < n; ++j) ci[j] += aip * bp[j];
+      } else {
+        const T *bp = b + p;
+        for (int j = 0; j < n; ++j) ci[j] += aip * bp[std::ptrdiff_t(j) * ldb];
+      }
+    }
+  }
+}
+
+template<typename T>
+void gemm(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb,
+          int m, int n, int k, T alpha, const T *a, int lda,
+          const T *b, int ldb, T beta, T *c, int ldc) {
+  const bool ta = (transa != CblasNoTrans);
+  const bool tb = (transb != CblasNoTrans);
+  // a column-major C = A * B is the row-major C' = B' * A'
+  if (layout == CblasColMajor)
+    gemm_row_major(tb, ta, n, m, k, alpha, b, ldb, a, lda, beta, c, ldc);
+  else
+    gemm_row_major(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+// C = alpha * A * A' + beta * C (no trans, A n x k) or alpha * A' * A +
+// beta * C (trans, A k x n) on the uplo triangle of the symmetric n x n C
+template<typename T>
+void syrk(CBLAS_LAYOUT layout, CBLAS_UPLO uplo, CBLAS_TRANSPOSE trans, int n,
+          int k, T alpha, const T *a, int lda, T beta, T *c, int ldc) {
+  // a column-major C is the row-major C with the other triangle, a
+  // column-major A the row-major A'
+  bool upper = (uplo == CblasUpper), ta = (trans != CblasNoTrans);
+  if (layout == CblasColMajor) {
+    upper = !upper;
+    ta = !ta;
+  }
+  const bool parallel = (double(n) * n * k > 65536.0);
+
+#pragma omp parallel for if(parallel) num_threads(team_size()) schedule(dynamic, 8)
+  for (int i = 0; i < n; ++i) {
+    const int j0 = upper ? i : 0, j1 = upper ? n : i + 1;
+    T *ci = c + std::ptrdiff_t(i) * ldc;
+    for (int j = j0; j < j1; ++j)
+      ci[j] = (beta == T(0)) ? T(0) : beta * ci[j];
+    if (alpha == T(0)) continue;
+
+    if (ta) {
+      // row i of A' * A: the rows of A scaled by their element i
+      for (int p = 0; p < k; ++p) {
+        const T *ap = a + std::ptrdiff_t(p) * lda;
+        const T api = alpha * ap[i];
+        if (api == T(0)) continue;
+        for (int j = j0; j < j1; ++j) ci[j] += api * ap[j];
+      }
+    } else {
+      const T *ai = a + std::ptrdiff_t(i) * lda;
+      for (int j = j0; j < j1; ++j) {
+        const T *aj = a + std::ptrdiff_t(j) * lda;
+        T s = T(0);
+        for (int p = 0; p < k; ++p) s += ai[p] * aj[p];
+        ci[j] += alpha * s;
+      }
+    }
+  }
+}
+
+// B := alpha * inv(op(A)) * B (side left) or alpha * B * inv(op(A)) (side
+// right), with A triangular
+template<typename T>
+void trsm(CBLAS_LAYOUT layout, CBLAS_SIDE side, CBLAS_UPLO uplo,
+          CBLAS_TRANSPOSE transa, CBLAS_DIAG diag, int m, int n, T alpha,
+          const T *a, int lda, T *b, int ldb) {
+  std::ptrdiff_t ars = lda, acs = 1, brs = ldb, bcs = 1;
+  if (layout == CblasColMajor) {
+    std::swap(ars, acs);
+    std::swap(brs, bcs);
+  }
+  bool lower = (uplo == CblasLower);
+  if (transa != CblasNoTrans) {
+    std::swap(ars, acs);
+    lower = !lower;
+  }
+  // X op(A) = B is op(A)' X' = B'
+  if (side == CblasRight) {
+    std::swap(ars, acs);
+    std::swap(brs, bcs);
+    std::swap(m, n);
+    lower = !lower;
+  }
+  const bool unit = (diag == CblasUnit);
+
+  auto at = [&](int i, int k) { return a[i * ars + k * acs]; };
+  auto bt = [&](int i, int j) -> T & { return b[i * brs + j * bcs]; };
+
+  for (int i = 0; i < m; ++i)
+    for (int j = 0; j < n; ++j) bt(i, j) *= alpha;
+
+  for (int r = 0; r < m; ++r) {
+    const int i = lower ? r : m - 1 - r;
+    const int k0 = lower ? 0 : i + 1, k1 = lower ? i : m;
+    for (int k = k0; k < k1; ++k) {
+      const T aik = at(i, k);
+      if (aik == T(0)) continue;
+      for (int j = 0; j < n; ++j) bt(i, j) -= aik * bt(k, j);
+    }
+    if (!unit) {
+      const T d = T(1) / at(i, i);
+      for (int j = 0; j < n; ++j) bt(i, j) *= d;
+    }
+  }
+}
+
+} // namespace builtin
+} // namespace slab
+
+// Level 1
+
+inline float cblas_sasum(const int n, const float *x, const int incx) {
+  return slab::builtin::asum<float, float>(n, x, incx);
+}
+
+inline double cblas_dasum(const int n, const double *x, const int incx) {
+  return slab::builtin::asum<double, double>(n, x, incx);
+}
+
+inline float cblas_scasum(const int n, const void *x, const int incx) {
+  return slab::builtin::asum<std::complex<float>, float>(
+      n, static_cast<const std::complex<float> *>(x), incx);
+}
+
+inline double cblas_dzasum(const int n, const void *x, const int incx) {
+  return slab::builtin::asum<std::complex<double>, double>(
+      n, static_cast<const std::complex<double> *>(x), incx);
+}
+
+inline void cblas_saxpy(const int n, const float a, const float *x,
+                        const int incx, float *y, const int incy) {
+  slab::builtin::axpy(n, a, x, incx, y, incy);
+}
+
+inline void cblas_daxpy(const int n, const double a, const double *x,
+                        const int incx, double *y, const int incy) {
+  slab::builtin::axpy(n, a, x, incx, y, incy);
+}
+
+inline void cblas_caxpy(const int n, const void *a, const void *x,
+                        const int incx, void *y, const int incy) {
+  using C = std::complex<float>;
+  slab::builtin::axpy(n, *static_cast<const C *>(a),
+                      static_cast<const C *>(x), incx,
+                      static_cast<C *>(y), incy);
+}
+
+inline void cblas_zaxpy(const int n, const void *a, const void *x,
+                        const int incx, void *y, const int incy) {
+  using C = std::complex<double>;
+  slab::builtin::axpy(n, *static_cast<const C *>(a),
+                      static_cast<const C *>(x), incx,
+                      static_cast<C *>(y), incy);
+}
+
+inline void cblas_scopy(const int n, const float *x, const int incx,
+                        float *y, const int incy) {
+  slab::builtin::copy(n, x, incx, y, incy);
+}
+
+inline void cblas_dcopy(const int n, const double *x, const int incx,
+                        double *y, const int incy) {
+  slab::builtin::copy(n, x, incx, y, incy);
+}
+
+inline void cblas_ccopy(const int n, const void *x, const int incx,
+                        void *y, const int incy) {
+  using C = std::complex<float>;
+  slab::builtin::copy(n, static_cast<const C *>(x), incx,
+                      static_cast<C *>(y), incy);
+}
+
+inline void cblas_zcopy(const int n, const void *x, const int incx,
+                        void *y, const int incy) {
+  using C = std::complex<double>;
+  slab::builtin::copy(n, static_cast<const C *>(x), incx,
+                      static_cast<C *>(y), incy);
+}
+
+inline float cblas_sdot(const int n, const float *x, const int incx,
+                        const float *y, const int incy) {
+  return slab::builtin::dot<float, float>(n, x, incx, y, incy);
+}
+
+inline double cblas_ddot(const int n, const double *x, const int incx,
+                         const double *y, const int incy) {
+  return slab::builtin::dot<double, double>(n, x, incx, y, incy);
+}
+
+inline float cblas_sdsdot(const int n, const float sb, const float *x,
+                          const int incx, const float *y, const int incy) {
+  return float(sb + slab::builtin::dot<float, double>(n, x, incx, y, incy));
+}
+
+inline double cblas_dsdot(const int n, const float *x, const int incx,
+                          const float *y, const int incy) {
+  return slab::builtin::dot<float, double>(n, x, incx, y, incy);
+}
+
+inline float cblas_snrm2(const int n, const float *x, const int incx) {
+  return slab::builtin::nrm2<float, float>(n, x, incx);
+}
+
+inline double cblas_dnrm2(const int n, const double *x, const int incx) {
+  return slab::builtin::nrm2<double, double>(n, x, incx);
+}
+
+inline float cblas_scnrm2(const int n, const void *x, const int incx) {
+  return slab::builtin::nrm2<std::complex<float>, float>(
+      n, static_cast<const std::complex<float> *>(x), incx);
+}
+
+inline double cblas_dznrm2(const int n, const void *x, const int incx) {
+  return slab::builtin::nrm2<std::complex<double>, double>(
+      n, static_cast<const std::complex<double> *>(x), incx);
+}
+
+inline void cblas_sscal(const int n, const float a, float *x, const int incx) {
+  slab::builtin::scal(n, a, x, incx);
+}
+
+inline void cblas_dscal(const int n, const double a, double *x, const int incx) {
+  slab::builtin::scal(n, a, x, incx);
+}
+
+inline void cblas_cscal(const int n, const void *a, void *x, const int incx) {
+  using C = std::complex<float>;
+  slab::builtin::scal(n, *static_cast<const C *>(a), static_cast<C *>(x), incx);
+}
+
+inline void cblas_zscal(const int n, const void *a, void *x, const int incx) {
+  using C = std::complex<double>;
+  slab::builtin::scal(n, *static_cast<const C *>(a), static_cast<C *>(x), incx);
+}
+
+inline void cblas_csscal(const int n, const float a, void *x, const int incx) {
+  slab::builtin::scal(n, a, static_cast<std::complex<float> *>(x), incx);
+}
+
+inline void cblas_zdscal(const int n, const double a, void *x, const int incx) {
+  slab::builtin::scal(n, a, static_cast<std::complex<double> *>(x), incx);
+}
+
+inline void cblas_sswap(const int n, float *x, const int incx,
+                        float *y, const int incy) {
+  slab::builtin::swap(n, x, incx, y, incy);
+}
+
+inline void cblas_dswap(const int n, double *x, const int incx,
+                        double *y, const int incy) {
+  slab::builtin::swap(n, x, incx, y, incy);
+}
+
+inline void cblas_cswap(const int n, void *x, const int incx,
+                        void *y, const int incy) {
+  using C = std::complex<float>;
+  slab::builtin::swap(n, static_cast<C *>(x), incx, static_cast<C *>(y), incy);
+}
+
+inline void cblas_zswap(const int n, void *x, const int incx,
+                        void *y, const int incy) {
+  using C = std::complex<double>;
+  slab::builtin::swap(n, static_cast<C *>(x), incx, static_cast<C *>(y), incy);
+}
+
+inline CBLAS_INDEX cblas_isamax(const int n, const float *x, const int incx) {
+  return slab::builtin::iamax(n, x, incx);
+}
+
+inline CBLAS_INDEX cblas_idamax(const int n, const double *x, const int incx) {
+  return slab::builtin::iamax(n, x, incx);
+}
+
+inline CBLAS_INDEX cblas_icamax(const int n, const void *x, const int incx) {
+  return slab::builtin::iamax(
+      n, static_cast<const std::complex<float> *>(x), incx);
+}
+
+inline CBLAS_INDEX cblas_izamax(const int n, const void *x, const int incx) {
+  return slab::builtin::iamax(
+      n, static_cast<const std::complex<double> *>(x), incx);
+}
+
+// Level 2
+
+inline void cblas_sgemv(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans,
+                        const int m, const int n, const float alpha,
+                        const float *a, const int lda, const float *x,
+                        const int incx, const float beta, float *y,
+                        const int incy) {
+  slab::builtin::gemv(layout, trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+}
+
+inline void cblas_dgemv(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans,
+                        const int m, const int n, const double alpha,
+                        const double *a, const int lda, const double *x,
+                        const int incx, const double beta, double *y,
+                        const int incy) {
+  slab::builtin::gemv(layout, trans, m, n, alpha, a, lda, x, incx, beta, y, incy);
+}
+
+inline void cblas_sgbmv(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans,
+                        const int m, const int n, const int kl, const int ku,
+                        const float alpha, const float *a, const int lda,
+                        const float *x, const int incx, const float beta,
+                        float *y, const int incy) {
+  slab::builtin::gbmv(layout, trans, m, n, kl, ku, alpha, a, lda, x, incx,
+                      beta, y, incy);
+}
+
+inline void cblas_dgbmv(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans,
+                        const int m, const int n, const int kl, const int ku,
+                        const double alpha, const double *a, const int lda,
+                        const double *x, const int incx, const double beta,
+                        double *y, const int incy) {
+  slab::builtin::gbmv(layout, trans, m, n, kl, ku, alpha, a, lda, x, incx,
+                      beta, y, incy);
+}
+
+inline void cblas_stpmv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const CBLAS_DIAG diag,
+                        const int n, const float *ap, float *x, const int incx) {
+  slab::builtin::tpmv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+
+inline void cblas_stpsv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const CBLAS_DIAG diag,
+                        const int n, const float *ap, float *x, const int incx) {
+  slab::builtin::tpsv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+
+inline void cblas_sspmv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const int n, const float alpha, const float *ap,
+                        const float *x, const int incx, const float beta,
+                        float *y, const int incy) {
+  slab::builtin::spmv(layout, uplo, n, alpha, ap, x, incx, beta, y, incy);
+}
+
+inline void cblas_sspr(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                       const int n, const float alpha, const float *x,
+                       const int incx, float *ap) {
+  slab::builtin::spr(layout, uplo, n, alpha, x, incx, ap);
+}
+
+inline void cblas_dtpmv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const CBLAS_DIAG diag,
+                        const int n, const double *ap, double *x, const int incx) {
+  slab::builtin::tpmv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+
+inline void cblas_dtpsv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const CBLAS_DIAG diag,
+                        const int n, const double *ap, double *x, const int incx) {
+  slab::builtin::tpsv(layout, uplo, trans, diag, n, ap, x, incx);
+}
+
+inline void cblas_dspmv(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const int n, const double alpha, const double *ap,
+                        const double *x, const int incx, const double beta,
+                        double *y, const int incy) {
+  slab::builtin::spmv(layout, uplo, n, alpha, ap, x, incx, beta, y, incy);
+}
+
+inline void cblas_dspr(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                       const int n, const double alpha, const double *x,
+                       const int incx, double *ap) {
+  slab::builtin::spr(layout, uplo, n, alpha, x, incx, ap);
+}
+
+// Level 3
+
+inline void cblas_sgemm(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE transa,
+                        const CBLAS_TRANSPOSE transb, const int m, const int n,
+                        const int k, const float alpha, const float *a,
+                        const int lda, const float *b, const int ldb,
+                        const float beta, float *c, const int ldc) {
+  slab::builtin::gemm(layout, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+                      beta, c, ldc);
+}
+
+inline void cblas_dgemm(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE transa,
+                        const CBLAS_TRANSPOSE transb, const int m, const int n,
+                        const int k, const double alpha, const double *a,
+                        const int lda, const double *b, const int ldb,
+                        const double beta, double *c, const int ldc) {
+  slab::builtin::gemm(layout, transa, transb, m, n, k, alpha, a, lda, b, ldb,
+                      beta, c, ldc);
+}
+
+inline void cblas_strsm(const CBLAS_LAYOUT layout, const CBLAS_SIDE side,
+                        const CBLAS_UPLO uplo, const CBLAS_TRANSPOSE transa,
+                        const CBLAS_DIAG diag, const int m, const int n,
+                        const float alpha, const float *a, const int lda,
+                        float *b, const int ldb) {
+  slab::builtin::trsm(layout, side, uplo, transa, diag, m, n, alpha, a, lda,
+                      b, ldb);
+}
+
+inline void cblas_dtrsm(const CBLAS_LAYOUT layout, const CBLAS_SIDE side,
+                        const CBLAS_UPLO uplo, const CBLAS_TRANSPOSE transa,
+                        const CBLAS_DIAG diag, const int m, const int n,
+                        const double alpha, const double *a, const int lda,
+                        double *b, const int ldb) {
+  slab::builtin::trsm(layout, side, uplo, transa, diag, m, n, alpha, a, lda,
+                      b, ldb);
+}
+
+inline void cblas_ssyrk(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const int n, const int k,
+                        const float alpha, const float *a, const int lda,
+                        const float beta, float *c, const int ldc) {
+  slab::builtin::syrk(layout, uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+}
+
+inline void cblas_dsyrk(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo,
+                        const CBLAS_TRANSPOSE trans, const int n, const int k,
+                        const double alpha, const double *a, const int lda,
+                        const double beta, double *c, const int ldc) {
+  slab::builtin::syrk(layout, uplo, trans, n, k, alpha, a, lda, beta, c, ldc);
+}
+
+#endif // SLAB_MATRIX_BUILTIN_BLAS_H_
@@ -0,0 +1,1467 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file builtin_lapack.h
+/// @brief Portable implementation of the LAPACKE routines used by the library
+///
+/// Like builtin_blas.h, this header is only used when no BLAS/LAPACK library
+/// was selected at configure time. The routines are straightforward,
+/// unblocked versions of the reference algorithms; they honour both
+/// LAPACK_ROW_MAJOR and LAPACK_COL_MAJOR through a (row stride, column
+/// stride) view of the array, so no transposed copies are made.
+
+#ifndef SLAB_MATRIX_BUILTIN_LAPACK_H_
+#define SLAB_MATRIX_BUILTIN_LAPACK_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "slab/matrix/builtin_blas.h"
+
+#define LAPACK_ROW_MAJOR 101
+#define LAPACK_COL_MAJOR 102
+
+typedef int lapack_int;
+
+namespace slab {
+namespace builtin {
+
+// A view of a LAPACK array that hides its storage layout.
+template<typename T>
+struct lapack_view {
+  lapack_view(int layout, T *p, int ld)
+      : ptr(p),
+        rs(layout == LAPACK_ROW_MAJOR ? ld : 1),
+        cs(layout == LAPACK_ROW_MAJOR ? 1 : ld) {}
+
+  T &operator()(int i, int j) const {
+    return ptr[std::ptrdiff_t(i) * rs + std::ptrdiff_t(j) * cs];
+  }
+
+  T *ptr;
+  std::ptrdiff_t rs;
+  std::ptrdiff_t cs;
+};
+
+// LU factorization with partial pivoting, ipiv is 1-based as in LAPACK
+template<typename T>
+lapack_int getrf(int layout, lapack_int m, lapack_int n, T *pa, lapack_int lda,
+                 lapack_int *ipiv) {
+  lapack_view<T> a(layout, pa, lda);
+  lapack_int info = 0;
+
+  for (lapack_int j = 0; j < std::min(m, n); ++j) {
+    lapack_int p = j;
+    for (lapack_int i = j + 1; i < m; ++i)
+      if (std::abs(a(i, j)) > std::abs(a(p, j))) p = i;
+    ipiv[j] = p + 1;
+
+    if (a(p, j) == T(0)) {
+      if (info == 0) info = j + 1;
+      continue;
+    }
+    if (p != j)
+      for (lapack_int k = 0; k < n; ++k) std::swap(a(j, k), a(p, k));
+
+    const T r = T(1) / a(j, j);
+    for (lapack_int i = j + 1; i < m; ++i) a(i, j) *= r;
+
+#pragma omp parallel for if((m - j) * (n - j) > 65536) schedule(static)
+    for (lapack_int i = j + 1; i < m; ++i) {
+      const T l = a(i, j);
+      if (l == T(0)) continue;
+      for (lapack_int k = j + 1; k < n; ++k) a(i, k) -= l * a(j, k);
+    }
+  }
+
+  return info;
+}
+
+// solves op(A) X = B with the factors computed by getrf
+template<typename T>
+lapack_int getrs(int layout, char trans, lapack_int n, lapack_int nrhs,
+                 const T *pa, lapack_int lda, const lapack_int *ipiv,
+                 T *pb, lapack_int ldb) {
+  lapack_view<const T> a(layout, pa, lda);
+  lapack_view<T> b(layout, pb, ldb);
+  const bool notrans = (trans == 'N' || trans == 'n');
+
+  for (lapack_int r = 0; r < nrhs; ++r) {
+    if (notrans) {
+      // L U x = P b
+      for (lapack_int i = 0; i < n; ++i)
+        if (ipiv[i] - 1 != i) std::swap(b(i, r), b(ipiv[i] - 1, r));
+      for (lapack_int i = 0; i < n; ++i)
+        for (lapack_int k = 0; k < i; ++k) b(i, r) -= a(i, k) * b(k, r);
+      for (lapack_int i = n - 1; i >= 0; --i) {
+        for (lapack_int k = i + 1; k < n; ++k) b(i, r) -= a(i, k) * b(k, r);
+        b(i, r) /= a(i, i);
+      }
+    } else {
+      // U' L' P x = b
+      for (lapack_int i = 0; i < n; ++i) {
+        for (lapack_int k = 0; k < i; ++k) b(i, r) -= a(k, i) * b(k, r);
+        b(i, r) /= a(i, i);
+      }
+      for (lapack_int i = n - 1; i >= 0; --i)
+        for (lapack_int k = i + 1; k < n; ++k) b(i, r) -= a(k, i) * b(k, r);
+      for (lapack_int i = n - 1; i >= 0; --i)
+        if (ipiv[i] - 1 != i) std::swap(b(i, r), b(ipiv[i] - 1, r));
+    }
+  }
+
+  return 0;
+}
+
+// inverse from the factors computed by getrf, by solving A X = I
+template<typename T>
+lapack_int getri(int layout, lapack_int n, T *pa, lapack_int lda,
+                 const lapack_int *ipiv) {
+  lapack_view<T> a(layout, pa, lda);
+  for (lapack_int i = 0; i < n; ++i)
+    if (a(i, i) == T(0)) return i + 1;
+
+  std::vector<T> px(std::size_t(n) * n, T(0));
+  lapack_view<T> x(layout, px.data(), n);
+  for (lapack_int i = 0; i < n; ++i) x(i, i) = T(1);
+  getrs(layout, 'N', n, n, pa, lda, ipiv, px.data(), n);
+
+  for (lapack_int i = 0; i < n; ++i)
+    for (lapack_int j = 0; j < n; ++j) a(i, j) = x(i, j);
+  return 0;
+}
+
+// reciprocal condition number from the factors computed by getrf, with the
+// norm of the inverse estimated by Hager's method. Row interchanges do not
+// change the norm, so only L and U are used, as in LAPACK.
+template<typename T>
+lapack_int gecon(int layout, char norm, lapack_int n, const T *pa,
+                 lapack_int lda, T anorm, T *rcond) {
+  *rcond = T(0);
+  if (n == 0) *rcond = T(1);
+  if (n == 0 || anorm == T(0)) return 0;
+
+  lapack_view<const T> a(layout, pa, lda);
+
+  // x := inv(U) inv(L) x, or its transpose
+  auto solve = [&](bool trans, T *x) {
+    if (!trans) {
+      for (lapack_int i = 0; i < n; ++i)
+        for (lapack_int k = 0; k < i; ++k) x[i] -= a(i, k) * x[k];
+      for (lapack_int i = n - 1; i >= 0; --i) {
+        for (lapack_int k = i + 1; k < n; ++k) x[i] -= a(i, k) * x[k];
+        x[i] /= a(i, i);
+      }
+    } else {
+      for (lapack_int i = 0; i < n; ++i) {
+        for (lapack_int k = 0; k < i; ++k) x[i] -= a(k, i) * x[k];
+        x[i] /= a(i, i);
+      }
+      for (lapack_int i = n - 1; i >= 0; --i)
+        for (lapack_int k = i + 1; k < n; ++k) x[i] -= a(k, i) * x[k];
+    }
+  };
+
+  // ||inv(A)||_inf = ||inv(A)'||_1
+  const bool trans = !(norm == '1' || norm == 'O' || norm == 'o');
+
+  std::vector<T> x(n, T(1) / n), z(n);
+  lapack_int last = -1;  // x = e(last), or all 1/n when negative
+  T est = T(0);
+
+  for (int iter = 0; iter < 5; ++iter) {
+    solve(trans, x.data());
+    T xnorm = T(0);
+    for (lapack_int i = 0; i < n; ++i) xnorm += std::abs(x[i]);
+    if (iter > 0 && xnorm <= est) break;
+    est = xnorm;
+
+    for (lapack_int i = 0; i < n; ++i) z[i] = x[i] < T(0) ? T(-1) : T(1);
+    solve(!trans, z.data());
+
+    lapack_int j = 0;
+    T ztx = T(0);
+    for (lapack_int i = 0; i < n; ++i) {
+      if (std::abs(z[i]) > std::abs(z[j])) j = i;
+      ztx += z[i];
+    }
+    ztx = last < 0 ? ztx / n : z[last];
+    if (std::abs(z[j]) <= ztx) break;
+
+    std::fill(x.begin(), x.end(), T(0));
+    x[j] = T(1);
+    last = j;
+  }
+
+  *rcond = (T(1) / est) / anorm;
+  return 0;
+}
+
+// Cholesky factorization A = L L' (uplo 'L') or A = U' U (uplo 'U'); only
+// the given triangle is referenced and overwritten
+template<typename T>
+lapack_int potrf(int layout, char uplo, lapack_int n, T *pa, lapack_int lda) {
+  lapack_view<T> a(layout, pa, lda);
+  // U' is lower, so U is factored through the transposed view
+  if (uplo == 'U' || uplo == 'u') std::swap(a.rs, a.cs);
+
+  for (lapack_int j = 0; j < n; ++j) {
+    T d = a(j, j);
+    for (lapack_int k = 0; k < j; ++k) d -= a(j, k) * a(j, k);
+    if (!(d > T(0))) return j + 1;
+    d = std::sqrt(d);
+    a(j, j) = d;
+
+#pragma omp parallel for if((n - j) * j > 65536) schedule(static)
+    for (lapack_int i = j + 1; i < n; ++i) {
+      T s = a(i, j);
+      for (lapack_int k = 0; k < j; ++k) s -= a(i, k) * a(j, k);
+      a(i, j) = s / d;
+    }
+  }
+
+  return 0;
+}
+
+// solves A X = B with the factor computed by potrf
+template<typename T>
+lapack_int potrs(int layout, char uplo, lapack_int n, lapack_int nrhs,
+                 const T *pa, lapack_int lda, T *pb, lapack_int ldb) {
+  lapack_view<const T> l(layout, pa, lda);
+  if (uplo == 'U' || uplo == 'u') std::swap(l.rs, l.cs);
+  lapack_view<T> b(layout, pb, ldb);
+
+  // L y = b, then L' x = y, for all right-hand sides at once
+  for (lapack_int i = 0; i < n; ++i) {
+    for (lapack_int k = 0; k < i; ++k) {
+      const T lik = l(i, k);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lik * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+  for (lapack_int i = n - 1; i >= 0; --i) {
+    for (lapack_int k = i + 1; k < n; ++k) {
+      const T lki = l(k, i);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lki * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+
+  return 0;
+}
+
+// inverse from the factor computed by potrf, in the same triangle
+template<typename T>
+lapack_int potri(int layout, char uplo, lapack_int n, T *pa, lapack_int lda) {
+  lapack_view<T> a(layout, pa, lda);
+  for (lapack_int i = 0; i < n; ++i)
+    if (a(i, i) == T(0)) return i + 1;
+
+  std::vector<T> px(std::size_t(n) * n, T(0));
+  lapack_view<T> x(layout, px.data(), n);
+  for (lapack_int i = 0; i < n; ++i) x(i, i) = T(1);
+  potrs(layout, uplo, n, n, pa, lda, px.data(), n);
+
+  const bool lower = !(uplo == 'U' || uplo == 'u');
+  for (lapack_int i = 0; i < n; ++i)
+    for (lapack_int j = 0; j < n; ++j)
+      if (lower ? j <= i : j >= i) a(i, j) = x(i, j);
+  return 0;
+}
+
+// LU factorization with partial pivoting of an m x n band matrix with kl
+// sub- and ku super-diagonals, as LAPACK's gbtf2. A(i, j) is ab(kv + i - j, j)
+// with kv = kl + ku; the first kl rows of ab receive the fill-in of U.
+template<typename T>
+lapack_int gbtrf(int layout, lapack_int m, lapack_int n, lapack_int kl,
+                 lapack_int ku, T *pab, lapack_int ldab, lapack_int *ipiv) {
+  lapack_view<T> ab(layout, pab, ldab);
+  const lapack_int kv = kl + ku;
+  lapack_int info = 0;
+
+  // the fill-in of the first columns
+  for (lapack_int j = ku + 1; j < std::min(kv, n); ++j)
+    for (lapack_int i = kv - j; i < kl; ++i) ab(i, j) = T(0);
+
+  lapack_int ju = 0;  // the last column touched by the interchanges so far
+  for (lapack_int j = 0; j < std::min(m, n); ++j) {
+    if (j + kv < n)
+      for (lapack_int i = 0; i < kl; ++i) ab(i, j + kv) = T(0);
+
+    const lapack_int km = std::min(kl, m - 1 - j);
+    lapack_int jp = 0;
+    for (lapack_int i = 1; i <= km; ++i)
+      if (std::abs(ab(kv + i, j)) > std::abs(ab(kv + jp, j))) jp = i;
+    ipiv[j] = j + jp + 1;
+
+    if (ab(kv + jp, j) == T(0)) {
+      if (info == 0) info = j + 1;
+      continue;
+    }
+
+    ju = std::max(ju, std::min(j + ku + jp, n - 1));
+    if (jp != 0)
+      for (lapack_int c = j; c <= ju; ++c)
+        std::swap(ab(kv + jp + j - c, c), ab(kv + j - c, c));
+
+    const T d = T(1) / ab(kv, j);
+    for (lapack_int i = 1; i <= km; ++i) ab(kv + i, j) *= d;
+    for (lapack_int c = j + 1; c <= ju; ++c) {
+      const T ujc = ab(kv + j - c, c);
+      if (ujc == T(0)) continue;
+      for (lapack_int i = 1; i <= km; ++i)
+        ab(kv + j + i - c, c) -= ab(kv + i, j) * ujc;
+    }
+  }
+
+  return info;
+}
+
+// solves op(A) X = B with the band factors computed by gbtrf
+template<typename T>
+lapack_int gbtrs(int layout, char trans, lapack_int n, lapack_int kl,
+                 lapack_int ku, lapack_int nrhs, const T *pab, lapack_int ldab,
+                 const lapack_int *ipiv, T *pb, lapack_int ldb) {
+  lapack_view<const T> ab(layout, pab, ldab);
+  lapack_view<T> b(layout, pb, ldb);
+  const lapack_int kv = kl + ku;
+
+  auto swap_rows = [&](lapack_int j) {
+    const lapack_int l = ipiv[j] - 1;
+    if (l != j)
+      for (lapack_int r = 0; r < nrhs; ++r) std::swap(b(l, r), b(j, r));
+  };
+
+  if (trans == 'N' || trans == 'n') {
+    // L y = P b, then U x = y
+    for (lapack_int j = 0; j < n - 1; ++j) {
+      swap_rows(j);
+      const lapack_int lm = std::min(kl, n - 1 - j);
+      for (lapack_int i = 1; i <= lm; ++i)
+        for (lapack_int r = 0; r < nrhs; ++r)
+          b(j + i, r) -= ab(kv + i, j) * b(j, r);
+    }
+    for (lapack_int i = n - 1; i >= 0; --i) {
+      for (lapack_int c = i + 1; c <= std::min(n - 1, i + kv); ++c)
+        for (lapack_int r = 0; r < nrhs; ++r)
+          b(i, r) -= ab(kv + i - c, c) * b(c, r);
+      const T d = T(1) / ab(kv, i);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+    }
+  } else {
+    // U' y = b, then L' P x = y
+    for (lapack_int i = 0; i < n; ++i) {
+      for (lapack_int k = std::max(0, i - kv); k < i; ++k)
+        for (lapack_int r = 0; r < nrhs; ++r)
+          b(i, r) -= ab(kv + k - i, i) * b(k, r);
+      const T d = T(1) / ab(kv, i);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+    }
+    for (lapack_int j = n - 2; j >= 0; --j) {
+      const lapack_int lm = std::min(kl, n - 1 - j);
+      for (lapack_int i = 1; i <= lm; ++i)
+        for (lapack_int r = 0; r < nrhs; ++r)
+          b(j, r) -= ab(kv + i, j) * b(j + i, r);
+      swap_rows(j);
+    }
+  }
+
+  return 0;
+}
+
+// The lower triangle of a symmetric band matrix with kd sub-diagonals, or the
+// transpose of its upper triangle: a(i, j) for j <= i <= j + kd
+template<typename T>
+struct band_lower {
+  band_lower(int layout, char uplo, lapack_int kd, T *p, lapack_int ldab)
+      : ab(layout, p, ldab), kd(kd), upper(uplo == 'U' || uplo == 'u') {}
+
+  T &operator()(lapack_int i, lapack_int j) const {
+    return upper ? ab(kd + j - i, i) : ab(i - j, j);
+  }
+
+  lapack_view<T> ab;
+  lapack_int kd;
+  bool upper;
+};
+
+// Cholesky factorization of a symmetric positive definite band matrix
+template<typename T>
+lapack_int pbtrf(int layout, char uplo, lapack_int n, lapack_int kd, T *pab,
+                 lapack_int ldab) {
+  band_lower<T> a(layout, uplo, kd, pab, ldab);
+
+  for (lapack_int j = 0; j < n; ++j) {
+    T d = a(j, j);
+    for (lapack_int k = std::max(0, j - kd); k < j; ++k) d -= a(j, k) * a(j, k);
+    if (!(d > T(0))) return j + 1;
+    d = std::sqrt(d);
+    a(j, j) = d;
+
+    for (lapack_int i = j + 1; i <= std::min(n - 1, j + kd); ++i) {
+      T s = a(i, j);
+      for (lapack_int k = std::max(0, i - kd); k < j; ++k)
+        s -= a(i, k) * a(j, k);
+      a(i, j) = s / d;
+    }
+  }
+
+  return 0;
+}
+
+// solves A X = B with the band factor computed by pbtrf
+template<typename T>
+lapack_int pbtrs(int layout, char uplo, lapack_int n, lapack_int kd,
+                 lapack_int nrhs, const T *pab, lapack_int ldab, T *pb,
+                 lapack_int ldb) {
+  band_lower<const T> l(layout, uplo, kd, pab, ldab);
+  lapack_view<T> b(layout, pb, ldb);
+
+  for (lapack_int i = 0; i < n; ++i) {
+    for (lapack_int k = std::max(0, i - kd); k < i; ++k) {
+      const T lik = l(i, k);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lik * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+  for (lapack_int i = n - 1; i >= 0; --i) {
+    for (lapack_int k = i + 1; k <= std::min(n - 1, i + kd); ++k) {
+      const T lki = l(k, i);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lki * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+
+  return 0;
+}
+
+// The lower triangle of a packed symmetric matrix, or the transpose of its
+// upper triangle: a(i, j) for i >= j
+template<typename T>
+struct packed_lower {
+  packed_lower(int layout, char uplo, lapack_int n, T *p)
+      : ptr(p), n(n), upper(uplo == 'U' || uplo == 'u'),
+        layout(layout == LAPACK_ROW_MAJOR ? CblasRowMajor : CblasColMajor) {}
+
+  T &operator()(lapack_int i, lapack_int j) const {
+    return upper ? ptr[packed_index(layout, CblasUpper, n, j, i)]
+                 : ptr[packed_index(layout, CblasLower, n, i, j)];
+  }
+
+  T *ptr;
+  lapack_int n;
+  bool upper;
+  CBLAS_LAYOUT layout;
+};
+
+// Cholesky factorization of a packed matrix, as potrf
+template<typename T>
+lapack_int pptrf(int layout, char uplo, lapack_int n, T *ap) {
+  packed_lower<T> a(layout, uplo, n, ap);
+
+  for (lapack_int j = 0; j < n; ++j) {
+    T d = a(j, j);
+    for (lapack_int k = 0; k < j; ++k) d -= a(j, k) * a(j, k);
+    if (!(d > T(0))) return j + 1;
+    d = std::sqrt(d);
+    a(j, j) = d;
+
+#pragma omp parallel for if((n - j) * j > 65536) schedule(static)
+    for (lapack_int i = j + 1; i < n; ++i) {
+      T s = a(i, j);
+      for (lapack_int k = 0; k < j; ++k) s -= a(i, k) * a(j, k);
+      a(i, j) = s / d;
+    }
+  }
+
+  return 0;
+}
+
+// solves A X = B with the packed factor computed by pptrf
+template<typename T>
+lapack_int pptrs(int layout, char uplo, lapack_int n, lapack_int nrhs,
+                 const T *ap, T *pb, lapack_int ldb) {
+  packed_lower<const T> l(layout, uplo, n, ap);
+  lapack_view<T> b(layout, pb, ldb);
+
+  for (lapack_int i = 0; i < n; ++i) {
+    for (lapack_int k = 0; k < i; ++k) {
+      const T lik = l(i, k);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lik * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+  for (lapack_int i = n - 1; i >= 0; --i) {
+    for (lapack_int k = i + 1; k < n; ++k) {
+      const T lki = l(k, i);
+      for (lapack_int r = 0; r < nrhs; ++r) b(i, r) -= lki * b(k, r);
+    }
+    const T d = T(1) / l(i, i);
+    for (lapack_int r = 0; r < nrhs; ++r) b(i, r) *= d;
+  }
+
+  return 0;
+}
+
+// Householder reflectors H = I - tau * v * v', with v(i) = 1 and v(l) = a(l, i)
+// for l > i, as stored by geqrf in the column i of a.
+
+// c(r0:r1, c0:c1) := H c(r0:r1, c0:c1), for the reflector in column i of a,
+// starting at row r0
+template<typename T, typename U>
+void apply_reflector_left(const lapack_view<U> &a, int i, T tau,
+                          lapack_view<T> &c, int r0, int r1, int c0, int c1) {
+  if (tau == T(0)) return;
+#pragma omp parallel for if((r1 - r0) * (c1 - c0) > 65536) schedule(static)
+  for (int j = c0; j < c1; ++j) {
+    T w = c(r0, j);
+    for (int l = r0 + 1; l < r1; ++l) w += a(l - r0 + i, i) * c(l, j);
+    w *= tau;
+    c(r0, j) -= w;
+    for (int l = r0 + 1; l < r1; ++l) c(l, j) -= w * a(l - r0 + i, i);
+  }
+}
+
+// c(r0:r1, c0:c1) := c(r0:r1, c0:c1) H, for the reflector in column i of a,
+// starting at column c0
+template<typename T, typename U>
+void apply_reflector_right(const lapack_view<U> &a, int i, T tau,
+                           lapack_view<T> &c, int r0, int r1, int c0, int c1) {
+  if (tau == T(0)) return;
+  for (int r = r0; r < r1; ++r) {
+    T w = c(r, c0);
+    for (int l = c0 + 1; l < c1; ++l) w += c(r, l) * a(l - c0 + i, i);
+    w *= tau;
+    c(r, c0) -= w;
+    for (int l = c0 + 1; l < c1; ++l) c(r, l) -= w * a(l - c0 + i, i);
+  }
+}
+
+// QR factorization A = Q R of the m x n matrix behind a view, Q = H(1)...H(k)
+template<typename T>
+void geqrf(int m, int n, lapack_view<T> a, T *tau) {
+  const int k = std::min(m, n);
+  for (int j = 0; j < k; ++j) {
+    const T alpha = a(j, j);
+    T xnorm2 = T(0);
+    for (int i = j + 1; i < m; ++i) xnorm2 += a(i, j) * a(i, j);
+
+    if (xnorm2 == T(0)) {
+      tau[j] = T(0);
+      continue;
+    }
+
+    const T norm = std::sqrt(alpha * alpha + xnorm2);
+    const T beta = alpha >= T(0) ? -norm : norm;
+    tau[j] = (beta - alpha) / beta;
+    const T scale = T(1) / (alpha - beta);
+    for (int i = j + 1; i < m; ++i) a(i, j) *= scale;
+    a(j, j) = beta;
+
+    apply_reflector_left(a, j, tau[j], a, j, m, j + 1, n);
+  }
+}
+
+// c := op(Q) c or c op(Q), for Q from geqrf; c is m x n
+template<typename T, typename U>
+void ormqr(char side, char trans, int m, int n, int k,
+           const lapack_view<U> &a, const T *tau, lapack_view<T> c) {
+  const bool left = (side == 'L' || side == 'l');
+  const bool notrans = (trans == 'N' || trans == 'n');
+  // Q' c and c Q apply H(1) first
+  const bool forward = (left != notrans);
+
+  for (int r = 0; r < k; ++r) {
+    const int i = forward ? r : k - 1 - r;
+    if (left)
+      apply_reflector_left(a, i, tau[i], c, i, m, 0, n);
+    else
+      apply_reflector_right(a, i, tau[i], c, 0, m, i, n);
+  }
+}
+
+// the first n columns of the m x m matrix Q from geqrf
+template<typename T>
+void orgqr(int m, int n, int k, lapack_view<T> a, const T *tau) {
+  std::vector<T> pv(std::size_t(m) * k);
+  lapack_view<T> v(LAPACK_COL_MAJOR, pv.data(), m);
+  for (int j = 0; j < k; ++j)
+    for (int i = j + 1; i < m; ++i) v(i, j) = a(i, j);
+
+  for (int i = 0; i < m; ++i)
+    for (int j = 0; j < n; ++j) a(i, j) = (i == j) ? T(1) : T(0);
+  ormqr('L', 'N', m, n, k, v, tau, a);
+}
+
+// the view of the transposed array
+template<typename T>
+lapack_view<T> transposed(lapack_view<T> a) {
+  std::swap(a.rs, a.cs);
+  return a;
+}
+
+// One-sided Jacobi SVD A = U S V' of the m x n matrix a, m >= n, stored
+// column-major: U overwrites a, the singular values are sorted in decreasing
+// order, and v is n x n column-major.
+template<typename T>
+void jacobi_svd(int m, int n, T *pa, T *s, T *pv) {
+  lapack_view<T> a(LAPACK_COL_MAJOR, pa, m);
+  lapack_view<T> v(LAPACK_COL_MAJOR, pv, n);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) v(i, j) = (i == j) ? T(1) : T(0);
+
+  const T eps = std::numeric_limits<T>::epsilon();
+  for (int sweep = 0; sweep < 60; ++sweep) {
+    bool rotated = false;
+    for (int p = 0; p < n - 1; ++p)
+      for (int q = p + 1; q < n; ++q) {
+        T alpha = 0, beta = 0, gamma = 0;
+        for (int i = 0; i < m; ++i) {
+          alpha += a(i, p) * a(i, p);
+          beta += a(i, q) * a(i, q);
+          gamma += a(i, p) * a(i, q);
+        }
+        if (std::abs(gamma) <= eps * std::sqrt(alpha * beta)) continue;
+        rotated = true;
+
+        const T zeta = (beta - alpha) / (2 * gamma);
+        const T t = (zeta >= T(0) ? T(1) : T(-1))
+            / (std::abs(zeta) + std::sqrt(T(1) + zeta * zeta));
+        const T c = T(1) / std::sqrt(T(1) + t * t), sn = c * t;
+        for (int i = 0; i < m; ++i) {
+          const T x = a(i, p), y = a(i, q);
+          a(i, p) = c * x - sn * y;
+          a(i, q) = sn * x + c * y;
+        }
+        for (int i = 0; i < n; ++i) {
+          const T x = v(i, p), y = v(i, q);
+          v(i, p) = c * x - sn * y;
+          v(i, q) = sn * x + c * y;
+        }
+      }
+    if (!rotated) break;
+  }
+
+  for (int j = 0; j < n; ++j) {
+    T norm = 0;
+    for (int i = 0; i < m; ++i) norm += a(i, j) * a(i, j);
+    s[j] = std::sqrt(norm);
+    if (s[j] != T(0))
+      for (int i = 0; i < m; ++i) a(i, j) /= s[j];
+  }
+
+  // selection sort, swapping whole columns
+  for (int j = 0; j < n; ++j) {
+    int p = j;
+    for (int l = j + 1; l < n; ++l)
+      if (s[l] > s[p]) p = l;
+    if (p == j) continue;
+    std::swap(s[j], s[p]);
+    for (int i = 0; i < m; ++i) std::swap(a(i, j), a(i, p));
+    for (int i = 0; i < n; ++i) std::swap(v(i, j), v(i, p));
+  }
+}
+
+// Cyclic Jacobi eigenvalue algorithm for the symmetric n x n matrix a,
+// stored column-major and destroyed: w holds the eigenvalues in increasing
+// order, and the columns of v (n x n, column-major) the eigenvectors.
+template<typename T>
+void jacobi_eig(int n, T *pa, T *w, T *pv) {
+  lapack_view<T> a(LAPACK_COL_MAJOR, pa, n);
+  lapack_view<T> v(LAPACK_COL_MAJOR, pv, n);
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j) v(i, j) = (i == j) ? T(1) : T(0);
+
+  const T eps = std::numeric_limits<T>::epsilon();
+  for (int sweep = 0; sweep < 100; ++sweep) {
+    T off = 0, diag = 0;
+    for (int j = 0; j < n; ++j) {
+      diag += a(j, j) * a(j, j);
+      for (int i = 0; i < j; ++i) off += a(i, j) * a(i, j);
+    }
+    if (off <= eps * eps * diag || off == T(0)) break;
+
+    for (int p = 0; p < n - 1; ++p)
+      for (int q = p + 1; q < n; ++q) {
+        if (a(p, q) == T(0)) continue;
+        const T theta = (a(q, q) - a(p, p)) / (2 * a(p, q));
+        const T t = (theta >= T(0) ? T(1) : T(-1))
+            / (std::abs(theta) + std::sqrt(theta * theta + T(1)));
+        const T c = T(1) / std::sqrt(t * t + T(1)), s = t * c;
+
+        for (int k = 0; k < n; ++k) {
+          const T x = a(k, p), y = a(k, q);
+          a(k, p) = c * x - s * y;
+          a(k, q) = s * x + c * y;
+        }
+        for (int k = 0; k < n; ++k) {
+          const T x = a(p, k), y = a(q, k);
+          a(p, k) = c * x - s * y;
+          a(q, k) = s * x + c * y;
+        }
+        a(p, q) = a(q, p) = T(0);
+        for (int k = 0; k < n; ++k) {
+          const T x = v(k, p), y = v(k, q);
+          v(k, p) = c * x - s * y;
+          v(k, q) = s * x + c * y;
+        }
+      }
+  }
+
+  for (int j = 0; j < n; ++j) w[j] = a(j, j);
+  for (int j = 0; j < n; ++j) {
+    int p = j;
+    for (int l = j + 1; l < n; ++l)
+      if (w[l] < w[p]) p = l;
+    if (p == j) continue;
+    std::swap(w[j], w[p]);
+    for (int i = 0; i < n; ++i) std::swap(v(i, j), v(i, p));
+  }
+}
+
+// Replaces the columns c0, ..., c1 - 1 of the m-row matrix u by unit vectors
+// orthogonal to all the other columns of u(:, 0:c1), for the columns that
+// are zero (when replace_zero only) or all of them.
+template<typename T>
+void orthonormal_complete(int m, int c0, int c1, lapack_view<T> u,
+                          bool replace_zero) {
+  for (int j = c0; j < c1; ++j) {
+    if (replace_zero) {
+      T norm = 0;
+      for (int i = 0; i < m; ++i) norm += u(i, j) * u(i, j);
+      if (norm != T(0)) continue;
+    }
+    // Gram-Schmidt on the unit vectors, until one is not in the span
+    for (int e = 0; e < m; ++e) {
+      for (int i = 0; i < m; ++i) u(i, j) = (i == e) ? T(1) : T(0);
+      for (int pass = 0; pass < 2; ++pass)
+        for (int l = 0; l < c1; ++l) {
+          if (l == j) continue;
+          T d = 0;
+          for (int i = 0; i < m; ++i) d += u(i, l) * u(i, j);
+          for (int i = 0; i < m; ++i) u(i, j) -= d * u(i, l);
+        }
+      T norm = 0;
+      for (int i = 0; i < m; ++i) norm += u(i, j) * u(i, j);
+      if (norm > T(0.25)) {
+        norm = std::sqrt(norm);
+        for (int i = 0; i < m; ++i) u(i, j) /= norm;
+        break;
+      }
+    }
+  }
+}
+
+// the full symmetric matrix, column-major, from the uplo triangle of a
+template<typename T>
+std::vector<T> symmetric_copy(int layout, char uplo, int n, const T *pa,
+                              int lda) {
+  lapack_view<const T> a(layout, pa, lda);
+  const bool lower = !(uplo == 'U' || uplo == 'u');
+  std::vector<T> s(std::size_t(n) * n);
+  for (int j = 0; j < n; ++j)
+    for (int i = 0; i < n; ++i) {
+      const bool in = lower ? i >= j : i <= j;
+      s[std::size_t(j) * n + i] = in ? a(i, j) : a(j, i);
+    }
+  return s;
+}
+
+template<typename T>
+lapack_int syevd(int layout, char jobz, char uplo, lapack_int n, T *pa,
+                 lapack_int lda, T *w, T *work, lapack_int lwork,
+                 lapack_int *iwork, lapack_int liwork) {
+  if (lwork == -1 || liwork == -1) {
+    work[0] = T(1);
+    iwork[0] = 1;
+    return 0;
+  }
+
+  std::vector<T> s = symmetric_copy(layout, uplo, n, pa, lda);
+  std::vector<T> pv(std::size_t(n) * n);
+  jacobi_eig(n, s.data(), w, pv.data());
+
+  if (jobz == 'V' || jobz == 'v') {
+    lapack_view<T> a(layout, pa, lda);
+    lapack_view<T> v(LAPACK_COL_MAJOR, pv.data(), n);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j) a(i, j) = v(i, j);
+  }
+  return 0;
+}
+
+template<typename T>
+lapack_int syevr(int layout, char jobz, char range, char uplo, lapack_int n,
+                 T *pa, lapack_int lda, T vl, T vu, lapack_int il,
+                 lapack_int iu, T, lapack_int *m, T *w, T *pz,
+                 lapack_int ldz, lapack_int *, T *work, lapack_int lwork,
+                 lapack_int *iwork, lapack_int liwork) {
+  if (lwork == -1 || liwork == -1) {
+    work[0] = T(1);
+    iwork[0] = 1;
+    return 0;
+  }
+
+  std::vector<T> s = symmetric_copy(layout, uplo, n, pa, lda);
+  std::vector<T> all(n), pv(std::size_t(n) * n);
+  jacobi_eig(n, s.data(), all.data(), pv.data());
+
+  // the selected eigenvalues, in increasing order
+  int first = 0, last = n;
+  if (range == 'I' || range == 'i') {
+    first = il - 1;
+    last = iu;
+  } else if (range == 'V' || range == 'v') {
+    while (first < n && all[first] <= vl) ++first;
+    last = first;
+    while (last < n && all[last] <= vu) ++last;
+  }
+
+  *m = last - first;
+  lapack_view<T> v(LAPACK_COL_MAJOR, pv.data(), n);
+  lapack_view<T> z(layout, pz, ldz);
+  for (int j = first; j < last; ++j) {
+    w[j - first] = all[j];
+    if (jobz == 'V' || jobz == 'v')
+      for (int i = 0; i < n; ++i) z(i, j - first) = v(i, j);
+  }
+  return 0;
+}
+
+// SVD A = U S V' through one-sided Jacobi; jobz is 'N' (values only), 'S'
+// (the first min(m, n) columns of U and rows of V') or 'A' (all of them)
+template<typename T>
+lapack_int gesdd(int layout, char jobz, lapack_int m, lapack_int n, T *pa,
+                 lapack_int lda, T *s, T *pu, lapack_int ldu, T *pvt,
+                 lapack_int ldvt, T *work, lapack_int lwork, lapack_int *) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    return 0;
+  }
+
+  lapack_view<T> a(layout, pa, lda);
+  const bool tall = (m >= n);
+  const int r = tall ? m : n, c = tall ? n : m;
+
+  std::vector<T> px(std::size_t(r) * c), py(std::size_t(c) * c);
+  lapack_view<T> x(LAPACK_COL_MAJOR, px.data(), r);
+  lapack_view<T> y(LAPACK_COL_MAJOR, py.data(), c);
+  for (int i = 0; i < r; ++i)
+    for (int j = 0; j < c; ++j) x(i, j) = tall ? a(i, j) : a(j, i);
+  jacobi_svd(r, c, px.data(), s, py.data());
+  if (jobz == 'N' || jobz == 'n') return 0;
+
+  // A = U S V', with U and V from x and y, or from y and x when A is wide
+  const bool all = (jobz == 'A' || jobz == 'a');
+  const int ucols = all ? m : c, vcols = all ? n : c;
+  std::vector<T> pu2(std::size_t(m) * ucols, T(0));
+  std::vector<T> pv2(std::size_t(n) * vcols, T(0));
+  lapack_view<T> u2(LAPACK_COL_MAJOR, pu2.data(), m);
+  lapack_view<T> v2(LAPACK_COL_MAJOR, pv2.data(), n);
+  for (int j = 0; j < c; ++j) {
+    for (int i = 0; i < m; ++i) u2(i, j) = tall ? x(i, j) : y(i, j);
+    for (int i = 0; i < n; ++i) v2(i, j) = tall ? y(i, j) : x(i, j);
+  }
+  // the columns of the null singular values, and those of the full bases
+  orthonormal_complete(m, 0, c, u2, true);
+  orthonormal_complete(n, 0, c, v2, true);
+  orthonormal_complete(m, c, ucols, u2, false);
+  orthonormal_complete(n, c, vcols, v2, false);
+
+  lapack_view<T> u(layout, pu, ldu);
+  lapack_view<T> vt(layout, pvt, ldvt);
+  for (int i = 0; i < m; ++i)
+    for (int j = 0; j < ucols; ++j) u(i, j) = u2(i, j);
+  for (int i = 0; i < vcols; ++i)
+    for (int j = 0; j < n; ++j) vt(i, j) = v2(j, i);
+  return 0;
+}
+
+template<typename T>
+lapack_int gelqf(int layout, lapack_int m, lapack_int n, T *a, lapack_int lda,
+                 T *tau, T *work, lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    return 0;
+  }
+  // the LQ factorization of A is the QR factorization of A'
+  geqrf(n, m, transposed(lapack_view<T>(layout, a, lda)), tau);
+  return 0;
+}
+
+template<typename T>
+lapack_int orglq(int layout, lapack_int m, lapack_int n, lapack_int k, T *a,
+                 lapack_int lda, const T *tau, T *work, lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    return 0;
+  }
+  orgqr(n, m, k, transposed(lapack_view<T>(layout, a, lda)), tau);
+  return 0;
+}
+
+template<typename T>
+lapack_int ormlq(int layout, char side, char trans, lapack_int m,
+                 lapack_int n, lapack_int k, const T *a, lapack_int lda,
+                 const T *tau, T *c, lapack_int ldc, T *work,
+                 lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    return 0;
+  }
+  // the Q of an LQ factorization is the transposed Q of a QR factorization
+  const bool notrans = (trans == 'N' || trans == 'n');
+  ormqr(side, notrans ? 'T' : 'N', m, n, k,
+        transposed(lapack_view<const T>(layout, a, lda)), tau,
+        lapack_view<T>(layout, c, ldc));
+  return 0;
+}
+
+// least squares or minimum norm solution of op(A) X = B through a QR
+// factorization of op(A) or op(A)'
+template<typename T>
+lapack_int gels(int layout, char trans, lapack_int m, lapack_int n,
+                lapack_int nrhs, T *pa, lapack_int lda, T *pb, lapack_int ldb,
+                T *work, lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    return 0;
+  }
+
+  lapack_view<T> a(layout, pa, lda);
+  lapack_view<T> b(layout, pb, ldb);
+  if (!(trans == 'N' || trans == 'n')) {
+    a = transposed(a);
+    std::swap(m, n);
+  }
+
+  const int k = std::min(m, n);
+  std::vector<T> tau(std::max(1, k));
+
+  if (m >= n) {
+    // min ||A x - b||: R x = (Q' b)(0:n)
+    geqrf(m, n, a, tau.data());
+    for (int i = 0; i < n; ++i)
+      if (a(i, i) == T(0)) return i + 1;
+    ormqr('L', 'T', m, nrhs, k, a, tau.data(), b);
+    for (int r = 0; r < nrhs; ++r)
+      for (int i = n - 1; i >= 0; --i) {
+        for (int l = i + 1; l < n; ++l) b(i, r) -= a(i, l) * b(l, r);
+        b(i, r) /= a(i, i);
+      }
+  } else {
+    // min ||x|| with A x = b: A' = Q R, x = Q [inv(R') b; 0]
+    lapack_view<T> at = transposed(a);
+    geqrf(n, m, at, tau.data());
+    for (int i = 0; i < m; ++i)
+      if (at(i, i) == T(0)) return i + 1;
+    for (int r = 0; r < nrhs; ++r) {
+      for (int i = 0; i < m; ++i) {
+        for (int l = 0; l < i; ++l) b(i, r) -= at(l, i) * b(l, r);
+        b(i, r) /= at(i, i);
+      }
+      for (int i = m; i < n; ++i) b(i, r) = T(0);
+    }
+    ormqr('L', 'N', n, nrhs, k, at, tau.data(), b);
+  }
+
+  return 0;
+}
+
+// minimum norm least squares solution of A X = B through the SVD of A;
+// singular values s(i) <= rcond * s(0) are treated as zero
+template<typename T>
+lapack_int gelsd(int layout, lapack_int m, lapack_int n, lapack_int nrhs,
+                 T *pa, lapack_int lda, T *pb, lapack_int ldb, T *s, T rcond,
+                 lapack_int *rank, T *work, lapack_int lwork,
+                 lapack_int *iwork) {
+  if (lwork == -1) {
+    work[0] = T(1);
+    iwork[0] = 1;
+    return 0;
+  }
+
+  lapack_view<T> a(layout, pa, lda);
+  lapack_view<T> b(layout, pb, ldb);
+  const bool tall = (m >= n);
+  const int r = tall ? m : n, c = tall ? n : m;
+  const int k = c;
+
+  // the SVD of A, or of A' when A is wide
+  std::vector<T> pu(std::size_t(r) * c), pv(std::size_t(c) * c);
+  lapack_view<T> u(LAPACK_COL_MAJOR, pu.data(), r);
+  lapack_view<T> v(LAPACK_COL_MAJOR, pv.data(), c);
+  for (int i = 0; i < r; ++i)
+    for (int j = 0; j < c; ++j) u(i, j) = tall ? a(i, j) : a(j, i);
+  jacobi_svd(r, c, pu.data(), s, pv.data());
+
+  // A = ul S vr', whichever of u and v is which
+  lapack_view<T> ul = tall ? u : v, vr = tall ? v : u;
+
+  if (rcond < T(0)) rcond = std::numeric_limits<T>::epsilon();
+  const T tol = rcond * (k > 0 ? s[0] : T(0));
+  *rank = 0;
+  while (*rank < k && s[*rank] > tol) ++*rank;
+
+  // x = vr inv(S) ul' b, with only the first rank singular values
+  std::vector<T> y(std::size_t(k) * nrhs, T(0));
+  for (int j = 0; j < *rank; ++j)
+    for (int q = 0; q < nrhs; ++q) {
+      T w = T(0);
+      for (int i = 0; i < m; ++i) w += ul(i, j) * b(i, q);
+      y[std::size_t(j) * nrhs + q] = w / s[j];
+    }
+  for (int i = 0; i < n; ++i)
+    for (int q = 0; q < nrhs; ++q) {
+      T w = T(0);
+      for (int j = 0; j < *rank; ++j) w += vr(i, j) * y[std::size_t(j) * nrhs + q];
+      b(i, q) = w;
+    }
+
+  return 0;
+}
+
+template<typename T>
+T lange(int layout, char norm, lapack_int m, lapack_int n, const T *pa,
+        lapack_int lda) {
+  lapack_view<const T> a(layout, pa, lda);
+  T res = 0;
+
+  switch (norm) {
+    case 'M': case 'm':
+      for (lapack_int i = 0; i < m; ++i)
+        for (lapack_int j = 0; j < n; ++j)
+          res = std::max(res, std::abs(a(i, j)));
+      break;
+    case 'O': case 'o': case '1':
+      for (lapack_int j = 0; j < n; ++j) {
+        T s = 0;
+        for (lapack_int i = 0; i < m; ++i) s += std::abs(a(i, j));
+        res = std::max(res, s);
+      }
+      break;
+    case 'I': case 'i':
+      for (lapack_int i = 0; i < m; ++i) {
+        T s = 0;
+        for (lapack_int j = 0; j < n; ++j) s += std::abs(a(i, j));
+        res = std::max(res, s);
+      }
+      break;
+    default:  // Frobenius
+      for (lapack_int i = 0; i < m; ++i)
+        for (lapack_int j = 0; j < n; ++j) res += a(i, j) * a(i, j);
+      res = std::sqrt(res);
+  }
+
+  return res;
+}
+
+} // namespace builtin
+} // namespace slab
+
+inline lapack_int LAPACKE_sgetrf(int layout, lapack_int m, lapack_int n,
+                                 float *a, lapack_int lda, lapack_int *ipiv) {
+  return slab::builtin::getrf(layout, m, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_dgetrf(int layout, lapack_int m, lapack_int n,
+                                 double *a, lapack_int lda, lapack_int *ipiv) {
+  return slab::builtin::getrf(layout, m, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_sgetrs(int layout, char trans, lapack_int n,
+                                 lapack_int nrhs, const float *a,
+                                 lapack_int lda, const lapack_int *ipiv,
+                                 float *b, lapack_int ldb) {
+  return slab::builtin::getrs(layout, trans, n, nrhs, a, lda, ipiv, b, ldb);
+}
+
+inline lapack_int LAPACKE_dgetrs(int layout, char trans, lapack_int n,
+                                 lapack_int nrhs, const double *a,
+                                 lapack_int lda, const lapack_int *ipiv,
+                                 double *b, lapack_int ldb) {
+  return slab::builtin::getrs(layout, trans, n, nrhs, a, lda, ipiv, b, ldb);
+}
+
+inline float LAPACKE_slange(int layout, char norm, lapack_int m, lapack_int n,
+                            const float *a, lapack_int lda) {
+  return slab::builtin::lange(layout, norm, m, n, a, lda);
+}
+
+inline double LAPACKE_dlange(int layout, char norm, lapack_int m, lapack_int n,
+                             const double *a, lapack_int lda) {
+  return slab::builtin::lange(layout, norm, m, n, a, lda);
+}
+
+inline lapack_int LAPACKE_sgetri(int layout, lapack_int n, float *a,
+                                 lapack_int lda, const lapack_int *ipiv) {
+  return slab::builtin::getri(layout, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_dgetri(int layout, lapack_int n, double *a,
+                                 lapack_int lda, const lapack_int *ipiv) {
+  return slab::builtin::getri(layout, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_sgecon(int layout, char norm, lapack_int n,
+                                 const float *a, lapack_int lda, float anorm,
+                                 float *rcond) {
+  return slab::builtin::gecon(layout, norm, n, a, lda, anorm, rcond);
+}
+
+inline lapack_int LAPACKE_dgecon(int layout, char norm, lapack_int n,
+                                 const double *a, lapack_int lda,
+                                 double anorm, double *rcond) {
+  return slab::builtin::gecon(layout, norm, n, a, lda, anorm, rcond);
+}
+
+inline lapack_int LAPACKE_spotrf(int layout, char uplo, lapack_int n,
+                                 float *a, lapack_int lda) {
+  return slab::builtin::potrf(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_dpotrf(int layout, char uplo, lapack_int n,
+                                 double *a, lapack_int lda) {
+  return slab::builtin::potrf(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_spotrs(int layout, char uplo, lapack_int n,
+                                 lapack_int nrhs, const float *a,
+                                 lapack_int lda, float *b, lapack_int ldb) {
+  return slab::builtin::potrs(layout, uplo, n, nrhs, a, lda, b, ldb);
+}
+
+inline lapack_int LAPACKE_dpotrs(int layout, char uplo, lapack_int n,
+                                 lapack_int nrhs, const double *a,
+                                 lapack_int lda, double *b, lapack_int ldb) {
+  return slab::builtin::potrs(layout, uplo, n, nrhs, a, lda, b, ldb);
+}
+
+inline lapack_int LAPACKE_spotri(int layout, char uplo, lapack_int n,
+                                 float *a, lapack_int lda) {
+  return slab::builtin::potri(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_dpotri(int layout, char uplo, lapack_int n,
+                                 double *a, lapack_int lda) {
+  return slab::builtin::potri(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_sgetrf_work(int layout, lapack_int m, lapack_int n,
+                                      float *a, lapack_int lda,
+                                      lapack_int *ipiv) {
+  return slab::builtin::getrf(layout, m, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_sgetri_work(int layout, lapack_int n, float *a,
+                                      lapack_int lda, const lapack_int *ipiv,
+                                      float *work, lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = float(n);
+    return 0;
+  }
+  return slab::builtin::getri(layout, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_sgecon_work(int layout, char norm, lapack_int n,
+                                      const float *a, lapack_int lda,
+                                      float anorm, float *rcond, float *,
+                                      lapack_int *) {
+  return slab::builtin::gecon(layout, norm, n, a, lda, anorm, rcond);
+}
+
+inline lapack_int LAPACKE_spotrf_work(int layout, char uplo, lapack_int n,
+                                      float *a, lapack_int lda) {
+  return slab::builtin::potrf(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_spotri_work(int layout, char uplo, lapack_int n,
+                                      float *a, lapack_int lda) {
+  return slab::builtin::potri(layout, uplo, n, a, lda);
+}
+
+inline float LAPACKE_slange_work(int layout, char norm, lapack_int m,
+                                 lapack_int n, const float *a, lapack_int lda,
+                                 float *) {
+  return slab::builtin::lange(layout, norm, m, n, a, lda);
+}
+
+inline lapack_int LAPACKE_dgetrf_work(int layout, lapack_int m, lapack_int n,
+                                      double *a, lapack_int lda,
+                                      lapack_int *ipiv) {
+  return slab::builtin::getrf(layout, m, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_dgetri_work(int layout, lapack_int n, double *a,
+                                      lapack_int lda, const lapack_int *ipiv,
+                                      double *work, lapack_int lwork) {
+  if (lwork == -1) {
+    work[0] = double(n);
+    return 0;
+  }
+  return slab::builtin::getri(layout, n, a, lda, ipiv);
+}
+
+inline lapack_int LAPACKE_dgecon_work(int layout, char norm, lapack_int n,
+                                      const double *a, lapack_int lda,
+                                      double anorm, double *rcond, double *,
+                                      lapack_int *) {
+  return slab::builtin::gecon(layout, norm, n, a, lda, anorm, rcond);
+}
+
+inline lapack_int LAPACKE_dpotrf_work(int layout, char uplo, lapack_int n,
+                                      double *a, lapack_int lda) {
+  return slab::builtin::potrf(layout, uplo, n, a, lda);
+}
+
+inline lapack_int LAPACKE_dpotri_work(int layout, char uplo, lapack_int n,
+                                      double *a, lapack_int lda) {
+  return slab::builtin::potri(layout, uplo, n, a, lda);
+}
+
+inline double LAPACKE_dlange_work(int layout, char norm, lapack_int m,
+                                 lapack_int n, const double *a, lapack_int lda,
+                                 double *) {
+  return slab::builtin::lange(layout, norm, m, n, a, lda);
+}
+
+inline lapack_int LAPACKE_sgbtrf_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int kl, lapack_int ku, float *ab,
+                                      lapack_int ldab, lapack_int *ipiv) {
+  return slab::builtin::gbtrf(layout, m, n, kl, ku, ab, ldab, ipiv);
+}
+
+inline lapack_int LAPACKE_sgbtrs_work(int layout, char trans, lapack_int n,
+                                      lapack_int kl, lapack_int ku,
+                                      lapack_int nrhs, const float *ab,
+                                      lapack_int ldab, const lapack_int *ipiv,
+                                      float *b, lapack_int ldb) {
+  return slab::builtin::gbtrs(layout, trans, n, kl, ku, nrhs, ab, ldab, ipiv,
+                              b, ldb);
+}
+
+inline lapack_int LAPACKE_spbtrf_work(int layout, char uplo, lapack_int n,
+                                      lapack_int kd, float *ab,
+                                      lapack_int ldab) {
+  return slab::builtin::pbtrf(layout, uplo, n, kd, ab, ldab);
+}
+
+inline lapack_int LAPACKE_spbtrs_work(int layout, char uplo, lapack_int n,
+                                      lapack_int kd, lapack_int nrhs,
+                                      const float *ab, lapack_int ldab, float *b,
+                                      lapack_int ldb) {
+  return slab::builtin::pbtrs(layout, uplo, n, kd, nrhs, ab, ldab, b, ldb);
+}
+
+inline lapack_int LAPACKE_dgbtrf_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int kl, lapack_int ku, double *ab,
+                                      lapack_int ldab, lapack_int *ipiv) {
+  return slab::builtin::gbtrf(layout, m, n, kl, ku, ab, ldab, ipiv);
+}
+
+inline lapack_int LAPACKE_dgbtrs_work(int layout, char trans, lapack_int n,
+                                      lapack_int kl, lapack_int ku,
+                                      lapack_int nrhs, const double *ab,
+                                      lapack_int ldab, const lapack_int *ipiv,
+                                      double *b, lapack_int ldb) {
+  return slab::builtin::gbtrs(layout, trans, n, kl, ku, nrhs, ab, ldab, ipiv,
+                              b, ldb);
+}
+
+inline lapack_int LAPACKE_dpbtrf_work(int layout, char uplo, lapack_int n,
+                                      lapack_int kd, double *ab,
+                                      lapack_int ldab) {
+  return slab::builtin::pbtrf(layout, uplo, n, kd, ab, ldab);
+}
+
+inline lapack_int LAPACKE_dpbtrs_work(int layout, char uplo, lapack_int n,
+                                      lapack_int kd, lapack_int nrhs,
+                                      const double *ab, lapack_int ldab, double *b,
+                                      lapack_int ldb) {
+  return slab::builtin::pbtrs(layout, uplo, n, kd, nrhs, ab, ldab, b, ldb);
+}
+
+inline lapack_int LAPACKE_spptrf_work(int layout, char uplo, lapack_int n,
+                                      float *ap) {
+  return slab::builtin::pptrf(layout, uplo, n, ap);
+}
+
+inline lapack_int LAPACKE_spptrs_work(int layout, char uplo, lapack_int n,
+                                      lapack_int nrhs, const float *ap,
+                                      float *b, lapack_int ldb) {
+  return slab::builtin::pptrs(layout, uplo, n, nrhs, ap, b, ldb);
+}
+
+inline lapack_int LAPACKE_dpptrf_work(int layout, char uplo, lapack_int n,
+                                      double *ap) {
+  return slab::builtin::pptrf(layout, uplo, n, ap);
+}
+
+inline lapack_int LAPACKE_dpptrs_work(int layout, char uplo, lapack_int n,
+                                      lapack_int nrhs, const double *ap,
+                                      double *b, lapack_int ldb) {
+  return slab::builtin::pptrs(layout, uplo, n, nrhs, ap, b, ldb);
+}
+
+inline lapack_int LAPACKE_sgelqf_work(int layout, lapack_int m, lapack_int n,
+                                      float *a, lapack_int lda, float *tau,
+                                      float *work, lapack_int lwork) {
+  return slab::builtin::gelqf(layout, m, n, a, lda, tau, work, lwork);
+}
+
+inline lapack_int LAPACKE_sorglq_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int k, float *a, lapack_int lda,
+                                      const float *tau, float *work,
+                                      lapack_int lwork) {
+  return slab::builtin::orglq(layout, m, n, k, a, lda, tau, work, lwork);
+}
+
+inline lapack_int LAPACKE_sormlq_work(int layout, char side, char trans,
+                                      lapack_int m, lapack_int n, lapack_int k,
+                                      const float *a, lapack_int lda,
+                                      const float *tau, float *c, lapack_int ldc,
+                                      float *work, lapack_int lwork) {
+  return slab::builtin::ormlq(layout, side, trans, m, n, k, a, lda, tau, c,
+                              ldc, work, lwork);
+}
+
+inline lapack_int LAPACKE_sgels_work(int layout, char trans, lapack_int m,
+                                     lapack_int n, lapack_int nrhs, float *a,
+                                     lapack_int lda, float *b, lapack_int ldb,
+                                     float *work, lapack_int lwork) {
+  return slab::builtin::gels(layout, trans, m, n, nrhs, a, lda, b, ldb, work,
+                             lwork);
+}
+
+inline lapack_int LAPACKE_sgelsd_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int nrhs, float *a, lapack_int lda,
+                                      float *b, lapack_int ldb, float *s,
+                                      float rcond, lapack_int *rank, float *work,
+                                      lapack_int lwork, lapack_int *iwork) {
+  return slab::builtin::gelsd(layout, m, n, nrhs, a, lda, b, ldb, s, rcond,
+                              rank, work, lwork, iwork);
+}
+
+inline lapack_int LAPACKE_dgelqf_work(int layout, lapack_int m, lapack_int n,
+                                      double *a, lapack_int lda, double *tau,
+                                      double *work, lapack_int lwork) {
+  return slab::builtin::gelqf(layout, m, n, a, lda, tau, work, lwork);
+}
+
+inline lapack_int LAPACKE_dorglq_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int k, double *a, lapack_int lda,
+                                      const double *tau, double *work,
+                                      lapack_int lwork) {
+  return slab::builtin::orglq(layout, m, n, k, a, lda, tau, work, lwork);
+}
+
+inline lapack_int LAPACKE_dormlq_work(int layout, char side, char trans,
+                                      lapack_int m, lapack_int n, lapack_int k,
+                                      const double *a, lapack_int lda,
+                                      const double *tau, double *c, lapack_int ldc,
+                                      double *work, lapack_int lwork) {
+  return slab::builtin::ormlq(layout, side, trans, m, n, k, a, lda, tau, c,
+                              ldc, work, lwork);
+}
+
+inline lapack_int LAPACKE_dgels_work(int layout, char trans, lapack_int m,
+                                     lapack_int n, lapack_int nrhs, double *a,
+                                     lapack_int lda, double *b, lapack_int ldb,
+                                     double *work, lapack_int lwork) {
+  return slab::builtin::gels(layout, trans, m, n, nrhs, a, lda, b, ldb, work,
+                             lwork);
+}
+
+inline lapack_int LAPACKE_dgelsd_work(int layout, lapack_int m, lapack_int n,
+                                      lapack_int nrhs, double *a, lapack_int lda,
+                                      double *b, lapack_int ldb, double *s,
+                                      double rcond, lapack_int *rank, double *work,
+                                      lapack_int lwork, lapack_int *iwork) {
+  return slab::builtin::gelsd(layout, m, n, nrhs, a, lda, b, ldb, s, rcond,
+                              rank, work, lwork, iwork);
+}
+
+inline lapack_int LAPACKE_ssyevd_work(int layout, char jobz, char uplo,
+                                      lapack_int n, float *a, lapack_int lda,
+                                      float *w, float *work, lapack_int lwork,
+                                      lapack_int *iwork, lapack_int liwork) {
+  return slab::builtin::syevd(layout, jobz, uplo, n, a, lda, w, work, lwork,
+                              iwork, liwork);
+}
+
+inline lapack_int LAPACKE_ssyevr_work(int layout, char jobz, char range,
+                                      char uplo, lapack_int n, float *a,
+                                      lapack_int lda, float vl, float vu,
+                                      lapack_int il, lapack_int iu,
+                                      float abstol, lapack_int *m, float *w,
+                                      float *z, lapack_int ldz,
+                                      lapack_int *isuppz, float *work,
+                                      lapack_int lwork, lapack_int *iwork,
+                                      lapack_int liwork) {
+  return slab::builtin::syevr(layout, jobz, range, uplo, n, a, lda, vl, vu,
+                              il, iu, abstol, m, w, z, ldz, isuppz, work,
+                              lwork, iwork, liwork);
+}
+
+inline lapack_int LAPACKE_sgesdd_work(int layout, char jobz, lapack_int m,
+                                      lapack_int n, float *a, lapack_int lda,
+                                      float *s, float *u, lapack_int ldu, float *vt,
+                                      lapack_int ldvt, float *work,
+                                      lapack_int lwork, lapack_int *iwork) {
+  return slab::builtin::gesdd(layout, jobz, m, n, a, lda, s, u, ldu, vt, ldvt,
+                              work, lwork, iwork);
+}
+
+inline lapack_int LAPACKE_dsyevd_work(int layout, char jobz, char uplo,
+                                      lapack_int n, double *a, lapack_int lda,
+                                      double *w, double *work, lapack_int lwork,
+                                      lapack_int *iwork, lapack_int liwork) {
+  return slab::builtin::syevd(layout, jobz, uplo, n, a, lda, w, work, lwork,
+                              iwork, liwork);
+}
+
+inline lapack_int LAPACKE_dsyevr_work(int layout, char jobz, char range,
+                                      char uplo, lapack_int n, double *a,
+                                      lapack_int lda, double vl, double vu,
+                                      lapack_int il, lapack_int iu,
+                                      double abstol, lapack_int *m, double *w,
+                                      double *z, lapack_int ldz,
+                                      lapack_int *isuppz, double *work,
+                                      lapack_int lwork, lapack_int *iwork,
+                                      lapack_int liwork) {
+  return slab::builtin::syevr(layout, jobz, range, uplo, n, a, lda, vl, vu,
+                              il, iu, abstol, m, w, z, ldz, isuppz, work,
+                              lwork, iwork, liwork);
+}
+
+inline lapack_int LAPACKE_dgesdd_work(int layout, char jobz, lapack_int m,
+                                      lapack_int n, double *a, lapack_int lda,
+                                      double *s, double *u, lapack_int ldu, double *vt,
+                                      lapack_int ldvt, double *work,
+                                      lapack_int lwork, lapack_int *iwork) {
+  return slab::builtin::gesdd(layout, jobz, m, n, a, lda, s, u, ldu, vt, ldvt,
+                              work, lwork, iwork);
+}
+
+#endif // SLAB_MATRIX_BUILTIN_LAPACK_H_
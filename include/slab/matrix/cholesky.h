@@ -0,0 +1,164 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file cholesky.h
+/// @brief A reusable Cholesky factorization of a symmetric positive definite
+/// matrix
+
+#ifndef SLAB_MATRIX_CHOLESKY_H_
+#define SLAB_MATRIX_CHOLESKY_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/lapack_interface.h"
+
+/// @addtogroup linear_solve LINEAR SOLVERS
+/// @{
+
+/// @brief The Cholesky factorization A = L * L' of a symmetric positive
+/// definite matrix
+///
+/// Half the cost of an LU factorization. Only the lower triangle of A is
+/// read. A matrix that is not positive definite is reported by info(), and
+/// then by the return codes of solve() and inverse(), never by an exception.
+template<typename T>
+class Cholesky {
+ public:
+  Cholesky() : info_(0) {}
+  explicit Cholesky(const Matrix<T, 2> &a) { factor(a); }
+
+  /// @brief Factors a, returns info() (0 on success, i > 0 if the leading
+  /// minor of order i is not positive definite)
+  int factor(const Matrix<T, 2> &a);
+
+  int info() const { return info_; }
+  /// @brief True if the factorization can be used to solve
+  bool ok() const { return info_ == 0 && l_.size() != 0; }
+
+  std::size_t n() const { return l_.n_rows(); }
+  /// @brief The lower triangular factor L, zero above the diagonal
+  const Matrix<T, 2> &lower() const { return l_; }
+
+  /// @brief Solves A * x = b
+  ///
+  /// @return 0 on success, info() if A is not positive definite.
+  int solve(const Matrix<T, 1> &b, Matrix<T, 1> &x) const;
+  /// @brief Solves A * X = B for all the columns of B in one call
+  int solve(const Matrix<T, 2> &b, Matrix<T, 2> &x) const;
+
+  /// @brief The solution of A * x = b, an empty matrix if A is not positive
+  /// definite
+  template<std::size_t N>
+  Matrix<T, N> solve(const Matrix<T, N> &b) const {
+    Matrix<T, N> x;
+    if (solve(b, x) != 0) x.clear();
+    return x;
+  }
+
+  /// @brief The determinant of A, 0 if A is not positive definite
+  T det() const;
+  /// @brief The logarithm of the determinant of A, which does not overflow
+  /// for large matrices; -inf if A is not positive definite
+  T log_det() const;
+
+  /// @brief Computes the inverse of A
+  ///
+  /// @return 0 on success, info() if A is not positive definite.
+  int inverse(Matrix<T, 2> &inv) const;
+  /// @brief The inverse of A, an empty matrix if A is not positive definite
+  Matrix<T, 2> inverse() const {
+    Matrix<T, 2> inv;
+    inverse(inv);
+    return inv;
+  }
+
+ private:
+  Matrix<T, 2> l_;
+  int info_;
+};
+
+template<typename T>
+int Cholesky<T>::factor(const Matrix<T, 2> &a) {
+  assert(a.n_rows() == a.n_cols());
+
+  l_ = a;
+  const std::size_t n = l_.n_rows();
+  info_ = (n == 0) ? 0 : lapack_potrf(l_, lapack_uplo::lower);
+
+  // potrf leaves the strict upper triangle of A as it was
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = i + 1; j != n; ++j) l_(i, j) = T(0);
+
+  return info_;
+}
+
+template<typename T>
+int Cholesky<T>::solve(const Matrix<T, 1> &b, Matrix<T, 1> &x) const {
+  assert(b.size() == n());
+  if (info_ != 0) return info_;
+
+  x = b;
+  if (n() == 0) return 0;
+  return lapack_potrs(l_, x, lapack_uplo::lower);
+}
+
+template<typename T>
+int Cholesky<T>::solve(const Matrix<T, 2> &b, Matrix<T, 2> &x) const {
+  assert(b.n_rows() == n());
+  if (info_ != 0) return info_;
+
+  x = b;
+  if (n() == 0 || b.n_cols() == 0) return 0;
+  return lapack_potrs(l_, x, lapack_uplo::lower);
+}
+
+template<typename T>
+T Cholesky<T>::det() const {
+  if (info_ != 0) return T(0);
+
+  T d = T(1);
+  for (std::size_t i = 0; i != n(); ++i) d *= l_(i, i) * l_(i, i);
+  return d;
+}
+
+template<typename T>
+T Cholesky<T>::log_det() const {
+  if (info_ != 0) return -std::numeric_limits<T>::infinity();
+
+  T d = T(0);
+  for (std::size_t i = 0; i != n(); ++i) d += std::log(l_(i, i));
+  return 2 * d;
+}
+
+template<typename T>
+int Cholesky<T>::inverse(Matrix<T, 2> &inv) const {
+  if (info_ != 0) {
+    inv.clear();
+    return info_;
+  }
+
+  inv = l_;
+  const std::size_t n = inv.n_rows();
+  if (n == 0) return 0;
+
+  const int info = lapack_potri(inv, lapack_uplo::lower);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = i + 1; j != n; ++j) inv(i, j) = inv(j, i);
+  return info;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_CHOLESKY_H_
@@ -0,0 +1,52 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file config.h
+/// @brief Selects the BLAS/LAPACK backend
+///
+/// All wrappers call the CBLAS and LAPACKE C interfaces, which are provided
+/// by one of the following backends, chosen at configure time with the
+/// MATRIX_BLAS_BACKEND CMake option:
+///
+///   + USE_MKL:   Intel(R) MKL;
+///   + USE_CBLAS: any CBLAS + LAPACKE implementation, e.g. OpenBLAS or BLIS
+///                with reference LAPACKE;
+///   + neither:   the portable kernels in builtin_blas.h and builtin_lapack.h.
+
+#ifndef SLAB_MATRIX_CONFIG_H_
+#define SLAB_MATRIX_CONFIG_H_
+
+#if defined(USE_MKL)
+
+#include "mkl.h"
+#define SLAB_BLAS_BACKEND "mkl"
+
+#elif defined(USE_CBLAS)
+
+#include <cblas.h>
+#include <lapacke.h>
+#define SLAB_BLAS_BACKEND "cblas"
+
+#else
+
+#include "slab/matrix/builtin_blas.h"
+#include "slab/matrix/builtin_lapack.h"
+#define SLAB_BLAS_BACKEND "builtin"
+#define SLAB_USE_BUILTIN_BLAS
+
+#endif
+
+#endif // SLAB_MATRIX_CONFIG_H_
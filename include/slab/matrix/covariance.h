@@ -0,0 +1,195 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file covariance.h
+/// @brief Covariance and correlation matrices
+///
+/// The rows of X are observations and its columns variables. cov() takes
+/// the column means in a first pass, then reads X by chunks of rows of about
+/// 4 MB: each chunk is centered (and scaled by the square roots of the
+/// weights) into a buffer of the workspace pool, and added to the upper
+/// triangle of the result by syrk. Neither a centered copy nor a transpose
+/// of X is made, and only half of the products are computed.
+
+#ifndef SLAB_MATRIX_COVARIANCE_H_
+#define SLAB_MATRIX_COVARIANCE_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/workspace.h"
+#include "slab/matrix/reduction.h"
+
+/// @addtogroup covariance COVARIANCE
+/// @{
+
+namespace matrix_impl {
+
+// The rows of an n x p matrix with arbitrary strides, read by chunks
+template<typename T>
+struct row_reader {
+  std::size_t n, p;
+  const T *x;
+  std::size_t rs, cs;
+
+  template<typename M>
+  explicit row_reader(const M &m)
+      : n(m.n_rows()), p(m.n_cols()), x(m.data() + m.descriptor().start),
+        rs(m.descriptor().strides[0]), cs(m.descriptor().strides[1]) {}
+
+  // the rows per chunk: about 4 MB, at least one
+  std::size_t chunk() const {
+    const std::size_t row_bytes = sizeof(T) * std::max<std::size_t>(p, 1);
+    return std::max<std::size_t>(1, (std::size_t(1) << 22) / row_bytes);
+  }
+
+  // Rows [i0, i0 + b) as a contiguous b x p array: x itself if its rows are
+  // contiguous and nothing is subtracted, otherwise z = (x - mu) * sqrt(w)
+  const T *rows(std::size_t i0, std::size_t b, T *z, const T *mu = nullptr,
+                const T *w = nullptr) const {
+    if (!mu && !w && cs == 1 && (rs == p || b == 1)) return x + i0 * rs;
+    const std::ptrdiff_t nb = b;
+#pragma omp parallel for if(b * p > 65536) schedule(static)
+    for (std::ptrdiff_t r = 0; r < nb; ++r) {
+      const T *xi = x + (i0 + r) * rs;
+      T *zi = z + r * p;
+      const T s = w ? std::sqrt(w[i0 + r]) : T(1);
+      for (std::size_t j = 0; j != p; ++j)
+        zi[j] = (mu ? xi[j * cs] - mu[j] : xi[j * cs]) * s;
+    }
+    return z;
+  }
+};
+
+// c = the p x p covariance of the rows of x, both triangles
+template<typename T>
+void covariance(const row_reader<T> &x, const T *w, double ddof, T *c) {
+  const std::size_t n = x.n, p = x.p, b = std::min(x.chunk(), n);
+  WorkspaceScope scope;
+  T *z = scope.get<T>(b * p);
+  T *part = scope.get<T>(p);
+  T *mu = scope.get<T>(p);
+  std::fill(mu, mu + p, T(0));
+
+  // the (weighted) means
+  double v1 = n, v2 = n;
+  if (w) {
+    v1 = v2 = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+      v1 += w[i];
+      v2 += double(w[i]) * w[i];
+    }
+  }
+  for (std::size_t i0 = 0; i0 < n; i0 += b) {
+    const std::size_t bi = std::min(b, n - i0);
+    const T *xi = x.rows(i0, bi, z);
+    if (w) {
+      blas_impl::gemv(CblasRowMajor, CblasTrans, bi, p, T(1), xi, p, w + i0, 1,
+                      T(1), mu, 1);
+    } else {
+      reduce_cols(bi, p, xi, p, part, sum_op(), plain_load<T>());
+      for (std::size_t j = 0; j != p; ++j) mu[j] += part[j];
+    }
+  }
+  for (std::size_t j = 0; j != p; ++j) mu[j] /= static_cast<T>(v1);
+
+  // the upper triangle of the sum of the outer products of the deviations
+  std::fill(c, c + p * p, T(0));
+  for (std::size_t i0 = 0; i0 < n; i0 += b) {
+    const std::size_t bi = std::min(b, n - i0);
+    const T *zi = x.rows(i0, bi, z, mu, w);
+    blas_impl::syrk(CblasRowMajor, CblasUpper, CblasTrans, p, bi, T(1), zi, p,
+                    T(1), c, p);
+  }
+
+  const T norm = static_cast<T>(v1 - ddof * v2 / v1);
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = i; j != p; ++j) {
+      c[i * p + j] /= norm;
+      c[j * p + i] = c[i * p + j];
+    }
+}
+
+// Scales a covariance matrix into a correlation matrix
+template<typename T>
+void to_correlation(std::size_t p, T *c) {
+  WorkspaceScope scope;
+  T *s = scope.get<T>(p);
+  for (std::size_t i = 0; i != p; ++i) s[i] = T(1) / std::sqrt(c[i * p + i]);
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = 0; j != p; ++j) c[i * p + j] *= s[i] * s[j];
+}
+
+} // namespace matrix_impl
+
+/// @brief The covariance matrix of the columns of x
+///
+/// @param x    an n x p Matrix or MatrixRef, one observation per row.
+/// @param ddof the sums of products of the deviations from the means are
+///             divided by n - ddof: 1 for the unbiased estimate, 0 for the
+///             maximum likelihood one.
+/// @return the p x p covariance matrix.
+template<typename M>
+Enable_if<Matrix_type<M>() && M::order_ == 2, Matrix<Element_type<M>, 2>>
+cov(const M &x, std::size_t ddof = 1) {
+  using T = Element_type<M>;
+  Matrix<T, 2> c(x.n_cols(), x.n_cols());
+  const T *no_weights = nullptr;
+  matrix_impl::covariance(matrix_impl::row_reader<T>(x), no_weights, ddof,
+                          c.data());
+  return c;
+}
+
+/// @brief The weighted covariance matrix of the columns of x
+///
+/// The means are weighted by w, one nonnegative weight per row, and the
+/// weighted sums of products of the deviations are divided by
+/// V1 - ddof * V2 / V1, with V1 the sum of the weights and V2 the sum of
+/// their squares. Integer weights with ddof = 0 give the covariance of the
+/// rows repeated as many times; unit weights give cov(x, ddof).
+template<typename M>
+Enable_if<Matrix_type<M>() && M::order_ == 2, Matrix<Element_type<M>, 2>>
+cov(const M &x, const Matrix<Element_type<M>, 1> &w, std::size_t ddof = 1) {
+  using T = Element_type<M>;
+  assert(w.size() == x.n_rows());
+  Matrix<T, 2> c(x.n_cols(), x.n_cols());
+  matrix_impl::covariance(matrix_impl::row_reader<T>(x), w.data(), ddof,
+                          c.data());
+  return c;
+}
+
+/// @brief The correlation matrix of the columns of x
+///
+/// A column with no variance has undefined (NaN) correlations.
+template<typename M>
+Enable_if<Matrix_type<M>() && M::order_ == 2, Matrix<Element_type<M>, 2>>
+corr(const M &x) {
+  Matrix<Element_type<M>, 2> c = cov(x, 0);
+  matrix_impl::to_correlation(c.n_rows(), c.data());
+  return c;
+}
+
+/// @brief The weighted correlation matrix of the columns of x, see cov()
+template<typename M>
+Enable_if<Matrix_type<M>() && M::order_ == 2, Matrix<Element_type<M>, 2>>
+corr(const M &x, const Matrix<Element_type<M>, 1> &w) {
+  Matrix<Element_type<M>, 2> c = cov(x, w, 0);
+  matrix_impl::to_correlation(c.n_rows(), c.data());
+  return c;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_COVARIANCE_H_
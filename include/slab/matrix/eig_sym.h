@@ -0,0 +1,165 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file eig_sym.h
+/// @brief Eigendecomposition of symmetric matrices
+///
+/// A symmetric row-major matrix is its own column-major transpose, so it is
+/// handed to LAPACK as is, the lower triangle of A being the upper triangle
+/// of the column-major array.
+
+#ifndef SLAB_MATRIX_EIG_SYM_H_
+#define SLAB_MATRIX_EIG_SYM_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/lapack_interface.h"
+
+namespace matrix_impl {
+
+// syevd on the n x n array a, which holds the eigenvectors on exit with
+// jobz = 'V'
+template<typename T>
+int syevd(char jobz, int n, T *a, T *w) {
+  static thread_local lapack_work<T> work;
+
+  WorkspaceScope scope;
+  work.fit({{0, jobz, n, 0}}, [&](T *query, int *iquery) {
+    lapack_impl::syevd(jobz, 'U', n, a, n, w, query, -1, iquery, -1);
+  });
+  return lapack_impl::syevd(jobz, 'U', n, a, n, w, work.work, work.lwork,
+                            work.iwork, work.liwork);
+}
+
+// syevr for the eigenvalues il to iu (1-based) of the n x n array a, and
+// with jobz = 'V' their eigenvectors in the n x (iu - il + 1) array z
+template<typename T>
+int syevr(char jobz, int n, T *a, int il, int iu, T *w, T *z,
+          int *isuppz) {
+  static thread_local lapack_work<T> work;
+
+  WorkspaceScope scope;
+  int found = 0;
+  work.fit({{1, jobz, n, iu - il}}, [&](T *query, int *iquery) {
+    lapack_impl::syevr(jobz, 'I', 'U', n, a, n, T(0), T(0), il, iu, T(0),
+                       &found, w, z, n, isuppz, query, -1, iquery, -1);
+  });
+  return lapack_impl::syevr(jobz, 'I', 'U', n, a, n, T(0), T(0), il, iu,
+                            T(0), &found, w, z, n, isuppz, work.work,
+                            work.lwork, work.iwork, work.liwork);
+}
+
+} // namespace matrix_impl
+
+/// @addtogroup eigen EIGENVALUES AND SINGULAR VALUES
+/// @{
+
+/// @brief Computes the eigenvalues of a symmetric matrix (syevd)
+///
+/// Only the lower triangle of a is read. The workspaces are taken from the
+/// workspace pool of the calling thread, so repeated calls with matrices of
+/// the same size do not allocate them again.
+///
+/// @param w the eigenvalues on exit, in increasing order.
+/// @return 0 on success, i > 0 if the algorithm failed to converge.
+template<typename T>
+int eig_sym(const Matrix<T, 2> &a, Matrix<T, 1> &w) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  if (w.size() != std::size_t(n)) w = Matrix<T, 1>(n);
+  if (n == 0) return 0;
+
+  WorkspaceScope scope;
+  T *scratch = scope.get<T>(a.size());
+  std::copy(a.data(), a.data() + a.size(), scratch);
+  return matrix_impl::syevd('N', n, scratch, w.data());
+}
+
+/// @brief Computes the eigenvalues and eigenvectors of a symmetric matrix
+/// (syevd)
+///
+/// @param w the eigenvalues on exit, in increasing order.
+/// @param v the orthonormal eigenvectors on exit, v.col(j) belonging to w(j).
+/// @return 0 on success, i > 0 if the algorithm failed to converge.
+template<typename T>
+int eig_sym(const Matrix<T, 2> &a, Matrix<T, 1> &w, Matrix<T, 2> &v) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  if (w.size() != std::size_t(n)) w = Matrix<T, 1>(n);
+  v = a;
+  if (n == 0) return 0;
+
+  // the eigenvectors come back as the columns of a column-major array
+  const int info = matrix_impl::syevd('V', n, v.data(), w.data());
+  for (int i = 0; i != n; ++i)
+    for (int j = i + 1; j != n; ++j) std::swap(v(i, j), v(j, i));
+  return info;
+}
+
+/// @brief Computes the k largest eigenvalues of a symmetric matrix (syevr)
+///
+/// Much cheaper than the whole decomposition when k is small.
+///
+/// @param w the k largest eigenvalues on exit, in increasing order.
+template<typename T>
+int eig_sym(const Matrix<T, 2> &a, std::size_t k, Matrix<T, 1> &w) {
+  assert(a.n_rows() == a.n_cols());
+  assert(k <= a.n_rows());
+
+  const int n = a.n_rows();
+  if (w.size() != k) w = Matrix<T, 1>(k);
+  if (k == 0) return 0;
+
+  WorkspaceScope scope;
+  T *scratch = scope.get<T>(a.size());
+  std::copy(a.data(), a.data() + a.size(), scratch);
+  return matrix_impl::syevr<T>('N', n, scratch, n - k + 1, n, w.data(),
+                               nullptr, scope.get<int>(2 * k));
+}
+
+/// @brief Computes the k largest eigenvalues of a symmetric matrix and their
+/// eigenvectors (syevr)
+///
+/// @param w the k largest eigenvalues on exit, in increasing order.
+/// @param v the n x k orthonormal eigenvectors on exit, v.col(j) belonging to
+///          w(j).
+template<typename T>
+int eig_sym(const Matrix<T, 2> &a, std::size_t k, Matrix<T, 1> &w,
+            Matrix<T, 2> &v) {
+  assert(a.n_rows() == a.n_cols());
+  assert(k <= a.n_rows());
+
+  const int n = a.n_rows();
+  if (w.size() != k) w = Matrix<T, 1>(k);
+  if (v.n_rows() != std::size_t(n) || v.n_cols() != k) v = Matrix<T, 2>(n, k);
+  if (k == 0) return 0;
+
+  WorkspaceScope scope;
+  T *scratch = scope.get<T>(a.size());
+  T *z = scope.get<T>(std::size_t(n) * k);
+  std::copy(a.data(), a.data() + a.size(), scratch);
+  const int info = matrix_impl::syevr<T>('V', n, scratch, n - k + 1, n,
+                                         w.data(), z, scope.get<int>(2 * k));
+
+  for (int i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != k; ++j) v(i, j) = z[j * n + i];
+  return info;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_EIG_SYM_H_
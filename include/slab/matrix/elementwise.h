@@ -0,0 +1,473 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file elementwise.h
+/// @brief Element-wise exp, log, sqrt, pow and tanh
+///
+/// With MKL the functions call VML (vdExp, vdLn, ...) in the accuracy mode
+/// given by a math_mode. Otherwise, high_accuracy calls the C++ library for
+/// each element, and the other modes use the kernels below: range reduction
+/// by bit manipulation and polynomial approximations, without branches,
+/// calls or conversions between integers and floating point, so that the
+/// loops over them are vectorized by the compiler. Over the whole range,
+/// subnormal numbers, infinities and NaN included, exp and log are accurate
+/// to 2 ulps and tanh to 4 (pow: see below). The float versions are
+/// computed in double precision.
+
+#ifndef SLAB_MATRIX_ELEMENTWISE_H_
+#define SLAB_MATRIX_ELEMENTWISE_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/reduction.h"
+
+/// @addtogroup elementwise ELEMENTWISE FUNCTIONS
+/// @{
+
+/// @brief The accuracy of the element-wise functions: VML_HA, VML_LA and
+/// VML_EP with MKL; the portable kernels serve both low_accuracy and
+/// enhanced_performance
+enum class math_mode { high_accuracy, low_accuracy, enhanced_performance };
+
+namespace matrix_impl {
+
+inline double from_bits(std::uint64_t u) {
+  double x;
+  std::memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+inline std::uint64_t to_bits(double x) {
+  std::uint64_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+// Adding and subtracting 1.5 * 2^52 rounds to an integer, which then sits
+// in the low bits of the sum
+constexpr double round_shifter = 6755399441055744.0;
+constexpr double ln2_hi = 6.93147180369123816490e-01;
+constexpr double ln2_lo = 1.90821492927058770002e-10;
+constexpr double log2_e = 1.44269504088896338700e+00;
+
+// 2^k for an integer k in [-1022, 1023] held in a double
+inline double exp2_int(double k) {
+  const std::uint64_t u = to_bits(k + round_shifter) - to_bits(round_shifter);
+  return from_bits((u + 1023) << 52);
+}
+
+// x = k * ln2 + r with an integer k and |r| <= ln2 / 2
+inline double reduce_ln2(double x, double &r) {
+  const double k = (x * log2_e + round_shifter) - round_shifter;
+  r = (x - k * ln2_hi) - k * ln2_lo;
+  return k;
+}
+
+// (e^r - 1) / r, Taylor to r^12, for |r| <= ln2 / 2
+inline double expm1_poly(double r) {
+  return 1 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 +
+         r * (1.0 / 720 + r * (1.0 / 5040 + r * (1.0 / 40320 +
+         r * (1.0 / 362880 + r * (1.0 / 3628800 + r * (1.0 / 39916800 +
+         r * (1.0 / 479001600 + r * (1.0 / 6227020800.0))))))))))));
+}
+
+inline double exp_kernel(double x) {
+  // beyond the clamps the result underflows to 0 or overflows to infinity
+  const double xc = x < -746.0 ? -746.0 : x > 710.0 ? 710.0 : x;
+  double r;
+  const double k = reduce_ln2(xc, r);
+  // 2^k as 2^k1 * 2^k2, so that both are normal numbers
+  const double k1 = (k * 0.5 + round_shifter) - round_shifter;
+  const double y = (1 + r * expm1_poly(r)) * exp2_int(k1) * exp2_int(k - k1);
+  return x == x ? y : x;
+}
+
+// fdlibm's log: x = 2^k * (1 + f) with 1 + f in [sqrt(2) / 2, sqrt(2)),
+// and log(1 + f) = f - f^2 / 2 + s * (f^2 / 2 + R(s^2)), s = f / (2 + f)
+inline double log_kernel(double x) {
+  constexpr double Lg1 = 6.666666666666735130e-01;
+  constexpr double Lg2 = 3.999999999940941908e-01;
+  constexpr double Lg3 = 2.857142874366239149e-01;
+  constexpr double Lg4 = 2.222219843214978396e-01;
+  constexpr double Lg5 = 1.818357216161805012e-01;
+  constexpr double Lg6 = 1.531383769920937332e-01;
+  constexpr double Lg7 = 1.479819860511658591e-01;
+  constexpr double two54 = 18014398509481984.0;
+
+  // subnormal numbers are scaled into normal ones
+  const bool sub = x < std::numeric_limits<double>::min();
+  const std::uint64_t u = to_bits(sub ? x * two54 : x);
+  double m = from_bits((u & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull);
+  const double biased = from_bits((u >> 52) | to_bits(4503599627370496.0)) -
+                        4503599627370496.0;
+  const bool high = m > 1.41421356237309504880;
+  m = high ? m * 0.5 : m;
+  const double k = biased - 1023 + (high ? 1 : 0) - (sub ? 54 : 0);
+
+  const double f = m - 1;
+  const double s = f / (2 + f);
+  const double hfsq = 0.5 * f * f;
+  const double z = s * s;
+  const double w = z * z;
+  const double t1 = w * (Lg2 + w * (Lg4 + w * Lg6));
+  const double t2 = z * (Lg1 + w * (Lg3 + w * (Lg5 + w * Lg7)));
+  const double y = k * ln2_hi - ((hfsq - (s * (hfsq + t1 + t2) + k * ln2_lo))
+                                 - f);
+
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  return x > 0 && x < inf ? y
+      : x == 0 ? -inf : x == inf ? inf : x == x ? nan : x;
+}
+
+// tanh(x) = (e^2|x| - 1) / (e^2|x| + 1) with the sign of x, from e^2|x| - 1
+// = 2^k * (e^r - 1) + (2^k - 1), without cancellation for small |x|
+inline double tanh_kernel(double x) {
+  // tanh(20) rounds to 1
+  const double ax = 2 * std::fabs(x);
+  const double y = ax > 40.0 ? 40.0 : ax;
+  double r;
+  const double k = reduce_ln2(y, r);
+  const double scale = exp2_int(k);
+  const double em1 = scale * (r * expm1_poly(r)) + (scale - 1);
+  const double t = std::copysign(em1 / (em1 + 2), x);
+  return x == x ? t : x;
+}
+
+// x^y as e^(y log x): the error grows with |y log x|, by about one ulp per
+// 2^-52 of relative error in y log x, i.e. up to some 10 bits near overflow
+inline double pow_kernel(double x, double y) {
+  const double p = exp_kernel(y * log_kernel(std::fabs(x)));
+  const bool integer = std::floor(y) == y;
+  const bool odd = integer && std::floor(y * 0.5) != y * 0.5;
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  // the signs of negative bases, which only odd powers of -0 and -inf keep,
+  // and 0 * inf in y log x for x = 1 or -1 and an infinite y
+  const bool edge = x == 0 || std::isinf(x);
+  const double s =
+      std::signbit(x) ? (odd ? -p : integer || edge ? p : nan) : p;
+  const bool one = x == 1 || (x == -1 && std::isinf(y));
+  return y == 0 || one ? 1 : s;
+}
+
+// The functions: an MKL VML call for float and double, the C++ library and
+// the kernels above
+
+struct exp_fn {
+  template<typename T>
+  static T precise(T x) { return std::exp(x); }
+  template<typename T>
+  static T fast(T x) { return static_cast<T>(exp_kernel(x)); }
+#if defined(USE_MKL)
+  static void vml(MKL_INT n, const float *a, float *y, MKL_INT64 mode) {
+    vmsExp(n, a, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, double *y, MKL_INT64 mode) {
+    vmdExp(n, a, y, mode);
+  }
+#endif
+};
+
+struct log_fn {
+  template<typename T>
+  static T precise(T x) { return std::log(x); }
+  template<typename T>
+  static T fast(T x) { return static_cast<T>(log_kernel(x)); }
+#if defined(USE_MKL)
+  static void vml(MKL_INT n, const float *a, float *y, MKL_INT64 mode) {
+    vmsLn(n, a, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, double *y, MKL_INT64 mode) {
+    vmdLn(n, a, y, mode);
+  }
+#endif
+};
+
+struct sqrt_fn {
+  template<typename T>
+  static T precise(T x) { return std::sqrt(x); }
+  template<typename T>
+  static T fast(T x) { return std::sqrt(x); }
+#if defined(USE_MKL)
+  static void vml(MKL_INT n, const float *a, float *y, MKL_INT64 mode) {
+    vmsSqrt(n, a, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, double *y, MKL_INT64 mode) {
+    vmdSqrt(n, a, y, mode);
+  }
+#endif
+};
+
+struct tanh_fn {
+  template<typename T>
+  static T precise(T x) { return std::tanh(x); }
+  template<typename T>
+  static T fast(T x) { return static_cast<T>(tanh_kernel(x)); }
+#if defined(USE_MKL)
+  static void vml(MKL_INT n, const float *a, float *y, MKL_INT64 mode) {
+    vmsTanh(n, a, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, double *y, MKL_INT64 mode) {
+    vmdTanh(n, a, y, mode);
+  }
+#endif
+};
+
+struct pow_fn {
+  template<typename T>
+  static T precise(T x, T y) { return std::pow(x, y); }
+  template<typename T>
+  static T fast(T x, T y) { return static_cast<T>(pow_kernel(x, y)); }
+#if defined(USE_MKL)
+  static void vml(MKL_INT n, const float *a, const float *b, float *y,
+                  MKL_INT64 mode) {
+    vmsPow(n, a, b, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, const double *b, double *y,
+                  MKL_INT64 mode) {
+    vmdPow(n, a, b, y, mode);
+  }
+  static void vml(MKL_INT n, const float *a, float b, float *y,
+                  MKL_INT64 mode) {
+    vmsPowx(n, a, b, y, mode);
+  }
+  static void vml(MKL_INT n, const double *a, double b, double *y,
+                  MKL_INT64 mode) {
+    vmdPowx(n, a, b, y, mode);
+  }
+#endif
+};
+
+#if defined(USE_MKL)
+inline MKL_INT64 vml_mode(math_mode mode) {
+  return mode == math_mode::high_accuracy ? VML_HA
+      : mode == math_mode::low_accuracy ? VML_LA : VML_EP;
+}
+#endif
+
+// the elements per thread below which the loops stay serial
+constexpr std::size_t elementwise_grain = 32768;
+
+// y[i] = F(a[i]); y may be a
+template<typename F, typename T>
+void map_unary(std::size_t n, const T *a, T *y, math_mode mode) {
+#if defined(USE_MKL)
+  assert(n <= static_cast<std::size_t>(std::numeric_limits<MKL_INT>::max()));
+  F::vml(static_cast<MKL_INT>(n), a, y, vml_mode(mode));
+#else
+  const std::ptrdiff_t nn = n;
+  if (mode == math_mode::high_accuracy) {
+#pragma omp parallel for if(n > elementwise_grain) schedule(static)
+    for (std::ptrdiff_t i = 0; i < nn; ++i) y[i] = F::precise(a[i]);
+  } else {
+#pragma omp parallel for simd if(n > elementwise_grain) schedule(static)
+    for (std::ptrdiff_t i = 0; i < nn; ++i) y[i] = F::fast(a[i]);
+  }
+#endif
+}
+
+// the i-th element of the second operand of a binary function
+template<typename T>
+T operand(const T *b, std::ptrdiff_t i) { return b[i]; }
+
+template<typename T>
+T operand(T b, std::ptrdiff_t) { return b; }
+
+// y[i] = F(a[i], b[i]), or F(a[i], b) for a scalar b
+template<typename F, typename T, typename B>
+void map_binary(std::size_t n, const T *a, B b, T *y, math_mode mode) {
+#if defined(USE_MKL)
+  assert(n <= static_cast<std::size_t>(std::numeric_limits<MKL_INT>::max()));
+  F::vml(static_cast<MKL_INT>(n), a, b, y, vml_mode(mode));
+#else
+  const std::ptrdiff_t nn = n;
+  if (mode == math_mode::high_accuracy) {
+#pragma omp parallel for if(n > elementwise_grain) schedule(static)
+    for (std::ptrdiff_t i = 0; i < nn; ++i)
+      y[i] = F::precise(a[i], operand(b, i));
+  } else {
+#pragma omp parallel for simd if(n > elementwise_grain) schedule(static)
+    for (std::ptrdiff_t i = 0; i < nn; ++i)
+      y[i] = F::fast(a[i], operand(b, i));
+  }
+#endif
+}
+
+// Calls f(y) with a pointer to room for the elements of m in row-major
+// order, written back if m is not contiguous
+template<typename M, typename F>
+void with_output(M &m, F f) {
+  using T = Element_type<M>;
+  if (is_contiguous(m)) {
+    f(m.data() + m.descriptor().start);
+    return;
+  }
+  Matrix<T, std::decay<M>::type::order_> tmp(m.descriptor().extents);
+  f(tmp.data());
+  m = tmp;
+}
+
+template<typename F, typename X, typename Y>
+void elementwise(const X &x, Y &y, math_mode mode) {
+  using T = Element_type<X>;
+  static_assert(std::is_floating_point<T>::value,
+                "elementwise: the elements must be float or double");
+  static_assert(Same<T, Element_type<Y>>(),
+                "elementwise: incompatible element types");
+  assert(x.descriptor().extents == y.descriptor().extents);
+  if (x.size() == 0) return;
+  with_elements(x, [&](const T *a) {
+    with_output(y, [&](T *z) { map_unary<F>(x.size(), a, z, mode); });
+  });
+}
+
+template<typename F, typename X, typename B, typename Y>
+void elementwise(const X &x, const B &b, Y &y, math_mode mode) {
+  using T = Element_type<X>;
+  static_assert(std::is_floating_point<T>::value,
+                "elementwise: the elements must be float or double");
+  static_assert(Same<T, Element_type<B>>() && Same<T, Element_type<Y>>(),
+                "elementwise: incompatible element types");
+  assert(x.descriptor().extents == b.descriptor().extents);
+  assert(x.descriptor().extents == y.descriptor().extents);
+  if (x.size() == 0) return;
+  with_elements(x, [&](const T *pa) {
+    with_elements(b, [&](const T *pb) {
+      with_output(y, [&](T *z) { map_binary<F>(x.size(), pa, pb, z, mode); });
+    });
+  });
+}
+
+template<typename F, typename X, typename Y>
+void elementwise_scalar(const X &x, Element_type<X> b, Y &y, math_mode mode) {
+  using T = Element_type<X>;
+  static_assert(std::is_floating_point<T>::value,
+                "elementwise: the elements must be float or double");
+  static_assert(Same<T, Element_type<Y>>(),
+                "elementwise: incompatible element types");
+  assert(x.descriptor().extents == y.descriptor().extents);
+  if (x.size() == 0) return;
+  with_elements(x, [&](const T *a) {
+    with_output(y, [&](T *z) { map_binary<F>(x.size(), a, b, z, mode); });
+  });
+}
+
+} // namespace matrix_impl
+
+/// @brief e^x for each element x of a Matrix or MatrixRef of float or
+/// double
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+exp(const M &x, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<M>, M::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise<matrix_impl::exp_fn>(x, y, mode);
+  return y;
+}
+
+/// @brief y = e^x element-wise, where y has the shape of x and may be x
+template<typename X, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<Y>(), void>
+exp(const X &x, Y &&y, math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise<matrix_impl::exp_fn>(x, y, mode);
+}
+
+/// @brief The natural logarithm of each element, see exp()
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+log(const M &x, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<M>, M::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise<matrix_impl::log_fn>(x, y, mode);
+  return y;
+}
+
+/// @brief y = log(x) element-wise, where y has the shape of x and may be x
+template<typename X, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<Y>(), void>
+log(const X &x, Y &&y, math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise<matrix_impl::log_fn>(x, y, mode);
+}
+
+/// @brief The square root of each element, see exp()
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+sqrt(const M &x, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<M>, M::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise<matrix_impl::sqrt_fn>(x, y, mode);
+  return y;
+}
+
+/// @brief y = sqrt(x) element-wise, where y has the shape of x and may be x
+template<typename X, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<Y>(), void>
+sqrt(const X &x, Y &&y, math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise<matrix_impl::sqrt_fn>(x, y, mode);
+}
+
+/// @brief The hyperbolic tangent of each element, see exp()
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+tanh(const M &x, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<M>, M::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise<matrix_impl::tanh_fn>(x, y, mode);
+  return y;
+}
+
+/// @brief y = tanh(x) element-wise, where y has the shape of x and may be x
+template<typename X, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<Y>(), void>
+tanh(const X &x, Y &&y, math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise<matrix_impl::tanh_fn>(x, y, mode);
+}
+
+/// @brief x^b for the elements of two matrices of the same shape
+///
+/// Without MKL, low_accuracy computes e^(b log x), with an error that grows
+/// with |b log x|; use high_accuracy for large results.
+template<typename X, typename B>
+Enable_if<Matrix_type<X>() && Matrix_type<B>(),
+          Matrix<Element_type<X>, X::order_>>
+pow(const X &x, const B &b, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<X>, X::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise<matrix_impl::pow_fn>(x, b, y, mode);
+  return y;
+}
+
+/// @brief y = x^b element-wise, where y has the shape of x and may be x
+template<typename X, typename B, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<B>() && Matrix_type<Y>(), void>
+pow(const X &x, const B &b, Y &&y, math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise<matrix_impl::pow_fn>(x, b, y, mode);
+}
+
+/// @brief x^b for each element x and a scalar b, see pow()
+template<typename X>
+Enable_if<Matrix_type<X>(), Matrix<Element_type<X>, X::order_>>
+pow(const X &x, Element_type<X> b, math_mode mode = math_mode::low_accuracy) {
+  Matrix<Element_type<X>, X::order_> y(x.descriptor().extents);
+  matrix_impl::elementwise_scalar<matrix_impl::pow_fn>(x, b, y, mode);
+  return y;
+}
+
+/// @brief y = x^b element-wise for a scalar b, see pow()
+template<typename X, typename Y>
+Enable_if<Matrix_type<X>() && Matrix_type<Y>(), void>
+pow(const X &x, Element_type<X> b, Y &&y,
+    math_mode mode = math_mode::low_accuracy) {
+  matrix_impl::elementwise_scalar<matrix_impl::pow_fn>(x, b, y, mode);
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_ELEMENTWISE_H_
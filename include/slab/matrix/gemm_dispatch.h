@@ -0,0 +1,408 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file gemm_dispatch.h
+/// @brief Size-aware selection of the GEMM strategy behind matmul()
+///
+/// The cost of a BLAS call is dominated by its dispatch overhead for tiny
+/// products, and by the choice of the number of threads for large ones. The
+/// GemmDispatcher picks a strategy from the size of the product (m * n * k
+/// multiply-adds), the element type and the thread budget, using thresholds
+/// measured by gemm_tune() and saved to a profile file:
+///
+///   + small_kernel: a kernel cached for the shape (see gemm_kernel.h);
+///   + sequential:   BLAS on the calling thread only;
+///   + threaded:     BLAS with as many threads as the product can keep busy;
+///   + batched:      independent products run concurrently, one thread each.
+///
+/// The profile is loaded on first use from $SLAB_GEMM_PROFILE, or from
+/// $HOME/.slab_gemm_profile; built-in defaults are used if there is none.
+/// The crossovers to threaded BLAS only hold for the thread budget they were
+/// measured with: under another budget, the defaults replace them.
+
+#ifndef SLAB_MATRIX_GEMM_DISPATCH_H_
+#define SLAB_MATRIX_GEMM_DISPATCH_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/gemm_kernel.h"
+
+/// @addtogroup gemm_dispatch GEMM DISPATCH
+/// @{
+
+enum class gemm_strategy {
+  small_kernel,
+  sequential,
+  threaded,
+  batched
+};
+
+/// @brief GEMM thresholds for one element type, in multiply-adds (m * n * k)
+struct GemmThresholds {
+  double small_max;        ///< largest product computed by the inline kernel
+  double sequential_max;   ///< largest product computed on a single thread
+  double work_per_thread;  ///< multiply-adds given to each thread when threaded
+};
+
+/// @brief A GEMM tuning profile
+struct GemmProfile {
+  GemmProfile()
+      : single_precision{8000, 2097152, 262144},
+        double_precision{8000, 2097152, 262144},
+        threads(0) {}
+
+  template<typename T>
+  const GemmThresholds &thresholds() const {
+    static_assert(is_float<T>::value || is_double<T>::value,
+                  "GemmProfile: float or double expected");
+    return is_double<T>::value ? double_precision : single_precision;
+  }
+
+  template<typename T>
+  GemmThresholds &thresholds() {
+    static_assert(is_float<T>::value || is_double<T>::value,
+                  "GemmProfile: float or double expected");
+    return is_double<T>::value ? double_precision : single_precision;
+  }
+
+  /// @brief Reads a profile saved by save(), returns false if it can't be read
+  bool load(const std::string &path);
+  /// @brief Writes the profile as "key value" lines
+  bool save(const std::string &path) const;
+
+  GemmThresholds single_precision;
+  GemmThresholds double_precision;
+  /// the thread budget the profile was tuned with, 0 if it applies to any
+  int threads;
+};
+
+inline bool GemmProfile::load(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) return false;
+
+  GemmProfile p;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream is(line);
+    std::string key;
+    double value;
+    if (!(is >> key >> value) || key[0] == '#') continue;
+
+    if (key == "float.small_max") p.single_precision.small_max = value;
+    else if (key == "float.sequential_max") p.single_precision.sequential_max = value;
+    else if (key == "float.work_per_thread") p.single_precision.work_per_thread = value;
+    else if (key == "double.small_max") p.double_precision.small_max = value;
+    else if (key == "double.sequential_max") p.double_precision.sequential_max = value;
+    else if (key == "double.work_per_thread") p.double_precision.work_per_thread = value;
+    else if (key == "threads") p.threads = static_cast<int>(value);
+  }
+
+  *this = p;
+  return true;
+}
+
+inline bool GemmProfile::save(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out) return false;
+
+  out << "# slab GEMM profile, written by gemm_tune()\n"
+      << "threads " << threads << '\n'
+      << "float.small_max " << single_precision.small_max << '\n'
+      << "float.sequential_max " << single_precision.sequential_max << '\n'
+      << "float.work_per_thread " << single_precision.work_per_thread << '\n'
+      << "double.small_max " << double_precision.small_max << '\n'
+      << "double.sequential_max " << double_precision.sequential_max << '\n'
+      << "double.work_per_thread " << double_precision.work_per_thread << '\n';
+  return static_cast<bool>(out);
+}
+
+/// @brief The default location of the GEMM profile: $SLAB_GEMM_PROFILE, or
+/// $HOME/.slab_gemm_profile
+inline std::string gemm_profile_path() {
+  if (const char *path = std::getenv("SLAB_GEMM_PROFILE")) return path;
+  if (const char *home = std::getenv("HOME"))
+    return std::string(home) + "/.slab_gemm_profile";
+  return std::string();
+}
+
+namespace matrix_impl {
+
+inline int max_threads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// Limits the number of threads used by BLAS calls on this thread for the
+// lifetime of the object. Generic CBLAS implementations only have a global
+// setting, so there it has no effect.
+class blas_thread_scope {
+ public:
+  explicit blas_thread_scope(int n) : prev_(0) {
+#if defined(USE_MKL)
+    prev_ = mkl_set_num_threads_local(n);
+#elif defined(SLAB_USE_BUILTIN_BLAS)
+    prev_ = builtin::num_threads();
+    builtin::num_threads() = n;
+#else
+    (void) n;
+#endif
+  }
+
+  ~blas_thread_scope() {
+#if defined(USE_MKL)
+    mkl_set_num_threads_local(prev_);
+#elif defined(SLAB_USE_BUILTIN_BLAS)
+    builtin::num_threads() = prev_;
+#endif
+  }
+
+  blas_thread_scope(const blas_thread_scope &) = delete;
+  blas_thread_scope &operator=(const blas_thread_scope &) = delete;
+
+ private:
+  int prev_;
+};
+
+} // namespace matrix_impl
+
+/// @brief Selects and runs the GEMM strategy for matmul()
+class GemmDispatcher {
+ public:
+  /// @brief The dispatcher used by matmul(), its profile is loaded from
+  /// gemm_profile_path() on first use
+  static GemmDispatcher &instance() {
+    static GemmDispatcher dispatcher(gemm_profile_path());
+    return dispatcher;
+  }
+
+  explicit GemmDispatcher(const std::string &path = std::string())
+      : budget_(0) {
+    if (!path.empty()) profile_.load(path);
+  }
+
+  const GemmProfile &profile() const { return profile_; }
+  /// @brief Replaces the profile; not to be called while products run
+  void set_profile(const GemmProfile &profile) { profile_ = profile; }
+
+  /// @brief The maximum number of threads a product may use
+  int thread_budget() const {
+    const int n = budget_.load(std::memory_order_relaxed);
+    return n > 0 ? n : matrix_impl::max_threads();
+  }
+  /// @brief Sets the thread budget, 0 for all OpenMP threads
+  void set_thread_budget(int n) { budget_.store(n, std::memory_order_relaxed); }
+
+  /// @brief Selects the strategy for batch products of size m x k by k x n
+  ///
+  /// @param threads the number of threads per product on exit.
+  template<typename T>
+  gemm_strategy select(std::size_t m, std::size_t n, std::size_t k,
+                       std::size_t batch, int &threads) const;
+
+  /// @brief C = A * B for row-major matrices
+  template<typename T>
+  void gemm(int m, int n, int k, const T *a, int lda, const T *b, int ldb,
+            T *c, int ldc) const;
+
+ private:
+  GemmProfile profile_;
+  std::atomic<int> budget_;
+};
+
+template<typename T>
+gemm_strategy GemmDispatcher::select(std::size_t m, std::size_t n,
+                                     std::size_t k, std::size_t batch,
+                                     int &threads) const {
+  GemmThresholds t = profile_.thresholds<T>();
+  const double work = double(m) * n * k;
+  const int budget = thread_budget();
+  if (profile_.threads > 0 && profile_.threads != budget) {
+    // tuned with another budget: only small_max, measured on one thread,
+    // still holds
+    const GemmThresholds defaults = GemmProfile().thresholds<T>();
+    t.sequential_max = std::max(defaults.sequential_max, t.small_max);
+    t.work_per_thread = defaults.work_per_thread;
+  }
+
+  threads = 1;
+  if (batch > 1 && budget > 1 && work <= t.sequential_max)
+    return gemm_strategy::batched;
+  if (work <= t.small_max)
+    return gemm_strategy::small_kernel;
+  if (work <= t.sequential_max || budget == 1)
+    return gemm_strategy::sequential;
+
+  threads = static_cast<int>(std::min<double>(budget, work / t.work_per_thread));
+  threads = std::max(threads, 2);
+  return gemm_strategy::threaded;
+}
+
+template<typename T>
+void GemmDispatcher::gemm(int m, int n, int k, const T *a, int lda,
+                          const T *b, int ldb, T *c, int ldc) const {
+  int threads;
+  if (select<T>(m, n, k, 1, threads) == gemm_strategy::small_kernel) {
+    gemm_kernel<T>(GemmKey(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                           m, n, k, lda, ldb, ldc))(a, b, c);
+    return;
+  }
+
+  matrix_impl::blas_thread_scope scope(threads);
+  blas_impl::gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k,
+                  T(1), a, lda, b, ldb, T(0), c, ldc);
+}
+
+/// @brief Computes the products A[i] * B[i] of a batch of matrices
+///
+/// Small products are run concurrently, one thread each, instead of one
+/// after the other with all threads.
+template<typename T>
+std::vector<Matrix<T, 2>> matmul_batch(const std::vector<Matrix<T, 2>> &a,
+                                       const std::vector<Matrix<T, 2>> &b) {
+  assert(a.size() == b.size());
+
+  const GemmDispatcher &dispatcher = GemmDispatcher::instance();
+  const int count = a.size();
+
+  std::vector<Matrix<T, 2>> c(count);
+  std::size_t m = 0, n = 0, k = 0;
+  for (int i = 0; i != count; ++i) {
+    assert(a[i].n_cols() == b[i].n_rows());
+    c[i] = Matrix<T, 2>(a[i].n_rows(), b[i].n_cols());
+    // the largest product decides for the whole batch
+    if (double(a[i].n_rows()) * b[i].n_cols() * a[i].n_cols()
+        > double(m) * n * k) {
+      m = a[i].n_rows();
+      n = b[i].n_cols();
+      k = a[i].n_cols();
+    }
+  }
+
+  auto product = [&](int i) {
+    dispatcher.gemm<T>(a[i].n_rows(), b[i].n_cols(), a[i].n_cols(),
+                       a[i].data(), a[i].n_cols(), b[i].data(), b[i].n_cols(),
+                       c[i].data(), b[i].n_cols());
+  };
+
+  int threads;
+  if (dispatcher.select<T>(m, n, k, count, threads) == gemm_strategy::batched) {
+#pragma omp parallel for schedule(dynamic) num_threads(dispatcher.thread_budget())
+    for (int i = 0; i < count; ++i) {
+      matrix_impl::blas_thread_scope scope(1);
+      product(i);
+    }
+  } else {
+    for (int i = 0; i < count; ++i) product(i);
+  }
+
+  return c;
+}
+
+namespace matrix_impl {
+
+// Best time, in seconds, of f() over runs adding up to at least 20 ms.
+template<typename F>
+double time_best(F f) {
+  using clock = std::chrono::steady_clock;
+  double best = std::numeric_limits<double>::max(), total = 0.0;
+  for (int run = 0; run < 3 || total < 0.02; ++run) {
+    const auto start = clock::now();
+    f();
+    const double t = std::chrono::duration<double>(clock::now() - start).count();
+    best = std::min(best, t);
+    total += t;
+  }
+  return best;
+}
+
+template<typename T>
+GemmThresholds tune_gemm(std::size_t max_size, int budget) {
+  static const std::size_t sizes[] = {
+      2, 4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+  };
+
+  GemmThresholds t = GemmProfile().thresholds<T>();
+  bool small_found = false, sequential_found = false;
+  double prev = 0.0;
+
+  for (std::size_t s : sizes) {
+    if (s > max_size) break;
+    const int n = s;
+    const double work = double(s) * s * s;
+
+    std::vector<T> a(s * s, T(1)), b(s * s, T(1)), c(s * s);
+    const GemmKernel<T> &kernel = gemm_kernel<T>(GemmKey(n, n, n));
+    const double t_small = time_best([&] {
+      kernel(a.data(), b.data(), c.data());
+    });
+    const double t_seq = time_best([&] {
+      blas_thread_scope scope(1);
+      blas_impl::gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                      T(1), a.data(), n, b.data(), n, T(0), c.data(), n);
+    });
+    const double t_par = time_best([&] {
+      blas_thread_scope scope(budget);
+      blas_impl::gemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                      T(1), a.data(), n, b.data(), n, T(0), c.data(), n);
+    });
+
+    // the thresholds are set at the last size before each crossover
+    if (!small_found && t_small > t_seq) {
+      t.small_max = prev;
+      small_found = true;
+    }
+    if (!sequential_found && budget > 1 && t_par < 0.9 * t_seq) {
+      t.sequential_max = prev;
+      t.work_per_thread = std::max(work / budget, 1.0);
+      sequential_found = true;
+    }
+    prev = work;
+  }
+
+  if (!small_found) t.small_max = prev;
+  if (!sequential_found) t.sequential_max = std::max(prev, t.small_max);
+  t.sequential_max = std::max(t.sequential_max, t.small_max);
+  return t;
+}
+
+} // namespace matrix_impl
+
+/// @brief Measures the GEMM thresholds of this machine
+///
+/// Times square products of sizes up to max_size with each strategy, using
+/// the thread budget of the dispatcher. The new profile is installed in
+/// GemmDispatcher::instance() and, unless path is empty, saved to path.
+inline GemmProfile gemm_tune(const std::string &path = gemm_profile_path(),
+                             std::size_t max_size = 512) {
+  GemmDispatcher &dispatcher = GemmDispatcher::instance();
+  const int budget = dispatcher.thread_budget();
+
+  GemmProfile profile;
+  profile.threads = budget;
+  profile.single_precision = matrix_impl::tune_gemm<float>(max_size, budget);
+  profile.double_precision = matrix_impl::tune_gemm<double>(max_size, budget);
+
+  dispatcher.set_profile(profile);
+  if (!path.empty()) profile.save(path);
+  return profile;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_GEMM_DISPATCH_H_
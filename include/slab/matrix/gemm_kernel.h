@@ -0,0 +1,372 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file gemm_kernel.h
+/// @brief Cached GEMM kernels for small products of a fixed shape
+///
+/// A small product spends more time in the argument checks and dispatch of
+/// cblas_?gemm than in arithmetic. A GemmKernel is built once for a shape,
+/// layout and transposition, and then only runs the product. With MKL it is
+/// generated by mkl_jit_create_?gemm; otherwise it is one of the unrolled
+/// kernels below, chosen for the shape, with the loops fully unrolled at
+/// compile time when m, n and k are all between 2 and 4. Kernels are created
+/// on first use and kept in a process-wide cache of the most recently used
+/// ones.
+
+#ifndef SLAB_MATRIX_GEMM_KERNEL_H_
+#define SLAB_MATRIX_GEMM_KERNEL_H_
+
+#include "slab/matrix/matrix.h"
+
+/// @addtogroup gemm_dispatch GEMM DISPATCH
+/// @{
+
+/// @brief What a GemmKernel computes: C = op(A) * op(B), where op(A) is m x k,
+/// op(B) is k x n, and A, B and C have the given leading dimensions
+struct GemmKey {
+  GemmKey() = default;
+
+  /// @brief The key of a product of packed, non-transposed row-major matrices
+  GemmKey(int m, int n, int k)
+      : layout(CblasRowMajor), transa(CblasNoTrans), transb(CblasNoTrans),
+        m(m), n(n), k(k), lda(k), ldb(n), ldc(n) {}
+
+  GemmKey(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE transa, CBLAS_TRANSPOSE transb,
+          int m, int n, int k, int lda, int ldb, int ldc)
+      : layout(layout), transa(transa), transb(transb),
+        m(m), n(n), k(k), lda(lda), ldb(ldb), ldc(ldc) {}
+
+  bool operator==(const GemmKey &x) const { return tie() == x.tie(); }
+  bool operator!=(const GemmKey &x) const { return !(*this == x); }
+  bool operator<(const GemmKey &x) const { return tie() < x.tie(); }
+
+  CBLAS_LAYOUT layout;
+  CBLAS_TRANSPOSE transa;
+  CBLAS_TRANSPOSE transb;
+  int m, n, k;
+  int lda, ldb, ldc;
+
+ private:
+  std::tuple<int, int, int, int, int, int, int, int, int> tie() const {
+    return std::make_tuple(int(layout), int(transa), int(transb),
+                           m, n, k, lda, ldb, ldc);
+  }
+};
+
+template<typename T>
+class GemmKernel;
+
+namespace matrix_impl {
+
+// The (row, column) strides of op(X) for a matrix X with leading dimension ld
+inline std::pair<std::ptrdiff_t, std::ptrdiff_t>
+gemm_strides(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans, int ld) {
+  const bool row_major = (layout == CblasRowMajor);
+  const bool notrans = (trans == CblasNoTrans);
+  if (row_major == notrans) return std::make_pair(std::ptrdiff_t(ld), std::ptrdiff_t(1));
+  return std::make_pair(std::ptrdiff_t(1), std::ptrdiff_t(ld));
+}
+
+// C = op(A) * op(B), computed by blocks of NB columns of C held in registers.
+// Contiguous rows of op(B) and C (UnitCols) are a compile-time case so that
+// the inner loops vectorize.
+template<typename T, int NB, bool UnitCols>
+void unrolled_gemm(const GemmKernel<T> &kernel, const T *a, const T *b, T *c) {
+  const int m = kernel.key().m, n = kernel.key().n, k = kernel.key().k;
+  const std::ptrdiff_t ars = kernel.a_strides().first;
+  const std::ptrdiff_t acs = kernel.a_strides().second;
+  const std::ptrdiff_t brs = kernel.b_strides().first;
+  const std::ptrdiff_t bcs = UnitCols ? 1 : kernel.b_strides().second;
+  const std::ptrdiff_t crs = kernel.c_strides().first;
+  const std::ptrdiff_t ccs = UnitCols ? 1 : kernel.c_strides().second;
+  const int nb = n - n % NB;
+
+  for (int i = 0; i < m; ++i) {
+    const T *ai = a + i * ars;
+    T *ci = c + i * crs;
+
+    for (int j = 0; j < nb; j += NB) {
+      T acc[NB] = {};
+      for (int p = 0; p < k; ++p) {
+        const T aip = ai[p * acs];
+        const T *bp = b + p * brs + j * bcs;
+        for (int jj = 0; jj < NB; ++jj) acc[jj] += aip * bp[jj * bcs];
+      }
+      for (int jj = 0; jj < NB; ++jj) ci[(j + jj) * ccs] = acc[jj];
+    }
+
+    for (int j = nb; j < n; ++j) {
+      T acc = T(0);
+      for (int p = 0; p < k; ++p) acc += ai[p * acs] * b[p * brs + j * bcs];
+      ci[j * ccs] = acc;
+    }
+  }
+}
+
+// C = op(A) * op(B) for a compile-time shape, in the order of the sums of
+// unrolled_gemm()
+template<typename T, int M, int N, int K>
+void fixed_gemm(const GemmKernel<T> &kernel, const T *a, const T *b, T *c) {
+  const std::ptrdiff_t ars = kernel.a_strides().first;
+  const std::ptrdiff_t acs = kernel.a_strides().second;
+  const std::ptrdiff_t brs = kernel.b_strides().first;
+  const std::ptrdiff_t bcs = kernel.b_strides().second;
+  const std::ptrdiff_t crs = kernel.c_strides().first;
+  const std::ptrdiff_t ccs = kernel.c_strides().second;
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < N; ++j) {
+      T acc = T(0);
+      for (int p = 0; p < K; ++p)
+        acc += a[i * ars + p * acs] * b[p * brs + j * bcs];
+      c[i * crs + j * ccs] = acc;
+    }
+}
+
+template<typename T>
+using gemm_fn = void (*)(const GemmKernel<T> &, const T *, const T *, T *);
+
+// The fixed_gemm() for m x n x k, nullptr outside of 2 to 4
+template<typename T, int M, int N>
+gemm_fn<T> fixed_gemm_k(int k) {
+  switch (k) {
+    case 2: return fixed_gemm<T, M, N, 2>;
+    case 3: return fixed_gemm<T, M, N, 3>;
+    case 4: return fixed_gemm<T, M, N, 4>;
+    default: return nullptr;
+  }
+}
+
+template<typename T, int M>
+gemm_fn<T> fixed_gemm_n(int n, int k) {
+  switch (n) {
+    case 2: return fixed_gemm_k<T, M, 2>(k);
+    case 3: return fixed_gemm_k<T, M, 3>(k);
+    case 4: return fixed_gemm_k<T, M, 4>(k);
+    default: return nullptr;
+  }
+}
+
+template<typename T>
+gemm_fn<T> fixed_gemm_for(int m, int n, int k) {
+  switch (m) {
+    case 2: return fixed_gemm_n<T, 2>(n, k);
+    case 3: return fixed_gemm_n<T, 3>(n, k);
+    case 4: return fixed_gemm_n<T, 4>(n, k);
+    default: return nullptr;
+  }
+}
+
+#ifdef USE_MKL
+inline void *jit_create(const GemmKey &key, float) {
+  void *jitter = nullptr;
+  const mkl_jit_status_t status = mkl_jit_create_sgemm(
+      &jitter, static_cast<MKL_LAYOUT>(key.layout),
+      static_cast<MKL_TRANSPOSE>(key.transa),
+      static_cast<MKL_TRANSPOSE>(key.transb),
+      key.m, key.n, key.k, 1.0f, key.lda, key.ldb, 0.0f, key.ldc);
+  return status == MKL_JIT_ERROR ? nullptr : jitter;
+}
+
+inline void *jit_create(const GemmKey &key, double) {
+  void *jitter = nullptr;
+  const mkl_jit_status_t status = mkl_jit_create_dgemm(
+      &jitter, static_cast<MKL_LAYOUT>(key.layout),
+      static_cast<MKL_TRANSPOSE>(key.transa),
+      static_cast<MKL_TRANSPOSE>(key.transb),
+      key.m, key.n, key.k, 1.0, key.lda, key.ldb, 0.0, key.ldc);
+  return status == MKL_JIT_ERROR ? nullptr : jitter;
+}
+
+inline void jit_run(void *jitter, const float *a, const float *b, float *c) {
+  mkl_jit_get_sgemm_ptr(jitter)(jitter, const_cast<float *>(a),
+                                const_cast<float *>(b), c);
+}
+
+inline void jit_run(void *jitter, const double *a, const double *b, double *c) {
+  mkl_jit_get_dgemm_ptr(jitter)(jitter, const_cast<double *>(a),
+                                const_cast<double *>(b), c);
+}
+#endif
+
+} // namespace matrix_impl
+
+/// @brief A GEMM kernel specialized for one GemmKey
+///
+/// Kernels are not copyable; they are obtained from gemm_kernel(), which
+/// shares them through a GemmKernelCache.
+template<typename T>
+class GemmKernel {
+ public:
+  static_assert(is_float<T>::value || is_double<T>::value,
+                "GemmKernel: float or double expected");
+
+  explicit GemmKernel(const GemmKey &key);
+  ~GemmKernel();
+
+  GemmKernel(const GemmKernel &) = delete;
+  GemmKernel &operator=(const GemmKernel &) = delete;
+
+  /// @brief C = op(A) * op(B)
+  void operator()(const T *a, const T *b, T *c) const {
+#ifdef USE_MKL
+    if (jitter_) {
+      matrix_impl::jit_run(jitter_, a, b, c);
+      return;
+    }
+#endif
+    run_(*this, a, b, c);
+  }
+
+  const GemmKey &key() const { return key_; }
+  /// @brief True if the kernel was generated by MKL
+  bool jitted() const { return jitter_ != nullptr; }
+
+  const std::pair<std::ptrdiff_t, std::ptrdiff_t> &a_strides() const { return as_; }
+  const std::pair<std::ptrdiff_t, std::ptrdiff_t> &b_strides() const { return bs_; }
+  const std::pair<std::ptrdiff_t, std::ptrdiff_t> &c_strides() const { return cs_; }
+
+ private:
+  GemmKey key_;
+  void *jitter_;
+  void (*run_)(const GemmKernel &, const T *, const T *, T *);
+  std::pair<std::ptrdiff_t, std::ptrdiff_t> as_, bs_, cs_;
+};
+
+template<typename T>
+GemmKernel<T>::GemmKernel(const GemmKey &key)
+    : key_(key), jitter_(nullptr), run_(nullptr),
+      as_(matrix_impl::gemm_strides(key.layout, key.transa, key.lda)),
+      bs_(matrix_impl::gemm_strides(key.layout, key.transb, key.ldb)),
+      cs_(matrix_impl::gemm_strides(key.layout, CblasNoTrans, key.ldc)) {
+#ifdef USE_MKL
+  jitter_ = matrix_impl::jit_create(key, T());
+#endif
+
+  run_ = matrix_impl::fixed_gemm_for<T>(key.m, key.n, key.k);
+  if (run_) return;
+
+  // the register block is as wide as the rows of C allow
+  const bool unit = (bs_.second == 1 && cs_.second == 1);
+  if (key.n % 8 == 0)
+    run_ = unit ? matrix_impl::unrolled_gemm<T, 8, true>
+                : matrix_impl::unrolled_gemm<T, 8, false>;
+  else
+    run_ = unit ? matrix_impl::unrolled_gemm<T, 4, true>
+                : matrix_impl::unrolled_gemm<T, 4, false>;
+}
+
+template<typename T>
+GemmKernel<T>::~GemmKernel() {
+#ifdef USE_MKL
+  if (jitter_) mkl_jit_destroy(jitter_);
+#endif
+}
+
+/// @brief The process-wide cache of GEMM kernels
+///
+/// At most capacity() kernels are kept, the least recently created or
+/// looked up being dropped first. A dropped kernel lives on as long as a
+/// shared_ptr to it is held, such as the one returned by get().
+template<typename T>
+class GemmKernelCache {
+ public:
+  static constexpr std::size_t default_capacity = 128;
+
+  static GemmKernelCache &instance() {
+    static GemmKernelCache cache;
+    return cache;
+  }
+
+  /// @brief The kernel for key, created on first use. Thread-safe.
+  std::shared_ptr<const GemmKernel<T>> get(const GemmKey &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+    lru_.emplace_front(key, std::make_shared<GemmKernel<T>>(key));
+    index_.emplace(key, lru_.begin());
+    evict();
+    return lru_.front().second;
+  }
+
+  /// @brief The number of kernels held
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+  }
+
+  std::size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+  }
+
+  /// @brief Sets the maximum number of kernels held, at least 1
+  void set_capacity(std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<std::size_t>(capacity, 1);
+    evict();
+  }
+
+ private:
+  using entry = std::pair<GemmKey, std::shared_ptr<const GemmKernel<T>>>;
+
+  GemmKernelCache() = default;
+
+  void evict() {
+    while (lru_.size() > capacity_) {
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+  mutable std::mutex mutex_;
+  std::size_t capacity_ = default_capacity;
+  std::list<entry> lru_;  // most recently used first
+  std::map<GemmKey, typename std::list<entry>::iterator> index_;
+};
+
+template<typename T>
+constexpr std::size_t GemmKernelCache<T>::default_capacity;
+
+/// @brief The cached kernel for key
+///
+/// The last four kernels used by a thread are looked up without locking, and
+/// held by the thread: the reference stays valid until the thread has looked
+/// up four other kernels. Use GemmKernelCache::get() to hold a kernel longer.
+template<typename T>
+const GemmKernel<T> &gemm_kernel(const GemmKey &key) {
+  struct entry {
+    GemmKey key;
+    std::shared_ptr<const GemmKernel<T>> kernel;
+  };
+  static thread_local entry recent[4];
+  static thread_local int next = 0;
+
+  for (const entry &e : recent)
+    if (e.kernel && e.key == key) return *e.kernel;
+
+  entry &e = recent[next];
+  e.kernel = GemmKernelCache<T>::instance().get(key);
+  e.key = key;
+  next = (next + 1) % 4;
+  return *e.kernel;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_GEMM_KERNEL_H_
@@ -0,0 +1,242 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file histogram.h
+/// @brief Histograms with fixed or adaptive bins
+///
+/// The bins are given by increasing edges e_0 < ... < e_b: bin i holds the
+/// values in [e_i, e_i+1), and the last bin also e_b. Values outside of
+/// [e_0, e_b] and NaN are not counted. The bin of a value is computed
+/// directly for uniform edges, and found by binary search otherwise.
+/// histogram_edges() chooses edges from the data: uniform between the
+/// extremes, at quantiles (equal frequencies), or of the width of the
+/// Freedman-Diaconis rule.
+
+#ifndef SLAB_MATRIX_HISTOGRAM_H_
+#define SLAB_MATRIX_HISTOGRAM_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/reduction.h"
+#include "slab/matrix/sort.h"
+#include "slab/matrix/quantile.h"
+
+/// @addtogroup quantile QUANTILES
+/// @{
+
+/// @brief The counts of the values in the bins between edges
+template<typename T>
+struct Histogram {
+  Matrix<T, 1> edges;
+  Matrix<std::size_t, 1> counts;
+};
+
+/// @brief How histogram_edges() chooses the bins
+enum class bin_rule { uniform, equal_frequency, freedman_diaconis };
+
+namespace matrix_impl {
+
+// The bin of a value among bins + 1 edges, or bins if there is none
+template<typename T>
+struct bin_finder {
+  const T *edges;
+  std::size_t bins;
+  bool uniform;
+
+  std::size_t operator()(const T &v) const {
+    const T lo = edges[0], hi = edges[bins];
+    if (!(v >= lo && v <= hi)) return bins;
+    if (v == hi) return bins - 1;
+    if (!uniform)
+      return std::upper_bound(edges, edges + bins + 1, v) - edges - 1;
+    // in double, which also keeps integer values from dividing to 0
+    std::size_t i = static_cast<std::size_t>(
+        (double(v) - double(lo)) / (double(hi) - double(lo)) * bins);
+    // rounding may miss by one
+    if (i >= bins) i = bins - 1;
+    if (v < edges[i]) --i;
+    else if (i + 1 < bins && v >= edges[i + 1]) ++i;
+    return i;
+  }
+};
+
+// bins + 1 increasing edges; integer edges are rounded down, and need a
+// range of at least bins values
+template<typename T>
+Matrix<T, 1> uniform_edges(T lo, T hi, std::size_t bins) {
+  assert(bins > 0 && lo < hi);
+  Matrix<T, 1> edges(bins + 1);
+  for (std::size_t i = 0; i != bins; ++i)
+    edges(i) = static_cast<T>(lo + (double(hi) - double(lo)) * i / bins);
+  edges(bins) = hi;
+  assert(std::adjacent_find(edges.begin(), edges.end()) == edges.end());
+  return edges;
+}
+
+// The counts of the elements of m, summed over the threads
+template<typename M>
+Matrix<std::size_t, 1> count_all(const M &m,
+                                 const bin_finder<Element_type<M>> &bin) {
+  using T = Element_type<M>;
+  const std::size_t axis = M::order_ - 1;
+  const std::size_t len = m.descriptor().extents[axis];
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = line_offsets(m.descriptor(), axis);
+  const T *x = m.data();
+  const std::size_t bins = bin.bins;
+  Matrix<std::size_t, 1> counts(bins);
+  std::fill(counts.begin(), counts.end(), std::size_t(0));
+  const std::ptrdiff_t nl = xo.size();
+#pragma omp parallel if(m.size() > 65536)
+  {
+    std::vector<std::size_t> local(bins + 1, 0);
+#pragma omp for schedule(static)
+    for (std::ptrdiff_t l = 0; l < nl; ++l)
+      for (std::size_t i = 0; i != len; ++i) ++local[bin(x[xo[l] + i * xs])];
+#pragma omp critical
+    for (std::size_t b = 0; b != bins; ++b) counts(b) += local[b];
+  }
+  return counts;
+}
+
+} // namespace matrix_impl
+
+/// @brief The histogram of the elements of x with the given edges
+///
+/// @param edges at least 2 increasing edges.
+template<typename M>
+Enable_if<Matrix_type<M>(), Histogram<Element_type<M>>>
+histogram(const M &x, const Matrix<Element_type<M>, 1> &edges) {
+  assert(edges.size() >= 2);
+  assert(std::is_sorted(edges.begin(), edges.end()));
+  const matrix_impl::bin_finder<Element_type<M>> bin{
+      edges.data(), edges.size() - 1, false};
+  return {edges, matrix_impl::count_all(x, bin)};
+}
+
+/// @brief The histogram of the elements of x in bins of equal width
+/// between lo and hi
+template<typename M>
+Enable_if<Matrix_type<M>(), Histogram<Element_type<M>>>
+histogram(const M &x, std::size_t bins, Element_type<M> lo,
+          Element_type<M> hi) {
+  Matrix<Element_type<M>, 1> edges = matrix_impl::uniform_edges(lo, hi, bins);
+  const matrix_impl::bin_finder<Element_type<M>> bin{edges.data(), bins, true};
+  Matrix<std::size_t, 1> counts = matrix_impl::count_all(x, bin);
+  return {std::move(edges), std::move(counts)};
+}
+
+/// @brief The histograms of the lines of m along axis, e.g. of the columns
+/// of a matrix for axis 0, with common edges
+///
+/// @return the counts, of the extents of m except the number of bins along
+///         axis.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<std::size_t, M::order_>>
+histogram(const M &m, const Matrix<Element_type<M>, 1> &edges,
+          std::size_t axis) {
+  using T = Element_type<M>;
+  assert(axis < M::order_);
+  assert(edges.size() >= 2);
+  assert(std::is_sorted(edges.begin(), edges.end()));
+  const std::size_t bins = edges.size() - 1;
+  std::array<std::size_t, M::order_> exts = m.descriptor().extents;
+  const std::size_t len = exts[axis];
+  exts[axis] = bins;
+  Matrix<std::size_t, M::order_> res(exts);
+  std::fill(res.begin(), res.end(), std::size_t(0));
+  if (res.size() == 0) return res;
+
+  const matrix_impl::bin_finder<T> bin{edges.data(), bins, false};
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t ys = res.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::vector<std::size_t> yo = matrix_impl::line_offsets(
+      res.descriptor(), axis);
+  const T *x = m.data();
+  std::size_t *y = res.data();
+  matrix_impl::for_lines(xo.size(), len, [&](std::size_t l) {
+    for (std::size_t i = 0; i != len; ++i) {
+      const std::size_t b = bin(x[xo[l] + i * xs]);
+      if (b != bins) ++y[yo[l] + b * ys];
+    }
+  });
+  return res;
+}
+
+/// @brief Edges for a histogram of the elements of x
+///
+/// @param rule uniform: bins of equal width between the extremes;
+///             equal_frequency: at the i / bins quantiles, merged where
+///             they are equal; freedman_diaconis: bins of width
+///             2 IQR / n^(1/3) between the extremes, whatever bins,
+///             but at most n bins.
+/// NaN is ignored. A range of a single value is widened by 0.5 on both
+/// sides.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, 1>>
+histogram_edges(const M &x, bin_rule rule, std::size_t bins = 10) {
+  using T = Element_type<M>;
+  static_assert(std::is_floating_point<T>::value,
+                "histogram_edges: the elements must be float or double");
+  assert(bins > 0);
+  // min() and max() skip NaN, which is not counted; lo > hi without values
+  T lo = min(x), hi = max(x);
+  if (!(lo < hi)) {
+    lo = lo <= hi ? lo : T(0);
+    return matrix_impl::uniform_edges<T>(lo - T(0.5), lo + T(0.5), bins);
+  }
+  if (rule == bin_rule::uniform)
+    return matrix_impl::uniform_edges(lo, hi, bins);
+
+  // the values other than NaN
+  Matrix<T, 1> all(x.size());
+  std::size_t n = 0;
+  matrix_impl::with_elements(x, [&](const T *p) {
+    for (std::size_t i = 0; i != all.size(); ++i)
+      if (!std::isnan(p[i])) all(n++) = p[i];
+  });
+  if (n != all.size()) {
+    Matrix<T, 1> values(n);
+    std::copy(all.begin(), all.begin() + n, values.begin());
+    all = std::move(values);
+  }
+  if (rule == bin_rule::equal_frequency) {
+    Matrix<double, 1> qs(bins + 1);
+    for (std::size_t i = 0; i <= bins; ++i) qs(i) = double(i) / bins;
+    Matrix<T, 1> edges = quantile(all, qs, 0);
+    const std::size_t m = std::unique(edges.begin(), edges.end()) -
+                          edges.begin();
+    if (m == edges.size()) return edges;
+    Matrix<T, 1> distinct(m);
+    std::copy(edges.begin(), edges.begin() + m, distinct.begin());
+    return distinct;
+  }
+
+  Matrix<double, 1> quartiles = {0.25, 0.75};
+  const Matrix<T, 1> iq = quantile(all, quartiles, 0);
+  const double width = 2 * (iq(1) - iq(0)) / std::cbrt(double(n));
+  // at most one bin per value, as an outlier may be far from a narrow IQR
+  const std::size_t fd = width > 0
+      ? static_cast<std::size_t>(
+            std::min(std::ceil((hi - lo) / width), double(n)))
+      : static_cast<std::size_t>(std::ceil(std::log2(double(n)))) + 1;
+  return matrix_impl::uniform_edges(lo, hi, std::max<std::size_t>(fd, 1));
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_HISTOGRAM_H_
@@ -0,0 +1,247 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file indexing.h
+/// @brief Gather and scatter by index vectors
+///
+/// take() gathers the slabs of a matrix at a list of indices along an axis,
+/// e.g. rows for a bootstrap sample or a mini-batch; put() and
+/// scatter_add() store or accumulate slabs at such indices. An index may
+/// repeat.
+///
+/// Along a leading axis a slab is a set of lines along the last axis,
+/// copied whole (one block per row of a row-major matrix). The source of
+/// the next index is prefetched while a line is copied, and take() copies
+/// in parallel over the indices. The scatters are parallel over ranges of
+/// target indices, each thread going through the indices in order, so that
+/// repeated indices are handled as in a serial loop: put() stores the last
+/// value, scatter_add() the sum of all. Along the last axis, the lines of
+/// the matrix are processed in parallel.
+
+#ifndef SLAB_MATRIX_INDEXING_H_
+#define SLAB_MATRIX_INDEXING_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/sort.h"
+
+/// @addtogroup indexing INDEXING
+/// @{
+
+namespace matrix_impl {
+
+// The elements of an index vector, which must be less than extent
+template<typename I>
+std::vector<std::size_t> index_list(const I &indices, std::size_t extent) {
+  static_assert(std::is_integral<Element_type<I>>::value,
+                "the indices must be integers");
+  const MatrixSlice<1> &d = indices.descriptor();
+  std::vector<std::size_t> idx(d.extents[0]);
+  for (std::size_t k = 0; k != idx.size(); ++k) {
+    const auto i = indices.data()[d.start + k * d.strides[0]];
+    assert(i >= 0 && static_cast<std::size_t>(i) < extent);
+    idx[k] = static_cast<std::size_t>(i);
+  }
+  (void) extent;
+  return idx;
+}
+
+// The offsets of the lines along the last axis of the slab at index 0
+// along axis of d
+template<std::size_t N>
+std::vector<std::size_t> slab_lines(MatrixSlice<N> d, std::size_t axis) {
+  d.extents[axis] = 1;
+  return line_offsets(d, N - 1);
+}
+
+template<typename T>
+inline void prefetch(const T *p) {
+#if defined(__GNUC__)
+  __builtin_prefetch(p);
+#else
+  (void) p;
+#endif
+}
+
+// f(y[i * ys], x[i * xs]), i < len
+template<typename T, typename U, typename F>
+inline void copy_line(T *y, std::size_t ys, const U *x, std::size_t xs,
+                      std::size_t len, F f) {
+  if (xs == 1 && ys == 1) {
+    for (std::size_t i = 0; i != len; ++i) f(y[i], x[i]);
+  } else {
+    for (std::size_t i = 0; i != len; ++i) f(y[i * ys], x[i * xs]);
+  }
+}
+
+struct assign_op {
+  template<typename T, typename U>
+  void operator()(T &y, const U &x) const { y = x; }
+};
+
+struct add_op {
+  template<typename T, typename U>
+  void operator()(T &y, const U &x) const { y += x; }
+};
+
+// f(m at idx[k], values at k) for the slabs along axis
+template<typename M, typename V, typename F>
+void scatter(M &m, const std::vector<std::size_t> &idx, const V &values,
+             std::size_t axis, F f) {
+  constexpr std::size_t N = M::order_;
+  const MatrixSlice<N> &d = m.descriptor();
+  const MatrixSlice<N> &vd = values.descriptor();
+  const std::size_t n = idx.size();
+  Value_type<M> *y = m.data();
+  const Value_type<V> *x = values.data();
+  const std::size_t ms = d.strides[axis], vs = vd.strides[axis];
+  const bool parallel = vd.size > 32768;
+
+  if (axis == N - 1) {
+    const std::vector<std::size_t> yo = line_offsets(d, axis);
+    const std::vector<std::size_t> xo = line_offsets(vd, axis);
+    for_lines(yo.size(), n, [&](std::size_t l) {
+      for (std::size_t k = 0; k != n; ++k)
+        f(y[yo[l] + idx[k] * ms], x[xo[l] + k * vs]);
+    });
+    return;
+  }
+
+  const std::size_t len = d.extents[N - 1];
+  const std::size_t ys = d.strides[N - 1], xs = vd.strides[N - 1];
+  const std::vector<std::size_t> yo = slab_lines(d, axis);
+  const std::vector<std::size_t> xo = slab_lines(vd, axis);
+  const std::size_t extent = d.extents[axis];
+#pragma omp parallel if(parallel)
+  {
+#ifdef _OPENMP
+    const std::size_t t = omp_get_thread_num(), nt = omp_get_num_threads();
+#else
+    const std::size_t t = 0, nt = 1;
+#endif
+    // the targets of this thread
+    const std::size_t i0 = extent * t / nt, i1 = extent * (t + 1) / nt;
+    for (std::size_t k = 0; k != n; ++k) {
+      if (idx[k] < i0 || idx[k] >= i1) continue;
+      for (std::size_t l = 0; l != yo.size(); ++l)
+        copy_line(y + yo[l] + idx[k] * ms, ys, x + xo[l] + k * vs, xs, len, f);
+    }
+  }
+}
+
+template<typename M>
+void check_slabs(const M &m, std::size_t n, const MatrixSlice<M::order_> &d,
+                 std::size_t axis) {
+  for (std::size_t k = 0; k != M::order_; ++k)
+    assert(d.extents[k] == (k == axis ? n : m.descriptor().extents[k]));
+  (void) m;
+  (void) n;
+  (void) d;
+  (void) axis;
+}
+
+} // namespace matrix_impl
+
+/// @brief The slabs of m at the given indices along axis, e.g. rows of a
+/// matrix for axis 0
+///
+/// @param indices a vector of integers in [0, m.extent(axis)), in any order
+///                and possibly repeated, e.g. a uvec or a Matrix<int, 1>.
+/// @return the matrix of the extents of m except indices.size() along
+///         axis, whose slab k is the slab indices(k) of m.
+template<typename M, typename I>
+Enable_if<Matrix_type<M>() && Vector_type<I>(),
+          Matrix<Element_type<M>, M::order_>>
+take(const M &m, const I &indices, std::size_t axis = 0) {
+  using T = Element_type<M>;
+  constexpr std::size_t N = M::order_;
+  assert(axis < N);
+  const MatrixSlice<N> &d = m.descriptor();
+  const std::vector<std::size_t> idx =
+      matrix_impl::index_list(indices, d.extents[axis]);
+  const std::size_t n = idx.size();
+  std::array<std::size_t, N> exts = d.extents;
+  exts[axis] = n;
+  Matrix<T, N> res(exts);
+  if (res.size() == 0) return res;
+
+  const MatrixSlice<N> &rd = res.descriptor();
+  const T *x = m.data();
+  T *y = res.data();
+  const std::size_t ms = d.strides[axis], rs = rd.strides[axis];
+  if (axis == N - 1) {
+    const std::vector<std::size_t> xo = matrix_impl::line_offsets(d, axis);
+    const std::vector<std::size_t> yo = matrix_impl::line_offsets(rd, axis);
+    matrix_impl::for_lines(xo.size(), n, [&](std::size_t l) {
+      for (std::size_t k = 0; k != n; ++k)
+        y[yo[l] + k * rs] = x[xo[l] + idx[k] * ms];
+    });
+    return res;
+  }
+
+  // a line along the last axis of each slab at a time
+  const std::size_t len = d.extents[N - 1], xs = d.strides[N - 1];
+  const std::vector<std::size_t> xo = matrix_impl::slab_lines(d, axis);
+  const std::vector<std::size_t> yo = matrix_impl::slab_lines(rd, axis);
+  const std::size_t nl = xo.size();
+  const std::ptrdiff_t count = n * nl;
+#pragma omp parallel for schedule(static) if(res.size() > 32768)
+  for (std::ptrdiff_t w = 0; w < count; ++w) {
+    const std::size_t k = w / nl, l = w % nl;
+    if (l == 0 && k + 1 < n) matrix_impl::prefetch(x + xo[0] + idx[k + 1] * ms);
+    const T *src = x + xo[l] + idx[k] * ms;
+    T *dst = y + yo[l] + k * rs;
+    if (xs == 1)
+      std::copy(src, src + len, dst);
+    else
+      matrix_impl::copy_line(dst, 1, src, xs, len, matrix_impl::assign_op());
+  }
+  return res;
+}
+
+/// @brief Stores the slabs of values into m at the given indices along
+/// axis, the inverse of take()
+///
+/// @param values of the extents of m except indices.size() along axis.
+/// For a repeated index, the last of its slabs is stored.
+template<typename M, typename I, typename V>
+Enable_if<Matrix_type<M>() && Vector_type<I>() && Matrix_type<V>(), void>
+put(M &&m, const I &indices, const V &values, std::size_t axis = 0) {
+  assert(axis < std::decay<M>::type::order_);
+  const std::vector<std::size_t> idx =
+      matrix_impl::index_list(indices, m.descriptor().extents[axis]);
+  matrix_impl::check_slabs(m, idx.size(), values.descriptor(), axis);
+  if (values.size() == 0) return;
+  matrix_impl::scatter(m, idx, values, axis, matrix_impl::assign_op());
+}
+
+/// @brief Adds the slabs of values to the slabs of m at the given indices
+/// along axis, e.g. gradients to the rows of an embedding
+///
+/// The slabs of a repeated index are all added, in order.
+template<typename M, typename I, typename V>
+Enable_if<Matrix_type<M>() && Vector_type<I>() && Matrix_type<V>(), void>
+scatter_add(M &&m, const I &indices, const V &values, std::size_t axis = 0) {
+  assert(axis < std::decay<M>::type::order_);
+  const std::vector<std::size_t> idx =
+      matrix_impl::index_list(indices, m.descriptor().extents[axis]);
+  matrix_impl::check_slabs(m, idx.size(), values.descriptor(), axis);
+  if (values.size() == 0) return;
+  matrix_impl::scatter(m, idx, values, axis, matrix_impl::add_op());
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_INDEXING_H_
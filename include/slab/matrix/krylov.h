@@ -0,0 +1,486 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file krylov.h
+/// @brief Iterative Krylov solvers: CG, BiCGSTAB and restarted GMRES
+///
+/// The solvers only need the products y = A * x, so A is a linear operator:
+/// a dense Matrix or MatrixRef, a SparseMatrix, a BandMatrix, or any
+/// callable f(x, y) that sets y = A * x for vectors of the same size. A
+/// preconditioner is an operator of the same kind applying M^-1, such as
+/// JacobiPreconditioner or IncompleteCholesky. The vectors of a solve are
+/// allocated once at its start and updated with the BLAS level 1 wrappers.
+
+#ifndef SLAB_MATRIX_KRYLOV_H_
+#define SLAB_MATRIX_KRYLOV_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/band_matrix.h"
+#include "slab/matrix/sparse_matrix.h"
+
+/// @addtogroup krylov KRYLOV SOLVERS
+/// @{
+
+/// @brief The stopping criteria of the Krylov solvers
+struct KrylovOptions {
+  /// stop when the residual |b - A * x| is at most tol * |b|
+  double tol = 1e-8;
+  /// most iterations, i.e. products by A (two per BiCGSTAB iteration)
+  int max_iter = 1000;
+  /// GMRES: the dimension of the Krylov subspace before a restart
+  int restart = 30;
+};
+
+/// @brief The outcome of a Krylov solver
+struct KrylovResult {
+  /// 0 if converged, 1 if max_iter was reached, 2 on a breakdown (e.g. A not
+  /// positive definite in CG, or singular)
+  int info = 0;
+  /// the iterations done
+  int iterations = 0;
+  /// the relative residual |b - A * x| / |b| reached, as updated by the
+  /// recurrences of the method
+  double residual = 0;
+};
+
+namespace matrix_impl {
+
+// y = A * x for the linear operators accepted by the Krylov solvers
+template<typename M, typename T>
+void dense_apply(const M &a, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  assert(a.n_cols() == x.size() && a.n_rows() == y.size());
+  assert(a.descriptor().strides[1] == 1);
+  blas_impl::gemv(CblasRowMajor, CblasNoTrans, a.n_rows(), a.n_cols(), T(1),
+                  a.data() + a.descriptor().start, a.descriptor().strides[0],
+                  x.data(), 1, T(0), y.data(), 1);
+}
+
+template<typename T>
+void apply(const Matrix<T, 2> &a, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  dense_apply(a, x, y);
+}
+
+template<typename T>
+void apply(const MatrixRef<T, 2> &a, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  dense_apply(a, x, y);
+}
+
+template<typename T>
+void apply(const SparseMatrix<T> &a, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  assert(a.n_cols() == x.size() && a.n_rows() == y.size());
+  a.mv(x.data(), y.data());
+}
+
+template<typename T>
+void apply(const BandMatrix<T> &a, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  blas_gbmv(T(1), a, x, T(0), y);
+}
+
+template<typename F, typename T>
+void apply(const F &f, const Matrix<T, 1> &x, Matrix<T, 1> &y) {
+  f(x, y);
+}
+
+// z = r, the preconditioner of the unpreconditioned solvers
+struct identity_operator {
+  template<typename T>
+  void operator()(const Matrix<T, 1> &r, Matrix<T, 1> &z) const {
+    blas_copy(r, z);
+  }
+};
+
+// r = b - A * x
+template<typename Op, typename T>
+void residual(const Op &a, const Matrix<T, 1> &b, const Matrix<T, 1> &x,
+              Matrix<T, 1> &r) {
+  apply(a, x, r);
+  blas_scal(T(-1), r);
+  blas_axpy(T(1), b, r);
+}
+
+// Sets up x (zeros unless it holds a starting point of the right size) and
+// returns |b|, or 0 after setting x = 0 if b = 0
+template<typename T>
+double start(const Matrix<T, 1> &b, Matrix<T, 1> &x) {
+  if (x.size() != b.size()) x = Matrix<T, 1>(b.size());
+  const double bnorm = blas_nrm2(b);
+  if (bnorm == 0) std::fill(x.begin(), x.end(), T(0));
+  return bnorm;
+}
+
+} // namespace matrix_impl
+
+/// @brief The Jacobi preconditioner M = diag(A)
+///
+/// Zeros on the diagonal of A are replaced by ones.
+template<typename T>
+class JacobiPreconditioner {
+ public:
+  JacobiPreconditioner() = default;
+  /// @brief From the diagonal of A
+  explicit JacobiPreconditioner(const Matrix<T, 1> &diag) : inv_(diag) {
+    invert();
+  }
+  explicit JacobiPreconditioner(const Matrix<T, 2> &a)
+      : inv_(std::min(a.n_rows(), a.n_cols())) {
+    for (std::size_t i = 0; i != inv_.size(); ++i) inv_(i) = a(i, i);
+    invert();
+  }
+  explicit JacobiPreconditioner(const SparseMatrix<T> &a)
+      : inv_(std::min(a.n_rows(), a.n_cols())) {
+    for (std::size_t i = 0; i != inv_.size(); ++i) inv_(i) = a(i, i);
+    invert();
+  }
+
+  std::size_t n() const { return inv_.size(); }
+
+  /// @brief z = M^-1 * r
+  void operator()(const Matrix<T, 1> &r, Matrix<T, 1> &z) const {
+    assert(r.size() == n() && z.size() == n());
+    for (std::size_t i = 0; i != n(); ++i) z(i) = inv_(i) * r(i);
+  }
+
+ private:
+  void invert() {
+    for (T &d : inv_) d = (d == T(0)) ? T(1) : T(1) / d;
+  }
+
+  Matrix<T, 1> inv_;
+};
+
+/// @brief The incomplete Cholesky factorization IC(0) of a sparse symmetric
+/// positive definite matrix, a preconditioner M = L * L'
+///
+/// L has the nonzero pattern of the lower triangle of A, which is the only
+/// part read. The factorization can fail on a positive definite matrix, when
+/// a pivot is not positive; info() then reports its row.
+template<typename T>
+class IncompleteCholesky {
+ public:
+  IncompleteCholesky() : info_(0) {}
+  explicit IncompleteCholesky(const SparseMatrix<T> &a) { factor(a); }
+
+  /// @brief Factors a, returns info() (0 on success, i > 0 if the pivot of
+  /// row i is not positive or missing)
+  int factor(const SparseMatrix<T> &a);
+
+  int info() const { return info_; }
+  bool ok() const { return info_ == 0 && l_.n_rows() != 0; }
+
+  std::size_t n() const { return l_.n_rows(); }
+  /// @brief The factor L in CSR storage, the diagonal last in each row
+  const SparseMatrix<T> &lower() const { return l_; }
+
+  /// @brief z = (L * L')^-1 * r
+  void operator()(const Matrix<T, 1> &r, Matrix<T, 1> &z) const;
+
+ private:
+  SparseMatrix<T> l_;
+  int info_;
+};
+
+template<typename T>
+int IncompleteCholesky<T>::factor(const SparseMatrix<T> &a) {
+  assert(a.n_rows() == a.n_cols());
+  const SparseMatrix<T> csr = a.convert(sparse_format::csr);
+  const std::size_t n = a.n_rows();
+  const std::vector<sparse_index> &ap = csr.ptr(), &ai = csr.indices();
+  const std::vector<T> &av = csr.values();
+
+  // the lower triangle of A
+  std::vector<sparse_index> ptr(n + 1, 0), idx;
+  std::vector<T> val;
+  info_ = 0;
+  for (std::size_t i = 0; i != n; ++i) {
+    for (sparse_index k = ap[i]; k < ap[i + 1] && ai[k] <= sparse_index(i);
+         ++k) {
+      idx.push_back(ai[k]);
+      val.push_back(av[k]);
+    }
+    ptr[i + 1] = idx.size();
+    if (ptr[i + 1] == ptr[i] || idx.back() != sparse_index(i)) {
+      info_ = i + 1;
+      l_ = SparseMatrix<T>();
+      return info_;
+    }
+  }
+
+  // L(i, j) = (A(i, j) - sum_p L(i, p) * L(j, p)) / L(j, j) on the pattern
+  for (std::size_t i = 0; i != n; ++i) {
+    const sparse_index diag = ptr[i + 1] - 1;
+    for (sparse_index k = ptr[i]; k < diag; ++k) {
+      const sparse_index j = idx[k];
+      T s = val[k];
+      sparse_index p = ptr[i], q = ptr[j];
+      const sparse_index jdiag = ptr[j + 1] - 1;
+      while (p < k && q < jdiag) {
+        if (idx[p] < idx[q]) ++p;
+        else if (idx[q] < idx[p]) ++q;
+        else s -= val[p++] * val[q++];
+      }
+      val[k] = s / val[jdiag];
+    }
+    T d = val[diag];
+    for (sparse_index k = ptr[i]; k < diag; ++k) d -= val[k] * val[k];
+    if (!(d > T(0))) {
+      info_ = i + 1;
+      l_ = SparseMatrix<T>();
+      return info_;
+    }
+    val[diag] = std::sqrt(d);
+  }
+  l_ = SparseMatrix<T>(n, n, std::move(ptr), std::move(idx), std::move(val));
+  return info_;
+}
+
+template<typename T>
+void IncompleteCholesky<T>::operator()(const Matrix<T, 1> &r,
+                                       Matrix<T, 1> &z) const {
+  assert(ok() && r.size() == n() && z.size() == n());
+  const sparse_index *ptr = l_.ptr().data(), *idx = l_.indices().data();
+  const T *val = l_.values().data();
+  const sparse_index m = n();
+
+  // L * y = r, then L' * z = y, in place
+  for (sparse_index i = 0; i < m; ++i) {
+    T s = r(i);
+    for (sparse_index k = ptr[i]; k < ptr[i + 1] - 1; ++k)
+      s -= val[k] * z(idx[k]);
+    z(i) = s / val[ptr[i + 1] - 1];
+  }
+  for (sparse_index i = m - 1; i >= 0; --i) {
+    const T zi = z(i) / val[ptr[i + 1] - 1];
+    z(i) = zi;
+    for (sparse_index k = ptr[i]; k < ptr[i + 1] - 1; ++k)
+      z(idx[k]) -= val[k] * zi;
+  }
+}
+
+/// @brief Solves A * x = b by the preconditioned conjugate gradient method,
+/// for symmetric positive definite A and M
+///
+/// @param a    the linear operator A, see krylov.h.
+/// @param b    the right-hand side.
+/// @param x    the starting point if it has the size of b, otherwise zeros;
+///             the solution on exit.
+/// @param m    the preconditioner, applying M^-1.
+/// @param opts the stopping criteria.
+template<typename Op, typename T, typename Precond>
+KrylovResult cg(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                const Precond &m, const KrylovOptions &opts = {}) {
+  KrylovResult result;
+  const double bnorm = matrix_impl::start(b, x);
+  if (bnorm == 0) return result;
+
+  const std::size_t n = b.size();
+  Matrix<T, 1> r(n), z(n), p(n), q(n);
+  matrix_impl::residual(a, b, x, r);
+  result.residual = blas_nrm2(r) / bnorm;
+  if (result.residual <= opts.tol) return result;
+
+  m(r, z);
+  blas_copy(z, p);
+  T rz = blas_dot(r, z);
+  while (result.iterations < opts.max_iter) {
+    matrix_impl::apply(a, p, q);
+    const T pq = blas_dot(p, q);
+    if (!(pq > T(0))) {
+      result.info = 2;
+      return result;
+    }
+    const T alpha = rz / pq;
+    blas_axpy(alpha, p, x);
+    blas_axpy(-alpha, q, r);
+    ++result.iterations;
+    result.residual = blas_nrm2(r) / bnorm;
+    if (result.residual <= opts.tol) return result;
+
+    m(r, z);
+    const T rz_next = blas_dot(r, z);
+    blas_scal(rz_next / rz, p);
+    blas_axpy(T(1), z, p);
+    rz = rz_next;
+  }
+  result.info = 1;
+  return result;
+}
+
+/// @brief Solves A * x = b by the conjugate gradient method, for symmetric
+/// positive definite A
+template<typename Op, typename T>
+KrylovResult cg(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                const KrylovOptions &opts = {}) {
+  return cg(a, b, x, matrix_impl::identity_operator(), opts);
+}
+
+/// @brief Solves A * x = b by BiCGSTAB with right preconditioning, for
+/// general square A
+///
+/// The parameters are those of cg(); each iteration applies A and M twice.
+template<typename Op, typename T, typename Precond>
+KrylovResult bicgstab(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                      const Precond &m, const KrylovOptions &opts = {}) {
+  KrylovResult result;
+  const double bnorm = matrix_impl::start(b, x);
+  if (bnorm == 0) return result;
+
+  const std::size_t n = b.size();
+  Matrix<T, 1> r(n), r0(n), p(n), v(n), ph(n), sh(n), t(n);
+  matrix_impl::residual(a, b, x, r);
+  result.residual = blas_nrm2(r) / bnorm;
+  if (result.residual <= opts.tol) return result;
+
+  blas_copy(r, r0);
+  T rho = T(1), alpha = T(1), omega = T(1);
+  while (result.iterations < opts.max_iter) {
+    const T rho_next = blas_dot(r0, r);
+    if (rho_next == T(0)) break;
+    // p = r + beta * (p - omega * v)
+    blas_axpy(-omega, v, p);
+    blas_scal((rho_next / rho) * (alpha / omega), p);
+    blas_axpy(T(1), r, p);
+    rho = rho_next;
+
+    m(p, ph);
+    matrix_impl::apply(a, ph, v);
+    const T r0v = blas_dot(r0, v);
+    if (r0v == T(0)) break;
+    alpha = rho / r0v;
+    // s = r - alpha * v, kept in r
+    blas_axpy(-alpha, v, r);
+    blas_axpy(alpha, ph, x);
+    ++result.iterations;
+    result.residual = blas_nrm2(r) / bnorm;
+    if (result.residual <= opts.tol) return result;
+
+    m(r, sh);
+    matrix_impl::apply(a, sh, t);
+    const T tt = blas_dot(t, t);
+    if (tt == T(0)) break;
+    omega = blas_dot(t, r) / tt;
+    blas_axpy(omega, sh, x);
+    blas_axpy(-omega, t, r);
+    result.residual = blas_nrm2(r) / bnorm;
+    if (result.residual <= opts.tol) return result;
+    if (omega == T(0)) break;
+  }
+  result.info = (result.iterations < opts.max_iter) ? 2 : 1;
+  return result;
+}
+
+/// @brief Solves A * x = b by BiCGSTAB, for general square A
+template<typename Op, typename T>
+KrylovResult bicgstab(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                      const KrylovOptions &opts = {}) {
+  return bicgstab(a, b, x, matrix_impl::identity_operator(), opts);
+}
+
+/// @brief Solves A * x = b by GMRES restarted every opts.restart iterations,
+/// with right preconditioning, for general square A
+///
+/// The parameters are those of cg(). The Arnoldi basis is orthogonalized by
+/// modified Gram-Schmidt and the least squares problems are updated by
+/// Givens rotations; opts.restart + 1 vectors of the size of b are kept.
+template<typename Op, typename T, typename Precond>
+KrylovResult gmres(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                   const Precond &m, const KrylovOptions &opts = {}) {
+  KrylovResult result;
+  const double bnorm = matrix_impl::start(b, x);
+  if (bnorm == 0) return result;
+
+  const std::size_t n = b.size();
+  const int k_max = std::max(1, opts.restart);
+  std::vector<Matrix<T, 1>> v(k_max + 1, Matrix<T, 1>(n));
+  Matrix<T, 1> w(n), z(n);
+  Matrix<T, 2> h(k_max + 1, k_max);
+  Matrix<T, 1> g(k_max + 1), cs(k_max), sn(k_max), y(k_max);
+
+  while (true) {
+    matrix_impl::residual(a, b, x, v[0]);
+    const T beta = blas_nrm2(v[0]);
+    result.residual = beta / bnorm;
+    if (result.residual <= opts.tol) return result;
+    if (result.iterations >= opts.max_iter) break;
+    blas_scal(T(1) / beta, v[0]);
+    std::fill(g.begin(), g.end(), T(0));
+    g(0) = beta;
+
+    int k = 0;
+    bool lucky = false;
+    while (k < k_max && result.iterations < opts.max_iter) {
+      m(v[k], z);
+      matrix_impl::apply(a, z, w);
+      for (int i = 0; i <= k; ++i) {
+        h(i, k) = blas_dot(w, v[i]);
+        blas_axpy(-h(i, k), v[i], w);
+      }
+      h(k + 1, k) = blas_nrm2(w);
+      lucky = (h(k + 1, k) == T(0));
+      if (!lucky) {
+        blas_copy(w, v[k + 1]);
+        blas_scal(T(1) / h(k + 1, k), v[k + 1]);
+      }
+
+      for (int i = 0; i < k; ++i) {
+        const T hi = h(i, k);
+        h(i, k) = cs(i) * hi + sn(i) * h(i + 1, k);
+        h(i + 1, k) = -sn(i) * hi + cs(i) * h(i + 1, k);
+      }
+      const T d = std::hypot(h(k, k), h(k + 1, k));
+      if (d == T(0)) {
+        result.info = 2;
+        return result;
+      }
+      cs(k) = h(k, k) / d;
+      sn(k) = h(k + 1, k) / d;
+      h(k, k) = d;
+      h(k + 1, k) = T(0);
+      g(k + 1) = -sn(k) * g(k);
+      g(k) = cs(k) * g(k);
+
+      ++k;
+      ++result.iterations;
+      result.residual = std::abs(g(k)) / bnorm;
+      if (result.residual <= opts.tol || lucky) break;
+    }
+
+    // x += M^-1 * V * y with H * y = g
+    for (int i = k - 1; i >= 0; --i) {
+      T s = g(i);
+      for (int j = i + 1; j < k; ++j) s -= h(i, j) * y(j);
+      y(i) = s / h(i, i);
+    }
+    std::fill(w.begin(), w.end(), T(0));
+    for (int i = 0; i < k; ++i) blas_axpy(y(i), v[i], w);
+    m(w, z);
+    blas_axpy(T(1), z, x);
+    if (result.residual <= opts.tol || lucky) return result;
+  }
+  result.info = 1;
+  return result;
+}
+
+/// @brief Solves A * x = b by restarted GMRES, for general square A
+template<typename Op, typename T>
+KrylovResult gmres(const Op &a, const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                   const KrylovOptions &opts = {}) {
+  return gmres(a, b, x, matrix_impl::identity_operator(), opts);
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_KRYLOV_H_
@@ -22,42 +22,586 @@
 
 #include "slab/matrix/matrix.h"
 #include "slab/matrix/traits.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/workspace.h"
 
+/// @brief The norm used to estimate a condition number
+enum class lapack_norm {
+  one,  ///< the 1-norm, largest column sum
+  inf   ///< the infinity-norm, largest row sum
+};
+
+/// @brief The triangle of a symmetric matrix that is referenced
+enum class lapack_uplo {
+  lower,
+  upper
+};
+
+namespace lapack_impl {
+
+// The LAPACKE routines behind the factorization classes, overloaded on the
+// element type. They take column-major arrays: a row-major matrix is passed
+// as its transpose, which avoids the transposed copy LAPACKE makes for
+// LAPACK_ROW_MAJOR. Workspaces are passed in, lwork = -1 being a query.
+
+inline int getrf(int m, int n, float *a, int lda, int *ipiv) {
+  return LAPACKE_sgetrf_work(LAPACK_COL_MAJOR, m, n, a, lda, ipiv);
+}
+
+inline int getri(int n, float *a, int lda, const int *ipiv, float *work,
+                 int lwork) {
+  return LAPACKE_sgetri_work(LAPACK_COL_MAJOR, n, a, lda, ipiv, work, lwork);
+}
+
+inline int gecon(char norm, int n, const float *a, int lda, float anorm,
+                 float *rcond, float *work, int *iwork) {
+  return LAPACKE_sgecon_work(LAPACK_COL_MAJOR, norm, n, a, lda, anorm, rcond,
+                              work, iwork);
+}
+
+inline int potrf(char uplo, int n, float *a, int lda) {
+  return LAPACKE_spotrf_work(LAPACK_COL_MAJOR, uplo, n, a, lda);
+}
+
+inline int potri(char uplo, int n, float *a, int lda) {
+  return LAPACKE_spotri_work(LAPACK_COL_MAJOR, uplo, n, a, lda);
+}
+
+inline float lange(char norm, int m, int n, const float *a, int lda,
+                   float *work) {
+  return LAPACKE_slange_work(LAPACK_COL_MAJOR, norm, m, n, a, lda, work);
+}
+
+inline int getrf(int m, int n, double *a, int lda, int *ipiv) {
+  return LAPACKE_dgetrf_work(LAPACK_COL_MAJOR, m, n, a, lda, ipiv);
+}
+
+inline int getri(int n, double *a, int lda, const int *ipiv, double *work,
+                 int lwork) {
+  return LAPACKE_dgetri_work(LAPACK_COL_MAJOR, n, a, lda, ipiv, work, lwork);
+}
+
+inline int gecon(char norm, int n, const double *a, int lda, double anorm,
+                 double *rcond, double *work, int *iwork) {
+  return LAPACKE_dgecon_work(LAPACK_COL_MAJOR, norm, n, a, lda, anorm, rcond,
+                              work, iwork);
+}
+
+inline int potrf(char uplo, int n, double *a, int lda) {
+  return LAPACKE_dpotrf_work(LAPACK_COL_MAJOR, uplo, n, a, lda);
+}
+
+inline int potri(char uplo, int n, double *a, int lda) {
+  return LAPACKE_dpotri_work(LAPACK_COL_MAJOR, uplo, n, a, lda);
+}
+
+inline double lange(char norm, int m, int n, const double *a, int lda,
+                    double *work) {
+  return LAPACKE_dlange_work(LAPACK_COL_MAJOR, norm, m, n, a, lda, work);
+}
+
+inline int gbtrf(int m, int n, int kl, int ku, float *ab, int ldab, int *ipiv) {
+  return LAPACKE_sgbtrf_work(LAPACK_COL_MAJOR, m, n, kl, ku, ab, ldab, ipiv);
+}
+
+inline int gbtrs(char trans, int n, int kl, int ku, int nrhs, const float *ab,
+                 int ldab, const int *ipiv, float *b, int ldb) {
+  return LAPACKE_sgbtrs_work(LAPACK_COL_MAJOR, trans, n, kl, ku, nrhs, ab,
+                              ldab, ipiv, b, ldb);
+}
+
+inline int pbtrf(char uplo, int n, int kd, float *ab, int ldab) {
+  return LAPACKE_spbtrf_work(LAPACK_COL_MAJOR, uplo, n, kd, ab, ldab);
+}
+
+inline int pbtrs(char uplo, int n, int kd, int nrhs, const float *ab, int ldab,
+                 float *b, int ldb) {
+  return LAPACKE_spbtrs_work(LAPACK_COL_MAJOR, uplo, n, kd, nrhs, ab, ldab, b,
+                              ldb);
+}
+
+inline int gbtrf(int m, int n, int kl, int ku, double *ab, int ldab, int *ipiv) {
+  return LAPACKE_dgbtrf_work(LAPACK_COL_MAJOR, m, n, kl, ku, ab, ldab, ipiv);
+}
+
+inline int gbtrs(char trans, int n, int kl, int ku, int nrhs, const double *ab,
+                 int ldab, const int *ipiv, double *b, int ldb) {
+  return LAPACKE_dgbtrs_work(LAPACK_COL_MAJOR, trans, n, kl, ku, nrhs, ab,
+                              ldab, ipiv, b, ldb);
+}
+
+inline int pbtrf(char uplo, int n, int kd, double *ab, int ldab) {
+  return LAPACKE_dpbtrf_work(LAPACK_COL_MAJOR, uplo, n, kd, ab, ldab);
+}
+
+inline int pbtrs(char uplo, int n, int kd, int nrhs, const double *ab, int ldab,
+                 double *b, int ldb) {
+  return LAPACKE_dpbtrs_work(LAPACK_COL_MAJOR, uplo, n, kd, nrhs, ab, ldab, b,
+                              ldb);
+}
+
+inline int pptrf(char uplo, int n, float *ap) {
+  return LAPACKE_spptrf_work(LAPACK_COL_MAJOR, uplo, n, ap);
+}
+
+inline int pptrs(char uplo, int n, int nrhs, const float *ap, float *b, int ldb) {
+  return LAPACKE_spptrs_work(LAPACK_COL_MAJOR, uplo, n, nrhs, ap, b, ldb);
+}
+
+inline int pptrf(char uplo, int n, double *ap) {
+  return LAPACKE_dpptrf_work(LAPACK_COL_MAJOR, uplo, n, ap);
+}
+
+inline int pptrs(char uplo, int n, int nrhs, const double *ap, double *b, int ldb) {
+  return LAPACKE_dpptrs_work(LAPACK_COL_MAJOR, uplo, n, nrhs, ap, b, ldb);
+}
+
+inline int gelqf(int m, int n, float *a, int lda, float *tau, float *work,
+                 int lwork) {
+  return LAPACKE_sgelqf_work(LAPACK_COL_MAJOR, m, n, a, lda, tau, work, lwork);
+}
+
+inline int orglq(int m, int n, int k, float *a, int lda, const float *tau,
+                 float *work, int lwork) {
+  return LAPACKE_sorglq_work(LAPACK_COL_MAJOR, m, n, k, a, lda, tau, work,
+                              lwork);
+}
+
+inline int ormlq(char side, char trans, int m, int n, int k, const float *a,
+                 int lda, const float *tau, float *c, int ldc, float *work,
+                 int lwork) {
+  return LAPACKE_sormlq_work(LAPACK_COL_MAJOR, side, trans, m, n, k, a, lda,
+                              tau, c, ldc, work, lwork);
+}
+
+inline int gels(char trans, int m, int n, int nrhs, float *a, int lda, float *b,
+                int ldb, float *work, int lwork) {
+  return LAPACKE_sgels_work(LAPACK_COL_MAJOR, trans, m, n, nrhs, a, lda, b,
+                             ldb, work, lwork);
+}
+
+inline int gelsd(int m, int n, int nrhs, float *a, int lda, float *b, int ldb,
+                 float *s, float rcond, int *rank, float *work, int lwork,
+                 int *iwork) {
+  return LAPACKE_sgelsd_work(LAPACK_COL_MAJOR, m, n, nrhs, a, lda, b, ldb, s,
+                              rcond, rank, work, lwork, iwork);
+}
+
+inline int gelqf(int m, int n, double *a, int lda, double *tau, double *work,
+                 int lwork) {
+  return LAPACKE_dgelqf_work(LAPACK_COL_MAJOR, m, n, a, lda, tau, work, lwork);
+}
+
+inline int orglq(int m, int n, int k, double *a, int lda, const double *tau,
+                 double *work, int lwork) {
+  return LAPACKE_dorglq_work(LAPACK_COL_MAJOR, m, n, k, a, lda, tau, work,
+                              lwork);
+}
+
+inline int ormlq(char side, char trans, int m, int n, int k, const double *a,
+                 int lda, const double *tau, double *c, int ldc, double *work,
+                 int lwork) {
+  return LAPACKE_dormlq_work(LAPACK_COL_MAJOR, side, trans, m, n, k, a, lda,
+                              tau, c, ldc, work, lwork);
+}
+
+inline int gels(char trans, int m, int n, int nrhs, double *a, int lda, double *b,
+                int ldb, double *work, int lwork) {
+  return LAPACKE_dgels_work(LAPACK_COL_MAJOR, trans, m, n, nrhs, a, lda, b,
+                             ldb, work, lwork);
+}
+
+inline int gelsd(int m, int n, int nrhs, double *a, int lda, double *b, int ldb,
+                 double *s, double rcond, int *rank, double *work, int lwork,
+                 int *iwork) {
+  return LAPACKE_dgelsd_work(LAPACK_COL_MAJOR, m, n, nrhs, a, lda, b, ldb, s,
+                              rcond, rank, work, lwork, iwork);
+}
+
+inline int syevd(char jobz, char uplo, int n, float *a, int lda, float *w,
+                 float *work, int lwork, int *iwork, int liwork) {
+  return LAPACKE_ssyevd_work(LAPACK_COL_MAJOR, jobz, uplo, n, a, lda, w, work,
+                              lwork, iwork, liwork);
+}
+
+inline int syevr(char jobz, char range, char uplo, int n, float *a, int lda,
+                 float vl, float vu, int il, int iu, float abstol, int *m, float *w,
+                 float *z, int ldz, int *isuppz, float *work, int lwork,
+                 int *iwork, int liwork) {
+  return LAPACKE_ssyevr_work(LAPACK_COL_MAJOR, jobz, range, uplo, n, a, lda,
+                              vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+                              work, lwork, iwork, liwork);
+}
+
+inline int gesdd(char jobz, int m, int n, float *a, int lda, float *s, float *u,
+                 int ldu, float *vt, int ldvt, float *work, int lwork,
+                 int *iwork) {
+  return LAPACKE_sgesdd_work(LAPACK_COL_MAJOR, jobz, m, n, a, lda, s, u, ldu,
+                              vt, ldvt, work, lwork, iwork);
+}
+
+inline int syevd(char jobz, char uplo, int n, double *a, int lda, double *w,
+                 double *work, int lwork, int *iwork, int liwork) {
+  return LAPACKE_dsyevd_work(LAPACK_COL_MAJOR, jobz, uplo, n, a, lda, w, work,
+                              lwork, iwork, liwork);
+}
+
+inline int syevr(char jobz, char range, char uplo, int n, double *a, int lda,
+                 double vl, double vu, int il, int iu, double abstol, int *m, double *w,
+                 double *z, int ldz, int *isuppz, double *work, int lwork,
+                 int *iwork, int liwork) {
+  return LAPACKE_dsyevr_work(LAPACK_COL_MAJOR, jobz, range, uplo, n, a, lda,
+                              vl, vu, il, iu, abstol, m, w, z, ldz, isuppz,
+                              work, lwork, iwork, liwork);
+}
+
+inline int gesdd(char jobz, int m, int n, double *a, int lda, double *s, double *u,
+                 int ldu, double *vt, int ldvt, double *work, int lwork,
+                 int *iwork) {
+  return LAPACKE_dgesdd_work(LAPACK_COL_MAJOR, jobz, m, n, a, lda, s, u, ldu,
+                              vt, ldvt, work, lwork, iwork);
+}
+
+// The optimal size of a workspace, as returned by an lwork = -1 query
 template<typename T>
-int lapack_getrf(Matrix<T, 2> &a, Matrix<int, 1> &ipiv) {
+int work_size(const T &query) {
+  return std::max(1, static_cast<int>(query));
+}
+
+} // namespace lapack_impl
+
+namespace matrix_impl {
+
+// Copies the m x n matrix a, a Matrix or a MatrixRef, to the row-major array
+// dst with leading dimension ld (or column-major, with col_major).
+template<typename M, typename T>
+void copy_to(const M &a, T *dst, std::size_t ld, bool col_major = false) {
+  const std::size_t m = a.n_rows(), n = a.n_cols();
+  const T *src = a.data() + a.descriptor().start;
+  const std::size_t rs = a.descriptor().strides[0];
+  const std::size_t cs = a.descriptor().strides[1];
+
+  for (std::size_t i = 0; i != m; ++i) {
+    const T *ai = src + i * rs;
+    if (col_major) {
+      for (std::size_t j = 0; j != n; ++j) dst[j * ld + i] = ai[j * cs];
+    } else if (cs == 1) {
+      std::copy(ai, ai + n, dst + i * ld);
+    } else {
+      for (std::size_t j = 0; j != n; ++j) dst[i * ld + j] = ai[j * cs];
+    }
+  }
+}
+
+// Copies b, a vector or a matrix of right-hand sides (a Matrix or a
+// MatrixRef), to dst as copy_to() does, a vector being a single column.
+template<typename B, typename T>
+void copy_rhs_to(const B &b, T *dst, std::size_t ld, bool col_major = false) {
+  const auto &d = b.descriptor();
+  const std::size_t m = d.extents[0];
+  const std::size_t n = (B::order_ == 1) ? 1 : d.extents[B::order_ - 1];
+  const T *src = b.data() + d.start;
+  const std::size_t rs = d.strides[0], cs = d.strides[B::order_ - 1];
+
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j)
+      dst[col_major ? j * ld + i : i * ld + j] = src[i * rs + j * cs];
+}
+
+// The workspaces of a LAPACK routine, sized by an lwork = liwork = -1 query
+// that is only repeated when the routine or the sizes of the call, its key,
+// change. The buffers are taken from the innermost WorkspaceScope.
+template<typename T>
+struct lapack_work {
+  using key_type = std::array<int, 4>;
+
+  // query(work, iwork) calls the routine with lwork = liwork = -1
+  template<typename F>
+  void fit(const key_type &key, F query) {
+    if (key != key_) {
+      T size = T(0);
+      int isize = 0;
+      query(&size, &isize);
+      lwork = lapack_impl::work_size(size);
+      liwork = std::max(1, isize);
+      key_ = key;
+    }
+    WorkspacePool &pool = WorkspacePool::local();
+    work = pool.get<T>(lwork);
+    iwork = pool.get<int>(liwork);
+  }
 
-  int info = 0;
+  T *work = nullptr;
+  int *iwork = nullptr;
+  int lwork = 0;
+  int liwork = 0;
 
+ private:
+  key_type key_ = {{-1, -1, -1, -1}};
+};
+
+// Copies the row-major m x n array a to the column-major array at
+template<typename T>
+void transpose_copy(int m, int n, const T *a, T *at) {
+  const int nb = 32;
+  for (int i0 = 0; i0 < m; i0 += nb)
+    for (int j0 = 0; j0 < n; j0 += nb)
+      for (int i = i0; i < std::min(m, i0 + nb); ++i)
+        for (int j = j0; j < std::min(n, j0 + nb); ++j)
+          at[std::size_t(j) * m + i] = a[std::size_t(i) * n + j];
+}
+
+// The norm of the row-major m x n array a; its 1-norm is the inf-norm of the
+// column-major A'
+template<typename T>
+T lange(lapack_norm norm, int m, int n, const T *a) {
+  if (m == 0 || n == 0) return T(0);
+  WorkspaceScope scope;
+  return lapack_impl::lange(norm == lapack_norm::one ? 'I' : '1', n, m, a, n,
+                            scope.get<T>(n));
+}
+
+// Solves op(A) * X = B with the row-major factors of lapack_getrf, B being
+// row-major n x nrhs: the row interchanges and triangular solves of getrs,
+// without the transposed copies LAPACKE makes for row-major arrays
+template<typename T>
+void getrs(bool trans, int n, int nrhs, const T *a, const int *ipiv, T *b,
+           int ldb) {
+  auto swap_rows = [&](int i) {
+    const int p = ipiv[i] - 1;
+    if (p != i)
+      std::swap_ranges(b + std::size_t(i) * ldb,
+                       b + std::size_t(i) * ldb + nrhs,
+                       b + std::size_t(p) * ldb);
+  };
+
+  if (!trans) {
+    for (int i = 0; i != n; ++i) swap_rows(i);
+    blas_impl::trsm(CblasRowMajor, CblasLeft, CblasLower, CblasNoTrans,
+                    CblasUnit, n, nrhs, T(1), a, n, b, ldb);
+    blas_impl::trsm(CblasRowMajor, CblasLeft, CblasUpper, CblasNoTrans,
+                    CblasNonUnit, n, nrhs, T(1), a, n, b, ldb);
+  } else {
+    blas_impl::trsm(CblasRowMajor, CblasLeft, CblasUpper, CblasTrans,
+                    CblasNonUnit, n, nrhs, T(1), a, n, b, ldb);
+    blas_impl::trsm(CblasRowMajor, CblasLeft, CblasLower, CblasTrans,
+                    CblasUnit, n, nrhs, T(1), a, n, b, ldb);
+    for (int i = n - 1; i >= 0; --i) swap_rows(i);
+  }
+}
+
+// Solves A * X = B with the row-major factor of lapack_potrf, B being
+// row-major n x nrhs
+template<typename T>
+void potrs(lapack_uplo uplo, int n, int nrhs, const T *a, T *b, int ldb) {
+  // A = L * L' or A = U' * U
+  const CBLAS_UPLO u = (uplo == lapack_uplo::lower) ? CblasLower : CblasUpper;
+  const bool lower = (uplo == lapack_uplo::lower);
+  blas_impl::trsm(CblasRowMajor, CblasLeft, u,
+                  lower ? CblasNoTrans : CblasTrans, CblasNonUnit, n, nrhs,
+                  T(1), a, n, b, ldb);
+  blas_impl::trsm(CblasRowMajor, CblasLeft, u,
+                  lower ? CblasTrans : CblasNoTrans, CblasNonUnit, n, nrhs,
+                  T(1), a, n, b, ldb);
+}
+
+// The uplo triangle of a row-major symmetric matrix is the other triangle of
+// the same array read column-major
+inline char col_major_uplo(lapack_uplo uplo) {
+  return (uplo == lapack_uplo::lower) ? 'U' : 'L';
+}
+
+// Resizes a result to n elements, or n x nrhs elements
+template<typename T>
+void fit(Matrix<T, 1> &x, std::size_t n, std::size_t) {
+  if (x.size() != n) x = Matrix<T, 1>(n);
+}
+
+template<typename T>
+void fit(Matrix<T, 2> &x, std::size_t n, std::size_t nrhs) {
+  if (x.n_rows() != n || x.n_cols() != nrhs) x = Matrix<T, 2>(n, nrhs);
+}
+
+} // namespace matrix_impl
+
+/// @brief Computes the LU factorization of a general matrix, P * A = L * U
+///
+/// @param a    the matrix on entry, the factors L and U on exit.
+/// @param ipiv the pivot indices, only reallocated if its size is not
+///             max(1, min(m, n)).
+/// @return 0 on success, i > 0 if U(i,i) is exactly zero.
+template<typename T>
+int lapack_getrf(Matrix<T, 2> &a, Matrix<int, 1> &ipiv) {
   const int m = a.n_rows();
   const int n = a.n_cols();
 
-  //assert(ipiv.size() >= std::max(1, std::min(m, n)));
-  ipiv.clear();
-  ipiv = Matrix<int, 1>(std::max(1, std::min(m, n)));
-
-  const int lda = n;
-
-  if (is_double<T>::value) {
-    info = LAPACKE_dgetrf(
-        LAPACK_ROW_MAJOR,
-        m,
-        n,
-        (double *) a.data(),
-        lda,
-        ipiv.data()
-    );
-  } else if (is_float<T>::value) {
-    info = LAPACKE_sgetrf(
-        LAPACK_ROW_MAJOR,
-        m,
-        n,
-        (float *) a.data(),
-        lda,
-        ipiv.data()
-    );
-  }
+  const std::size_t npiv = std::max(1, std::min(m, n));
+  if (ipiv.size() != npiv) ipiv = Matrix<int, 1>(npiv);
+  if (m == 0 || n == 0) return 0;
+
+  // getrf factors a column-major copy of A, taken from the workspace pool
+  WorkspaceScope scope;
+  T *at = scope.get<T>(std::size_t(m) * n);
+  matrix_impl::transpose_copy(m, n, a.data(), at);
+  const int info = lapack_impl::getrf(m, n, at, m, ipiv.data());
+  matrix_impl::transpose_copy(n, m, at, a.data());
 
   return info;
 }
 
+/// @brief Solves a system of linear equations with an LU-factored square
+/// matrix, as computed by lapack_getrf
+///
+/// @param a    the factors L and U from lapack_getrf.
+/// @param ipiv the pivot indices from lapack_getrf.
+/// @param b    the right-hand sides on entry, the solution on exit.
+/// @param trans solve op(A) * X = B with op = no_trans, trans or conj_trans.
+template<typename T>
+int lapack_getrs(const Matrix<T, 2> &a, const Matrix<int, 1> &ipiv,
+                 Matrix<T, 2> &b, blas_trans trans = blas_trans::no_trans) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.n_rows());
+
+  const int n = a.n_rows();
+  const int nrhs = b.n_cols();
+  if (n == 0 || nrhs == 0) return 0;
+
+  matrix_impl::getrs(trans != blas_trans::no_trans, n, nrhs, a.data(),
+                     ipiv.data(), b.data(), nrhs);
+  return 0;
+}
+
+/// @brief Solves a system of linear equations with an LU-factored square
+/// matrix and a single right-hand side
+template<typename T>
+int lapack_getrs(const Matrix<T, 2> &a, const Matrix<int, 1> &ipiv,
+                 Matrix<T, 1> &b, blas_trans trans = blas_trans::no_trans) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.size());
+
+  const int n = a.n_rows();
+  if (n == 0) return 0;
+
+  matrix_impl::getrs(trans != blas_trans::no_trans, n, 1, a.data(),
+                     ipiv.data(), b.data(), 1);
+  return 0;
+}
+
+/// @brief Computes the inverse of an LU-factored square matrix
+///
+/// @param a    the factors L and U from lapack_getrf on entry, the inverse on
+///             exit.
+/// @param ipiv the pivot indices from lapack_getrf.
+/// @return 0 on success, i > 0 if U(i,i) is exactly zero.
+template<typename T>
+int lapack_getri(Matrix<T, 2> &a, const Matrix<int, 1> &ipiv) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  if (n == 0) return 0;
+
+  static thread_local matrix_impl::lapack_work<T> work;
+
+  WorkspaceScope scope;
+  T *at = scope.get<T>(std::size_t(n) * n);
+  matrix_impl::transpose_copy(n, n, a.data(), at);
+  work.fit({{0, n, 0, 0}}, [&](T *query, int *) {
+    lapack_impl::getri(n, at, n, ipiv.data(), query, -1);
+  });
+  const int info = lapack_impl::getri(n, at, n, ipiv.data(), work.work,
+                                      work.lwork);
+  matrix_impl::transpose_copy(n, n, at, a.data());
+
+  return info;
+}
+
+/// @brief Estimates the reciprocal of the condition number of an LU-factored
+/// square matrix
+///
+/// @param a     the factors L and U from lapack_getrf.
+/// @param anorm the norm of the original matrix A.
+/// @param rcond the estimate of 1 / (norm(A) * norm(inv(A))) on exit.
+/// @param norm  the norm of the condition number.
+template<typename T>
+int lapack_gecon(const Matrix<T, 2> &a, T anorm, T &rcond,
+                 lapack_norm norm = lapack_norm::one) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  const char t = (norm == lapack_norm::one) ? '1' : 'I';
+
+  WorkspaceScope scope;
+  T *at = scope.get<T>(std::size_t(n) * n);
+  matrix_impl::transpose_copy(n, n, a.data(), at);
+  return lapack_impl::gecon(t, n, at, std::max(1, n), anorm, &rcond,
+                            scope.get<T>(4 * n), scope.get<int>(n));
+}
+
+/// @brief Computes the Cholesky factorization of a symmetric positive
+/// definite matrix, A = L * L' or A = U' * U
+///
+/// @param a    the matrix on entry, only the uplo triangle being referenced;
+///             the factor in that triangle on exit.
+/// @return 0 on success, i > 0 if the leading minor of order i is not
+///         positive definite.
+template<typename T>
+int lapack_potrf(Matrix<T, 2> &a, lapack_uplo uplo = lapack_uplo::lower) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  if (n == 0) return 0;
+
+  // A' = A: the array is factored in place, read column-major
+  return lapack_impl::potrf(matrix_impl::col_major_uplo(uplo), n, a.data(), n);
+}
+
+/// @brief Solves a system of linear equations with a Cholesky-factored
+/// matrix, as computed by lapack_potrf
+///
+/// @param a the factor from lapack_potrf.
+/// @param b the right-hand sides on entry, one per column, the solution on
+///          exit.
+template<typename T>
+int lapack_potrs(const Matrix<T, 2> &a, Matrix<T, 2> &b,
+                 lapack_uplo uplo = lapack_uplo::lower) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.n_rows());
+
+  const int n = a.n_rows();
+  const int nrhs = b.n_cols();
+  if (n == 0 || nrhs == 0) return 0;
+
+  matrix_impl::potrs(uplo, n, nrhs, a.data(), b.data(), nrhs);
+  return 0;
+}
+
+/// @brief Solves a system of linear equations with a Cholesky-factored
+/// matrix and a single right-hand side
+template<typename T>
+int lapack_potrs(const Matrix<T, 2> &a, Matrix<T, 1> &b,
+                 lapack_uplo uplo = lapack_uplo::lower) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.size());
+
+  const int n = a.n_rows();
+  if (n == 0) return 0;
+
+  matrix_impl::potrs(uplo, n, 1, a.data(), b.data(), 1);
+  return 0;
+}
+
+/// @brief Computes the inverse of a Cholesky-factored matrix
+///
+/// @param a the factor from lapack_potrf on entry; the uplo triangle of the
+///          inverse on exit.
+template<typename T>
+int lapack_potri(Matrix<T, 2> &a, lapack_uplo uplo = lapack_uplo::lower) {
+  assert(a.n_rows() == a.n_cols());
+
+  const int n = a.n_rows();
+  if (n == 0) return 0;
+
+  return lapack_impl::potri(matrix_impl::col_major_uplo(uplo), n, a.data(), n);
+}
+
 #endif // SLAB_MATRIX_LAPACK_INTERFACE_H_
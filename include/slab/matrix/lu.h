@@ -0,0 +1,178 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file lu.h
+/// @brief A reusable LU factorization of a square matrix
+
+#ifndef SLAB_MATRIX_LU_H_
+#define SLAB_MATRIX_LU_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/lapack_interface.h"
+
+/// @addtogroup linear_solve LINEAR SOLVERS
+/// @{
+
+/// @brief The LU factorization P * A = L * U of a square matrix
+///
+/// The factors and pivots are kept, so that systems with the same matrix and
+/// new right-hand sides are solved without factoring again:
+///
+///     LU<double> lu(jacobian);
+///     for (...) {
+///       lu.solve(residual, step);  // step := inv(jacobian) * residual
+///       ...
+///     }
+///
+/// Factoring a new matrix of the same size, or solving into the same
+/// solution, reuses the storage.
+template<typename T>
+class LU {
+ public:
+  LU() : info_(0), anorm_(0), anorm_inf_(0) {}
+  explicit LU(const Matrix<T, 2> &a) { factor(a); }
+
+  /// @brief Factors a, returns info() (0 on success, i > 0 if U(i,i) is zero)
+  int factor(const Matrix<T, 2> &a);
+
+  /// @brief 0 if the factorization succeeded, i > 0 if U(i,i) is exactly
+  /// zero: the matrix is singular and cannot be used to solve
+  int info() const { return info_; }
+  /// @brief True if the factorization can be used to solve
+  bool ok() const { return info_ == 0 && lu_.size() != 0; }
+
+  std::size_t n() const { return lu_.n_rows(); }
+  /// @brief L (unit diagonal, below) and U (on and above the diagonal)
+  const Matrix<T, 2> &factors() const { return lu_; }
+  /// @brief The 1-based row interchanges, as returned by getrf
+  const Matrix<int, 1> &pivots() const { return ipiv_; }
+
+  /// @brief Solves op(A) * x = b
+  ///
+  /// @return 0 on success, info() if A is singular.
+  int solve(const Matrix<T, 1> &b, Matrix<T, 1> &x,
+            blas_trans trans = blas_trans::no_trans) const;
+  /// @brief Solves op(A) * X = B, one right-hand side per column
+  int solve(const Matrix<T, 2> &b, Matrix<T, 2> &x,
+            blas_trans trans = blas_trans::no_trans) const;
+
+  /// @brief The solution of op(A) * x = b, an empty matrix if A is singular
+  template<std::size_t N>
+  Matrix<T, N> solve(const Matrix<T, N> &b,
+                     blas_trans trans = blas_trans::no_trans) const {
+    Matrix<T, N> x;
+    if (solve(b, x, trans) != 0) x.clear();
+    return x;
+  }
+
+  /// @brief The determinant of A
+  T det() const;
+
+  /// @brief Computes the inverse of A
+  ///
+  /// @return 0 on success, info() if A is singular.
+  int inverse(Matrix<T, 2> &inv) const;
+  /// @brief The inverse of A, an empty matrix if A is singular
+  Matrix<T, 2> inverse() const {
+    Matrix<T, 2> inv;
+    inverse(inv);
+    return inv;
+  }
+
+  /// @brief An estimate of the reciprocal condition number of A in the given
+  /// norm, 0 if A is singular
+  T rcond(lapack_norm norm = lapack_norm::one) const;
+
+ private:
+  Matrix<T, 2> lu_;
+  Matrix<int, 1> ipiv_;
+  int info_;
+  T anorm_;      // the 1-norm of A
+  T anorm_inf_;  // the inf-norm of A
+};
+
+template<typename T>
+int LU<T>::factor(const Matrix<T, 2> &a) {
+  assert(a.n_rows() == a.n_cols());
+
+  lu_ = a;
+  const int n = a.n_rows();
+  anorm_ = matrix_impl::lange(lapack_norm::one, n, n, a.data());
+  anorm_inf_ = matrix_impl::lange(lapack_norm::inf, n, n, a.data());
+
+  info_ = (n == 0) ? 0 : lapack_getrf(lu_, ipiv_);
+  return info_;
+}
+
+template<typename T>
+int LU<T>::solve(const Matrix<T, 1> &b, Matrix<T, 1> &x,
+                 blas_trans trans) const {
+  assert(b.size() == n());
+  if (info_ != 0) return info_;
+
+  x = b;
+  if (n() == 0) return 0;
+  return lapack_getrs(lu_, ipiv_, x, trans);
+}
+
+template<typename T>
+int LU<T>::solve(const Matrix<T, 2> &b, Matrix<T, 2> &x,
+                 blas_trans trans) const {
+  assert(b.n_rows() == n());
+  if (info_ != 0) return info_;
+
+  x = b;
+  if (n() == 0 || b.n_cols() == 0) return 0;
+  return lapack_getrs(lu_, ipiv_, x, trans);
+}
+
+template<typename T>
+T LU<T>::det() const {
+  if (info_ != 0) return T(0);
+
+  T d = T(1);
+  for (std::size_t i = 0; i != n(); ++i) {
+    d *= lu_(i, i);
+    if (ipiv_(i) != int(i) + 1) d = -d;
+  }
+  return d;
+}
+
+template<typename T>
+int LU<T>::inverse(Matrix<T, 2> &inv) const {
+  if (info_ != 0) {
+    inv.clear();
+    return info_;
+  }
+
+  inv = lu_;
+  if (n() == 0) return 0;
+  return lapack_getri(inv, ipiv_);
+}
+
+template<typename T>
+T LU<T>::rcond(lapack_norm norm) const {
+  if (info_ != 0) return T(0);
+  if (n() == 0) return T(1);
+
+  T r = T(0);
+  lapack_gecon(lu_, norm == lapack_norm::one ? anorm_ : anorm_inf_, r, norm);
+  return r;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_LU_H_
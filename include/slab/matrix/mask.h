@@ -0,0 +1,581 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file mask.h
+/// @brief Boolean masks from element-wise comparisons, and masked selection
+/// and assignment
+///
+/// A Mask holds one bit per element of a matrix, in row-major order, packed
+/// in 64-bit words. The comparison operators of a Matrix or MatrixRef with
+/// a scalar or another matrix of the same extents produce a Mask, which
+/// combines with &, | and ^, and is used by masked_assign(), select() and
+/// where(): e.g. masked_assign(x, x < 0.0, 0.0) clips x at 0, and
+/// select(m, m.col(j) > t, 0) selects the rows of m where column j exceeds
+/// t.
+///
+/// All of them go through the elements 64 at a time, one word of the mask,
+/// with branch-free loops that vectorize; the elements of a matrix that is
+/// not contiguous are gathered in a buffer first. Large operands are split
+/// across OpenMP threads by blocks of words.
+
+#ifndef SLAB_MATRIX_MASK_H_
+#define SLAB_MATRIX_MASK_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/reduction.h"
+#include "slab/matrix/sort.h"
+#include "slab/matrix/indexing.h"
+
+/// @addtogroup mask MASKS
+/// @{
+
+/// @brief A bit-packed boolean matrix of order N
+template<std::size_t N>
+class Mask {
+ public:
+  Mask() : size_(0) { extents_.fill(0); }
+  explicit Mask(const std::array<std::size_t, N> &extents, bool value = false)
+      : extents_(extents), size_(matrix_impl::compute_size(extents)),
+        words_((size_ + 63) / 64, value ? ~std::uint64_t(0) : 0) {
+    clear_tail();
+  }
+
+  const std::array<std::size_t, N> &extents() const { return extents_; }
+  std::size_t extent(std::size_t n) const { return extents_[n]; }
+  std::size_t size() const { return size_; }
+
+  /// @brief The element at the given subscripts
+  template<typename... Dims>
+  bool operator()(Dims... dims) const {
+    static_assert(sizeof...(Dims) == N, "Mask::operator(): dimension mismatch");
+    const std::size_t args[N]{std::size_t(dims)...};
+    std::size_t i = 0;
+    for (std::size_t k = 0; k != N; ++k) {
+      assert(args[k] < extents_[k]);
+      i = i * extents_[k] + args[k];
+    }
+    return get(i);
+  }
+
+  /// @brief The element at row-major position i
+  bool get(std::size_t i) const {
+    assert(i < size_);
+    return (words_[i / 64] >> (i % 64)) & 1;
+  }
+  void set(std::size_t i, bool value = true) {
+    assert(i < size_);
+    const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+    if (value) words_[i / 64] |= bit;
+    else words_[i / 64] &= ~bit;
+  }
+
+  /// @brief The number of elements set
+  std::size_t count() const;
+  bool any() const {
+    return std::any_of(words_.begin(), words_.end(),
+                       [](std::uint64_t w) { return w != 0; });
+  }
+  bool all() const { return count() == size_; }
+
+  /// @brief The words of the elements 64 i to 64 i + 63, element 64 i in
+  /// the lowest bit; the bits past size() are 0
+  std::uint64_t *words() { return words_.data(); }
+  const std::uint64_t *words() const { return words_.data(); }
+  std::size_t n_words() const { return words_.size(); }
+
+  Mask operator~() const {
+    Mask res(*this);
+    for (std::uint64_t &w : res.words_) w = ~w;
+    res.clear_tail();
+    return res;
+  }
+  Mask &operator&=(const Mask &x) {
+    return combine(x, [](std::uint64_t a, std::uint64_t b) { return a & b; });
+  }
+  Mask &operator|=(const Mask &x) {
+    return combine(x, [](std::uint64_t a, std::uint64_t b) { return a | b; });
+  }
+  Mask &operator^=(const Mask &x) {
+    return combine(x, [](std::uint64_t a, std::uint64_t b) { return a ^ b; });
+  }
+
+ private:
+  void clear_tail() {
+    if (size_ % 64 != 0)
+      words_.back() &= (std::uint64_t(1) << (size_ % 64)) - 1;
+  }
+
+  template<typename F>
+  Mask &combine(const Mask &x, F f) {
+    assert(extents_ == x.extents_);
+    for (std::size_t w = 0; w != words_.size(); ++w)
+      words_[w] = f(words_[w], x.words_[w]);
+    return *this;
+  }
+
+  std::array<std::size_t, N> extents_;
+  std::size_t size_;
+  std::vector<std::uint64_t> words_;
+};
+
+template<std::size_t N>
+Mask<N> operator&(Mask<N> a, const Mask<N> &b) { return a &= b; }
+
+template<std::size_t N>
+Mask<N> operator|(Mask<N> a, const Mask<N> &b) { return a |= b; }
+
+template<std::size_t N>
+Mask<N> operator^(Mask<N> a, const Mask<N> &b) { return a ^= b; }
+
+namespace matrix_impl {
+
+inline std::size_t popcount64(std::uint64_t w) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(w);
+#else
+  std::size_t n = 0;
+  for (; w != 0; w &= w - 1) ++n;
+  return n;
+#endif
+}
+
+inline std::size_t ctz64(std::uint64_t w) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(w);
+#else
+  std::size_t n = 0;
+  for (; (w & 1) == 0; w >>= 1) ++n;
+  return n;
+#endif
+}
+
+// the number of words of a mask per parallel task
+constexpr std::size_t mask_block = 64;
+
+// f(w0, w1) on the blocks of words [w0, w1) of a mask, in parallel above
+// 8 blocks
+template<typename F>
+void for_word_blocks(std::size_t words, F f) {
+  const std::ptrdiff_t nb = (words + mask_block - 1) / mask_block;
+#pragma omp parallel for schedule(static) if(nb > 8)
+  for (std::ptrdiff_t b = 0; b < nb; ++b)
+    f(b * mask_block, std::min(words, (b + 1) * mask_block));
+}
+
+// The elements of a Matrix or MatrixRef by runs of consecutive row-major
+// positions, read in place if it is contiguous
+template<typename M>
+class run_reader {
+ public:
+  using T = Element_type<M>;
+
+  explicit run_reader(const M &m)
+      : x_(m.data()), contiguous_(is_contiguous(m)) {
+    const auto &d = m.descriptor();
+    len_ = d.extents[M::order_ - 1];
+    xs_ = d.strides[M::order_ - 1];
+    start_ = d.start;
+    if (!contiguous_ && d.size != 0) xo_ = line_offsets(d, M::order_ - 1);
+  }
+
+  // the elements at positions [i0, i0 + n), copied to buf unless
+  // contiguous
+  const T *get(std::size_t i0, std::size_t n, T *buf) const {
+    if (contiguous_) return x_ + start_ + i0;
+    std::size_t l = i0 / len_, j = i0 % len_;
+    for (std::size_t i = 0; i != n; ++i) {
+      buf[i] = x_[xo_[l] + j * xs_];
+      if (++j == len_) {
+        j = 0;
+        ++l;
+      }
+    }
+    return buf;
+  }
+
+  // the offset in data() of the element at position i
+  std::size_t offset(std::size_t i) const {
+    return contiguous_ ? start_ + i : xo_[i / len_] + (i % len_) * xs_;
+  }
+
+  bool contiguous() const { return contiguous_; }
+
+ private:
+  const T *x_;
+  bool contiguous_;
+  std::size_t len_, xs_, start_;
+  std::vector<std::size_t> xo_;
+};
+
+// A scalar read as a run of equal elements
+template<typename T>
+class scalar_reader {
+ public:
+  explicit scalar_reader(const T &v) { std::fill(v_, v_ + 64, v); }
+  const T *get(std::size_t, std::size_t, T *) const { return v_; }
+
+ private:
+  T v_[64];
+};
+
+// The bits pred(x[j], y[j]), j < len <= 64; a constant len of 64 lets
+// the loop vectorize
+template<typename T, typename P>
+inline std::uint64_t pack_bits(std::size_t len, const T *x, const T *y,
+                               P pred) {
+  std::uint64_t bits = 0;
+  for (std::size_t j = 0; j != len; ++j)
+    bits |= std::uint64_t(pred(x[j], y[j])) << j;
+  return bits;
+}
+
+// The mask of pred(a, b) for the elements of a and b, read by runs
+template<typename T, std::size_t N, typename A, typename B, typename P>
+Mask<N> compare(const std::array<std::size_t, N> &exts, const A &a,
+                const B &b, P pred) {
+  Mask<N> res(exts);
+  const std::size_t n = res.size();
+  std::uint64_t *words = res.words();
+  for_word_blocks(res.n_words(), [&](std::size_t w0, std::size_t w1) {
+    T abuf[64], bbuf[64];
+    for (std::size_t w = w0; w != w1; ++w) {
+      const std::size_t len = std::min<std::size_t>(64, n - w * 64);
+      const T *x = a.get(w * 64, len, abuf);
+      const T *y = b.get(w * 64, len, bbuf);
+      words[w] = len == 64 ? pack_bits(64, x, y, pred)
+                           : pack_bits(len, x, y, pred);
+    }
+  });
+  return res;
+}
+
+template<typename A, typename B, typename P>
+Mask<A::order_> compare_matrices(const A &a, const B &b, P pred) {
+  static_assert(Same<Element_type<A>, Element_type<B>>(),
+                "comparison: incompatible element types");
+  assert(a.descriptor().extents == b.descriptor().extents);
+  return compare<Element_type<A>>(a.descriptor().extents, run_reader<A>(a),
+                                  run_reader<B>(b), pred);
+}
+
+template<typename M, typename P>
+Mask<M::order_> compare_scalar(const M &m, const Element_type<M> &v,
+                               P pred) {
+  using T = Element_type<M>;
+  return compare<T>(m.descriptor().extents, run_reader<M>(m),
+                    scalar_reader<T>(v), pred);
+}
+
+struct less_op {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const { return a < b; }
+};
+
+struct less_equal_op {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const { return a <= b; }
+};
+
+struct equal_op {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const { return a == b; }
+};
+
+struct not_equal_op {
+  template<typename T>
+  bool operator()(const T &a, const T &b) const { return a != b; }
+};
+
+// y at the elements of mask gets the corresponding elements of src
+template<typename M, typename S>
+void masked_fill(M &m, const Mask<M::order_> &mask, const S &src) {
+  using T = Element_type<M>;
+  assert(m.descriptor().extents == mask.extents());
+  const run_reader<M> dst(m);
+  T *y = m.data();
+  const std::size_t n = mask.size();
+  const std::uint64_t *words = mask.words();
+  for_word_blocks(mask.n_words(), [&](std::size_t w0, std::size_t w1) {
+    T buf[64];
+    for (std::size_t w = w0; w != w1; ++w) {
+      std::uint64_t bits = words[w];
+      if (bits == 0) continue;
+      const std::size_t len = std::min<std::size_t>(64, n - w * 64);
+      const T *x = src.get(w * 64, len, buf);
+      if (dst.contiguous()) {
+        T *p = y + dst.offset(w * 64);
+        for (std::size_t j = 0; j != len; ++j)
+          p[j] = (bits >> j) & 1 ? x[j] : p[j];
+      } else {
+        for (; bits != 0; bits &= bits - 1) {
+          const std::size_t j = ctz64(bits);
+          y[dst.offset(w * 64 + j)] = x[j];
+        }
+      }
+    }
+  });
+}
+
+template<typename T, std::size_t N, typename A, typename B>
+Matrix<T, N> where_fill(const Mask<N> &mask, const A &a, const B &b) {
+  Matrix<T, N> res(mask.extents());
+  T *y = res.data();
+  const std::size_t n = mask.size();
+  const std::uint64_t *words = mask.words();
+  for_word_blocks(mask.n_words(), [&](std::size_t w0, std::size_t w1) {
+    T abuf[64], bbuf[64];
+    for (std::size_t w = w0; w != w1; ++w) {
+      const std::uint64_t bits = words[w];
+      const std::size_t len = std::min<std::size_t>(64, n - w * 64);
+      const T *x = a.get(w * 64, len, abuf);
+      const T *z = b.get(w * 64, len, bbuf);
+      T *p = y + w * 64;
+      for (std::size_t j = 0; j != len; ++j)
+        p[j] = (bits >> j) & 1 ? x[j] : z[j];
+    }
+  });
+  return res;
+}
+
+// The positions of the elements set
+template<std::size_t N>
+Matrix<std::size_t, 1> set_positions(const Mask<N> &mask) {
+  Matrix<std::size_t, 1> idx(mask.count());
+  std::size_t k = 0;
+  for (std::size_t w = 0; w != mask.n_words(); ++w)
+    for (std::uint64_t bits = mask.words()[w]; bits != 0; bits &= bits - 1)
+      idx(k++) = w * 64 + ctz64(bits);
+  return idx;
+}
+
+} // namespace matrix_impl
+
+template<std::size_t N>
+std::size_t Mask<N>::count() const {
+  std::size_t n = 0;
+  for (std::uint64_t w : words_) n += matrix_impl::popcount64(w);
+  return n;
+}
+
+/// @brief Element-wise comparisons of a Matrix or MatrixRef with a scalar
+/// or with another of the same extents; NaN compares false except with !=
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator<(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(m, v, matrix_impl::less_op());
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator<=(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(m, v, matrix_impl::less_equal_op());
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator>(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(
+      m, v, [](const Element_type<M> &a, const Element_type<M> &b) {
+        return b < a;
+      });
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator>=(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(
+      m, v, [](const Element_type<M> &a, const Element_type<M> &b) {
+        return b <= a;
+      });
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator==(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(m, v, matrix_impl::equal_op());
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator!=(const M &m, const Element_type<M> &v) {
+  return matrix_impl::compare_scalar(m, v, matrix_impl::not_equal_op());
+}
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator<(const Element_type<M> &v, const M &m) { return m > v; }
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator<=(const Element_type<M> &v, const M &m) { return m >= v; }
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator>(const Element_type<M> &v, const M &m) { return m < v; }
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator>=(const Element_type<M> &v, const M &m) { return m <= v; }
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator==(const Element_type<M> &v, const M &m) { return m == v; }
+
+template<typename M>
+Enable_if<Matrix_type<M>(), Mask<M::order_>>
+operator!=(const Element_type<M> &v, const M &m) { return m != v; }
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator<(const A &a, const B &b) {
+  return matrix_impl::compare_matrices(a, b, matrix_impl::less_op());
+}
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator<=(const A &a, const B &b) {
+  return matrix_impl::compare_matrices(a, b, matrix_impl::less_equal_op());
+}
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator>(const A &a, const B &b) { return b < a; }
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator>=(const A &a, const B &b) { return b <= a; }
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator==(const A &a, const B &b) {
+  return matrix_impl::compare_matrices(a, b, matrix_impl::equal_op());
+}
+
+template<typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>() && A::order_ == B::order_,
+          Mask<A::order_>>
+operator!=(const A &a, const B &b) {
+  return matrix_impl::compare_matrices(a, b, matrix_impl::not_equal_op());
+}
+
+/// @brief Sets the elements of m where mask is set to value, e.g.
+/// masked_assign(x, x < 0.0, 0.0)
+template<typename M>
+Enable_if<Matrix_type<M>(), void>
+masked_assign(M &&m, const Mask<std::decay<M>::type::order_> &mask,
+              const Element_type<M> &value) {
+  matrix_impl::masked_fill(m, mask,
+                           matrix_impl::scalar_reader<Element_type<M>>(value));
+}
+
+/// @brief Sets the elements of m where mask is set to the corresponding
+/// elements of values, of the same extents
+template<typename M, typename V>
+Enable_if<Matrix_type<M>() && Matrix_type<V>(), void>
+masked_assign(M &&m, const Mask<std::decay<M>::type::order_> &mask,
+              const V &values) {
+  static_assert(Same<Element_type<M>, Element_type<V>>(),
+                "masked_assign: incompatible element types");
+  assert(values.descriptor().extents == mask.extents());
+  matrix_impl::masked_fill(m, mask, matrix_impl::run_reader<V>(values));
+}
+
+/// @brief The elements of m where mask is set, in row-major order
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, 1>>
+select(const M &m, const Mask<M::order_> &mask) {
+  using T = Element_type<M>;
+  assert(m.descriptor().extents == mask.extents());
+  const std::uint64_t *words = mask.words();
+  const std::size_t nw = mask.n_words(), n = mask.size();
+  // the first output position of each block of words
+  const std::size_t nb =
+      (nw + matrix_impl::mask_block - 1) / matrix_impl::mask_block;
+  std::vector<std::size_t> pos(nb + 1, 0);
+  matrix_impl::for_word_blocks(nw, [&](std::size_t w0, std::size_t w1) {
+    std::size_t c = 0;
+    for (std::size_t w = w0; w != w1; ++w)
+      c += matrix_impl::popcount64(words[w]);
+    pos[w0 / matrix_impl::mask_block + 1] = c;
+  });
+  std::partial_sum(pos.begin(), pos.end(), pos.begin());
+
+  Matrix<T, 1> res(pos[nb]);
+  T *y = res.data();
+  const matrix_impl::run_reader<M> src(m);
+  matrix_impl::for_word_blocks(nw, [&](std::size_t w0, std::size_t w1) {
+    T buf[64];
+    std::size_t k = pos[w0 / matrix_impl::mask_block];
+    for (std::size_t w = w0; w != w1; ++w) {
+      std::uint64_t bits = words[w];
+      if (bits == 0) continue;
+      const T *x = src.get(w * 64, std::min<std::size_t>(64, n - w * 64),
+                           buf);
+      for (; bits != 0; bits &= bits - 1) y[k++] = x[matrix_impl::ctz64(bits)];
+    }
+  });
+  return res;
+}
+
+/// @brief The slabs of m along axis where the 1-D mask is set, e.g. the
+/// rows where a column exceeds a threshold: select(m, m.col(j) > t, 0)
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+select(const M &m, const Mask<1> &mask, std::size_t axis) {
+  assert(axis < M::order_);
+  assert(mask.size() == m.descriptor().extents[axis]);
+  return take(m, matrix_impl::set_positions(mask), axis);
+}
+
+/// @brief The elements of a where mask is set and of b elsewhere; a and b
+/// are matrices of the extents of mask or scalars
+template<std::size_t N, typename A, typename B>
+Enable_if<Matrix_type<A>() && Matrix_type<B>(), Matrix<Element_type<A>, N>>
+where(const Mask<N> &mask, const A &a, const B &b) {
+  static_assert(Same<Element_type<A>, Element_type<B>>(),
+                "where: incompatible element types");
+  assert(a.descriptor().extents == mask.extents());
+  assert(b.descriptor().extents == mask.extents());
+  return matrix_impl::where_fill<Element_type<A>>(
+      mask, matrix_impl::run_reader<A>(a), matrix_impl::run_reader<B>(b));
+}
+
+template<std::size_t N, typename A>
+Enable_if<Matrix_type<A>(), Matrix<Element_type<A>, N>>
+where(const Mask<N> &mask, const A &a, const Element_type<A> &b) {
+  using T = Element_type<A>;
+  assert(a.descriptor().extents == mask.extents());
+  return matrix_impl::where_fill<T>(mask, matrix_impl::run_reader<A>(a),
+                                    matrix_impl::scalar_reader<T>(b));
+}
+
+template<std::size_t N, typename B>
+Enable_if<Matrix_type<B>(), Matrix<Element_type<B>, N>>
+where(const Mask<N> &mask, const Element_type<B> &a, const B &b) {
+  using T = Element_type<B>;
+  assert(b.descriptor().extents == mask.extents());
+  return matrix_impl::where_fill<T>(mask, matrix_impl::scalar_reader<T>(a),
+                                    matrix_impl::run_reader<B>(b));
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_MASK_H_
@@ -102,7 +102,8 @@ class Matrix : public MatrixBase<T, N> {
   template<typename F>
   Matrix &apply(F f);                          // f(x) for every element x
 
-  // f(x, mx) for corresponding elements of *this and m
+  // f(x, mx) for corresponding elements of *this and m, which is broadcast
+  // to the extents of *this, in order; an m overlapping *this is copied first
   template<typename M, typename F>
   Enable_if<Matrix_type<M>(), Matrix &>
   apply(const M &m, F f);
@@ -115,6 +116,9 @@ class Matrix : public MatrixBase<T, N> {
   Matrix &operator/=(const T &value);          // scalar division
   Matrix &operator%=(const T &value);          // scalar modulo
 
+  // the operands below are broadcast to the extents of *this, e.g. a
+  // vector to every row of a matrix, see broadcast.h
+
   // matrix addition
   template<typename M>
   Enable_if<Matrix_type<M>(), Matrix &> operator+=(const M &x);
@@ -182,6 +186,7 @@ Enable_if<matrix_impl::Requesting_slice<Args...>(), MatrixRef<T, N>>
 Matrix<T, N>::operator()(const Args &... args) {
   MatrixSlice<N> d;
   d.start = matrix_impl::do_slice(this->desc_, d, args...);
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
@@ -191,6 +196,7 @@ Enable_if<matrix_impl::Requesting_slice<Args...>(), const MatrixRef<T, N>>
 Matrix<T, N>::operator()(const Args &... args) const {
   MatrixSlice<N> d;
   d.start = matrix_impl::do_slice(this->desc_, d, args...);
+  d.size = matrix_impl::compute_size(d.extents);
   return {d, data()};
 }
 
@@ -214,7 +220,7 @@ MatrixRef<const T, N - 1> Matrix<T, N>::row(std::size_t n) const {
 // col
 template<typename T, std::size_t N>
 MatrixRef<T, N - 1> Matrix<T, N>::col(std::size_t n) {
-  assert(n < this->cols());
+  assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, data()};
@@ -222,7 +228,7 @@ MatrixRef<T, N - 1> Matrix<T, N>::col(std::size_t n) {
 
 template<typename T, std::size_t N>
 MatrixRef<const T, N - 1> Matrix<T, N>::col(std::size_t n) const {
-  assert(n < this->cols());
+  assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, data()};
@@ -238,13 +244,7 @@ Matrix<T, N> &Matrix<T, N>::apply(F f) {
 template<typename T, std::size_t N>
 template<typename M, typename F>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::apply(const M &m, F f) {
-  assert(same_extents(this->desc_, m.descriptor()));
-  auto j = m.begin();
-  for (auto i = begin(); i != end(); ++i) {
-    f(*i, *j);
-    ++j;
-  }
-
+  matrix_impl::broadcast_update(data(), this->desc_, m, false, f);
   return *this;
 }
 
@@ -276,43 +276,41 @@ Matrix<T, N> &Matrix<T, N>::operator%=(const T &val) {
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator+=(const M &m) {
-  //static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a += b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a += b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator-=(const M &m) {
-  //static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a -= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a -= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator*=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a *= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a *= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator/=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a /= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a /= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), Matrix<T, N> &> Matrix<T, N>::operator%=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a %= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a %= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
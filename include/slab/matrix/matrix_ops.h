@@ -147,132 +147,84 @@ Matrix<T, N> operator%(const MatrixRef<T, N> &x, const T &val) {
   return res;
 }
 
+// Element-wise operations between Matrices and MatrixRefs, broadcast
+//
+// The operands are broadcast together as in NumPy, see broadcast.h: an
+// operand of lower order is repeated along the missing leading axes, e.g. a
+// vector is combined with every row of a matrix, so that X - mu centers the
+// columns of X, and an extent 1 is repeated along its axis, e.g. that of
+// as_column(v).
+
+template<typename A, typename B>
+using Broadcast_result = Enable_if<
+    Matrix_type<A>() && Matrix_type<B>() && (A::order_ > 0) &&
+        (B::order_ > 0) && Same<Element_type<A>, Element_type<B>>(),
+    Matrix<Element_type<A>, (A::order_ > B::order_ ? A::order_ : B::order_)>>;
+
 // Matrix Addtion
 //
 // res = A + B
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator+(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator+(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator+(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator+(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res += b;
-  return res;
+template<typename A, typename B>
+Broadcast_result<A, B> operator+(const A &a, const B &b) {
+  using T = Element_type<A>;
+  return matrix_impl::broadcast_binary<T, Broadcast_result<A, B>::order_>(
+      a, b, [](const T &x, const T &y) { return x + y; });
 }
 
 // Matrix Subtraction
 //
 // res = A - B
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator-(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator-(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator-(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator-(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res -= b;
-  return res;
+template<typename A, typename B>
+Broadcast_result<A, B> operator-(const A &a, const B &b) {
+  using T = Element_type<A>;
+  return matrix_impl::broadcast_binary<T, Broadcast_result<A, B>::order_>(
+      a, b, [](const T &x, const T &y) { return x - y; });
 }
 
 // Element-wise Multiplication
 //
 // res = A * B
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator*(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator*(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator*(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator*(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res *= b;
-  return res;
+template<typename A, typename B>
+Broadcast_result<A, B> operator*(const A &a, const B &b) {
+  using T = Element_type<A>;
+  return matrix_impl::broadcast_binary<T, Broadcast_result<A, B>::order_>(
+      a, b, [](const T &x, const T &y) { return x * y; });
 }
 
 // Element-wise Division
 //
 // res = A / B
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator/(const Matrix<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
-}
-
-template<typename T, std::size_t N>
-Matrix<T, N> operator/(const MatrixRef<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+template<typename A, typename B>
+Broadcast_result<A, B> operator/(const A &a, const B &b) {
+  using T = Element_type<A>;
+  return matrix_impl::broadcast_binary<T, Broadcast_result<A, B>::order_>(
+      a, b, [](const T &x, const T &y) { return x / y; });
 }
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator/(const Matrix<T, N> &a, const MatrixRef<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+// A vector v of n elements viewed as a 1 x n matrix, which broadcasts
+// across the rows of an m x n matrix
+template<typename V>
+Enable_if<Vector_type<V>(), MatrixRef<const Element_type<V>, 2>>
+as_row(const V &v) {
+  const MatrixSlice<1> &d = v.descriptor();
+  return {MatrixSlice<2>(d.start, {1, d.extents[0]},
+                         {d.extents[0] * d.strides[0], d.strides[0]}),
+          v.data()};
 }
 
-template<typename T, std::size_t N>
-Matrix<T, N> operator/(const MatrixRef<T, N> &a, const Matrix<T, N> &b) {
-  Matrix<T, N> res = a;
-  res /= b;
-  return res;
+// A vector v of m elements viewed as an m x 1 matrix, which broadcasts
+// across the columns of an m x n matrix: X / as_column(s) divides row i
+// by s(i)
+template<typename V>
+Enable_if<Vector_type<V>(), MatrixRef<const Element_type<V>, 2>>
+as_column(const V &v) {
+  const MatrixSlice<1> &d = v.descriptor();
+  return {MatrixSlice<2>(d.start, {d.extents[0], 1}, {d.strides[0], 1}),
+          v.data()};
 }
 
 template<typename T>
@@ -368,6 +320,8 @@ Matrix<T, 2> matmul(const Matrix<T, 2> &a, const Matrix<T, 2> &b) {
   return c;
 }
 
+// The double and float products go through the GemmDispatcher, which picks
+// an inline kernel, single-threaded BLAS or threaded BLAS from their size.
 template<>
 Matrix<double, 2>
 matmul(const Matrix<double, 2> &a, const Matrix<double, 2> &b) {
@@ -382,22 +336,11 @@ matmul(const Matrix<double, 2> &a, const Matrix<double, 2> &b) {
   const int ldc = b.n_cols();
 
   Matrix<double, 2> c(m, n);
-  cblas_dgemm(
-      CblasRowMajor,             // Layout: row-major (CblasRowMajor) or column-major (CblasColMajor).
-      CblasNoTrans,              // transa: CblasNoTrans/CblasTrans/CblasConjTrans.
-      CblasNoTrans,              // transb: CblasNoTrans/CblasTrans/CblasConjTrans.
-      m,                         // m     : the number of rows of the matrix op(A) and of the matrix C.
-      n,                         // n     : the number of cols of the matrix op(B) and of the matrix C.
-      k,                         // k     : the number of cols of the matrix op(A) and the number of rows of the matrix op(B).
-      (const double) 1.0,        // alpha : the scalar alpha.
-      (const double *) (a.data() + a.descriptor().start),  // the matrix A.
-      lda,                       // lda   : the leading dimension of a.
-      (const double *) (b.data() + b.descriptor().start),  // the matrix B.
-      ldb,                       // ldb   : the leading dimension of b.
-      (const double) 0.0,        // beta  : the scalar beta.
-      (double *) c.data(),       // c     : the matrix C.
-      ldc                        // ldc   : the leading dimension of c.
-    );
+  GemmDispatcher::instance().gemm<double>(
+      m, n, k,
+      a.data() + a.descriptor().start, lda,
+      b.data() + b.descriptor().start, ldb,
+      c.data(), ldc);
 
   return c;
 }
@@ -416,22 +359,11 @@ matmul(const Matrix<float, 2> &a, const Matrix<float, 2> &b) {
   const int ldc = b.n_cols();
 
   Matrix<float, 2> c(m, n);
-  cblas_sgemm(
-      CblasRowMajor,
-      CblasNoTrans,
-      CblasNoTrans,
-      m,
-      n,
-      k,
-      (const float) 1.0,
-      (const float *) (a.data() + a.descriptor().start),
-      lda,
-      (const float *) (b.data() + b.descriptor().start),
-      ldb,
-      (const float) 0.0,
-      (float *) c.data(),
-      ldc
-  );
+  GemmDispatcher::instance().gemm<float>(
+      m, n, k,
+      a.data() + a.descriptor().start, lda,
+      b.data() + b.descriptor().start, ldb,
+      c.data(), ldc);
 
   return c;
 }
@@ -463,11 +395,7 @@ auto reshape(const Matrix<T, N> &a, Args... args) -> decltype(Matrix<T, sizeof..
 template<typename T>
 Matrix<T, 2> transpose(const Matrix<T, 2> &a) {
   Matrix<T, 2> res(a.n_cols(), a.n_rows());
-  for (std::size_t i = 0; i < a.n_rows(); ++i) {
-    for (std::size_t j = 0; j < a.n_rows(); ++j) {
-      res(j, i) = a(i, j);
-    }
-  }
+  matrix_impl::transpose_copy(a.n_rows(), a.n_cols(), a.data(), res.data());
 
   return res;
 }
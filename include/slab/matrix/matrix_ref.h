@@ -93,7 +93,8 @@ class MatrixRef : public MatrixBase<T, N> {
   template<typename F>
   MatrixRef &apply(F f);                             // f(x) for every element x
 
-  // f(x, mx) for corresponding elements of *this and m
+  // f(x, mx) for corresponding elements of *this and m, which is broadcast
+  // to the extents of *this, in order; an m overlapping *this is copied first
   template<typename M, typename F>
   Enable_if<Matrix_type<M>(), MatrixRef &>
   apply(const M &m, F f);
@@ -106,6 +107,9 @@ class MatrixRef : public MatrixBase<T, N> {
   MatrixRef &operator/=(const T &value);             // scalar division
   MatrixRef &operator%=(const T &value);             // scalar modulo
 
+  // the operands below are broadcast to the extents of *this, e.g. a
+  // vector to every row of a matrix, see broadcast.h
+
   // matrix addition
   template<typename M>
   Enable_if<Matrix_type<M>(), MatrixRef &> operator+=(const M &x);
@@ -198,7 +202,7 @@ MatrixRef<const T, N - 1> MatrixRef<T, N>::row(size_t n) const {
 // col
 template<typename T, size_t N>
 MatrixRef<T, N - 1> MatrixRef<T, N>::col(size_t n) {
-  assert(n < this->cols());
+  assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, ptr_};
@@ -206,7 +210,7 @@ MatrixRef<T, N - 1> MatrixRef<T, N>::col(size_t n) {
 
 template<typename T, size_t N>
 MatrixRef<const T, N - 1> MatrixRef<T, N>::col(size_t n) const {
-  assert(n < this->cols());
+  assert(n < this->n_cols());
   MatrixSlice<N - 1> col;
   matrix_impl::slice_dim<1>(n, this->desc_, col);
   return {col, ptr_};
@@ -223,13 +227,7 @@ MatrixRef<T, N> &MatrixRef<T, N>::apply(F f) {
 template<typename T, std::size_t N>
 template<typename M, typename F>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::apply(const M &m, F f) {
-  assert(same_extents(this->desc_, m.descriptor()));
-  auto j = m.begin();
-  for (auto i = begin(); i != end(); ++i) {
-    f(*i, *j);
-    ++j;
-  }
-
+  matrix_impl::broadcast_update(data(), this->desc_, m, false, f);
   return *this;
 }
 
@@ -261,43 +259,41 @@ MatrixRef<T, N> &MatrixRef<T, N>::operator%=(const T &val) {
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator+=(const M &m) {
-  //static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a += b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a += b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator-=(const M &m) {
-  //static_assert(m.order_ == N, "+=: mismatched Matrix dimensions");
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a -= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a -= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator*=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a *= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a *= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator/=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a /= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a /= b; });
+  return *this;
 }
 
 template<typename T, std::size_t N>
 template<typename M>
 Enable_if<Matrix_type<M>(), MatrixRef<T, N> &> MatrixRef<T, N>::operator%=(const M &m) {
-  assert(same_extents(this->desc_, m.descriptor()));  // make sure sizes match
-
-  return apply(m, [&](T &a, const Value_type<M> &b) { a %= b; });
+  matrix_impl::broadcast_update(data(), this->desc_, m, true,
+                                [](T &a, const Value_type<M> &b) { a %= b; });
+  return *this;
 }
 
 template<typename T>
@@ -1,13 +1,104 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file packed_matrix.h
+/// @brief Triangular and symmetric matrices in packed storage
+///
+/// A packed n x n matrix only stores the n * (n + 1) / 2 elements of one
+/// triangle, row by row, which halves the memory of a dense matrix. The
+/// products and solves run the packed BLAS routines (tpmv, tpsv, spmv, spr)
+/// and the Cholesky factorization the packed LAPACK ones (pptrf, pptrs).
+
 #ifndef SLAB_MATRIX_PACKED_MATRIX_H_
 #define SLAB_MATRIX_PACKED_MATRIX_H_
 
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/lapack_interface.h"
+
+/// @addtogroup packed_matrix PACKED MATRICES
+/// @{
+
+/// @brief The storage shared by TriangularMatrix and SymmetricMatrix: the
+/// uplo triangle of an n x n matrix, packed row by row
 template<typename T>
-class TriangularMatrix {
+class PackedMatrixBase {
  public:
   using value_type = T;
   using iterator = typename std::vector<T>::iterator;
-  using const_iterator  = typename std::vector<T>::const_iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  /// @brief The number of rows and columns
+  std::size_t n() const { return n_; }
+  std::size_t n_rows() const { return n_; }
+  std::size_t n_cols() const { return n_; }
+  /// @brief The number of stored elements, n * (n + 1) / 2
+  std::size_t size() const { return elems_.size(); }
+  lapack_uplo uplo() const { return uplo_; }
+
+  /// @brief True if (i, j) is in the stored triangle
+  bool stored(std::size_t i, std::size_t j) const {
+    return uplo_ == lapack_uplo::lower ? j <= i : i <= j;
+  }
+
+  T *data() { return elems_.data(); }
+  const T *data() const { return elems_.data(); }
+
+  iterator begin() { return elems_.begin(); }
+  const_iterator begin() const { return elems_.cbegin(); }
+  iterator end() { return elems_.end(); }
+  const_iterator end() const { return elems_.cend(); }
 
+ protected:
+  PackedMatrixBase() = default;
+  PackedMatrixBase(std::size_t n, lapack_uplo uplo)
+      : elems_(n * (n + 1) / 2), n_(n), uplo_(uplo) {}
+
+  // the position of (i, j), which must be in the stored triangle
+  std::size_t index(std::size_t i, std::size_t j) const {
+    assert(i < n_ && j < n_ && stored(i, j));
+    if (uplo_ == lapack_uplo::lower) return i * (i + 1) / 2 + j;
+    return i * (2 * n_ - i + 1) / 2 + (j - i);
+  }
+
+  // packs the uplo triangle of a
+  void pack(const Matrix<T, 2> &a) {
+    assert(a.n_rows() == n_ && a.n_cols() == n_);
+    T *p = elems_.data();
+    for (std::size_t i = 0; i != n_; ++i) {
+      const std::size_t j0 = (uplo_ == lapack_uplo::lower) ? 0 : i;
+      const std::size_t j1 = (uplo_ == lapack_uplo::lower) ? i + 1 : n_;
+      const T *ai = a.data() + i * n_;
+      p = std::copy(ai + j0, ai + j1, p);
+    }
+  }
+
+  CBLAS_UPLO cblas_uplo() const {
+    return uplo_ == lapack_uplo::lower ? CblasLower : CblasUpper;
+  }
+
+  std::vector<T> elems_;
+  std::size_t n_ = 0;
+  lapack_uplo uplo_ = lapack_uplo::lower;
+};
+
+/// @brief A lower or upper triangular matrix in packed storage
+template<typename T>
+class TriangularMatrix : public PackedMatrixBase<T> {
+ public:
   TriangularMatrix() = default;
   TriangularMatrix(TriangularMatrix &&) = default;
   TriangularMatrix &operator=(TriangularMatrix &&) = default;
@@ -15,17 +106,230 @@ class TriangularMatrix {
   TriangularMatrix &operator=(TriangularMatrix const &) = default;
   ~TriangularMatrix() = default;
 
-  TriangularMatrix(std::size_t, const std::initializer_list<T> &);
+  /// @brief An n x n triangular matrix of zeros
+  ///
+  /// @param unit if true, the diagonal is taken to be ones and not read.
+  explicit TriangularMatrix(std::size_t n,
+                            lapack_uplo uplo = lapack_uplo::lower,
+                            bool unit = false)
+      : PackedMatrixBase<T>(n, uplo), is_unit_tri_(unit) {}
+
+  /// @brief An n x n triangular matrix from its n * (n + 1) / 2 elements,
+  /// row by row
+  TriangularMatrix(std::size_t n, const std::initializer_list<T> &init,
+                   lapack_uplo uplo = lapack_uplo::lower, bool unit = false);
+
+  /// @brief The uplo triangle of a square matrix
+  explicit TriangularMatrix(const Matrix<T, 2> &a,
+                            lapack_uplo uplo = lapack_uplo::lower,
+                            bool unit = false)
+      : PackedMatrixBase<T>(a.n_rows(), uplo), is_unit_tri_(unit) {
+    this->pack(a);
+  }
+
+  /// @brief True if the diagonal is made of ones that are not stored
+  bool is_unit() const { return is_unit_tri_; }
+
+  /// @brief The element (i, j), in the stored triangle
+  T &operator()(std::size_t i, std::size_t j) {
+    return this->elems_[this->index(i, j)];
+  }
+  /// @brief The element (i, j) of the matrix, zero outside of the triangle
+  T operator()(std::size_t i, std::size_t j) const {
+    if (i == j && is_unit_tri_) return T(1);
+    return this->stored(i, j) ? this->elems_[this->index(i, j)] : T(0);
+  }
+
+  /// @brief The dense matrix, with zeros outside of the triangle
+  Matrix<T, 2> dense() const;
+
+  CBLAS_DIAG cblas_diag() const { return is_unit_tri_ ? CblasUnit : CblasNonUnit; }
+  using PackedMatrixBase<T>::cblas_uplo;
+
  private:
-  std::vector<T> elem_;
   bool is_unit_tri_ = false;
 };
 
 template<typename T>
-TriangularMatrix::TriangularMatrix(std::size_t n,
-                                   const std::initializer_list<T> &init)
-{
+TriangularMatrix<T>::TriangularMatrix(std::size_t n,
+                                      const std::initializer_list<T> &init,
+                                      lapack_uplo uplo, bool unit)
+    : PackedMatrixBase<T>(n, uplo), is_unit_tri_(unit) {
+  assert(init.size() == this->size());
+  std::copy(init.begin(), init.end(), this->elems_.begin());
+}
+
+template<typename T>
+Matrix<T, 2> TriangularMatrix<T>::dense() const {
+  const std::size_t n = this->n();
+  Matrix<T, 2> a(n, n);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != n; ++j) a(i, j) = (*this)(i, j);
+  return a;
+}
+
+/// @brief A symmetric matrix in packed storage, only one triangle of which
+/// is stored
+template<typename T>
+class SymmetricMatrix : public PackedMatrixBase<T> {
+ public:
+  SymmetricMatrix() = default;
+  SymmetricMatrix(SymmetricMatrix &&) = default;
+  SymmetricMatrix &operator=(SymmetricMatrix &&) = default;
+  SymmetricMatrix(SymmetricMatrix const &) = default;
+  SymmetricMatrix &operator=(SymmetricMatrix const &) = default;
+  ~SymmetricMatrix() = default;
+
+  /// @brief An n x n symmetric matrix of zeros
+  explicit SymmetricMatrix(std::size_t n,
+                           lapack_uplo uplo = lapack_uplo::lower)
+      : PackedMatrixBase<T>(n, uplo) {}
+
+  /// @brief An n x n symmetric matrix from the n * (n + 1) / 2 elements of
+  /// its uplo triangle, row by row
+  SymmetricMatrix(std::size_t n, const std::initializer_list<T> &init,
+                  lapack_uplo uplo = lapack_uplo::lower)
+      : PackedMatrixBase<T>(n, uplo) {
+    assert(init.size() == this->size());
+    std::copy(init.begin(), init.end(), this->elems_.begin());
+  }
+
+  /// @brief The symmetric matrix whose uplo triangle is that of a
+  explicit SymmetricMatrix(const Matrix<T, 2> &a,
+                           lapack_uplo uplo = lapack_uplo::lower)
+      : PackedMatrixBase<T>(a.n_rows(), uplo) {
+    this->pack(a);
+  }
+
+  /// @brief The element (i, j), which is also the element (j, i)
+  T &operator()(std::size_t i, std::size_t j) {
+    return this->stored(i, j) ? this->elems_[this->index(i, j)]
+                              : this->elems_[this->index(j, i)];
+  }
+  const T &operator()(std::size_t i, std::size_t j) const {
+    return this->stored(i, j) ? this->elems_[this->index(i, j)]
+                              : this->elems_[this->index(j, i)];
+  }
+
+  /// @brief The dense matrix, with both triangles filled in
+  Matrix<T, 2> dense() const {
+    const std::size_t n = this->n();
+    Matrix<T, 2> a(n, n);
+    for (std::size_t i = 0; i != n; ++i)
+      for (std::size_t j = 0; j != n; ++j) a(i, j) = (*this)(i, j);
+    return a;
+  }
+
+  using PackedMatrixBase<T>::cblas_uplo;
+};
+
+/// @brief x := op(A) * x, with A a packed triangular matrix (tpmv)
+template<typename T>
+void blas_tpmv(const TriangularMatrix<T> &a, Matrix<T, 1> &x,
+               blas_trans trans = blas_trans::no_trans) {
+  assert(a.n() == x.size());
+  if (a.n() == 0) return;
+  blas_impl::tpmv(CblasRowMajor, a.cblas_uplo(),
+                  static_cast<CBLAS_TRANSPOSE>(trans), a.cblas_diag(), a.n(),
+                  a.data(), x.data(), 1);
+}
+
+/// @brief Solves op(A) * x = b in place, with A a packed triangular matrix
+/// (tpsv)
+///
+/// @param x the right-hand side b on entry, the solution on exit.
+template<typename T>
+void blas_tpsv(const TriangularMatrix<T> &a, Matrix<T, 1> &x,
+               blas_trans trans = blas_trans::no_trans) {
+  assert(a.n() == x.size());
+  if (a.n() == 0) return;
+  blas_impl::tpsv(CblasRowMajor, a.cblas_uplo(),
+                  static_cast<CBLAS_TRANSPOSE>(trans), a.cblas_diag(), a.n(),
+                  a.data(), x.data(), 1);
+}
+
+/// @brief y := alpha * A * x + beta * y, with A a packed symmetric matrix
+/// (spmv)
+template<typename T>
+void blas_spmv(const T &alpha, const SymmetricMatrix<T> &a,
+               const Matrix<T, 1> &x, const T &beta, Matrix<T, 1> &y) {
+  assert(a.n() == x.size());
+  assert(a.n() == y.size());
+  if (a.n() == 0) return;
+  blas_impl::spmv(CblasRowMajor, a.cblas_uplo(), a.n(), alpha, a.data(),
+                  x.data(), 1, beta, y.data(), 1);
+}
+
+/// @brief A := alpha * x * x' + A, with A a packed symmetric matrix (spr)
+template<typename T>
+void blas_spr(const T &alpha, const Matrix<T, 1> &x, SymmetricMatrix<T> &a) {
+  assert(a.n() == x.size());
+  if (a.n() == 0) return;
+  blas_impl::spr(CblasRowMajor, a.cblas_uplo(), a.n(), alpha, x.data(), 1,
+                 a.data());
+}
+
+/// @brief The product of a packed triangular matrix and a vector
+template<typename T>
+Matrix<T, 1> matmul(const TriangularMatrix<T> &a, const Matrix<T, 1> &x) {
+  Matrix<T, 1> y = x;
+  blas_tpmv(a, y);
+  return y;
+}
+
+/// @brief The product of a packed symmetric matrix and a vector
+template<typename T>
+Matrix<T, 1> matmul(const SymmetricMatrix<T> &a, const Matrix<T, 1> &x) {
+  Matrix<T, 1> y(a.n());
+  blas_spmv(T(1), a, x, T(0), y);
+  return y;
+}
+
+/// @brief Computes the Cholesky factorization of a packed symmetric positive
+/// definite matrix, A = L * L' or A = U' * U (pptrf)
+///
+/// @param a the matrix on entry, the factor in its stored triangle on exit.
+/// @return 0 on success, i > 0 if the leading minor of order i is not
+///         positive definite.
+template<typename T>
+int lapack_pptrf(SymmetricMatrix<T> &a) {
+  if (a.n() == 0) return 0;
+  // the row-major packing of a triangle is the column-major packing of the
+  // other one, and A' = A
+  return lapack_impl::pptrf(matrix_impl::col_major_uplo(a.uplo()), a.n(),
+                            a.data());
+}
+
+/// @brief Solves A * x = b with the packed Cholesky factor computed by
+/// lapack_pptrf (pptrs)
+///
+/// @param b the right-hand side on entry, the solution on exit.
+template<typename T>
+int lapack_pptrs(const SymmetricMatrix<T> &a, Matrix<T, 1> &b) {
+  assert(a.n() == b.size());
+  if (a.n() == 0) return 0;
+  return lapack_impl::pptrs(matrix_impl::col_major_uplo(a.uplo()), a.n(), 1,
+                            a.data(), b.data(), a.n());
+}
+
+/// @brief Solves A * X = B with the packed Cholesky factor computed by
+/// lapack_pptrf, one right-hand side per column of B (pptrs)
+template<typename T>
+int lapack_pptrs(const SymmetricMatrix<T> &a, Matrix<T, 2> &b) {
+  assert(a.n() == b.n_rows());
+  const int n = a.n(), nrhs = b.n_cols();
+  if (n == 0 || nrhs == 0) return 0;
 
+  // pptrs solves for the columns of a column-major B
+  WorkspaceScope scope;
+  T *bt = scope.get<T>(b.size());
+  matrix_impl::transpose_copy(n, nrhs, b.data(), bt);
+  const int info = lapack_impl::pptrs(matrix_impl::col_major_uplo(a.uplo()),
+                                      n, nrhs, a.data(), bt, n);
+  matrix_impl::transpose_copy(nrhs, n, bt, b.data());
+  return info;
 }
 
-#endif // SLAB_MATRIX_PACKED_MATRIX_H
+/// @}
+
+#endif // SLAB_MATRIX_PACKED_MATRIX_H_
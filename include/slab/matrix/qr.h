@@ -0,0 +1,314 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file qr.h
+/// @brief QR factorization and linear least squares
+///
+/// LAPACK works on column-major arrays, and a row-major m x n matrix A is the
+/// column-major n x m matrix A'. Since A = Q * R if and only if A' = R' * Q',
+/// the QR factorization of A is computed as the LQ factorization of A'
+/// (gelqf, orglq, ormlq): the same Householder reflectors, with neither a
+/// transposed copy of A nor of Q.
+
+#ifndef SLAB_MATRIX_QR_H_
+#define SLAB_MATRIX_QR_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/lapack_interface.h"
+
+/// @addtogroup linear_solve LINEAR SOLVERS
+/// @{
+
+/// @brief The QR factorization A = Q * R of an m x n matrix
+///
+/// Q is kept implicitly, as Householder reflectors: apply_q() multiplies by
+/// Q or Q' without forming it, and q() forms its first min(m, n) columns only
+/// when asked. A Matrix or a MatrixRef, e.g. a block of a larger matrix, can
+/// be factored. The workspaces are sized once per shape and reused; a QR
+/// object is therefore not to be shared between threads.
+template<typename T>
+class QR {
+ public:
+  QR() : info_(0) {}
+  explicit QR(const Matrix<T, 2> &a) { factor(a); }
+  explicit QR(const MatrixRef<T, 2> &a) { factor(a); }
+
+  /// @brief Factors a, returns 0 on success
+  template<typename M>
+  Enable_if<Matrix_type<M>(), int> factor(const M &a);
+
+  int info() const { return info_; }
+  std::size_t n_rows() const { return qr_.n_rows(); }
+  std::size_t n_cols() const { return qr_.n_cols(); }
+
+  /// @brief The min(m, n) x n upper triangular factor R
+  Matrix<T, 2> r() const;
+  /// @brief The first min(m, n) columns of Q
+  Matrix<T, 2> q() const;
+
+  /// @brief c := op(Q) * c, where c has m rows
+  int apply_q(Matrix<T, 2> &c, blas_trans trans = blas_trans::no_trans) const;
+  /// @brief c := op(Q) * c, where c has m elements
+  int apply_q(Matrix<T, 1> &c, blas_trans trans = blas_trans::no_trans) const;
+
+  /// @brief The least squares solution of A * x = b, for m >= n
+  ///
+  /// @param b a vector or a matrix, a Matrix or a MatrixRef.
+  /// @return 0 on success, i > 0 if R(i,i) is exactly zero: A does not have
+  ///         full rank.
+  template<typename B>
+  Enable_if<Matrix_type<B>(), int>
+  solve(const B &b, Matrix<T, B::order_> &x) const;
+
+  /// @brief The least squares solution of A * x = b, an empty matrix if A
+  /// does not have full rank
+  template<typename B>
+  Enable_if<Matrix_type<B>(), Matrix<T, B::order_>> solve(const B &b) const {
+    Matrix<T, B::order_> x;
+    if (solve(b, x) != 0) x.clear();
+    return x;
+  }
+
+ private:
+  int ormlq(char side, char trans, int m, int n, T *c, int ldc) const;
+
+  Matrix<T, 2> qr_;  // R and the reflectors, row-major
+  std::vector<T> tau_;
+  int info_;
+  mutable matrix_impl::lapack_work<T> work_;
+};
+
+template<typename T>
+template<typename M>
+Enable_if<Matrix_type<M>(), int> QR<T>::factor(const M &a) {
+  static_assert(Same<Element_type<M>, T>(), "QR: incompatible element types");
+
+  const int m = a.n_rows(), n = a.n_cols();
+  if (qr_.n_rows() != std::size_t(m) || qr_.n_cols() != std::size_t(n))
+    qr_ = Matrix<T, 2>(m, n);
+  matrix_impl::copy_to(a, qr_.data(), n);
+  tau_.resize(std::max(1, std::min(m, n)));
+
+  info_ = 0;
+  if (m == 0 || n == 0) return info_;
+
+  WorkspaceScope scope;
+  work_.fit({{0, m, n, 0}}, [&](T *query, int *) {
+    lapack_impl::gelqf(n, m, qr_.data(), n, tau_.data(), query, -1);
+  });
+  info_ = lapack_impl::gelqf(n, m, qr_.data(), n, tau_.data(),
+                             work_.work, work_.lwork);
+  return info_;
+}
+
+template<typename T>
+Matrix<T, 2> QR<T>::r() const {
+  const std::size_t k = std::min(n_rows(), n_cols());
+  Matrix<T, 2> r(k, n_cols());
+  for (std::size_t i = 0; i != k; ++i)
+    for (std::size_t j = i; j != n_cols(); ++j) r(i, j) = qr_(i, j);
+  return r;
+}
+
+template<typename T>
+Matrix<T, 2> QR<T>::q() const {
+  const int m = n_rows(), n = n_cols(), k = std::min(m, n);
+  Matrix<T, 2> q(m, k);
+  if (k == 0) return q;
+
+  // the reflectors, as the column-major k x m matrix q'
+  for (int i = 0; i != m; ++i)
+    for (int j = 0; j != k; ++j) q(i, j) = qr_(i, j);
+
+  WorkspaceScope scope;
+  work_.fit({{1, m, k, 0}}, [&](T *query, int *) {
+    lapack_impl::orglq(k, m, k, q.data(), k, tau_.data(), query, -1);
+  });
+  lapack_impl::orglq(k, m, k, q.data(), k, tau_.data(), work_.work,
+                     work_.lwork);
+  return q;
+}
+
+template<typename T>
+int QR<T>::ormlq(char side, char trans, int m, int n, T *c, int ldc) const {
+  const int k = std::min(n_rows(), n_cols());
+  WorkspaceScope scope;
+  work_.fit({{2, side * 256 + trans, m, n}}, [&](T *query, int *) {
+    lapack_impl::ormlq(side, trans, m, n, k, qr_.data(), n_cols(),
+                       tau_.data(), c, ldc, query, -1);
+  });
+  return lapack_impl::ormlq(side, trans, m, n, k, qr_.data(), n_cols(),
+                            tau_.data(), c, ldc, work_.work, work_.lwork);
+}
+
+template<typename T>
+int QR<T>::apply_q(Matrix<T, 2> &c, blas_trans trans) const {
+  assert(c.n_rows() == n_rows());
+  if (c.size() == 0 || n_cols() == 0) return 0;
+
+  // c is the column-major p x m matrix c', and (op(Q) c)' = c' op(Q)', where
+  // Q' is the Q of the LQ factorization
+  const int p = c.n_cols();
+  return ormlq('R', trans == blas_trans::no_trans ? 'N' : 'T', p, n_rows(),
+               c.data(), p);
+}
+
+template<typename T>
+int QR<T>::apply_q(Matrix<T, 1> &c, blas_trans trans) const {
+  assert(c.size() == n_rows());
+  if (c.size() == 0 || n_cols() == 0) return 0;
+  return ormlq('R', trans == blas_trans::no_trans ? 'N' : 'T', 1, n_rows(),
+               c.data(), 1);
+}
+
+template<typename T>
+template<typename B>
+Enable_if<Matrix_type<B>(), int>
+QR<T>::solve(const B &b, Matrix<T, B::order_> &x) const {
+  constexpr std::size_t N = B::order_;
+  static_assert(N == 1 || N == 2, "QR::solve: b must be a vector or a matrix");
+  static_assert(Same<Element_type<B>, T>(),
+                "QR::solve: incompatible element types");
+  assert(n_rows() >= n_cols());
+  assert(b.extent(0) == n_rows());
+  if (info_ != 0) return info_;
+
+  const std::size_t n = n_cols();
+  for (std::size_t i = 0; i != n; ++i)
+    if (qr_(i, i) == T(0)) return i + 1;
+
+  // x = inv(R) * (Q' b)(0:n), Q' b being computed in the workspace pool
+  const std::size_t nrhs = (N == 1) ? 1 : b.extent(N - 1);
+  WorkspaceScope scope;
+  T *y = scope.get<T>(b.size());
+  matrix_impl::copy_rhs_to(b, y, nrhs);
+  if (n != 0 && nrhs != 0) ormlq('R', 'T', nrhs, n_rows(), y, nrhs);
+
+  matrix_impl::fit(x, n, nrhs);
+  std::copy(y, y + n * nrhs, x.data());
+
+  if (n != 0 && nrhs != 0)
+    blas_impl::trsm(CblasRowMajor, CblasLeft, CblasUpper, CblasNoTrans,
+                    CblasNonUnit, n, nrhs, T(1), qr_.data(), n, x.data(), nrhs);
+  return 0;
+}
+
+/// @brief How lstsq() solves a least squares problem
+enum class lstsq_method {
+  /// QR or LQ factorization (gels): A must have full rank
+  qr,
+  /// SVD (gelsd): the minimum norm solution of any A, singular values below
+  /// rcond times the largest one being ignored
+  svd
+};
+
+/// @brief Solves the linear least squares problem min ||A * x - b||
+///
+/// If A is m x n with m < n, the minimum norm solution of A * x = b is
+/// computed instead. The copy of A that LAPACK overwrites and the workspaces
+/// are taken from the workspace pool of the calling thread.
+///
+/// @param a      the matrix, a Matrix or a MatrixRef.
+/// @param b      the right-hand side, a vector or one per column, a Matrix or
+///               a MatrixRef.
+/// @param x      the solution on exit, with n rows.
+/// @param method the factorization to use.
+/// @param rank   if not null, the effective rank of A on exit (svd only).
+/// @param rcond  the relative threshold of the singular values (svd only),
+///               machine precision if negative.
+/// @return 0 on success, i > 0 if A does not have full rank (qr), or if the
+///         SVD did not converge (svd).
+template<typename M, typename B, typename T = Element_type<B>>
+Enable_if<Matrix_type<M>() && Matrix_type<B>(), int>
+lstsq(const M &a, const B &b, Matrix<T, B::order_> &x,
+      lstsq_method method = lstsq_method::qr, int *rank = nullptr,
+      T rcond = T(-1)) {
+  constexpr std::size_t N = B::order_;
+  static_assert(N == 1 || N == 2, "lstsq: b must be a vector or a matrix");
+  static_assert(Same<Element_type<M>, T>(), "lstsq: incompatible element types");
+  assert(a.n_rows() == b.extent(0));
+
+  const int m = a.n_rows(), n = a.n_cols();
+  const int nrhs = (N == 1) ? 1 : b.extent(N - 1);
+  const int ldb = std::max(1, std::max(m, n));
+
+  if (m == 0 || n == 0 || nrhs == 0) {
+    // no equation or no unknown: the minimum norm solution is 0
+    matrix_impl::fit(x, n, nrhs);
+    std::fill(x.begin(), x.end(), T(0));
+    if (rank) *rank = 0;
+    return 0;
+  }
+
+  static thread_local matrix_impl::lapack_work<T> work;
+
+  WorkspaceScope scope;
+  T *wa = scope.get<T>(std::size_t(m) * n);
+  T *wb = scope.get<T>(std::size_t(ldb) * nrhs);
+
+  // b is passed column-major, with room for the n rows of the solution
+  matrix_impl::copy_rhs_to(b, wb, ldb, true);
+
+  int info = 0;
+  const typename matrix_impl::lapack_work<T>::key_type key =
+      {{int(method), m, n, nrhs}};
+  if (method == lstsq_method::qr) {
+    // the row-major A, as the column-major A', solved with trans = 'T'
+    matrix_impl::copy_to(a, wa, n);
+    work.fit(key, [&](T *query, int *) {
+      lapack_impl::gels('T', n, m, nrhs, wa, n, wb, ldb, query, -1);
+    });
+    info = lapack_impl::gels('T', n, m, nrhs, wa, n, wb, ldb, work.work,
+                             work.lwork);
+    if (rank) *rank = (info == 0) ? std::min(m, n) : 0;
+  } else {
+    // gelsd has no transposed mode: A is copied column-major
+    matrix_impl::copy_to(a, wa, m, true);
+    T *s = scope.get<T>(std::min(m, n));
+    int r = 0;
+    work.fit(key, [&](T *query, int *iquery) {
+      lapack_impl::gelsd(m, n, nrhs, wa, m, wb, ldb, s, rcond, &r, query, -1,
+                         iquery);
+    });
+    info = lapack_impl::gelsd(m, n, nrhs, wa, m, wb, ldb, s, rcond, &r,
+                              work.work, work.lwork, work.iwork);
+    if (rank) *rank = r;
+  }
+  if (info != 0) return info;
+
+  matrix_impl::fit(x, n, nrhs);
+  for (int i = 0; i != n; ++i)
+    for (int j = 0; j != nrhs; ++j)
+      x.data()[std::size_t(i) * nrhs + j] = wb[std::size_t(j) * ldb + i];
+
+  return 0;
+}
+
+/// @brief The solution of the linear least squares problem min ||A * x - b||,
+/// an empty matrix on failure
+template<typename M, typename B>
+Enable_if<Matrix_type<M>() && Matrix_type<B>(),
+          Matrix<Element_type<B>, B::order_>>
+lstsq(const M &a, const B &b, lstsq_method method = lstsq_method::qr) {
+  Matrix<Element_type<B>, B::order_> x;
+  if (lstsq(a, b, x, method) != 0) x.clear();
+  return x;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_QR_H_
@@ -0,0 +1,308 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file quantile.h
+/// @brief Quantiles along an axis, exact or from t-digests
+///
+/// The exact quantiles of a line are found by successive nth_element calls
+/// on a copy of the line in the workspace pool, one per quantile in
+/// ascending order, each on the part of the line not yet ordered. Lines
+/// are processed in parallel.
+///
+/// A TDigest (Dunning and Ertl's merging t-digest) summarizes a stream in
+/// O(compression) centroids, small near the tails, and answers quantile
+/// queries with a relative error of the order of 1 / compression, smaller
+/// near the extremes. Digests of chunks or threads merge into one.
+
+#ifndef SLAB_MATRIX_QUANTILE_H_
+#define SLAB_MATRIX_QUANTILE_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/workspace.h"
+#include "slab/matrix/reduction.h"
+#include "slab/matrix/sort.h"
+
+/// @addtogroup quantile QUANTILES
+/// @{
+
+/// @brief How quantile() computes quantiles
+enum class quantile_method { exact, tdigest };
+
+/// @brief A mergeable t-digest of a stream of numbers
+template<typename T>
+class TDigest {
+ public:
+  /// @param compression about twice the number of centroids kept; the
+  ///        error of the quantiles is of the order of 1 / compression.
+  explicit TDigest(double compression = 100)
+      : compression_(compression) {
+    assert(compression >= 10);
+  }
+
+  /// @brief Adds x with weight w
+  void add(T x, double w = 1) {
+    if (x != x || w <= 0) return;
+    buffer_.push_back({static_cast<double>(x), w});
+    total_ += w;
+    min_ = std::min<double>(min_, x);
+    max_ = std::max<double>(max_, x);
+    if (buffer_.size() >= buffer_size()) flush();
+  }
+
+  /// @brief Adds the elements of a Matrix or MatrixRef, e.g. a column
+  template<typename M>
+  Enable_if<Matrix_type<M>(), void> add(const M &x) {
+    static_assert(Same<Element_type<M>, T>(),
+                  "TDigest: incompatible element types");
+    if (x.size() == 0) return;
+    const std::size_t axis = M::order_ - 1;
+    const std::size_t len = x.descriptor().extents[axis];
+    const std::size_t xs = x.descriptor().strides[axis];
+    for (std::size_t o : matrix_impl::line_offsets(x.descriptor(), axis))
+      for (std::size_t i = 0; i != len; ++i) add(x.data()[o + i * xs]);
+  }
+
+  /// @brief Adds the numbers summarized by another digest
+  void merge(const TDigest &other) {
+    other.flush();
+    buffer_.insert(buffer_.end(), other.centroids_.begin(),
+                   other.centroids_.end());
+    total_ += other.total_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    flush();
+  }
+
+  /// @brief The total weight of the numbers added
+  double count() const { return total_; }
+  /// @brief The number of centroids
+  std::size_t size() const {
+    flush();
+    return centroids_.size();
+  }
+  T min() const { return static_cast<T>(min_); }
+  T max() const { return static_cast<T>(max_); }
+
+  /// @brief The estimate of the q-quantile, 0 <= q <= 1; NaN if empty
+  T quantile(double q) const;
+
+ private:
+  struct centroid {
+    double mean, weight;
+  };
+
+  std::size_t buffer_size() const {
+    return static_cast<std::size_t>(5 * compression_);
+  }
+
+  // the largest quantile that a centroid starting at quantile q may reach,
+  // under the scale function k(q) = compression / 2pi * asin(2q - 1)
+  double q_limit(double q) const {
+    constexpr double pi = 3.14159265358979323846;
+    const double k =
+        compression_ / (2 * pi) * std::asin(2 * std::min(q, 1.0) - 1) + 1;
+    if (k >= compression_ / 4) return 1;
+    return (std::sin(k * 2 * pi / compression_) + 1) / 2;
+  }
+
+  // Merges the buffer into the centroids
+  void flush() const;
+
+  double compression_;
+  double total_ = 0;
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+  mutable std::vector<centroid> centroids_;
+  mutable std::vector<centroid> buffer_;
+};
+
+template<typename T>
+void TDigest<T>::flush() const {
+  if (buffer_.empty()) return;
+  buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+  std::sort(buffer_.begin(), buffer_.end(),
+            [](const centroid &a, const centroid &b) {
+              return a.mean < b.mean;
+            });
+  centroids_.clear();
+  centroid cur = buffer_[0];
+  double q0 = 0, limit = q_limit(0);
+  for (std::size_t i = 1; i != buffer_.size(); ++i) {
+    const centroid &c = buffer_[i];
+    if (q0 + (cur.weight + c.weight) / total_ <= limit) {
+      cur.weight += c.weight;
+      cur.mean += (c.mean - cur.mean) * c.weight / cur.weight;
+    } else {
+      centroids_.push_back(cur);
+      q0 += cur.weight / total_;
+      limit = q_limit(q0);
+      cur = c;
+    }
+  }
+  centroids_.push_back(cur);
+  buffer_.clear();
+}
+
+template<typename T>
+T TDigest<T>::quantile(double q) const {
+  assert(q >= 0 && q <= 1);
+  flush();
+  if (centroids_.empty()) return std::numeric_limits<T>::quiet_NaN();
+  if (q <= 0) return static_cast<T>(min_);
+  if (q >= 1) return static_cast<T>(max_);
+
+  // linear between the centers of the centroids, and from the extremes to
+  // the first and last centers
+  const double index = q * total_;
+  const centroid &first = centroids_.front();
+  if (index < first.weight / 2)
+    return static_cast<T>(min_ + (first.mean - min_) * index /
+                                     (first.weight / 2));
+  double cum = 0;
+  for (std::size_t i = 0; i + 1 < centroids_.size(); ++i) {
+    const centroid &a = centroids_[i], &b = centroids_[i + 1];
+    const double left = cum + a.weight / 2;
+    const double right = cum + a.weight + b.weight / 2;
+    if (index < right)
+      return static_cast<T>(a.mean + (b.mean - a.mean) * (index - left) /
+                                         (right - left));
+    cum += a.weight;
+  }
+  const centroid &last = centroids_.back();
+  const double center = total_ - last.weight / 2;
+  return static_cast<T>(last.mean + (max_ - last.mean) * (index - center) /
+                                        (last.weight / 2));
+}
+
+namespace matrix_impl {
+
+// The qs-quantiles of the n elements of x, reordered, into y[j * ys]:
+// linear between the order statistics around (n - 1) q; NaN if x has any
+template<typename T>
+void exact_quantiles(T *x, std::size_t n, const Matrix<double, 1> &qs,
+                     const std::size_t *order, T *y, std::size_t ys) {
+  const std::size_t nq = qs.size();
+  if (n == 0 || std::any_of(x, x + n, [](const T &v) { return v != v; })) {
+    for (std::size_t j = 0; j != nq; ++j)
+      y[j * ys] = std::numeric_limits<T>::quiet_NaN();
+    return;
+  }
+  // x[done, n) holds the order statistics done, done + 1, ...
+  std::size_t done = 0;
+  for (std::size_t j = 0; j != nq; ++j) {
+    const double h = (n - 1) * qs(order[j]);
+    const std::size_t lo = static_cast<std::size_t>(h);
+    if (lo >= done) {
+      std::nth_element(x + done, x + lo, x + n);
+      done = lo;
+    }
+    T v = x[lo];
+    if (h > lo) {
+      const T next = *std::min_element(x + lo + 1, x + n);
+      v += static_cast<T>((h - lo) * (next - v));
+    }
+    y[order[j] * ys] = v;
+  }
+}
+
+// The quantiles of the lines of m along axis; those of line l go to
+// y[yo[l] + j * ys]
+template<typename M>
+void quantile_lines(const M &m, const Matrix<double, 1> &qs,
+                    std::size_t axis, quantile_method method,
+                    double compression, Element_type<M> *y,
+                    const std::vector<std::size_t> &yo, std::size_t ys) {
+  using T = Element_type<M>;
+  const std::size_t len = m.descriptor().extents[axis];
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = line_offsets(m.descriptor(), axis);
+  const T *x = m.data();
+  std::vector<std::size_t> order(qs.size());
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  std::sort(order.begin(), order.end(),
+            [&](std::size_t a, std::size_t b) { return qs(a) < qs(b); });
+
+  for_lines(xo.size(), len, [&](std::size_t l) {
+    if (method == quantile_method::exact) {
+      WorkspaceScope scope;
+      T *line = scope.get<T>(len);
+      for (std::size_t i = 0; i != len; ++i) line[i] = x[xo[l] + i * xs];
+      exact_quantiles(line, len, qs, order.data(), y + yo[l], ys);
+    } else {
+      TDigest<T> digest(compression);
+      for (std::size_t i = 0; i != len; ++i) digest.add(x[xo[l] + i * xs]);
+      for (std::size_t j = 0; j != qs.size(); ++j)
+        y[yo[l] + j * ys] = digest.quantile(qs(j));
+    }
+  });
+}
+
+} // namespace matrix_impl
+
+/// @brief The qs-quantiles of the lines of m along axis
+///
+/// @param qs          the quantiles, in [0, 1], in any order.
+/// @param method      exact: linear interpolation between the order
+///                    statistics around (n - 1) q, NumPy's default, and NaN
+///                    for lines with NaN; tdigest: estimates from a TDigest
+///                    of each line, which ignores NaN.
+/// @param compression the compression of the t-digests.
+/// @return the quantiles, of the extents of m except qs.size() along axis.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+quantile(const M &m, const Matrix<double, 1> &qs, std::size_t axis,
+         quantile_method method = quantile_method::exact,
+         double compression = 100) {
+  using T = Element_type<M>;
+  static_assert(std::is_floating_point<T>::value,
+                "quantile: the elements must be float or double");
+  assert(axis < M::order_);
+  assert(std::all_of(qs.begin(), qs.end(),
+                     [](double q) { return q >= 0 && q <= 1; }));
+  std::array<std::size_t, M::order_> exts = m.descriptor().extents;
+  exts[axis] = qs.size();
+  Matrix<T, M::order_> res(exts);
+  if (res.size() == 0) return res;
+  matrix_impl::quantile_lines(m, qs, axis, method, compression, res.data(),
+                              matrix_impl::line_offsets(res.descriptor(), axis),
+                              res.descriptor().strides[axis]);
+  return res;
+}
+
+/// @brief The exact medians of the lines of m along axis, see quantile()
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+median(const M &m, std::size_t axis) {
+  using T = Element_type<M>;
+  static_assert(std::is_floating_point<T>::value,
+                "median: the elements must be float or double");
+  assert(axis < M::order_);
+  auto res = matrix_impl::reduced_matrix<T>(m.descriptor(), axis);
+  // one result per line, in order
+  std::vector<std::size_t> yo(
+      matrix_impl::line_offsets(m.descriptor(), axis).size());
+  std::iota(yo.begin(), yo.end(), std::size_t(0));
+  Matrix<double, 1> half(1);
+  half(0) = 0.5;
+  if (!yo.empty())
+    matrix_impl::quantile_lines(m, half, axis, quantile_method::exact, 0,
+                                matrix_impl::elements(res), yo, 1);
+  return res;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_QUANTILE_H_
@@ -0,0 +1,314 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file random.h
+/// @brief Random matrices from reproducible parallel streams
+///
+/// The generator is the counter-based Philox4x32-10 of Salmon et al.: the
+/// 128-bit output for a counter is a bijection of the counter keyed by the
+/// seed, so any part of the sequence is computed without the rest. The
+/// elements of a matrix, in row-major order, are split in tiles of
+/// random_tile elements; tile t of a call is generated from the counters
+/// (b, t0 + t), b = 0, 1, ..., where t0 is the position of the stream. Tiles
+/// are filled in parallel, and the result depends on the seed and the
+/// position only, not on the number of threads.
+///
+/// With MKL, the uniform and normal floating point generators fill each
+/// tile from a VSL Philox4x32-10 stream started at the counter of the tile,
+/// with the inverse CDF method for normals. Their values differ from those
+/// of the portable generators, which use the Box-Muller transform, but are
+/// reproducible in the same way.
+
+#ifndef SLAB_MATRIX_RANDOM_H_
+#define SLAB_MATRIX_RANDOM_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/reduction.h"
+
+/// @addtogroup random RANDOM
+/// @{
+
+namespace matrix_impl {
+
+// the number of elements generated from the counters of one tile
+constexpr std::size_t random_tile = std::size_t(1) << 14;
+
+using philox_block = std::array<std::uint32_t, 4>;
+
+// The Philox4x32-10 bijection of the counter c with key k
+inline philox_block philox4x32(philox_block c,
+                               std::array<std::uint32_t, 2> k) {
+  for (int r = 0; r != 10; ++r) {
+    if (r != 0) {
+      k[0] += 0x9E3779B9u;
+      k[1] += 0xBB67AE85u;
+    }
+    const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * c[0];
+    const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * c[2];
+    c = {{static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+          static_cast<std::uint32_t>(p1),
+          static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+          static_cast<std::uint32_t>(p0)}};
+  }
+  return c;
+}
+
+// A uniform number in (0, 1) from 24 random bits
+inline float unit_open(std::uint32_t a) {
+  return ((a >> 8) + 0.5f) * (1.0f / 16777216.0f);
+}
+
+// A uniform number in (0, 1) from 53 random bits
+inline double unit_open(std::uint32_t a, std::uint32_t b) {
+  const std::uint64_t bits = (std::uint64_t(a) << 21) ^ (b >> 11);
+  return (bits + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// The uniforms of a block: four floats or two doubles
+inline void block_uniforms(const philox_block &w, float *u) {
+  for (std::size_t i = 0; i != 4; ++i) u[i] = unit_open(w[i]);
+}
+
+inline void block_uniforms(const philox_block &w, double *u) {
+  u[0] = unit_open(w[0], w[1]);
+  u[1] = unit_open(w[2], w[3]);
+}
+
+// The distributions: per_block values from each output of the generator
+
+template<typename T>
+struct uniform_dist {
+  static_assert(std::is_floating_point<T>::value,
+                "randu: the elements must be float or double");
+  static constexpr std::size_t per_block = 16 / sizeof(T);
+  T a, b;
+  void operator()(const philox_block &w, T *x) const {
+    block_uniforms(w, x);
+    for (std::size_t i = 0; i != per_block; ++i) x[i] = a + (b - a) * x[i];
+  }
+};
+
+// Box-Muller on pairs of uniforms
+template<typename T>
+struct normal_dist {
+  static_assert(std::is_floating_point<T>::value,
+                "randn: the elements must be float or double");
+  static constexpr std::size_t per_block = 16 / sizeof(T);
+  T mean, sd;
+  void operator()(const philox_block &w, T *x) const {
+    constexpr T two_pi = T(6.283185307179586476925286766559);
+    block_uniforms(w, x);
+    for (std::size_t i = 0; i != per_block; i += 2) {
+      const T r = sd * std::sqrt(-2 * std::log(x[i]));
+      const T theta = two_pi * x[i + 1];
+      x[i] = mean + r * std::cos(theta);
+      x[i + 1] = mean + r * std::sin(theta);
+    }
+  }
+};
+
+// Integers in [lo, lo + range) from 64 random bits each, range = 0 for
+// all 2^64 values; the bias of the modulo is below range / 2^64
+template<typename T>
+struct integer_dist {
+  static_assert(std::is_integral<T>::value,
+                "randint: the elements must be integers");
+  static constexpr std::size_t per_block = 2;
+  T lo;
+  std::uint64_t range;
+  void operator()(const philox_block &w, T *x) const {
+    for (std::size_t i = 0; i != 2; ++i) {
+      std::uint64_t bits = (std::uint64_t(w[2 * i]) << 32) | w[2 * i + 1];
+      if (range != 0) bits %= range;
+      x[i] = static_cast<T>(static_cast<std::uint64_t>(lo) + bits);
+    }
+  }
+};
+
+template<typename T, typename Dist>
+void random_tile_fill(T *x, std::size_t len, std::uint64_t seed,
+                      std::uint64_t tile, const Dist &dist) {
+  constexpr std::size_t k = Dist::per_block;
+  const std::array<std::uint32_t, 2> key = {
+      {static_cast<std::uint32_t>(seed),
+       static_cast<std::uint32_t>(seed >> 32)}};
+  philox_block ctr = {{0, 0, static_cast<std::uint32_t>(tile),
+                       static_cast<std::uint32_t>(tile >> 32)}};
+  T tail[k];
+  for (std::size_t i = 0; i < len; i += k, ++ctr[0]) {
+    const philox_block w = philox4x32(ctr, key);
+    if (len - i >= k) {
+      dist(w, x + i);
+    } else {
+      dist(w, tail);
+      std::copy(tail, tail + (len - i), x + i);
+    }
+  }
+}
+
+#if defined(USE_MKL)
+// A VSL Philox4x32-10 stream at the counter (0, tile) with the key seed
+class vsl_tile_stream {
+ public:
+  vsl_tile_stream(std::uint64_t seed, std::uint64_t tile) {
+    const unsigned int params[6] = {
+        static_cast<unsigned int>(seed), static_cast<unsigned int>(seed >> 32),
+        0, 0,
+        static_cast<unsigned int>(tile), static_cast<unsigned int>(tile >> 32)};
+    vslNewStreamEx(&stream_, VSL_BRNG_PHILOX4X32X10, 6, params);
+  }
+  ~vsl_tile_stream() { vslDeleteStream(&stream_); }
+  vsl_tile_stream(const vsl_tile_stream &) = delete;
+  vsl_tile_stream &operator=(const vsl_tile_stream &) = delete;
+  VSLStreamStatePtr get() const { return stream_; }
+
+ private:
+  VSLStreamStatePtr stream_ = nullptr;
+};
+
+inline void random_tile_fill(float *x, std::size_t len, std::uint64_t seed,
+                             std::uint64_t tile,
+                             const uniform_dist<float> &dist) {
+  vsl_tile_stream s(seed, tile);
+  vsRngUniform(VSL_RNG_METHOD_UNIFORM_STD, s.get(), len, x, dist.a, dist.b);
+}
+
+inline void random_tile_fill(double *x, std::size_t len, std::uint64_t seed,
+                             std::uint64_t tile,
+                             const uniform_dist<double> &dist) {
+  vsl_tile_stream s(seed, tile);
+  vdRngUniform(VSL_RNG_METHOD_UNIFORM_STD, s.get(), len, x, dist.a, dist.b);
+}
+
+inline void random_tile_fill(float *x, std::size_t len, std::uint64_t seed,
+                             std::uint64_t tile,
+                             const normal_dist<float> &dist) {
+  vsl_tile_stream s(seed, tile);
+  vsRngGaussian(VSL_RNG_METHOD_GAUSSIAN_ICDF, s.get(), len, x, dist.mean,
+                dist.sd);
+}
+
+inline void random_tile_fill(double *x, std::size_t len, std::uint64_t seed,
+                             std::uint64_t tile,
+                             const normal_dist<double> &dist) {
+  vsl_tile_stream s(seed, tile);
+  vdRngGaussian(VSL_RNG_METHOD_GAUSSIAN_ICDF, s.get(), len, x, dist.mean,
+                dist.sd);
+}
+#endif
+
+// Fills the n elements x from tile t0 on, one tile per iteration
+template<typename T, typename Dist>
+void random_fill(T *x, std::size_t n, std::uint64_t seed, std::uint64_t t0,
+                 const Dist &dist) {
+  const std::ptrdiff_t nt = (n + random_tile - 1) / random_tile;
+#pragma omp parallel for if(nt > 1) schedule(static)
+  for (std::ptrdiff_t t = 0; t < nt; ++t) {
+    const std::size_t i0 = t * random_tile;
+    random_tile_fill(x + i0, std::min(random_tile, n - i0), seed, t0 + t,
+                     dist);
+  }
+}
+
+} // namespace matrix_impl
+
+/// @brief A position in the sequence of random numbers of a seed
+///
+/// Each fill consumes whole tiles of matrix_impl::random_tile elements, so
+/// that successive fills give independent numbers and the position after
+/// a fill depends only on the number of elements.
+class RandomStream {
+ public:
+  explicit RandomStream(std::uint64_t seed = 0, std::uint64_t position = 0)
+      : seed_(seed), position_(position) {}
+
+  std::uint64_t seed() const { return seed_; }
+  /// @brief The number of tiles consumed
+  std::uint64_t position() const { return position_; }
+
+  /// @brief Skips the tiles of n elements, as if they had been generated
+  void skip(std::size_t n) { reserve(n); }
+
+  /// @brief Returns the first of the tiles of n elements, and moves past them
+  std::uint64_t reserve(std::size_t n) {
+    const std::uint64_t t0 = position_;
+    position_ += (n + matrix_impl::random_tile - 1) / matrix_impl::random_tile;
+    return t0;
+  }
+
+ private:
+  std::uint64_t seed_;
+  std::uint64_t position_;
+};
+
+namespace matrix_impl {
+
+// Fills m in row-major order, through a copy if it is not contiguous
+template<typename M, typename Dist>
+void random_fill(M &m, RandomStream &rng, const Dist &dist) {
+  using T = Element_type<M>;
+  const std::uint64_t t0 = rng.reserve(m.size());
+  if (m.size() == 0) return;
+  if (is_contiguous(m)) {
+    random_fill(m.data() + m.descriptor().start, m.size(), rng.seed(), t0,
+                dist);
+    return;
+  }
+  Matrix<T, M::order_> tmp(m.descriptor().extents);
+  random_fill(tmp.data(), tmp.size(), rng.seed(), t0, dist);
+  m = tmp;
+}
+
+} // namespace matrix_impl
+
+/// @brief Fills m with numbers uniform in (a, b)
+///
+/// @param m   a Matrix or MatrixRef of float or double.
+/// @param rng the stream, moved past the numbers generated.
+template<typename M>
+Enable_if<Matrix_type<M>(), void>
+randu(M &&m, RandomStream &rng, Element_type<M> a = 0,
+      Element_type<M> b = 1) {
+  matrix_impl::random_fill(m, rng,
+                           matrix_impl::uniform_dist<Element_type<M>>{a, b});
+}
+
+/// @brief Fills m with normal numbers of the given mean and standard
+/// deviation, see randu()
+template<typename M>
+Enable_if<Matrix_type<M>(), void>
+randn(M &&m, RandomStream &rng, Element_type<M> mean = 0,
+      Element_type<M> sd = 1) {
+  matrix_impl::random_fill(m, rng,
+                           matrix_impl::normal_dist<Element_type<M>>{mean, sd});
+}
+
+/// @brief Fills m with integers uniform in [lo, hi]
+///
+/// @param m a Matrix or MatrixRef of an integer type.
+template<typename M>
+Enable_if<Matrix_type<M>(), void>
+randint(M &&m, RandomStream &rng, Element_type<M> lo, Element_type<M> hi) {
+  using T = Element_type<M>;
+  assert(lo <= hi);
+  const std::uint64_t range =
+      static_cast<std::uint64_t>(hi) - static_cast<std::uint64_t>(lo) + 1;
+  matrix_impl::random_fill(m, rng, matrix_impl::integer_dist<T>{lo, range});
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_RANDOM_H_
@@ -0,0 +1,460 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file reduction.h
+/// @brief Reductions of all the elements of a matrix, or along one axis
+///
+/// sum(), prod(), min(), max(), mean() and var() take a Matrix or a
+/// MatrixRef of any order. Along an axis, the elements are read in memory
+/// order: reducing the rows of a matrix (axis 0) accumulates whole rows into
+/// a vector of column results, which vectorizes, instead of walking each
+/// column with a stride. Sums are pairwise over blocks of 64 elements, so
+/// that their rounding error grows with the logarithm of the number of
+/// terms. Large reductions are split across OpenMP threads, by output
+/// elements when there are enough, otherwise by ranges of the reduced axis.
+
+#ifndef SLAB_MATRIX_REDUCTION_H_
+#define SLAB_MATRIX_REDUCTION_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/workspace.h"
+
+/// @addtogroup reduction REDUCTIONS
+/// @{
+
+namespace matrix_impl {
+
+struct sum_op {
+  template<typename T>
+  static T init() { return T(0); }
+  template<typename T>
+  T operator()(const T &a, const T &b) const { return a + b; }
+};
+
+struct prod_op {
+  template<typename T>
+  static T init() { return T(1); }
+  template<typename T>
+  T operator()(const T &a, const T &b) const { return a * b; }
+};
+
+struct min_op {
+  template<typename T>
+  static T init() {
+    return std::numeric_limits<T>::has_infinity
+        ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+  }
+  template<typename T>
+  T operator()(const T &a, const T &b) const { return b < a ? b : a; }
+};
+
+struct max_op {
+  template<typename T>
+  static T init() {
+    return std::numeric_limits<T>::has_infinity
+        ? -std::numeric_limits<T>::infinity()
+        : std::numeric_limits<T>::lowest();
+  }
+  template<typename T>
+  T operator()(const T &a, const T &b) const { return a < b ? b : a; }
+};
+
+// The value reduced for an element x, i being the index of its result
+// within the block being reduced
+template<typename T>
+struct plain_load {
+  T operator()(const T &x, std::size_t) const { return x; }
+  plain_load shift(std::size_t) const { return *this; }
+};
+
+// (x - mu_i)^2, for the variances
+template<typename T>
+struct squared_deviation {
+  const T *mu;
+  T operator()(const T &x, std::size_t i) const {
+    const T d = x - mu[i];
+    return d * d;
+  }
+  squared_deviation shift(std::size_t k) const { return {mu + k}; }
+};
+
+// (x - mu)^2, for the variance of all the elements
+template<typename T>
+struct squared_deviation_from {
+  T mu;
+  T operator()(const T &x, std::size_t) const {
+    const T d = x - mu;
+    return d * d;
+  }
+  squared_deviation_from shift(std::size_t) const { return *this; }
+};
+
+constexpr std::size_t reduce_block = 64;
+
+// The depth of the pairwise recursion of reduce_rows() on len rows
+inline std::size_t reduce_depth(std::size_t len) {
+  std::size_t depth = 1;
+  for (; len > reduce_block; len = (len + 1) / 2) ++depth;
+  return depth;
+}
+
+// acc[i] = op over r < len of load(x[r * ld + i], i), for i < w: blocks of
+// up to 64 rows are reduced row by row, the blocks pairwise. scratch holds
+// w * (reduce_depth(len) - 1) elements.
+template<typename T, typename Op, typename Load>
+void reduce_rows(std::size_t len, std::size_t w, const T *x, std::size_t ld,
+                 T *acc, T *scratch, Op op, Load load) {
+  if (len <= reduce_block) {
+    if (w == 1) {
+      // independent partial results for a single long run
+      T part[8];
+      std::fill(part, part + 8, Op::template init<T>());
+      std::size_t r = 0;
+      for (; r + 8 <= len; r += 8)
+        for (std::size_t l = 0; l != 8; ++l)
+          part[l] = op(part[l], load(x[(r + l) * ld], 0));
+      for (; r != len; ++r) part[0] = op(part[0], load(x[r * ld], 0));
+      for (std::size_t l = 1; l != 8; ++l) part[0] = op(part[0], part[l]);
+      acc[0] = part[0];
+      return;
+    }
+    std::fill(acc, acc + w, Op::template init<T>());
+    for (std::size_t r = 0; r != len; ++r) {
+      const T *xr = x + r * ld;
+      for (std::size_t i = 0; i != w; ++i) acc[i] = op(acc[i], load(xr[i], i));
+    }
+    return;
+  }
+  const std::size_t half = (len + 1) / 2;
+  reduce_rows(half, w, x, ld, acc, scratch + w, op, load);
+  reduce_rows(len - half, w, x + half * ld, ld, scratch, scratch + w, op, load);
+  for (std::size_t i = 0; i != w; ++i) acc[i] = op(acc[i], scratch[i]);
+}
+
+// reduce_rows() on columns [0, w) in tiles that stay in cache, with scratch
+// memory from the workspace pool of the calling thread
+template<typename T, typename Op, typename Load>
+void reduce_cols(std::size_t len, std::size_t w, const T *x, std::size_t ld,
+                 T *acc, Op op, Load load) {
+  constexpr std::size_t tile = 512;
+  WorkspaceScope scope;
+  const std::size_t tw = std::min(w, tile);
+  T *scratch = scope.get<T>(tw * reduce_depth(len));
+  for (std::size_t j = 0; j < w; j += tile)
+    reduce_rows(len, std::min(tile, w - j), x + j, ld, acc + j, scratch, op,
+                load.shift(j));
+}
+
+// out[o * inner + i] = op over r < len of the element (o, r, i) of an
+// outer x len x inner array, src[o * os + r * rs + i]
+template<typename T, typename Op, typename Load>
+void reduce_axis(std::size_t outer, std::size_t len, std::size_t inner,
+                 const T *src, std::size_t os, std::size_t rs, T *out, Op op,
+                 Load load) {
+  const bool parallel = (outer * len * inner > 65536);
+#ifdef _OPENMP
+  const std::size_t nt = parallel ? omp_get_max_threads() : 1;
+#else
+  const std::size_t nt = 1;
+#endif
+  const std::ptrdiff_t no = outer;
+  if (nt == 1 || outer >= nt) {
+    // one output block per iteration
+#pragma omp parallel for if(parallel && nt > 1) schedule(static)
+    for (std::ptrdiff_t o = 0; o < no; ++o)
+      reduce_cols(len, inner, src + o * os, rs, out + o * inner, op,
+                  load.shift(o * inner));
+    return;
+  }
+
+  for (std::size_t o = 0; o != outer; ++o) {
+    const T *x = src + o * os;
+    T *y = out + o * inner;
+    const Load lo = load.shift(o * inner);
+    if (inner >= 256 * nt) {
+      // wide blocks: split the columns
+      const std::size_t step = (inner + nt - 1) / nt;
+#pragma omp parallel for schedule(static) num_threads(nt)
+      for (std::ptrdiff_t t = 0; t < std::ptrdiff_t(nt); ++t) {
+        const std::size_t j0 = std::min(inner, t * step);
+        const std::size_t j1 = std::min(inner, j0 + step);
+        if (j0 < j1)
+          reduce_cols(len, j1 - j0, x + j0, rs, y + j0, op, lo.shift(j0));
+      }
+      continue;
+    }
+    // narrow blocks: split the reduced axis, then combine the partial results
+    // in thread order
+    std::vector<T> part(nt * inner, Op::template init<T>());
+    const std::size_t step = (len + nt - 1) / nt;
+#pragma omp parallel for schedule(static) num_threads(nt)
+    for (std::ptrdiff_t t = 0; t < std::ptrdiff_t(nt); ++t) {
+      const std::size_t r0 = std::min(len, t * step);
+      const std::size_t r1 = std::min(len, r0 + step);
+      if (r0 < r1)
+        reduce_cols(r1 - r0, inner, x + r0 * rs, rs, part.data() + t * inner,
+                    op, lo);
+    }
+    std::copy(part.begin(), part.begin() + inner, y);
+    for (std::size_t t = 1; t != nt; ++t)
+      for (std::size_t i = 0; i != inner; ++i)
+        y[i] = op(y[i], part[t * inner + i]);
+  }
+}
+
+// True if the elements of m are contiguous, in row-major order
+template<typename M>
+bool is_contiguous(const M &m) {
+  const auto &d = m.descriptor();
+  std::size_t stride = 1;
+  for (std::size_t k = M::order_; k-- != 0;) {
+    if (d.extents[k] != 1 && d.strides[k] != stride) return false;
+    stride *= d.extents[k];
+  }
+  return true;
+}
+
+// Calls f with a pointer to the elements of m in row-major order, copying
+// them only if m is not contiguous
+template<typename M, typename F>
+void with_elements(const M &m, F f) {
+  using T = Element_type<M>;
+  if (is_contiguous(m)) {
+    f(m.data() + m.descriptor().start);
+    return;
+  }
+  const Matrix<T, M::order_> copy(m);
+  f(copy.data());
+}
+
+// Calls f(x, ld) with the elements of m as rows of its last extent, row r
+// starting at x + r * ld. Contiguous elements, and matrices with contiguous
+// rows such as column blocks, are read in place; the others are copied.
+template<typename M, typename F>
+void with_rows(const M &m, F f) {
+  using T = Element_type<M>;
+  const auto &d = m.descriptor();
+  const std::size_t n = d.extents[M::order_ - 1];
+  if (is_contiguous(m)) {
+    f(m.data() + d.start, n);
+    return;
+  }
+  if (M::order_ == 2 && (d.strides[M::order_ - 1] == 1 || n == 1)) {
+    f(m.data() + d.start, d.strides[0]);
+    return;
+  }
+  const Matrix<T, M::order_> copy(m);
+  f(copy.data(), n);
+}
+
+// The shape of a reduction of m along axis: (outer, len, inner)
+template<typename M>
+std::array<std::size_t, 3> axis_shape(const M &m, std::size_t axis) {
+  assert(axis < M::order_);
+  std::array<std::size_t, 3> s = {{1, m.descriptor().extents[axis], 1}};
+  for (std::size_t k = 0; k != M::order_; ++k) {
+    if (k < axis) s[0] *= m.descriptor().extents[k];
+    if (k > axis) s[2] *= m.descriptor().extents[k];
+  }
+  return s;
+}
+
+// A matrix of the extents of m without the axis
+template<typename T, std::size_t N>
+Matrix<T, N - 1> reduced_matrix(const MatrixSlice<N> &d, std::size_t axis) {
+  std::array<std::size_t, N - 1> exts;
+  for (std::size_t k = 0, j = 0; k != N; ++k)
+    if (k != axis) exts[j++] = d.extents[k];
+  return Matrix<T, N - 1>(exts);
+}
+
+template<typename T>
+Matrix<T, 0> reduced_matrix(const MatrixSlice<1> &, std::size_t axis) {
+  assert(axis == 0);
+  (void) axis;
+  return Matrix<T, 0>();
+}
+
+template<typename T, std::size_t N>
+T *elements(Matrix<T, N> &m) { return m.data(); }
+
+template<typename T>
+T *elements(Matrix<T, 0> &m) { return &m(); }
+
+template<typename T, std::size_t N>
+const T *elements(const Matrix<T, N> &m) { return m.data(); }
+
+template<typename T>
+const T *elements(const Matrix<T, 0> &m) { return &m(); }
+
+template<typename M, typename Op, typename Load = plain_load<Element_type<M>>>
+Element_type<M> reduce_all(const M &m, Op op, Load load = Load()) {
+  using T = Element_type<M>;
+  T result = Op::template init<T>();
+  if (m.size() == 0) return result;
+  const std::size_t n = m.descriptor().extents[M::order_ - 1];
+  with_rows(m, [&](const T *x, std::size_t ld) {
+    if (ld == n) {
+      reduce_axis(1, m.size(), 1, x, 0, 1, &result, op, load);
+      return;
+    }
+    // strided rows: reduce the columns, then their results
+    const std::size_t rows = m.size() / n;
+    std::vector<T> part(n);
+    reduce_axis(1, rows, n, x, 0, ld, part.data(), op, load);
+    reduce_axis(1, n, 1, part.data(), 0, 1, &result, op, plain_load<T>());
+  });
+  return result;
+}
+
+template<typename M, typename Op, typename Load = plain_load<Element_type<M>>>
+Matrix<Element_type<M>, M::order_ - 1>
+reduce_along(const M &m, std::size_t axis, Op op, Load load = Load()) {
+  using T = Element_type<M>;
+  auto res = reduced_matrix<T>(m.descriptor(), axis);
+  const std::array<std::size_t, 3> s = axis_shape(m, axis);
+  T *y = elements(res);
+  if (m.size() == 0) {
+    std::fill(y, y + s[0] * s[2], Op::template init<T>());
+    return res;
+  }
+  const std::size_t n = m.descriptor().extents[M::order_ - 1];
+  with_rows(m, [&](const T *x, std::size_t ld) {
+    // the last axis is read along a row, the others a row of ld at a time
+    const std::size_t rs = axis + 1 == M::order_ ? 1 : s[2] / n * ld;
+    const std::size_t os = axis + 1 == M::order_ ? ld : s[1] * rs;
+    reduce_axis(s[0], s[1], s[2], x, os, rs, y, op, load);
+  });
+  return res;
+}
+
+} // namespace matrix_impl
+
+/// @brief The sum of the elements of m
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> sum(const M &m) {
+  return matrix_impl::reduce_all(m, matrix_impl::sum_op());
+}
+
+/// @brief The sums of m along an axis, e.g. the column sums of a matrix for
+/// axis 0 and its row sums for axis 1
+///
+/// The result has the extents of m without the axis.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+sum(const M &m, std::size_t axis) {
+  return matrix_impl::reduce_along(m, axis, matrix_impl::sum_op());
+}
+
+/// @brief The product of the elements of m
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> prod(const M &m) {
+  return matrix_impl::reduce_all(m, matrix_impl::prod_op());
+}
+
+/// @brief The products of m along an axis
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+prod(const M &m, std::size_t axis) {
+  return matrix_impl::reduce_along(m, axis, matrix_impl::prod_op());
+}
+
+/// @brief The smallest element of m, +inf (or the largest value of an
+/// integer type) if m is empty
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> min(const M &m) {
+  return matrix_impl::reduce_all(m, matrix_impl::min_op());
+}
+
+/// @brief The smallest elements of m along an axis
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+min(const M &m, std::size_t axis) {
+  return matrix_impl::reduce_along(m, axis, matrix_impl::min_op());
+}
+
+/// @brief The largest element of m, -inf (or the lowest value of an integer
+/// type) if m is empty
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> max(const M &m) {
+  return matrix_impl::reduce_all(m, matrix_impl::max_op());
+}
+
+/// @brief The largest elements of m along an axis
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+max(const M &m, std::size_t axis) {
+  return matrix_impl::reduce_along(m, axis, matrix_impl::max_op());
+}
+
+/// @brief The mean of the elements of m
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> mean(const M &m) {
+  return sum(m) / static_cast<Element_type<M>>(m.size());
+}
+
+/// @brief The means of m along an axis, e.g. the column means of a matrix
+/// for axis 0
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+mean(const M &m, std::size_t axis) {
+  using T = Element_type<M>;
+  auto res = sum(m, axis);
+  const std::array<std::size_t, 3> s = matrix_impl::axis_shape(m, axis);
+  T *y = matrix_impl::elements(res);
+  for (std::size_t i = 0; i != s[0] * s[2]; ++i) y[i] /= static_cast<T>(s[1]);
+  return res;
+}
+
+/// @brief The (population) variance of the elements of m
+///
+/// Computed in two passes, the mean then the sum of squared deviations.
+template<typename M>
+Enable_if<Matrix_type<M>(), Element_type<M>> var(const M &m) {
+  using T = Element_type<M>;
+  const matrix_impl::squared_deviation_from<T> load = {mean(m)};
+  const T ss = matrix_impl::reduce_all(m, matrix_impl::sum_op(), load);
+  return ss / static_cast<T>(m.size());
+}
+
+/// @brief The variances of m along an axis, e.g. the column variances of a
+/// matrix for axis 0
+///
+/// The sums of squared deviations from the means are divided by the extent
+/// of the axis minus ddof: 0 for population variances, 1 for unbiased sample
+/// variances. The variances are NaN if ddof is not less than the extent.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_ - 1>>
+var(const M &m, std::size_t axis, std::size_t ddof = 0) {
+  using T = Element_type<M>;
+  const auto mu = mean(m, axis);
+  auto res = matrix_impl::reduce_along(
+      m, axis, matrix_impl::sum_op(),
+      matrix_impl::squared_deviation<T>{matrix_impl::elements(mu)});
+  const std::array<std::size_t, 3> s = matrix_impl::axis_shape(m, axis);
+  T *y = matrix_impl::elements(res);
+  if (ddof >= s[1]) {
+    std::fill(y, y + s[0] * s[2], std::numeric_limits<T>::quiet_NaN());
+    return res;
+  }
+  const T denom = static_cast<T>(s[1] - ddof);
+  for (std::size_t i = 0; i != s[0] * s[2]; ++i) y[i] /= denom;
+  return res;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_REDUCTION_H_
@@ -0,0 +1,242 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file running_stats.h
+/// @brief Column statistics accumulated over batches of rows
+///
+/// A RunningStats keeps the number of rows, the column means, the sums of
+/// products of the deviations from the means (the co-moments), and the
+/// column minima and maxima. Each batch is read by chunks of about 4 MB;
+/// the moments of a chunk are taken around its own mean, the co-moments by
+/// syrk, and merged into the totals by the pairwise update of Chan, Golub
+/// and LeVeque, which generalizes Welford's. The same update merges two
+/// accumulators, e.g. filled by different threads or processes.
+
+#ifndef SLAB_MATRIX_RUNNING_STATS_H_
+#define SLAB_MATRIX_RUNNING_STATS_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/blas_interface.h"
+#include "slab/matrix/workspace.h"
+#include "slab/matrix/reduction.h"
+#include "slab/matrix/covariance.h"
+
+/// @addtogroup running_stats RUNNING STATISTICS
+/// @{
+
+/// @brief Column means, variances, extrema and optionally the covariance
+/// matrix of rows added in batches
+///
+/// Only the statistics are stored: p * p elements for the co-moments, p
+/// without the covariance matrix, and 3 * p for the rest.
+template<typename T>
+class RunningStats {
+ public:
+  RunningStats() : RunningStats(0) {}
+
+  /// @brief An empty accumulator for p columns
+  ///
+  /// @param covariance if false, only the variances are kept.
+  explicit RunningStats(std::size_t p, bool covariance = true)
+      : p_(p), full_(covariance), mean_(p), m2_(covariance ? p * p : p),
+        min_(p), max_(p) {
+    std::fill(min_.begin(), min_.end(), matrix_impl::min_op::init<T>());
+    std::fill(max_.begin(), max_.end(), matrix_impl::max_op::init<T>());
+  }
+
+  /// @brief An accumulator from its state, e.g. sent by another process
+  ///
+  /// m2 is the p x p matrix of co-moments (its upper triangle is read), or
+  /// the vector of the p sums of squared deviations, as returned by
+  /// comoments() and squared_deviations().
+  template<std::size_t N>
+  RunningStats(std::size_t count, const Matrix<T, 1> &mean,
+               const Matrix<T, N> &m2, const Matrix<T, 1> &min,
+               const Matrix<T, 1> &max)
+      : p_(mean.size()), n_(count), full_(N == 2), mean_(mean),
+        m2_(m2.data(), m2.data() + m2.size()), min_(min), max_(max) {
+    static_assert(N == 1 || N == 2,
+                  "RunningStats: m2 must be a matrix or a vector");
+    assert(m2_.size() == (full_ ? p_ * p_ : p_));
+  }
+
+  std::size_t n_cols() const { return p_; }
+  /// @brief The number of rows added
+  std::size_t count() const { return n_; }
+  /// @brief True if the covariance matrix is kept
+  bool has_covariance() const { return full_; }
+
+  /// @brief Adds the rows of x, a Matrix or MatrixRef with n_cols() columns
+  template<typename M>
+  Enable_if<Matrix_type<M>() && M::order_ == 2, void> add(const M &x);
+
+  /// @brief Adds the statistics of another accumulator of the same columns
+  void merge(const RunningStats &other) {
+    assert(other.p_ == p_ && other.full_ == full_);
+    merge(other.n_, other.mean_.data(), other.m2_.data(), other.min_.data(),
+          other.max_.data());
+  }
+
+  /// @brief Removes all the rows
+  void clear() { *this = RunningStats(p_, full_); }
+
+  const Matrix<T, 1> &mean() const { return mean_; }
+  const Matrix<T, 1> &min() const { return min_; }
+  const Matrix<T, 1> &max() const { return max_; }
+
+  /// @brief The column variances, the sums of squared deviations divided
+  /// by count() - ddof
+  Matrix<T, 1> var(std::size_t ddof = 1) const {
+    Matrix<T, 1> v(p_);
+    const T d = static_cast<T>(n_) - static_cast<T>(ddof);
+    for (std::size_t j = 0; j != p_; ++j)
+      v(j) = (full_ ? m2_[j * p_ + j] : m2_[j]) / d;
+    return v;
+  }
+
+  /// @brief The covariance matrix, see cov(); requires has_covariance()
+  Matrix<T, 2> cov(std::size_t ddof = 1) const {
+    assert(full_);
+    Matrix<T, 2> c(p_, p_);
+    const T d = static_cast<T>(n_) - static_cast<T>(ddof);
+    for (std::size_t i = 0; i != p_; ++i)
+      for (std::size_t j = i; j != p_; ++j)
+        c(i, j) = c(j, i) = m2_[i * p_ + j] / d;
+    return c;
+  }
+
+  /// @brief The correlation matrix; requires has_covariance()
+  Matrix<T, 2> corr() const {
+    Matrix<T, 2> c = cov(0);
+    matrix_impl::to_correlation(p_, c.data());
+    return c;
+  }
+
+  /// @brief The co-moments: the p x p sums of products of the deviations
+  /// from the means, both triangles filled; requires has_covariance()
+  Matrix<T, 2> comoments() const {
+    assert(full_);
+    Matrix<T, 2> c(p_, p_);
+    for (std::size_t i = 0; i != p_; ++i)
+      for (std::size_t j = i; j != p_; ++j)
+        c(i, j) = c(j, i) = m2_[i * p_ + j];
+    return c;
+  }
+
+  /// @brief The p sums of squared deviations from the means, the diagonal
+  /// of comoments()
+  Matrix<T, 1> squared_deviations() const {
+    Matrix<T, 1> v(p_);
+    for (std::size_t j = 0; j != p_; ++j)
+      v(j) = full_ ? m2_[j * p_ + j] : m2_[j];
+    return v;
+  }
+
+ private:
+  // Merges the statistics of nb rows: Chan et al.'s update of the means
+  // and co-moments, with delta the difference of the means
+  void merge(std::size_t nb, const T *mean, const T *m2, const T *mn,
+             const T *mx);
+
+  std::size_t p_;
+  std::size_t n_ = 0;
+  bool full_;
+  Matrix<T, 1> mean_;
+  std::vector<T> m2_;
+  Matrix<T, 1> min_;
+  Matrix<T, 1> max_;
+};
+
+template<typename T>
+template<typename M>
+Enable_if<Matrix_type<M>() && M::order_ == 2, void>
+RunningStats<T>::add(const M &x) {
+  static_assert(Same<Element_type<M>, T>(),
+                "RunningStats: incompatible element types");
+  assert(x.n_cols() == p_);
+  const matrix_impl::row_reader<T> reader(x);
+  const std::size_t n = reader.n, p = p_;
+  if (n == 0 || p == 0) {
+    n_ += n;
+    return;
+  }
+  const std::size_t b = std::min(reader.chunk(), n);
+
+  WorkspaceScope scope;
+  T *z = scope.get<T>(b * p);
+  T *mean = scope.get<T>(p);
+  T *mn = scope.get<T>(p);
+  T *mx = scope.get<T>(p);
+  T *m2 = scope.get<T>(full_ ? p * p : p);
+
+  for (std::size_t i0 = 0; i0 < n; i0 += b) {
+    const std::size_t bi = std::min(b, n - i0);
+    const T *xi = reader.rows(i0, bi, z);
+
+    // the moments of the chunk around its own mean
+    matrix_impl::reduce_cols(bi, p, xi, p, mean, matrix_impl::sum_op(),
+                             matrix_impl::plain_load<T>());
+    for (std::size_t j = 0; j != p; ++j) mean[j] /= static_cast<T>(bi);
+    matrix_impl::reduce_cols(bi, p, xi, p, mn, matrix_impl::min_op(),
+                             matrix_impl::plain_load<T>());
+    matrix_impl::reduce_cols(bi, p, xi, p, mx, matrix_impl::max_op(),
+                             matrix_impl::plain_load<T>());
+    if (full_) {
+      const T *zi = reader.rows(i0, bi, z, mean);
+      blas_impl::syrk(CblasRowMajor, CblasUpper, CblasTrans, p, bi, T(1), zi,
+                      p, T(0), m2, p);
+    } else {
+      matrix_impl::reduce_cols(bi, p, xi, p, m2, matrix_impl::sum_op(),
+                               matrix_impl::squared_deviation<T>{mean});
+    }
+    merge(bi, mean, m2, mn, mx);
+  }
+}
+
+template<typename T>
+void RunningStats<T>::merge(std::size_t nb, const T *mean, const T *m2,
+                            const T *mn, const T *mx) {
+  if (nb == 0) return;
+  const std::size_t p = p_;
+  const std::size_t na = n_;
+  n_ += nb;
+  const T wb = static_cast<T>(nb) / static_cast<T>(n_);
+  const T f = static_cast<T>(na) * wb;  // na * nb / n
+
+  WorkspaceScope scope;
+  T *delta = scope.get<T>(p);
+  for (std::size_t j = 0; j != p; ++j) {
+    delta[j] = mean[j] - mean_(j);
+    mean_(j) += delta[j] * wb;
+    if (mn[j] < min_(j)) min_(j) = mn[j];
+    if (max_(j) < mx[j]) max_(j) = mx[j];
+  }
+  if (full_) {
+    for (std::size_t i = 0; i != p; ++i) {
+      const T fi = f * delta[i];
+      T *ci = m2_.data() + i * p;
+      const T *bi = m2 + i * p;
+      for (std::size_t j = i; j != p; ++j) ci[j] += bi[j] + fi * delta[j];
+    }
+  } else {
+    for (std::size_t j = 0; j != p; ++j)
+      m2_[j] += m2[j] + f * delta[j] * delta[j];
+  }
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_RUNNING_STATS_H_
@@ -0,0 +1,284 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file solve.h
+/// @brief Solvers for square systems of linear equations
+
+#ifndef SLAB_MATRIX_SOLVE_H_
+#define SLAB_MATRIX_SOLVE_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/lapack_interface.h"
+#include "slab/matrix/lu.h"
+#include "slab/matrix/cholesky.h"
+
+/// @addtogroup linear_solve LINEAR SOLVERS
+/// @{
+
+/// @brief How solve() factorizes the coefficient matrix
+enum class solve_method {
+  /// LU factorization in the working precision (getrf/getrs)
+  lu,
+  /// LU factorization in single precision followed by iterative refinement
+  /// of the solution in double precision, as in LAPACK's dsgesv. Falls back
+  /// to a double precision LU factorization when refinement does not
+  /// converge. Only differs from lu for double precision systems.
+  mixed_precision,
+  /// Cholesky factorization (potrf/potrs), for symmetric positive definite
+  /// matrices only; fails with the order of the first minor that is not
+  /// positive definite
+  cholesky
+};
+
+namespace matrix_impl {
+
+// Converts n doubles to floats, returns false if one of them overflows.
+inline bool to_single(std::size_t n, const double *x, float *y) {
+  const double rmax = std::numeric_limits<float>::max();
+  for (std::size_t i = 0; i != n; ++i) {
+    if (std::abs(x[i]) > rmax) return false;
+    y[i] = static_cast<float>(x[i]);
+  }
+  return true;
+}
+
+// Returns the largest |r_j|_inf / |x_j|_inf over the columns of the
+// residual R and the solution X, both column-major n x nrhs. A column of X
+// that is zero counts for |r_j|_inf, 0 if its residual is zero as well.
+inline double residual_ratio(int n, int nrhs, const double *x, const double *r) {
+  double res = 0.0;
+  if (n == 0) return res;
+  for (int j = 0; j != nrhs; ++j) {
+    const double *xj = x + std::size_t(j) * n;
+    const double *rj = r + std::size_t(j) * n;
+    const double xnrm = std::abs(xj[cblas_idamax(n, xj, 1)]);
+    const double rnrm = std::abs(rj[cblas_idamax(n, rj, 1)]);
+    if (rnrm != 0.0) res = std::max(res, xnrm != 0.0 ? rnrm / xnrm : rnrm);
+  }
+  return res;
+}
+
+// R = B - A * X, where A is row-major n x n and B, X, R are column-major
+inline void residual(int n, int nrhs, const double *a, const double *b,
+                     const double *x, double *r) {
+  std::copy(b, b + std::size_t(n) * nrhs, r);
+  // a row-major A is a column-major A'
+  cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, n, nrhs, n,
+              -1.0, a, n, x, n, 1.0, r, n);
+}
+
+// Solves in single precision and refines the solution in double precision.
+// A is row-major n x n, B and X are column-major n x nrhs. Returns false if
+// the system has to be solved in double precision instead, with the reason in
+// iter (see solve_mixed()).
+//
+// Since a row-major A is a column-major A', the single precision copy of A is
+// factored as P * A' = L * U without any transposition, and the systems are
+// solved with the transposed factors.
+inline bool sgesv_refine(int n, int nrhs, const double *a, const double *b,
+                         double *x, int &iter) {
+  const int itermax = 30;
+  const std::size_t nb = std::size_t(n) * nrhs;
+  // nothing to solve for, nor to factor with leading dimensions of 0
+  if (nb == 0) {
+    iter = 0;
+    return true;
+  }
+
+  WorkspaceScope scope;
+  float *sa = scope.get<float>(std::size_t(n) * n);
+  float *sx = scope.get<float>(nb);
+  int *ipiv = scope.get<int>(std::max(1, n));
+  double *r = scope.get<double>(nb);
+
+  iter = -1;
+  if (!to_single(nb, b, sx) || !to_single(std::size_t(n) * n, a, sa))
+    return false;
+
+  iter = -2;
+  if (LAPACKE_sgetrf(LAPACK_COL_MAJOR, n, n, sa, n, ipiv) != 0)
+    return false;
+
+  LAPACKE_sgetrs(LAPACK_COL_MAJOR, 'T', n, nrhs, sa, n, ipiv, sx, n);
+  std::copy(sx, sx + nb, x);
+
+  // stopping criterion of dsgesv: ||r||_inf < ||x||_inf * ||A||_inf * eps * sqrt(n)
+  const double anrm = LAPACKE_dlange(LAPACK_ROW_MAJOR, 'I', n, n, a, n);
+  const double eps = std::numeric_limits<double>::epsilon() / 2;
+  const double cte = anrm * eps * std::sqrt(double(n));
+
+  residual(n, nrhs, a, b, x, r);
+  double ratio = residual_ratio(n, nrhs, x, r);
+
+  for (int i = 0; i <= itermax; ++i) {
+    if (ratio <= cte) {
+      iter = i;
+      return true;
+    }
+
+    iter = -1;
+    if (!to_single(nb, r, sx)) return false;
+
+    LAPACKE_sgetrs(LAPACK_COL_MAJOR, 'T', n, nrhs, sa, n, ipiv, sx, n);
+    for (std::size_t k = 0; k != nb; ++k) x[k] += sx[k];
+
+    residual(n, nrhs, a, b, x, r);
+    const double next = residual_ratio(n, nrhs, x, r);
+
+    // refinement has stagnated when a correction no longer halves the
+    // residual: A is too ill-conditioned for a single precision LU
+    iter = -3;
+    if (next > cte && next > 0.5 * ratio) return false;
+    ratio = next;
+  }
+
+  return false;
+}
+
+// The mixed precision solver behind solve_mixed(), with the same storage
+// conventions as sgesv_refine().
+inline int dsgesv(int n, int nrhs, const double *a, const double *b,
+                  double *x, int &iter) {
+  if (sgesv_refine(n, nrhs, a, b, x, iter)) return 0;
+
+  WorkspaceScope scope;
+  double *da = scope.get<double>(std::size_t(n) * n);
+  int *ipiv = scope.get<int>(std::max(1, n));
+  std::copy(a, a + std::size_t(n) * n, da);
+  std::copy(b, b + std::size_t(n) * nrhs, x);
+
+  const int info = LAPACKE_dgetrf(LAPACK_COL_MAJOR, n, n, da, n, ipiv);
+  if (info != 0) return info;
+
+  return LAPACKE_dgetrs(LAPACK_COL_MAJOR, 'T', n, nrhs, da, n, ipiv, x, n);
+}
+
+} // namespace matrix_impl
+
+/// @brief Solves A * X = B using a single precision LU factorization and
+/// iterative refinement in double precision
+///
+/// The factorization runs in single precision, at about twice the speed of
+/// dgetrf. Each solution is then refined until its residual, computed in
+/// double precision, is as small as that of a double precision solve. If the
+/// conversion to single precision overflows, the single precision matrix is
+/// singular, or refinement stagnates, the system is solved with a double
+/// precision LU factorization instead.
+///
+/// @param a    the coefficient matrix, left unchanged.
+/// @param b    the right-hand sides.
+/// @param x    the solution on exit.
+/// @param iter the number of refinement steps if >= 0; otherwise the solver
+///             fell back to double precision because the conversion to single
+///             precision overflowed (-1), the single precision factorization
+///             failed (-2), or refinement stagnated (-3).
+/// @return 0 on success, i > 0 if U(i,i) of the double precision LU
+///         factorization is exactly zero.
+inline int solve_mixed(const Matrix<double, 2> &a, const Matrix<double, 2> &b,
+                       Matrix<double, 2> &x, int &iter) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.n_rows());
+
+  const std::size_t n = b.n_rows();
+  const std::size_t nrhs = b.n_cols();
+
+  // the right-hand sides are solved for as column-major arrays
+  WorkspaceScope scope;
+  double *bt = scope.get<double>(n * nrhs);
+  double *xt = scope.get<double>(n * nrhs);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != nrhs; ++j)
+      bt[j * n + i] = b(i, j);
+
+  const int info = matrix_impl::dsgesv(n, nrhs, a.data(), bt, xt, iter);
+
+  matrix_impl::fit(x, n, nrhs);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != nrhs; ++j)
+      x(i, j) = xt[j * n + i];
+
+  return info;
+}
+
+/// @brief Solves A * x = b using a single precision LU factorization and
+/// iterative refinement in double precision
+inline int solve_mixed(const Matrix<double, 2> &a, const Matrix<double, 1> &b,
+                       Matrix<double, 1> &x, int &iter) {
+  assert(a.n_rows() == a.n_cols());
+  assert(a.n_rows() == b.size());
+
+  matrix_impl::fit(x, b.size(), 1);
+  return matrix_impl::dsgesv(b.size(), 1, a.data(), b.data(), x.data(), iter);
+}
+
+namespace matrix_impl {
+
+template<typename T, std::size_t N>
+int solve_lu(const Matrix<T, 2> &a, const Matrix<T, N> &b, Matrix<T, N> &x) {
+  const LU<T> lu(a);
+  return lu.solve(b, x);
+}
+
+template<typename T, std::size_t N>
+int solve_mixed_or_lu(const Matrix<T, 2> &a, const Matrix<T, N> &b,
+                      Matrix<T, N> &x) {
+  return solve_lu(a, b, x);
+}
+
+template<std::size_t N>
+int solve_mixed_or_lu(const Matrix<double, 2> &a, const Matrix<double, N> &b,
+                      Matrix<double, N> &x) {
+  int iter;
+  return solve_mixed(a, b, x, iter);
+}
+
+} // namespace matrix_impl
+
+/// @brief Solves the square system A * x = b
+///
+/// @param a      the coefficient matrix, left unchanged.
+/// @param b      the right-hand side: a vector, or a matrix with one
+///               right-hand side per column.
+/// @param x      the solution on exit.
+/// @param method the factorization to use.
+/// @return 0 on success, i > 0 if A is singular (U(i,i) is exactly zero), or
+///         not positive definite with solve_method::cholesky.
+template<typename T, std::size_t N>
+int solve(const Matrix<T, 2> &a, const Matrix<T, N> &b, Matrix<T, N> &x,
+          solve_method method = solve_method::lu) {
+  static_assert(N == 1 || N == 2, "solve: b must be a vector or a matrix");
+
+  if (method == solve_method::mixed_precision)
+    return matrix_impl::solve_mixed_or_lu(a, b, x);
+  if (method == solve_method::cholesky)
+    return Cholesky<T>(a).solve(b, x);
+  return matrix_impl::solve_lu(a, b, x);
+}
+
+/// @brief Solves the square system A * x = b
+///
+/// @return the solution, or an empty matrix if A is singular.
+template<typename T, std::size_t N>
+Matrix<T, N> solve(const Matrix<T, 2> &a, const Matrix<T, N> &b,
+                   solve_method method = solve_method::lu) {
+  Matrix<T, N> x;
+  if (solve(a, b, x, method) != 0) x.clear();
+  return x;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_SOLVE_H_
@@ -0,0 +1,410 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file sort.h
+/// @brief Sorting and selection along an axis
+///
+/// A matrix is seen as lines along the axis: the elements whose other
+/// indices are fixed. The lines are read in place through the strides of a
+/// MatrixRef and processed in parallel. Values are ordered with NaN after
+/// all numbers, and equal values by their index, so that every result is
+/// deterministic; sorts are stable.
+///
+/// topk() keeps the best k elements of a line in a heap, in O(n log k) time
+/// and O(k) space, unless k is a large part of the line, where it selects
+/// with nth_element. Lines that are few and long are split between threads,
+/// whose candidates are merged.
+
+#ifndef SLAB_MATRIX_SORT_H_
+#define SLAB_MATRIX_SORT_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/workspace.h"
+#include "slab/matrix/reduction.h"
+
+/// @addtogroup sort SORTING
+/// @{
+
+/// @brief The k best elements of each line of a matrix along an axis, in
+/// order, and their indices along the axis
+template<typename T, std::size_t N>
+struct TopKResult {
+  Matrix<T, N> values;
+  Matrix<std::size_t, N> indices;
+};
+
+namespace matrix_impl {
+
+// a < b, with NaN after every number
+template<typename T>
+bool less_nan_last(const T &a, const T &b) {
+  return a < b || (a == a && b != b);
+}
+
+template<typename T>
+struct ranked {
+  T value;
+  std::size_t index;
+};
+
+// Ascending or descending order of the values, then ascending indices
+template<typename T>
+struct rank_order {
+  bool descending;
+  bool operator()(const ranked<T> &a, const ranked<T> &b) const {
+    const T &x = descending ? b.value : a.value;
+    const T &y = descending ? a.value : b.value;
+    if (less_nan_last(x, y)) return true;
+    return !less_nan_last(y, x) && a.index < b.index;
+  }
+};
+
+// The offsets of the first elements of the lines of d along axis, in the
+// row-major order of the other indices
+template<std::size_t N>
+std::vector<std::size_t> line_offsets(const MatrixSlice<N> &d,
+                                      std::size_t axis) {
+  std::size_t count = 1;
+  for (std::size_t k = 0; k != N; ++k)
+    if (k != axis) count *= d.extents[k];
+  std::vector<std::size_t> offsets(count);
+  std::array<std::size_t, N> index{};
+  std::size_t offset = d.start;
+  for (std::size_t l = 0; l != count; ++l) {
+    offsets[l] = offset;
+    for (std::size_t k = N; k-- != 0;) {
+      if (k == axis) continue;
+      if (++index[k] != d.extents[k]) {
+        offset += d.strides[k];
+        break;
+      }
+      index[k] = 0;
+      offset -= (d.extents[k] - 1) * d.strides[k];
+    }
+  }
+  return offsets;
+}
+
+// Calls f(l) for the lines l of len elements, in parallel if they are many
+// or long enough
+template<typename F>
+void for_lines(std::size_t lines, std::size_t len, F f) {
+  const std::ptrdiff_t nl = lines;
+#pragma omp parallel for if(lines > 1 && lines * len > 32768) schedule(guided)
+  for (std::ptrdiff_t l = 0; l < nl; ++l) f(l);
+}
+
+// The best min(k, end - begin) elements of the line x[i * xs], begin <= i
+// < end, written to out in order; returns their number
+template<typename T>
+std::size_t select_line(const T *x, std::size_t xs, std::size_t begin,
+                        std::size_t end, std::size_t k,
+                        rank_order<T> before, ranked<T> *out) {
+  const std::size_t n = end - begin;
+  if (k >= n || k * 8 > n) {
+    WorkspaceScope scope;
+    ranked<T> *all = scope.get<ranked<T>>(n);
+    for (std::size_t i = 0; i != n; ++i)
+      all[i] = {x[(begin + i) * xs], begin + i};
+    const std::size_t m = std::min(k, n);
+    if (m < n) std::nth_element(all, all + m, all + n, before);
+    std::sort(all, all + m, before);
+    std::copy(all, all + m, out);
+    return m;
+  }
+  // a heap of the best k so far, the worst of them on top
+  for (std::size_t i = 0; i != k; ++i)
+    out[i] = {x[(begin + i) * xs], begin + i};
+  std::make_heap(out, out + k, before);
+  for (std::size_t i = begin + k; i != end; ++i) {
+    const ranked<T> e = {x[i * xs], i};
+    if (before(e, out[0])) {
+      std::pop_heap(out, out + k, before);
+      out[k - 1] = e;
+      std::push_heap(out, out + k, before);
+    }
+  }
+  std::sort_heap(out, out + k, before);
+  return k;
+}
+
+// select_line() on one long line, split between the threads
+template<typename T>
+std::size_t select_line_parallel(const T *x, std::size_t xs, std::size_t n,
+                                 std::size_t k, rank_order<T> before,
+                                 ranked<T> *out) {
+#ifdef _OPENMP
+  const std::size_t nt = omp_get_max_threads();
+#else
+  const std::size_t nt = 1;
+#endif
+  WorkspaceScope scope;
+  ranked<T> *candidates = scope.get<ranked<T>>(nt * k);
+  std::vector<std::size_t> counts(nt, 0);
+  const std::ptrdiff_t nparts = nt;
+#pragma omp parallel for schedule(static)
+  for (std::ptrdiff_t t = 0; t < nparts; ++t) {
+    const std::size_t begin = n * t / nt, end = n * (t + 1) / nt;
+    counts[t] = select_line(x, xs, begin, end, k, before, candidates + t * k);
+  }
+  std::size_t m = 0;
+  for (std::size_t t = 0; t != nt; ++t) {
+    std::copy(candidates + t * k, candidates + t * k + counts[t],
+              candidates + m);
+    m += counts[t];
+  }
+  const std::size_t kept = std::min(k, m);
+  std::partial_sort(candidates, candidates + kept, candidates + m, before);
+  std::copy(candidates, candidates + kept, out);
+  return kept;
+}
+
+// The index along the line x[i * xs], i < n, of its first maximum
+// (descending) or minimum
+template<typename T>
+std::size_t arg_best(const T *x, std::size_t xs, std::size_t n,
+                     bool descending) {
+  std::size_t best = 0;
+  for (std::size_t i = 1; i < n; ++i) {
+    const bool better = descending ? less_nan_last(x[best * xs], x[i * xs])
+                                   : less_nan_last(x[i * xs], x[best * xs]);
+    if (better) best = i;
+  }
+  return best;
+}
+
+// arg_best() of every line of m along axis, into y
+template<typename M>
+void arg_best_lines(const M &m, std::size_t axis, bool descending,
+                    std::size_t *y) {
+  using T = Element_type<M>;
+  const std::size_t len = m.descriptor().extents[axis];
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = line_offsets(m.descriptor(), axis);
+  const T *x = m.data();
+  if (len == 0) {
+    std::fill(y, y + xo.size(), std::size_t(0));
+    return;
+  }
+  if (xs == 1) {
+    for_lines(xo.size(), len, [&](std::size_t l) {
+      y[l] = arg_best(x + xo[l], 1, len, descending);
+    });
+    return;
+  }
+  // strided lines, usually next to each other: a block of lines at a time
+  constexpr std::size_t block = 64;
+  const std::size_t nb = (xo.size() + block - 1) / block;
+  for_lines(nb, block * len, [&](std::size_t b) {
+    const std::size_t l0 = b * block, l1 = std::min(xo.size(), l0 + block);
+    for (std::size_t l = l0; l != l1; ++l) y[l] = 0;
+    for (std::size_t i = 1; i < len; ++i)
+      for (std::size_t l = l0; l != l1; ++l) {
+        const T &v = x[xo[l] + i * xs];
+        const T &best = x[xo[l] + y[l] * xs];
+        if (descending ? less_nan_last(best, v) : less_nan_last(v, best))
+          y[l] = i;
+      }
+  });
+}
+
+} // namespace matrix_impl
+
+/// @brief A copy of m with its lines along axis sorted in ascending order
+///
+/// NaN are placed last.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<Element_type<M>, M::order_>>
+sort(const M &m, std::size_t axis = M::order_ - 1) {
+  using T = Element_type<M>;
+  assert(axis < M::order_);
+  Matrix<T, M::order_> res(m.descriptor().extents);
+  if (res.size() == 0) return res;
+  const std::size_t len = m.descriptor().extents[axis];
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t ys = res.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::vector<std::size_t> yo = matrix_impl::line_offsets(
+      res.descriptor(), axis);
+  const T *x = m.data();
+  T *y = res.data();
+  matrix_impl::for_lines(xo.size(), len, [&](std::size_t l) {
+    WorkspaceScope scope;
+    T *line = ys == 1 ? y + yo[l] : scope.get<T>(len);
+    for (std::size_t i = 0; i != len; ++i) line[i] = x[xo[l] + i * xs];
+    std::stable_sort(line, line + len, matrix_impl::less_nan_last<T>);
+    if (ys != 1)
+      for (std::size_t i = 0; i != len; ++i) y[yo[l] + i * ys] = line[i];
+  });
+  return res;
+}
+
+/// @brief The indices along axis that sort the lines of m, see sort()
+///
+/// Equal elements keep their order.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<std::size_t, M::order_>>
+argsort(const M &m, std::size_t axis = M::order_ - 1) {
+  using T = Element_type<M>;
+  assert(axis < M::order_);
+  Matrix<std::size_t, M::order_> res(m.descriptor().extents);
+  if (res.size() == 0) return res;
+  const std::size_t len = m.descriptor().extents[axis];
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t ys = res.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::vector<std::size_t> yo = matrix_impl::line_offsets(
+      res.descriptor(), axis);
+  const T *x = m.data();
+  std::size_t *y = res.data();
+  matrix_impl::for_lines(xo.size(), len, [&](std::size_t l) {
+    WorkspaceScope scope;
+    matrix_impl::ranked<T> *line = scope.get<matrix_impl::ranked<T>>(len);
+    for (std::size_t i = 0; i != len; ++i) line[i] = {x[xo[l] + i * xs], i};
+    std::sort(line, line + len, matrix_impl::rank_order<T>{false});
+    for (std::size_t i = 0; i != len; ++i) y[yo[l] + i * ys] = line[i].index;
+  });
+  return res;
+}
+
+/// @brief The index along axis of the first maximum of each line of m
+///
+/// A NaN is larger than any number.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<std::size_t, M::order_ - 1>>
+argmax(const M &m, std::size_t axis) {
+  assert(axis < M::order_);
+  auto res = matrix_impl::reduced_matrix<std::size_t>(m.descriptor(), axis);
+  matrix_impl::arg_best_lines(m, axis, true, matrix_impl::elements(res));
+  return res;
+}
+
+/// @brief The index along axis of the first minimum of each line of m
+///
+/// NaN are ignored, unless a line has nothing else.
+template<typename M>
+Enable_if<Matrix_type<M>(), Matrix<std::size_t, M::order_ - 1>>
+argmin(const M &m, std::size_t axis) {
+  assert(axis < M::order_);
+  auto res = matrix_impl::reduced_matrix<std::size_t>(m.descriptor(), axis);
+  matrix_impl::arg_best_lines(m, axis, false, matrix_impl::elements(res));
+  return res;
+}
+
+/// @brief The row-major index of the first maximum of m, see argmax()
+template<typename M>
+Enable_if<Matrix_type<M>(), std::size_t> argmax(const M &m) {
+  assert(m.size() != 0);
+  const std::size_t axis = M::order_ - 1;
+  const std::size_t len = m.descriptor().extents[axis];
+  const Matrix<std::size_t, M::order_ - 1> best = argmax(m, axis);
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t *b = matrix_impl::elements(best);
+  std::size_t l = 0;
+  for (std::size_t j = 1; j < xo.size(); ++j)
+    if (matrix_impl::less_nan_last(m.data()[xo[l] + b[l] * xs],
+                                   m.data()[xo[j] + b[j] * xs]))
+      l = j;
+  return l * len + b[l];
+}
+
+/// @brief The row-major index of the first minimum of m, see argmin()
+template<typename M>
+Enable_if<Matrix_type<M>(), std::size_t> argmin(const M &m) {
+  assert(m.size() != 0);
+  const std::size_t axis = M::order_ - 1;
+  const std::size_t len = m.descriptor().extents[axis];
+  const Matrix<std::size_t, M::order_ - 1> best = argmin(m, axis);
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t *b = matrix_impl::elements(best);
+  std::size_t l = 0;
+  for (std::size_t j = 1; j < xo.size(); ++j)
+    if (matrix_impl::less_nan_last(m.data()[xo[j] + b[j] * xs],
+                                   m.data()[xo[l] + b[l] * xs]))
+      l = j;
+  return l * len + b[l];
+}
+
+/// @brief The k largest (or smallest) elements of each line of m along
+/// axis, in order, and their indices
+///
+/// @param k       at most the extent of m along axis.
+/// @param largest if false, the k smallest elements, in ascending order.
+/// @return the values and indices, of the extents of m except k along axis.
+///         Equal values are ranked by index; NaN rank above every number.
+template<typename M>
+Enable_if<Matrix_type<M>(), TopKResult<Element_type<M>, M::order_>>
+topk(const M &m, std::size_t k, std::size_t axis = M::order_ - 1,
+     bool largest = true) {
+  using T = Element_type<M>;
+  constexpr std::size_t N = M::order_;
+  assert(axis < N);
+  const std::size_t len = m.descriptor().extents[axis];
+  assert(k <= len);
+  std::array<std::size_t, N> exts = m.descriptor().extents;
+  exts[axis] = k;
+  TopKResult<T, N> res{Matrix<T, N>(exts), Matrix<std::size_t, N>(exts)};
+  if (res.values.size() == 0) return res;
+
+  const std::size_t xs = m.descriptor().strides[axis];
+  const std::size_t ys = res.values.descriptor().strides[axis];
+  const std::vector<std::size_t> xo = matrix_impl::line_offsets(
+      m.descriptor(), axis);
+  const std::vector<std::size_t> yo = matrix_impl::line_offsets(
+      res.values.descriptor(), axis);
+  const matrix_impl::rank_order<T> before{largest};
+  const T *x = m.data();
+  T *yv = res.values.data();
+  std::size_t *yi = res.indices.data();
+  auto store = [&](std::size_t l, const matrix_impl::ranked<T> *best) {
+    for (std::size_t i = 0; i != k; ++i) {
+      yv[yo[l] + i * ys] = best[i].value;
+      yi[yo[l] + i * ys] = best[i].index;
+    }
+  };
+
+#ifdef _OPENMP
+  const std::size_t nt = omp_get_max_threads();
+#else
+  const std::size_t nt = 1;
+#endif
+  if (nt > 1 && xo.size() < nt && len >= 65536) {
+    WorkspaceScope scope;
+    matrix_impl::ranked<T> *best = scope.get<matrix_impl::ranked<T>>(k);
+    for (std::size_t l = 0; l != xo.size(); ++l) {
+      matrix_impl::select_line_parallel(x + xo[l], xs, len, k, before, best);
+      store(l, best);
+    }
+    return res;
+  }
+  matrix_impl::for_lines(xo.size(), len, [&](std::size_t l) {
+    WorkspaceScope scope;
+    matrix_impl::ranked<T> *best = scope.get<matrix_impl::ranked<T>>(k);
+    matrix_impl::select_line(x + xo[l], xs, 0, len, k, before, best);
+    store(l, best);
+  });
+  return res;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_SORT_H_
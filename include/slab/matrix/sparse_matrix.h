@@ -0,0 +1,760 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file sparse_matrix.h
+/// @brief Sparse matrices in compressed row (CSR) or column (CSC) storage
+///
+/// A SparseMatrix only stores its nonzero elements, sorted by row (CSR) or
+/// by column (CSC). It is assembled by a SparseBuilder from (row, column,
+/// value) triplets added by any number of threads, or converted from a dense
+/// Matrix. The products with dense vectors and matrices run the MKL
+/// inspector-executor sparse BLAS when the library is built with MKL, and
+/// otherwise a portable kernel that splits the rows of a CSR matrix into
+/// OpenMP blocks of equal numbers of nonzeros.
+
+#ifndef SLAB_MATRIX_SPARSE_MATRIX_H_
+#define SLAB_MATRIX_SPARSE_MATRIX_H_
+
+#include "slab/matrix/matrix.h"
+
+/// @addtogroup sparse_matrix SPARSE MATRICES
+/// @{
+
+/// @brief The storage of a SparseMatrix
+enum class sparse_format {
+  /// compressed sparse rows: the column indices and values of row i are at
+  /// positions ptr[i] to ptr[i + 1] - 1
+  csr,
+  /// compressed sparse columns: the row indices and values of column j are
+  /// at positions ptr[j] to ptr[j + 1] - 1
+  csc
+};
+
+/// @brief The index type of sparse matrices, MKL_INT with MKL
+#ifdef USE_MKL
+using sparse_index = MKL_INT;
+#else
+using sparse_index = int;
+#endif
+
+namespace matrix_impl {
+
+// Triplets in the order they were added, or sorted with distinct positions
+template<typename T>
+struct triplet_list {
+  std::vector<sparse_index> rows, cols;
+  std::vector<T> val;
+
+  std::size_t size() const { return val.size(); }
+};
+
+// Sorts (col, value) pairs by column, keeping the order of equal columns
+template<typename T>
+void sort_row(std::pair<sparse_index, T> *p, std::size_t n) {
+  auto less = [](const std::pair<sparse_index, T> &a,
+                 const std::pair<sparse_index, T> &b) {
+    return a.first < b.first;
+  };
+  if (n > 32) {
+    std::stable_sort(p, p + n, less);
+    return;
+  }
+  for (std::size_t i = 1; i < n; ++i)
+    for (std::size_t j = i; j != 0 && less(p[j], p[j - 1]); --j)
+      std::swap(p[j], p[j - 1]);
+}
+
+// Sums the pairs of the same column of a row sorted by column, then calls
+// out(col, sum) for each column, unless the sum is zero and drop_zeros
+template<typename T, typename F>
+void sum_row(const std::pair<sparse_index, T> *p, std::size_t n,
+             bool drop_zeros, F out) {
+  for (std::size_t k = 0; k != n;) {
+    const sparse_index col = p[k].first;
+    T sum = p[k].second;
+    for (++k; k != n && p[k].first == col; ++k) sum += p[k].second;
+    if (!drop_zeros || sum != T(0)) out(col, sum);
+  }
+}
+
+// The triplets of t of an m-row matrix sorted by row then column, the
+// values of a repeated position being summed in the order they were added.
+// A counting sort by row when t has at least m triplets, and otherwise a
+// comparison sort, so that the cost does not grow with m.
+template<typename T>
+triplet_list<T> sort_triplets(std::size_t m, const triplet_list<T> &t) {
+  const std::size_t n = t.size();
+  triplet_list<T> res;
+  auto push = [&](sparse_index r) {
+    return [&res, r](sparse_index c, const T &v) {
+      res.rows.push_back(r);
+      res.cols.push_back(c);
+      res.val.push_back(v);
+    };
+  };
+
+  std::vector<std::pair<sparse_index, T>> bucket(n);
+  if (n >= m) {
+    std::vector<std::size_t> start(m + 1, 0);
+    for (std::size_t k = 0; k != n; ++k) ++start[t.rows[k] + 1];
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    std::vector<std::size_t> next(start.begin(), start.end() - 1);
+    for (std::size_t k = 0; k != n; ++k)
+      bucket[next[t.rows[k]]++] = std::make_pair(t.cols[k], t.val[k]);
+    next = std::vector<std::size_t>();
+    for (std::size_t r = 0; r != m; ++r) {
+      sort_row(bucket.data() + start[r], start[r + 1] - start[r]);
+      sum_row(bucket.data() + start[r], start[r + 1] - start[r], false,
+              push(r));
+    }
+    return res;
+  }
+
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  std::stable_sort(order.begin(), order.end(),
+                   [&t](std::size_t a, std::size_t b) {
+                     return t.rows[a] < t.rows[b] ||
+                            (t.rows[a] == t.rows[b] && t.cols[a] < t.cols[b]);
+                   });
+  for (std::size_t k = 0; k != n; ++k)
+    bucket[k] = std::make_pair(t.cols[order[k]], t.val[order[k]]);
+  for (std::size_t k = 0; k != n;) {
+    const sparse_index r = t.rows[order[k]];
+    std::size_t e = k + 1;
+    while (e != n && t.rows[order[e]] == r) ++e;
+    sum_row(bucket.data() + k, e - k, false, push(r));
+    k = e;
+  }
+  return res;
+}
+
+// Merges chunks sorted by row then column, each with distinct positions,
+// into the CSR arrays of an m-row matrix, the values of a position being
+// summed in the order of the chunks. The rows are split into blocks merged
+// in parallel: the entries of a block, a range of each chunk, are bucketed
+// by row by a counting sort and each row is sorted by column. A first pass
+// gives the lengths of the rows and a second writes them, so that nothing
+// of the size of the chunks is held besides them and the result.
+// O(nnz + m), plus two binary searches per block and chunk.
+template<typename T>
+void merge_chunks(std::size_t m, const std::vector<triplet_list<T>> &chunks,
+                  bool drop_zeros, bool parallel,
+                  std::vector<sparse_index> &ptr,
+                  std::vector<sparse_index> &idx, std::vector<T> &val) {
+#ifdef _OPENMP
+  const std::size_t nt = parallel ? omp_get_max_threads() : 1;
+#else
+  const std::size_t nt = 1;
+#endif
+  const std::size_t block = std::max<std::size_t>(1024, m / (16 * nt) + 1);
+  const std::ptrdiff_t nb = (m + block - 1) / block;
+  const std::size_t nc = chunks.size();
+  ptr.assign(m + 1, 0);
+
+  for (int pass = 0; pass != 2; ++pass) {
+    if (pass == 1) {
+      std::size_t nnz = 0;
+      for (std::size_t r = 0; r != m; ++r) {
+        nnz += ptr[r + 1];
+        ptr[r + 1] = nnz;
+      }
+      assert(nnz <= std::size_t(std::numeric_limits<sparse_index>::max()) &&
+             "SparseBuilder: too many elements");
+      idx.resize(nnz);
+      val.resize(nnz);
+    }
+#pragma omp parallel if(parallel)
+    {
+      std::vector<std::size_t> lo(nc), hi(nc), start, next;
+      std::vector<std::pair<sparse_index, T>> bucket;
+#pragma omp for schedule(dynamic)
+      for (std::ptrdiff_t b = 0; b < nb; ++b) {
+        const sparse_index r0 = b * block;
+        const sparse_index r1 = std::min(m, (b + 1) * block);
+        start.assign(r1 - r0 + 1, 0);
+        for (std::size_t c = 0; c != nc; ++c) {
+          const std::vector<sparse_index> &rows = chunks[c].rows;
+          lo[c] = std::lower_bound(rows.begin(), rows.end(), r0) -
+                  rows.begin();
+          hi[c] = std::lower_bound(rows.begin() + lo[c], rows.end(), r1) -
+                  rows.begin();
+          for (std::size_t k = lo[c]; k != hi[c]; ++k)
+            ++start[rows[k] - r0 + 1];
+        }
+        std::partial_sum(start.begin(), start.end(), start.begin());
+        bucket.resize(start.back());
+        next.assign(start.begin(), start.end() - 1);
+        for (std::size_t c = 0; c != nc; ++c)
+          for (std::size_t k = lo[c]; k != hi[c]; ++k)
+            bucket[next[chunks[c].rows[k] - r0]++] =
+                std::make_pair(chunks[c].cols[k], chunks[c].val[k]);
+
+        for (sparse_index r = r0; r != r1; ++r) {
+          std::pair<sparse_index, T> *p = bucket.data() + start[r - r0];
+          const std::size_t n = start[r - r0 + 1] - start[r - r0];
+          sort_row(p, n);
+          if (pass == 0) {
+            sum_row(p, n, drop_zeros,
+                    [&](sparse_index, const T &) { ++ptr[r + 1]; });
+          } else {
+            sparse_index k = ptr[r];
+            sum_row(p, n, drop_zeros, [&](sparse_index c, const T &v) {
+              idx[k] = c;
+              val[k++] = v;
+            });
+          }
+        }
+      }
+    }
+  }
+}
+
+// The rows [r0, r1) of thread t of nt, the rows of a CSR matrix being split
+// into blocks with the same number of nonzeros
+inline void nnz_block(const sparse_index *ptr, sparse_index m, int t, int nt,
+                      sparse_index &r0, sparse_index &r1) {
+  const double nnz = ptr[m];
+  auto bound = [&](int p) -> sparse_index {
+    if (p == nt) return m;
+    const sparse_index target = static_cast<sparse_index>(nnz * p / nt);
+    return std::lower_bound(ptr, ptr + m + 1, target) - ptr;
+  };
+  r0 = bound(t);
+  r1 = std::max(r0, bound(t + 1));
+}
+
+// Runs f(r0, r1) on blocks of rows of a CSR matrix, in parallel above
+// about 32k nonzeros
+template<typename F>
+void for_row_blocks(const sparse_index *ptr, sparse_index m, F f) {
+  const bool parallel = (ptr[m] > 32768);
+#pragma omp parallel if(parallel)
+  {
+#ifdef _OPENMP
+    const int t = omp_get_thread_num(), nt = omp_get_num_threads();
+#else
+    const int t = 0, nt = 1;
+#endif
+    sparse_index r0, r1;
+    nnz_block(ptr, m, t, nt, r0, r1);
+    f(r0, r1);
+  }
+}
+
+// y = A * x, A CSR m x n
+template<typename T>
+void csr_mv(sparse_index m, const sparse_index *ptr, const sparse_index *idx,
+            const T *val, const T *x, T *y) {
+  for_row_blocks(ptr, m, [&](sparse_index r0, sparse_index r1) {
+    for (sparse_index i = r0; i < r1; ++i) {
+      T s = T(0);
+      for (sparse_index k = ptr[i]; k < ptr[i + 1]; ++k) s += val[k] * x[idx[k]];
+      y[i] = s;
+    }
+  });
+}
+
+// C = A * B, A CSR m x n, B and C row-major with p columns
+template<typename T>
+void csr_mm(sparse_index m, sparse_index p, const sparse_index *ptr,
+            const sparse_index *idx, const T *val, const T *b, T *c) {
+  for_row_blocks(ptr, m, [&](sparse_index r0, sparse_index r1) {
+    for (sparse_index i = r0; i < r1; ++i) {
+      T *ci = c + std::size_t(i) * p;
+      std::fill(ci, ci + p, T(0));
+      for (sparse_index k = ptr[i]; k < ptr[i + 1]; ++k) {
+        const T a = val[k];
+        const T *bk = b + std::size_t(idx[k]) * p;
+        for (sparse_index j = 0; j < p; ++j) ci[j] += a * bk[j];
+      }
+    }
+  });
+}
+
+// C = A * B, A CSC m x n, B and C row-major with p columns: the columns of A
+// scatter into the rows of C, so this runs on a single thread
+template<typename T>
+void csc_mm(sparse_index m, sparse_index n, sparse_index p,
+            const sparse_index *ptr, const sparse_index *idx, const T *val,
+            const T *b, T *c) {
+  std::fill(c, c + std::size_t(m) * p, T(0));
+  for (sparse_index j = 0; j < n; ++j) {
+    const T *bj = b + std::size_t(j) * p;
+    for (sparse_index k = ptr[j]; k < ptr[j + 1]; ++k) {
+      const T a = val[k];
+      T *ci = c + std::size_t(idx[k]) * p;
+      for (sparse_index l = 0; l < p; ++l) ci[l] += a * bj[l];
+    }
+  }
+}
+
+#ifdef USE_MKL
+inline sparse_status_t mkl_sparse_create(sparse_matrix_t *h, sparse_format f,
+                                         MKL_INT m, MKL_INT n, MKL_INT *ptr,
+                                         MKL_INT *idx, float *val) {
+  return f == sparse_format::csr
+      ? mkl_sparse_s_create_csr(h, SPARSE_INDEX_BASE_ZERO, m, n, ptr, ptr + 1,
+                                idx, val)
+      : mkl_sparse_s_create_csc(h, SPARSE_INDEX_BASE_ZERO, m, n, ptr, ptr + 1,
+                                idx, val);
+}
+
+inline sparse_status_t mkl_sparse_create(sparse_matrix_t *h, sparse_format f,
+                                         MKL_INT m, MKL_INT n, MKL_INT *ptr,
+                                         MKL_INT *idx, double *val) {
+  return f == sparse_format::csr
+      ? mkl_sparse_d_create_csr(h, SPARSE_INDEX_BASE_ZERO, m, n, ptr, ptr + 1,
+                                idx, val)
+      : mkl_sparse_d_create_csc(h, SPARSE_INDEX_BASE_ZERO, m, n, ptr, ptr + 1,
+                                idx, val);
+}
+
+inline matrix_descr mkl_general() {
+  matrix_descr d;
+  d.type = SPARSE_MATRIX_TYPE_GENERAL;
+  return d;
+}
+
+inline sparse_status_t mkl_sparse_mv(sparse_matrix_t h, const float *x,
+                                     float *y) {
+  return mkl_sparse_s_mv(SPARSE_OPERATION_NON_TRANSPOSE, 1.0f, h,
+                         mkl_general(), x, 0.0f, y);
+}
+
+inline sparse_status_t mkl_sparse_mv(sparse_matrix_t h, const double *x,
+                                     double *y) {
+  return mkl_sparse_d_mv(SPARSE_OPERATION_NON_TRANSPOSE, 1.0, h,
+                         mkl_general(), x, 0.0, y);
+}
+
+inline sparse_status_t mkl_sparse_mm(sparse_matrix_t h, MKL_INT p,
+                                     const float *b, float *c) {
+  return mkl_sparse_s_mm(SPARSE_OPERATION_NON_TRANSPOSE, 1.0f, h,
+                         mkl_general(), SPARSE_LAYOUT_ROW_MAJOR, b, p, p,
+                         0.0f, c, p);
+}
+
+inline sparse_status_t mkl_sparse_mm(sparse_matrix_t h, MKL_INT p,
+                                     const double *b, double *c) {
+  return mkl_sparse_d_mm(SPARSE_OPERATION_NON_TRANSPOSE, 1.0, h,
+                         mkl_general(), SPARSE_LAYOUT_ROW_MAJOR, b, p, p,
+                         0.0, c, p);
+}
+
+// The inspector-executor handle of a SparseMatrix, created and optimized on
+// first use. It refers to the arrays of the matrix, so a copy of the matrix
+// starts without one.
+class mkl_sparse_handle {
+ public:
+  mkl_sparse_handle() = default;
+  mkl_sparse_handle(const mkl_sparse_handle &) {}
+  mkl_sparse_handle &operator=(const mkl_sparse_handle &) {
+    reset();
+    return *this;
+  }
+  ~mkl_sparse_handle() { reset(); }
+
+  template<typename T>
+  sparse_matrix_t get(sparse_format f, MKL_INT m, MKL_INT n,
+                      const MKL_INT *ptr, const MKL_INT *idx, const T *val) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!h_) {
+      sparse_matrix_t h = nullptr;
+      if (mkl_sparse_create(&h, f, m, n, const_cast<MKL_INT *>(ptr),
+                            const_cast<MKL_INT *>(idx),
+                            const_cast<T *>(val)) != SPARSE_STATUS_SUCCESS)
+        return nullptr;
+      mkl_sparse_set_mv_hint(h, SPARSE_OPERATION_NON_TRANSPOSE, mkl_general(),
+                             100);
+      mkl_sparse_optimize(h);
+      h_ = h;
+    }
+    return h_;
+  }
+
+  void reset() {
+    if (h_) mkl_sparse_destroy(h_);
+    h_ = nullptr;
+  }
+
+ private:
+  sparse_matrix_t h_ = nullptr;
+  std::mutex mutex_;
+};
+#endif
+
+} // namespace matrix_impl
+
+/// @brief A sparse matrix in CSR or CSC storage
+///
+/// Indices are zero-based and sorted within each row (CSR) or column (CSC),
+/// without duplicates.
+template<typename T>
+class SparseMatrix {
+ public:
+  static_assert(is_float<T>::value || is_double<T>::value,
+                "SparseMatrix: float or double expected");
+
+  using value_type = T;
+
+  SparseMatrix() = default;
+
+  /// @brief An m x n matrix of zeros
+  SparseMatrix(std::size_t m, std::size_t n,
+               sparse_format format = sparse_format::csr)
+      : m_(m), n_(n), format_(format),
+        ptr_((format == sparse_format::csr ? m : n) + 1, 0) {}
+
+  /// @brief An m x n matrix from its compressed arrays, which are moved in
+  SparseMatrix(std::size_t m, std::size_t n, std::vector<sparse_index> ptr,
+               std::vector<sparse_index> idx, std::vector<T> val,
+               sparse_format format = sparse_format::csr)
+      : m_(m), n_(n), format_(format), ptr_(std::move(ptr)),
+        idx_(std::move(idx)), val_(std::move(val)) {
+    assert(ptr_.size() == major() + 1);
+    assert(idx_.size() == val_.size());
+    assert(std::size_t(ptr_.back()) == val_.size());
+  }
+
+  /// @brief The nonzero elements of a dense matrix
+  explicit SparseMatrix(const Matrix<T, 2> &a,
+                        sparse_format format = sparse_format::csr);
+
+  std::size_t n_rows() const { return m_; }
+  std::size_t n_cols() const { return n_; }
+  /// @brief The number of stored elements
+  std::size_t nnz() const { return val_.size(); }
+  sparse_format format() const { return format_; }
+
+  /// @brief The m + 1 (CSR) or n + 1 (CSC) offsets of the rows or columns
+  const std::vector<sparse_index> &ptr() const { return ptr_; }
+  /// @brief The column (CSR) or row (CSC) index of each element
+  const std::vector<sparse_index> &indices() const { return idx_; }
+  const std::vector<T> &values() const { return val_; }
+  /// @brief The values, which may be changed in place
+  std::vector<T> &values() {
+#ifdef USE_MKL
+    handle_.reset();
+#endif
+    return val_;
+  }
+
+  /// @brief The element (i, j), zero if it is not stored
+  T operator()(std::size_t i, std::size_t j) const;
+
+  /// @brief The dense matrix
+  Matrix<T, 2> dense() const;
+  /// @brief The same matrix in the given storage
+  SparseMatrix convert(sparse_format format) const;
+  /// @brief The transpose, which only swaps the meaning of the arrays: the
+  /// CSR storage of A is the CSC storage of A'
+  SparseMatrix transpose() const {
+    SparseMatrix t(*this);
+    std::swap(t.m_, t.n_);
+    t.format_ = (format_ == sparse_format::csr) ? sparse_format::csc
+                                                 : sparse_format::csr;
+    return t;
+  }
+
+  /// @brief y = A * x for the arrays x of n_cols() and y of n_rows() elements
+  void mv(const T *x, T *y) const;
+  /// @brief C = A * B for the row-major arrays B of n_cols() x p and C of
+  /// n_rows() x p elements
+  void mm(std::size_t p, const T *b, T *c) const;
+
+ private:
+  std::size_t major() const {
+    return format_ == sparse_format::csr ? m_ : n_;
+  }
+
+  std::size_t m_ = 0;
+  std::size_t n_ = 0;
+  sparse_format format_ = sparse_format::csr;
+  std::vector<sparse_index> ptr_ = std::vector<sparse_index>(1, 0);
+  std::vector<sparse_index> idx_;
+  std::vector<T> val_;
+#ifdef USE_MKL
+  mutable matrix_impl::mkl_sparse_handle handle_;
+#endif
+};
+
+template<typename T>
+SparseMatrix<T>::SparseMatrix(const Matrix<T, 2> &a, sparse_format format)
+    : SparseMatrix(a.n_rows(), a.n_cols(), format) {
+  const bool csr = (format == sparse_format::csr);
+  const std::size_t nmaj = major(), nmin = csr ? n_ : m_;
+  for (std::size_t p = 0; p != nmaj; ++p) {
+    for (std::size_t q = 0; q != nmin; ++q) {
+      const T x = csr ? a(p, q) : a(q, p);
+      if (x == T(0)) continue;
+      idx_.push_back(q);
+      val_.push_back(x);
+    }
+    ptr_[p + 1] = idx_.size();
+  }
+}
+
+template<typename T>
+T SparseMatrix<T>::operator()(std::size_t i, std::size_t j) const {
+  assert(i < m_ && j < n_);
+  if (format_ == sparse_format::csc) std::swap(i, j);
+  const sparse_index *first = idx_.data() + ptr_[i];
+  const sparse_index *last = idx_.data() + ptr_[i + 1];
+  const sparse_index *it = std::lower_bound(first, last, sparse_index(j));
+  return (it != last && *it == sparse_index(j)) ? val_[it - idx_.data()]
+                                                : T(0);
+}
+
+template<typename T>
+Matrix<T, 2> SparseMatrix<T>::dense() const {
+  Matrix<T, 2> a(m_, n_);
+  const bool csr = (format_ == sparse_format::csr);
+  for (std::size_t p = 0; p != major(); ++p)
+    for (sparse_index k = ptr_[p]; k < ptr_[p + 1]; ++k) {
+      if (csr) a(p, idx_[k]) = val_[k];
+      else a(idx_[k], p) = val_[k];
+    }
+  return a;
+}
+
+template<typename T>
+SparseMatrix<T> SparseMatrix<T>::convert(sparse_format format) const {
+  if (format == format_) return *this;
+
+  // one stable counting sort by the minor index
+  const std::size_t nmin = (format_ == sparse_format::csr) ? n_ : m_;
+  std::vector<sparse_index> ptr(nmin + 1, 0), idx(nnz());
+  std::vector<T> val(nnz());
+  for (sparse_index c : idx_) ++ptr[c + 1];
+  std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
+
+  std::vector<sparse_index> next(ptr.begin(), ptr.end() - 1);
+  for (std::size_t p = 0; p != major(); ++p)
+    for (sparse_index k = ptr_[p]; k < ptr_[p + 1]; ++k) {
+      const sparse_index dst = next[idx_[k]]++;
+      idx[dst] = p;
+      val[dst] = val_[k];
+    }
+  return SparseMatrix(m_, n_, std::move(ptr), std::move(idx), std::move(val),
+                      format);
+}
+
+template<typename T>
+void SparseMatrix<T>::mv(const T *x, T *y) const {
+#ifdef USE_MKL
+  if (nnz() != 0) {
+    sparse_matrix_t h = handle_.get(format_, m_, n_, ptr_.data(),
+                                    idx_.data(), val_.data());
+    if (h && matrix_impl::mkl_sparse_mv(h, x, y) == SPARSE_STATUS_SUCCESS)
+      return;
+  }
+#endif
+  if (format_ == sparse_format::csr)
+    matrix_impl::csr_mv<T>(m_, ptr_.data(), idx_.data(), val_.data(), x, y);
+  else
+    matrix_impl::csc_mm<T>(m_, n_, 1, ptr_.data(), idx_.data(), val_.data(),
+                           x, y);
+}
+
+template<typename T>
+void SparseMatrix<T>::mm(std::size_t p, const T *b, T *c) const {
+#ifdef USE_MKL
+  if (nnz() != 0 && p != 0) {
+    sparse_matrix_t h = handle_.get(format_, m_, n_, ptr_.data(),
+                                    idx_.data(), val_.data());
+    if (h && matrix_impl::mkl_sparse_mm(h, p, b, c) == SPARSE_STATUS_SUCCESS)
+      return;
+  }
+#endif
+  if (format_ == sparse_format::csr)
+    matrix_impl::csr_mm<T>(m_, p, ptr_.data(), idx_.data(), val_.data(), b, c);
+  else
+    matrix_impl::csc_mm<T>(m_, n_, p, ptr_.data(), idx_.data(), val_.data(),
+                           b, c);
+}
+
+/// @brief Assembles a SparseMatrix from (row, column, value) triplets, in
+/// any order; the values of repeated positions are summed
+///
+/// add() may be called from several threads at once: each thread appends
+/// to a buffer of its own in the builder. When a buffer holds chunk_size()
+/// triplets, it is sorted into a chunk with its duplicates summed, so that
+/// repeated positions use no memory after that; the sort does not depend on
+/// n_rows() when the chunk is smaller. build() sorts the remaining buffers
+/// into chunks and merges the chunks in parallel blocks of rows, in
+/// O(nnz + n_rows()), with no more memory than the chunks and the result.
+/// The indices, and the number of stored elements of the result, must fit
+/// sparse_index.
+template<typename T>
+class SparseBuilder {
+ public:
+  static constexpr std::size_t default_chunk_size = std::size_t(1) << 22;
+
+  SparseBuilder(std::size_t m, std::size_t n,
+                std::size_t chunk_size = default_chunk_size)
+      : m_(m), n_(n), chunk_size_(std::max<std::size_t>(chunk_size, 1)),
+        id_(next_id()) {}
+
+  SparseBuilder(const SparseBuilder &) = delete;
+  SparseBuilder &operator=(const SparseBuilder &) = delete;
+
+  std::size_t n_rows() const { return m_; }
+  std::size_t n_cols() const { return n_; }
+  /// @brief The number of triplets a thread buffers before summing them
+  std::size_t chunk_size() const { return chunk_size_; }
+
+  /// @brief The number of triplets added so far, not to be called while
+  /// other threads add
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t n = 0;
+    for (const auto &b : buffers_) n += b.second->added;
+    return n;
+  }
+
+  /// @brief Reserves the buffer of the calling thread for nnz triplets, at
+  /// most chunk_size()
+  void reserve(std::size_t nnz) {
+    buffer &b = local();
+    nnz = std::min(nnz, chunk_size_);
+    b.rows.reserve(nnz);
+    b.cols.reserve(nnz);
+    b.val.reserve(nnz);
+  }
+
+  /// @brief Adds value to the element (i, j), from any thread
+  void add(std::size_t i, std::size_t j, const T &value) {
+    assert(i < m_ && j < n_);
+    assert(i <= std::size_t(std::numeric_limits<sparse_index>::max()) &&
+           j <= std::size_t(std::numeric_limits<sparse_index>::max()));
+    buffer &b = local();
+    b.rows.push_back(i);
+    b.cols.push_back(j);
+    b.val.push_back(value);
+    ++b.added;
+    if (b.val.size() >= chunk_size_) flush(b);
+  }
+
+  /// @brief Removes all the triplets
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.clear();
+    chunks_.clear();
+    id_ = next_id();
+  }
+
+  /// @brief The matrix of the triplets added so far, not to be called while
+  /// other threads add
+  ///
+  /// If drop_zeros, the elements whose values sum to zero are not stored.
+  SparseMatrix<T> build(sparse_format format = sparse_format::csr,
+                        bool drop_zeros = false);
+
+ private:
+  struct buffer : matrix_impl::triplet_list<T> {
+    std::size_t added = 0;
+  };
+  using chunk = matrix_impl::triplet_list<T>;
+
+  static std::uint64_t next_id() {
+    static std::atomic<std::uint64_t> id(1);
+    return id++;
+  }
+
+  // the buffer of the calling thread: the builder last used by the thread
+  // is remembered, and the buffers of the others are looked up by thread
+  buffer &local() {
+    static thread_local std::uint64_t last_id = 0;
+    static thread_local buffer *last = nullptr;
+    if (last_id != id_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::unique_ptr<buffer> &b = buffers_[std::this_thread::get_id()];
+      if (!b) b.reset(new buffer);
+      last = b.get();
+      last_id = id_;
+    }
+    return *last;
+  }
+
+  void flush(buffer &b) {
+    chunk c = matrix_impl::sort_triplets(m_, b);
+    b.rows.clear();
+    b.cols.clear();
+    b.val.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunks_.push_back(std::move(c));
+  }
+
+  std::size_t m_, n_;
+  std::size_t chunk_size_;
+  std::uint64_t id_;
+  std::map<std::thread::id, std::unique_ptr<buffer>> buffers_;
+  std::vector<chunk> chunks_;
+  mutable std::mutex mutex_;
+};
+
+template<typename T>
+SparseMatrix<T> SparseBuilder<T>::build(sparse_format format,
+                                        bool drop_zeros) {
+  // sort what remains in the thread buffers, releasing them
+  std::vector<buffer *> pending;
+  std::size_t triplets = 0;
+  for (const auto &b : buffers_) {
+    if (!b.second->val.empty()) pending.push_back(b.second.get());
+    triplets += b.second->added;
+  }
+  const bool parallel = (triplets > 32768);
+  const std::size_t first = chunks_.size();
+  chunks_.resize(first + pending.size());
+  const std::ptrdiff_t np = pending.size();
+#pragma omp parallel for schedule(dynamic) if(parallel)
+  for (std::ptrdiff_t p = 0; p < np; ++p) {
+    buffer &b = *pending[p];
+    chunks_[first + p] = matrix_impl::sort_triplets(m_, b);
+    b.rows = std::vector<sparse_index>();
+    b.cols = std::vector<sparse_index>();
+    b.val = std::vector<T>();
+  }
+
+  std::vector<sparse_index> ptr, idx;
+  std::vector<T> val;
+  matrix_impl::merge_chunks(m_, chunks_, drop_zeros, parallel, ptr, idx, val);
+  SparseMatrix<T> a(m_, n_, std::move(ptr), std::move(idx), std::move(val));
+  return format == sparse_format::csr ? a : a.convert(format);
+}
+
+/// @brief The product of a sparse matrix and a vector
+template<typename T>
+Matrix<T, 1> matmul(const SparseMatrix<T> &a, const Matrix<T, 1> &x) {
+  assert(a.n_cols() == x.size());
+  Matrix<T, 1> y(a.n_rows());
+  if (a.n_rows() != 0) a.mv(x.data(), y.data());
+  return y;
+}
+
+/// @brief The product of a sparse matrix and a dense matrix
+template<typename T>
+Matrix<T, 2> matmul(const SparseMatrix<T> &a, const Matrix<T, 2> &b) {
+  assert(a.n_cols() == b.n_rows());
+  Matrix<T, 2> c(a.n_rows(), b.n_cols());
+  if (c.size() != 0) a.mm(b.n_cols(), b.data(), c.data());
+  return c;
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_SPARSE_MATRIX_H_
@@ -170,6 +170,7 @@ bool check_bounds(const MatrixSlice<N> &ms, Dims... dims) {
 template<size_t NRest, size_t N>
 std::size_t do_slice_dim(const MatrixSlice<N> &os, MatrixSlice<N> &ns, std::size_t s) {
   std::size_t i = N - NRest;
+  assert(s < os.extents[i]);
   ns.strides[i] = os.strides[i];
   ns.extents[i] = 1;
   return s * ns.strides[i];
@@ -182,6 +183,10 @@ std::size_t do_slice_dim(const MatrixSlice<N> &os, MatrixSlice<N> &ns, slice s)
   ns.extents[i] = (s.length == size_t(-1)) ?
                   (os.extents[i] - s.start + s.stride - 1) / s.stride
                                            : s.length;
+  // the slice must lie within the extent
+  assert(s.start <= os.extents[i]);
+  assert(ns.extents[i] == 0 ||
+         s.start + (ns.extents[i] - 1) * s.stride < os.extents[i]);
   return s.start * os.strides[i];
 }
 
@@ -0,0 +1,129 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file svd.h
+/// @brief Singular value decomposition
+///
+/// A row-major m x n matrix A is the column-major n x m matrix A', and
+/// A = U * S * V' if and only if A' = V * S * U'. gesdd is therefore run on
+/// A' as stored, and writes V' and U directly in row-major order: neither A
+/// nor the singular vectors are transposed.
+
+#ifndef SLAB_MATRIX_SVD_H_
+#define SLAB_MATRIX_SVD_H_
+
+#include "slab/matrix/matrix.h"
+#include "slab/matrix/lapack_interface.h"
+
+/// @addtogroup eigen EIGENVALUES AND SINGULAR VALUES
+/// @{
+
+/// @brief The singular vectors computed by svd()
+enum class svd_mode {
+  /// the first min(m, n) columns of U and rows of V'
+  thin,
+  /// all of U (m x m) and V' (n x n)
+  full,
+  /// no singular vectors
+  values
+};
+
+namespace matrix_impl {
+
+// gesdd on the m x n matrix a; u, vt are row-major m x ldu and ldvt x n
+template<typename M, typename T>
+int gesdd(const M &a, char jobz, T *s, T *u, int ldu, T *vt) {
+  const int m = a.n_rows(), n = a.n_cols(), k = std::min(m, n);
+
+  static thread_local lapack_work<T> work;
+
+  WorkspaceScope scope;
+  T *at = scope.get<T>(std::size_t(m) * n);
+  copy_to(a, at, n);
+
+  // the column-major A' = V S U': gesdd's "U" is our V', its "V'" our U
+  work.fit({{0, jobz, m, n}}, [&](T *query, int *iquery) {
+    lapack_impl::gesdd(jobz, n, m, at, n, s, vt, n, u, ldu, query, -1, iquery);
+    *iquery = 8 * k;
+  });
+  return lapack_impl::gesdd(jobz, n, m, at, n, s, vt, n, u, ldu, work.work,
+                            work.lwork, work.iwork);
+}
+
+} // namespace matrix_impl
+
+/// @brief Computes the singular values of a matrix (gesdd)
+///
+/// The workspaces are taken from the workspace pool of the calling thread, so
+/// repeated calls with matrices of the same size do not allocate them again.
+///
+/// @param a a Matrix or a MatrixRef.
+/// @param s the min(m, n) singular values on exit, in decreasing order.
+/// @return 0 on success, i > 0 if the algorithm did not converge.
+template<typename M, typename T>
+Enable_if<Matrix_type<M>(), int> svd(const M &a, Matrix<T, 1> &s) {
+  static_assert(Same<Element_type<M>, T>(), "svd: incompatible element types");
+
+  const std::size_t k = std::min(a.n_rows(), a.n_cols());
+  if (s.size() != k) s = Matrix<T, 1>(k);
+  if (k == 0) return 0;
+
+  T dummy[1];
+  return matrix_impl::gesdd(a, 'N', s.data(), dummy, 1, dummy);
+}
+
+/// @brief Computes the singular value decomposition A = U * S * V' (gesdd)
+///
+/// @param a    a Matrix or a MatrixRef.
+/// @param u    the left singular vectors on exit, as columns.
+/// @param s    the min(m, n) singular values on exit, in decreasing order.
+/// @param vt   the right singular vectors on exit, as rows.
+/// @param mode thin or full U and V'; with values, u and vt are left empty.
+/// @return 0 on success, i > 0 if the algorithm did not converge.
+template<typename M, typename T>
+Enable_if<Matrix_type<M>(), int>
+svd(const M &a, Matrix<T, 2> &u, Matrix<T, 1> &s, Matrix<T, 2> &vt,
+    svd_mode mode = svd_mode::thin) {
+  static_assert(Same<Element_type<M>, T>(), "svd: incompatible element types");
+
+  if (mode == svd_mode::values) {
+    u.clear();
+    vt.clear();
+    return svd(a, s);
+  }
+
+  const std::size_t m = a.n_rows(), n = a.n_cols(), k = std::min(m, n);
+  const std::size_t ucols = (mode == svd_mode::full) ? m : k;
+  const std::size_t vrows = (mode == svd_mode::full) ? n : k;
+  if (s.size() != k) s = Matrix<T, 1>(k);
+  if (u.n_rows() != m || u.n_cols() != ucols) u = Matrix<T, 2>(m, ucols);
+  if (vt.n_rows() != vrows || vt.n_cols() != n) vt = Matrix<T, 2>(vrows, n);
+  if (m == 0 || n == 0) {
+    // the full U or V' of an empty matrix is any orthogonal matrix
+    std::fill(u.begin(), u.end(), T(0));
+    std::fill(vt.begin(), vt.end(), T(0));
+    for (std::size_t i = 0; i != ucols; ++i) u(i, i) = T(1);
+    for (std::size_t i = 0; i != vrows; ++i) vt(i, i) = T(1);
+    return 0;
+  }
+
+  const char jobz = (mode == svd_mode::full) ? 'A' : 'S';
+  return matrix_impl::gesdd(a, jobz, s.data(), u.data(), ucols, vt.data());
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_SVD_H_
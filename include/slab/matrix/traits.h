@@ -81,9 +81,34 @@ constexpr bool Matrix_type() {
   return Has_matrix_type<M>();
 }
 
+template<typename M>
+struct get_vector_type_result {
+
+  template<typename T>
+  static bool check(const Matrix<T, 1> &m);
+
+  template<typename T>
+  static bool check(const MatrixRef<T, 1> &m);
+
+  static substitution_failure check(...);
+
+  using type = decltype(check(std::declval<M>()));
+};
+
+// Matrix<T, 1> or MatrixRef<T, 1>, e.g. a row or a column of a matrix
+template<typename M>
+constexpr bool Vector_type() {
+  return substitution_succeeded<typename get_vector_type_result<M>::type>::value;
+}
+
 template<typename C>
 using Value_type = typename C::value_type;
 
+// the (non-const) element type of a Matrix or MatrixRef, or a reference to one
+template<typename M>
+using Element_type = typename std::remove_const<
+    Value_type<typename std::decay<M>::type>>::type;
+
 template<typename T>
 struct is_double : public std::false_type {};
 
@@ -0,0 +1,210 @@
+//
+// Copyright 2018 The StatsLabs Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/// @file workspace.h
+/// @brief Per-thread scratch memory for the LAPACK and BLAS wrappers
+///
+/// Most LAPACK routines need scratch arrays whose size comes from a workspace
+/// query, and the row-major wrappers need column-major copies of their
+/// arguments. Instead of allocating them on every call, the wrappers take
+/// them from the WorkspacePool of the calling thread: a stack of memory
+/// released in bulk when the WorkspaceScope that took it ends. When a scope
+/// needs more memory than the pool holds, the missing part is allocated
+/// separately, and the pool is grown to the high-water mark once the
+/// outermost scope ends. Repeating the same calls then allocates nothing.
+
+#ifndef SLAB_MATRIX_WORKSPACE_H_
+#define SLAB_MATRIX_WORKSPACE_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// @addtogroup workspace WORKSPACE
+/// @{
+
+/// @brief Memory statistics of a WorkspacePool
+struct WorkspaceStats {
+  std::size_t capacity_bytes;  ///< bytes held by the pool
+  std::size_t peak_bytes;      ///< most bytes in use at once
+  std::size_t allocations;     ///< heap allocations made by the pool
+  std::size_t requests;        ///< buffers handed out
+};
+
+/// @brief The scratch memory of one thread, see workspace.h
+///
+/// Buffers are aligned to 64 bytes. They are only valid until the
+/// WorkspaceScope that was innermost when they were taken ends.
+class WorkspacePool {
+ public:
+  static constexpr std::size_t alignment = 64;
+
+  /// @brief The pool of the calling thread
+  static WorkspacePool &local() {
+    static thread_local WorkspacePool pool;
+    return pool;
+  }
+
+  WorkspacePool() = default;
+  WorkspacePool(const WorkspacePool &) = delete;
+  WorkspacePool &operator=(const WorkspacePool &) = delete;
+
+  /// @brief A buffer of n elements of T, uninitialized, in the innermost
+  /// WorkspaceScope
+  template<typename T>
+  T *get(std::size_t n) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "WorkspacePool: trivial types expected");
+    return static_cast<T *>(get_bytes(n * sizeof(T)));
+  }
+
+  WorkspaceStats stats() const {
+    return {capacity_, peak_, allocations_, requests_};
+  }
+
+  /// @brief Resets the peak, allocation and request counts
+  void reset_stats() {
+    peak_ = used_;
+    allocations_ = 0;
+    requests_ = 0;
+  }
+
+  /// @brief Frees the memory of the pool, which must not be in use
+  void release() {
+    assert(depth_ == 0);
+    block_ = buffer();
+    capacity_ = 0;
+    peak_ = 0;
+    high_water_ = 0;
+  }
+
+ private:
+  friend class WorkspaceScope;
+
+  struct mark {
+    std::size_t offset;
+    std::size_t overflow;
+    std::size_t used;
+  };
+
+  struct buffer {
+    std::unique_ptr<unsigned char[]> data;
+    std::size_t size;  // zero in a value-initialized buffer()
+  };
+
+  static std::size_t round_up(std::size_t bytes) {
+    return (bytes + alignment - 1) / alignment * alignment;
+  }
+
+  static unsigned char *aligned(const buffer &b) {
+    const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(b.data.get());
+    return reinterpret_cast<unsigned char *>(round_up(p));
+  }
+
+  buffer allocate(std::size_t bytes) {
+    ++allocations_;
+    capacity_ += bytes;
+    return {std::unique_ptr<unsigned char[]>(
+        new unsigned char[bytes + alignment - 1]), bytes};
+  }
+
+  void *get_bytes(std::size_t bytes) {
+    assert(depth_ > 0 && "WorkspacePool: no WorkspaceScope");
+    bytes = round_up(std::max<std::size_t>(bytes, 1));
+    ++requests_;
+    used_ += bytes;
+    peak_ = std::max(peak_, used_);
+    high_water_ = std::max(high_water_, used_);
+
+    if (offset_ + bytes <= block_.size) {
+      void *p = aligned(block_) + offset_;
+      offset_ += bytes;
+      return p;
+    }
+    // the pool is too small: the buffer lives until the scope ends
+    overflow_.push_back(allocate(bytes));
+    return aligned(overflow_.back());
+  }
+
+  mark enter() {
+    ++depth_;
+    return {offset_, overflow_.size(), used_};
+  }
+
+  void leave(const mark &m) {
+    assert(depth_ > 0);
+    --depth_;
+    offset_ = m.offset;
+    used_ = m.used;
+    while (overflow_.size() != m.overflow) {
+      capacity_ -= overflow_.back().size;
+      overflow_.pop_back();
+      grow_ = true;
+    }
+    if (depth_ != 0 || !grow_) return;
+
+    // once nothing is in use, the pool grows to the high-water mark
+    capacity_ -= block_.size;
+    block_ = buffer();
+    block_ = allocate(high_water_);
+    grow_ = false;
+  }
+
+  buffer block_ = buffer();
+  std::size_t offset_ = 0;  // bytes of block_ in use
+  std::vector<buffer> overflow_;
+  std::size_t depth_ = 0;
+  std::size_t used_ = 0;
+  std::size_t high_water_ = 0;
+  bool grow_ = false;
+
+  std::size_t capacity_ = 0;
+  std::size_t peak_ = 0;
+  std::size_t allocations_ = 0;
+  std::size_t requests_ = 0;
+};
+
+/// @brief Returns the buffers taken from the pool of the calling thread
+/// during its lifetime
+class WorkspaceScope {
+ public:
+  WorkspaceScope() : pool_(WorkspacePool::local()), mark_(pool_.enter()) {}
+  ~WorkspaceScope() { pool_.leave(mark_); }
+
+  WorkspaceScope(const WorkspaceScope &) = delete;
+  WorkspaceScope &operator=(const WorkspaceScope &) = delete;
+
+  /// @brief A buffer of n elements of T, see WorkspacePool::get()
+  template<typename T>
+  T *get(std::size_t n) { return pool_.template get<T>(n); }
+
+ private:
+  WorkspacePool &pool_;
+  WorkspacePool::mark mark_;
+};
+
+/// @brief The memory statistics of the workspace pool of the calling thread
+inline WorkspaceStats workspace_stats() {
+  return WorkspacePool::local().stats();
+}
+
+/// @}
+
+#endif // SLAB_MATRIX_WORKSPACE_H_
@@ -4,6 +4,25 @@
 #include "test_matrix_opereration.h"
 
 #include "test_blas.h"
+#include "test_lapack.h"
+#include "test_eigen.h"
+#include "test_workspace.h"
+#include "test_packed.h"
+#include "test_band.h"
+#include "test_sparse.h"
+#include "test_krylov.h"
+#include "test_reduction.h"
+#include "test_covariance.h"
+#include "test_running_stats.h"
+#include "test_random.h"
+#include "test_elementwise.h"
+#include "test_broadcast.h"
+#include "test_sort.h"
+#include "test_quantile.h"
+#include "test_indexing.h"
+#include "test_mask.h"
+#include "test_gemm_kernel.h"
+#include "test_gemm_dispatch.h"
 
 int main(int argc, char **argv)
 {
@@ -0,0 +1,115 @@
+#ifndef MATRIX_TEST_BAND_H
+#define MATRIX_TEST_BAND_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(BandMatrixTest, StorageAndProduct) {
+  mat dense = {
+      {4, 1, 2, 0, 0},
+      {-1, 5, 1, 2, 0},
+      {0, 2, 6, -1, 1},
+      {0, 0, 1, 7, 2},
+      {0, 0, 0, 3, 8}
+  };
+  BandMatrix<double> a(dense, 1, 2);
+  EXPECT_EQ(5, a.n());
+  EXPECT_EQ(4, a.ldab());
+  EXPECT_EQ(20, a.size());
+  EXPECT_TRUE(a.in_band(1, 3));
+  EXPECT_FALSE(a.in_band(3, 1));
+
+  const BandMatrix<double> &ca = a;
+  EXPECT_EQ(2, ca(0, 2));
+  EXPECT_EQ(0, ca(4, 0));
+
+  mat back = a.dense();
+  for (std::size_t i = 0; i != 5; ++i)
+    for (std::size_t j = 0; j != 5; ++j) EXPECT_EQ(dense(i, j), back(i, j));
+
+  vec x = {1, -1, 2, 0.5, -2};
+  vec y = matmul(a, x);
+  vec expected = matmul(dense, x);
+  for (std::size_t i = 0; i != 5; ++i) EXPECT_NEAR(expected(i), y(i), 1e-14);
+
+  // y := A' x + 2 y
+  vec yt = y;
+  blas_gbmv(1.0, a, x, 2.0, yt, blas_trans::trans);
+  vec at_x = matmul(mat(transpose(dense)), x);
+  for (std::size_t i = 0; i != 5; ++i)
+    EXPECT_NEAR(at_x(i) + 2 * y(i), yt(i), 1e-14);
+}
+
+TEST(BandMatrixTest, LUSolve) {
+  // small diagonal entries force row interchanges
+  mat dense = {
+      {0.1, 2, 0, 0, 0, 0},
+      {3, 0.2, 1, 0, 0, 0},
+      {0, 4, 0.1, -1, 0, 0},
+      {0, 0, 2, 0.3, 1, 0},
+      {0, 0, 0, -2, 0.1, 5},
+      {0, 0, 0, 0, 1, 0.4}
+  };
+  BandMatrix<double> a(dense, 1, 1);
+  vec x = {1, 2, -1, 0.5, 3, -2};
+  vec b = matmul(dense, x);
+
+  BandLU<double> lu(a);
+  ASSERT_TRUE(lu.ok());
+  vec sol;
+  ASSERT_EQ(0, lu.solve(b, sol));
+  for (std::size_t i = 0; i != 6; ++i) EXPECT_NEAR(x(i), sol(i), 1e-12);
+
+  vec bt = matmul(mat(transpose(dense)), x);
+  ASSERT_EQ(0, lu.solve(bt, sol, blas_trans::trans));
+  for (std::size_t i = 0; i != 6; ++i) EXPECT_NEAR(x(i), sol(i), 1e-12);
+
+  mat xs = {{1, 0}, {2, 1}, {-1, 1}, {0.5, 2}, {3, -1}, {-2, 0}};
+  mat bs = matmul(dense, xs);
+  mat sols = lu.solve(bs);
+  for (std::size_t i = 0; i != 6; ++i)
+    for (std::size_t j = 0; j != 2; ++j) EXPECT_NEAR(xs(i, j), sols(i, j), 1e-12);
+
+  BandMatrix<double> singular(3, 1, 1);
+  singular(0, 0) = 1;
+  singular(1, 0) = 1;
+  BandLU<double> slu(singular);
+  EXPECT_EQ(2, slu.info());
+  EXPECT_EQ(0, slu.solve(vec{1, 1, 1}).size());
+}
+
+TEST(BandMatrixTest, CholeskySolveLargeTridiagonal) {
+  // the second difference matrix, with the solution of a spline-like system
+  const std::size_t n = 100000;
+  BandMatrix<double> a(n, 1, 1);
+  for (std::size_t i = 0; i != n; ++i) {
+    a(i, i) = 2.5;
+    if (i > 0) a(i, i - 1) = -1;
+    if (i + 1 < n) a(i, i + 1) = -1;
+  }
+
+  vec x(n);
+  for (std::size_t i = 0; i != n; ++i) x(i) = std::sin(0.001 * i);
+  vec b = matmul(a, x);
+
+  vec sol;
+  ASSERT_EQ(0, solve(a, b, sol, solve_method::cholesky));
+  double err = 0;
+  for (std::size_t i = 0; i != n; ++i) err = std::max(err, std::abs(x(i) - sol(i)));
+  EXPECT_LT(err, 1e-12);
+
+  ASSERT_EQ(0, solve(a, b, sol));
+  err = 0;
+  for (std::size_t i = 0; i != n; ++i) err = std::max(err, std::abs(x(i) - sol(i)));
+  EXPECT_LT(err, 1e-12);
+
+  BandMatrix<double> indefinite(mat{{1, 2}, {2, 1}}, 1, 1);
+  BandCholesky<double> chol(indefinite);
+  EXPECT_EQ(2, chol.info());
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_BAND_H
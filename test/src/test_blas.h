@@ -108,6 +108,70 @@ TEST(BLASlevel1Test, IAMAX) {
   EXPECT_EQ(1, idx2);
 }
 
+TEST(BLASlevel1Test, ColumnViews) {
+  const mat m = {
+      {1, 2, 3},
+      {4, 5, 6},
+      {7, 8, 9}
+  };
+
+  EXPECT_DOUBLE_EQ(15, blas_asum(m.col(1)));
+  EXPECT_DOUBLE_EQ(std::sqrt(126.0), blas_nrm2(m.col(2)));
+  EXPECT_DOUBLE_EQ(2 * 3 + 5 * 6 + 8 * 9, blas_dot(m.col(1), m.col(2)));
+  EXPECT_DOUBLE_EQ(4 * 2 + 5 * 5 + 6 * 8, blas_dot(m.row(1), m.col(1)));
+  EXPECT_EQ(2, blas_iamax(m.col(0)));
+
+  vec c;
+  blas_copy(m.col(2), c);
+  EXPECT_EQ(3, c.size());
+  EXPECT_EQ(3, c(0));
+  EXPECT_EQ(6, c(1));
+  EXPECT_EQ(9, c(2));
+}
+
+TEST(BLASlevel1Test, UpdateViewsInPlace) {
+  mat m = {
+      {1, 2, 3},
+      {4, 5, 6}
+  };
+  vec v = {10, 20};
+
+  blas_scal(2.0, m.col(1));
+  blas_axpy(1.0, v, m.col(2));
+  blas_swap(m.col(0), v);
+
+  EXPECT_EQ(10, m(0, 0));
+  EXPECT_EQ(20, m(1, 0));
+  EXPECT_EQ(4, m(0, 1));
+  EXPECT_EQ(10, m(1, 1));
+  EXPECT_EQ(13, m(0, 2));
+  EXPECT_EQ(26, m(1, 2));
+  EXPECT_EQ(1, v(0));
+  EXPECT_EQ(4, v(1));
+}
+
+TEST(BLASlevel1Test, StridedSlices) {
+  vec v = {1, -7, 2, 3, 4, 5};
+  auto odd = v(slice(1, 3, 2));           // {-7, 3, 5}
+
+  EXPECT_EQ(3, odd.size());
+  EXPECT_DOUBLE_EQ(15, blas_asum(odd));
+  EXPECT_EQ(0, blas_iamax(odd));
+  EXPECT_DOUBLE_EQ(1 + 4 + 16, blas_dot(v(slice(0, 3, 2)), v(slice(0, 3, 2))));
+}
+
+TEST(BLASlevel1Test, Complex) {
+  cx_vec z = {{3, 4}, {-1, 2}};
+
+  EXPECT_DOUBLE_EQ(10, blas_asum(z));
+  EXPECT_DOUBLE_EQ(std::sqrt(30.0), blas_nrm2(z));
+
+  blas_scal(std::complex<double>(0, 1), z);
+  EXPECT_EQ(std::complex<double>(-4, 3), z(0));
+  blas_scal(2.0, z);
+  EXPECT_EQ(std::complex<double>(-4, -2), z(1));
+}
+
 }
 
 #endif //MATRIX_TEST_MATRIX_BLAS_H
@@ -0,0 +1,138 @@
+#ifndef MATRIX_TEST_BROADCAST_H
+#define MATRIX_TEST_BROADCAST_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(BroadcastTest, VectorAcrossRowsAndColumns) {
+  mat m = {{1, 2, 3}, {4, 5, 6}};
+  vec v = {10, 20, 30};
+  mat r = m + v;
+  EXPECT_EQ(11, r(0, 0));
+  EXPECT_EQ(36, r(1, 2));
+  mat l = v - m;
+  EXPECT_EQ(9, l(0, 0));
+  EXPECT_EQ(24, l(1, 2));
+  mat p = m * as_row(v);
+  EXPECT_EQ(40, p(1, 0));
+
+  vec s = {2, 4};
+  mat q = m / as_column(s);
+  EXPECT_EQ(0.5, q(0, 0));
+  EXPECT_EQ(1.5, q(1, 2));
+
+  // a row and a column broadcast to their outer sum
+  mat o = as_column(s) + as_row(v);
+  ASSERT_EQ(2, o.n_rows());
+  ASSERT_EQ(3, o.n_cols());
+  EXPECT_EQ(34, o(1, 2));
+
+  // compound operators, with a column of a matrix as the operand
+  mat c = m;
+  c -= m.row(0);
+  EXPECT_EQ(0, c(0, 2));
+  EXPECT_EQ(3, c(1, 2));
+  c = m;
+  c *= as_column(m.col(0));
+  EXPECT_EQ(3, c(0, 2));
+  EXPECT_EQ(24, c(1, 2));
+  MatrixRef<double, 2> tail = c(slice(0, 2), slice(1, 2));
+  tail += v(slice(0, 2));
+  EXPECT_EQ(12, tail(0, 0));
+  EXPECT_EQ(44, c(1, 2));
+  EXPECT_EQ(16, c(1, 0));
+}
+
+TEST(BroadcastTest, SizeOneExtentsInNDimensions) {
+  Matrix<int, 3> a(2, 1, 4), b(1, 3, 4);
+  std::iota(a.begin(), a.end(), 0);
+  std::iota(b.begin(), b.end(), 100);
+  Matrix<int, 3> c = a + b;
+  ASSERT_EQ(2, c.extent(0));
+  ASSERT_EQ(3, c.extent(1));
+  ASSERT_EQ(4, c.extent(2));
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      for (std::size_t k = 0; k != 4; ++k)
+        EXPECT_EQ(a(i, 0, k) + b(0, j, k), c(i, j, k));
+
+  // a matrix across the leading axis, in place
+  Matrix<int, 2> m = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+  c -= m;
+  EXPECT_EQ(a(1, 0, 3) + b(0, 2, 3) - 12, c(1, 2, 3));
+  Matrix<int, 3> d(2, 3, 1);
+  std::fill(d.begin(), d.end(), 2);
+  d(1, 2, 0) = 3;
+  c *= d;
+  EXPECT_EQ(3 * (a(1, 0, 3) + b(0, 2, 3) - 12), c(1, 2, 3));
+  EXPECT_EQ(2 * (a(0, 0, 0) + b(0, 0, 0) - 1), c(0, 0, 0));
+}
+
+TEST(BroadcastTest, ApplyInOrderAndAliasedOperands) {
+  // apply() calls f in order, even on a matrix large enough for the
+  // operators to run in parallel
+  const std::size_t n = 300;
+  mat big(n, n);
+  vec ones(n);
+  std::fill(ones.begin(), ones.end(), 1.0);
+  std::size_t calls = 0;
+  big.apply(ones, [&](double &a, const double &b) { a = b * calls++; });
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != n; ++j) ASSERT_EQ(i * n + j, big(i, j));
+
+  // an operand within *this is read before *this is updated
+  mat m = {{1, 2, 3}, {4, 5, 6}};
+  mat d = m;
+  d -= d.row(0);
+  EXPECT_EQ(0, d(0, 2));
+  EXPECT_EQ(3, d(1, 2));
+  d = m;
+  d(slice(0, 2), slice(1, 2)) /= as_column(d.col(1));
+  EXPECT_EQ(1, d(0, 1));
+  EXPECT_EQ(1.5, d(0, 2));
+  EXPECT_EQ(1.2, d(1, 2));
+  d = m;
+  d += d;
+  EXPECT_EQ(12, d(1, 2));
+  big -= big.row(n - 1);
+  EXPECT_EQ(0, big(n - 1, 5));
+  EXPECT_EQ(-double(n * n - n), big(0, 0));
+}
+
+TEST(BroadcastTest, CenterAndScaleColumns) {
+  const std::size_t n = 400, p = 300;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j)
+      x(i, j) = std::sin(0.1 * i + j) * (j + 1) + j;
+
+  vec mu(p), sd(p);
+  for (std::size_t j = 0; j != p; ++j) {
+    double s = 0, ss = 0;
+    for (std::size_t i = 0; i != n; ++i) s += x(i, j);
+    mu(j) = s / n;
+    for (std::size_t i = 0; i != n; ++i)
+      ss += (x(i, j) - mu(j)) * (x(i, j) - mu(j));
+    sd(j) = std::sqrt(ss / (n - 1));
+  }
+  mat z = (x - mu) / sd;
+  mat w = x;
+  w -= mu;
+  w /= sd;
+  for (std::size_t j = 0; j != p; ++j) {
+    double s = 0, ss = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+      s += z(i, j);
+      ss += z(i, j) * z(i, j);
+      EXPECT_EQ(z(i, j), w(i, j));
+    }
+    EXPECT_NEAR(0, s / n, 1e-12);
+    EXPECT_NEAR(1, ss / (n - 1), 1e-12);
+  }
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_BROADCAST_H
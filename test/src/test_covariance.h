@@ -0,0 +1,89 @@
+#ifndef MATRIX_TEST_COVARIANCE_H
+#define MATRIX_TEST_COVARIANCE_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+// the covariance of the columns of x, the straightforward way
+inline mat naive_cov(const mat &x, std::size_t ddof) {
+  const std::size_t n = x.n_rows(), p = x.n_cols();
+  vec mu = mean(x, 0);
+  mat c(p, p);
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = 0; j != p; ++j) {
+      double s = 0;
+      for (std::size_t k = 0; k != n; ++k)
+        s += (x(k, i) - mu(i)) * (x(k, j) - mu(j));
+      c(i, j) = s / (n - ddof);
+    }
+  return c;
+}
+
+TEST(CovarianceTest, MatchesDefinition) {
+  mat x = {
+      {1, 2, 0.5},
+      {2, 1, 1.5},
+      {4, 0, 2.0},
+      {3, 5, -1.0},
+      {0, 2, 0.0}
+  };
+  mat c = cov(x);
+  mat expected = naive_cov(x, 1);
+  ASSERT_EQ(3, c.n_rows());
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j) {
+      EXPECT_NEAR(expected(i, j), c(i, j), 1e-14);
+      EXPECT_EQ(c(i, j), c(j, i));
+    }
+  EXPECT_NEAR(naive_cov(x, 0)(0, 1), cov(x, 0)(0, 1), 1e-14);
+
+  mat r = corr(x);
+  for (std::size_t i = 0; i != 3; ++i) {
+    EXPECT_NEAR(1, r(i, i), 1e-14);
+    for (std::size_t j = 0; j != 3; ++j)
+      EXPECT_NEAR(expected(i, j) / std::sqrt(expected(i, i) * expected(j, j)),
+                  r(i, j), 1e-14);
+  }
+
+  // integer weights repeat rows
+  vec w = {1, 3, 0, 2, 1};
+  mat repeated = {
+      {1, 2, 0.5},
+      {2, 1, 1.5}, {2, 1, 1.5}, {2, 1, 1.5},
+      {3, 5, -1.0}, {3, 5, -1.0},
+      {0, 2, 0.0}
+  };
+  mat cw = cov(x, w, 0);
+  mat cr = cov(repeated, 0);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j) EXPECT_NEAR(cr(i, j), cw(i, j), 1e-14);
+  vec ones = {1, 1, 1, 1, 1};
+  EXPECT_NEAR(c(2, 1), cov(x, ones)(2, 1), 1e-14);
+  EXPECT_NEAR(corr(repeated)(0, 2), corr(x, w)(0, 2), 1e-14);
+
+  // the columns 0 and 2 of x, a strided view
+  mat c02 = cov(x(slice(0, 5), slice(0, 2, 2)));
+  EXPECT_NEAR(expected(0, 2), c02(0, 1), 1e-14);
+  EXPECT_NEAR(expected(2, 2), c02(1, 1), 1e-14);
+}
+
+TEST(CovarianceTest, TallMatrixInChunks) {
+  // more rows than one chunk of 4 MB, with a large mean
+  const std::size_t n = 150000, p = 5;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j)
+      x(i, j) = 1e6 + std::sin(0.7 * i * (j + 1)) + (j == 4 ? x(i, 0) - 1e6 : 0);
+  mat c = cov(x);
+  mat expected = naive_cov(x, 1);
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = 0; j != p; ++j)
+      EXPECT_NEAR(expected(i, j), c(i, j), 1e-9);
+  EXPECT_GT(corr(x)(0, 4), 0.7);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_COVARIANCE_H
@@ -0,0 +1,146 @@
+#ifndef MATRIX_TEST_EIGEN_H
+#define MATRIX_TEST_EIGEN_H
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(EigSymTest, AllAndTopK) {
+  // eigenvalues 2 - sqrt(2), 2, 2 + sqrt(2); only the lower triangle is read
+  mat a = {
+      {2, 99, 99},
+      {-1, 2, 99},
+      {0, -1, 2}
+  };
+  mat sym = {
+      {2, -1, 0},
+      {-1, 2, -1},
+      {0, -1, 2}
+  };
+  const double r2 = std::sqrt(2.0);
+
+  vec w;
+  EXPECT_EQ(0, eig_sym(a, w));
+  ASSERT_EQ(3, w.size());
+  EXPECT_NEAR(2 - r2, w(0), 1e-12);
+  EXPECT_NEAR(2, w(1), 1e-12);
+  EXPECT_NEAR(2 + r2, w(2), 1e-12);
+
+  mat v;
+  EXPECT_EQ(0, eig_sym(a, w, v));
+  for (std::size_t j = 0; j != 3; ++j) {
+    vec vj = v.col(j);
+    vec av = matmul(sym, vj);
+    EXPECT_NEAR(1, blas_nrm2(vj), 1e-12);
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(w(j) * vj(i), av(i), 1e-12);
+  }
+
+  vec top;
+  mat vtop;
+  EXPECT_EQ(0, eig_sym(a, 2, top));
+  ASSERT_EQ(2, top.size());
+  EXPECT_NEAR(2, top(0), 1e-12);
+  EXPECT_NEAR(2 + r2, top(1), 1e-12);
+
+  EXPECT_EQ(0, eig_sym(a, 1, top, vtop));
+  ASSERT_EQ(3, vtop.n_rows());
+  ASSERT_EQ(1, vtop.n_cols());
+  EXPECT_NEAR(2 + r2, top(0), 1e-12);
+  // (1, -sqrt(2), 1) / 2, up to the sign
+  const double sign = vtop(0, 0) > 0 ? 1 : -1;
+  EXPECT_NEAR(0.5, sign * vtop(0, 0), 1e-12);
+  EXPECT_NEAR(-r2 / 2, sign * vtop(1, 0), 1e-12);
+  EXPECT_NEAR(0.5, sign * vtop(2, 0), 1e-12);
+}
+
+namespace {
+
+void expect_svd(const mat &a, svd_mode mode) {
+  mat u, vt;
+  vec s;
+  ASSERT_EQ(0, svd(a, u, s, vt, mode));
+
+  const std::size_t m = a.n_rows(), n = a.n_cols(), k = std::min(m, n);
+  ASSERT_EQ(k, s.size());
+  ASSERT_EQ(m, u.n_rows());
+  ASSERT_EQ(n, vt.n_cols());
+  for (std::size_t i = 1; i < k; ++i) EXPECT_GE(s(i - 1), s(i));
+
+  // orthonormal columns of U and rows of V'
+  for (std::size_t i = 0; i != u.n_cols(); ++i)
+    for (std::size_t j = 0; j != u.n_cols(); ++j)
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, blas_dot(u.col(i), u.col(j)), 1e-12);
+  for (std::size_t i = 0; i != vt.n_rows(); ++i)
+    for (std::size_t j = 0; j != vt.n_rows(); ++j)
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, blas_dot(vt.row(i), vt.row(j)), 1e-12);
+
+  // A = U S V'
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) {
+      double x = 0;
+      for (std::size_t l = 0; l != k; ++l) x += u(i, l) * s(l) * vt(l, j);
+      EXPECT_NEAR(a(i, j), x, 1e-12);
+    }
+}
+
+} // namespace
+
+TEST(SVDTest, ThinFullValues) {
+  mat tall = {
+      {3, 2, 2},
+      {2, 3, -2},
+      {1, 0, 4},
+      {0, 1, 1}
+  };
+  mat wide = {
+      {3, 2, 2, 1},
+      {2, 3, -2, 0}
+  };
+  expect_svd(tall, svd_mode::thin);
+  expect_svd(tall, svd_mode::full);
+  expect_svd(wide, svd_mode::thin);
+  expect_svd(wide, svd_mode::full);
+
+  // the singular values of {{3, 2, 2}, {2, 3, -2}} are 5 and 3
+  vec s;
+  EXPECT_EQ(0, svd(wide(slice{0, 2}, slice{0, 3}), s));
+  ASSERT_EQ(2, s.size());
+  EXPECT_NEAR(5, s(0), 1e-12);
+  EXPECT_NEAR(3, s(1), 1e-12);
+
+  mat u, vt;
+  EXPECT_EQ(0, svd(wide, u, s, vt, svd_mode::values));
+  EXPECT_EQ(0, u.size());
+  EXPECT_EQ(2, s.size());
+
+  // empty matrices: the full U or V' is the identity, even when reused
+  expect_svd(mat(3, 0), svd_mode::full);
+  expect_svd(mat(0, 2), svd_mode::full);
+  expect_svd(mat(3, 0), svd_mode::thin);
+  u = mat(3, 3);
+  std::fill(u.begin(), u.end(), 7.0);
+  EXPECT_EQ(0, svd(mat(3, 0), u, s, vt, svd_mode::full));
+  EXPECT_EQ(1, u(2, 2));
+  EXPECT_EQ(0, u(2, 1));
+  EXPECT_EQ(0, s.size());
+}
+
+TEST(SVDTest, RankDeficient) {
+  mat a = {
+      {1, 2},
+      {2, 4},
+      {3, 6}
+  };
+  expect_svd(a, svd_mode::full);
+
+  vec s;
+  EXPECT_EQ(0, svd(a, s));
+  EXPECT_NEAR(std::sqrt(70.0), s(0), 1e-12);
+  EXPECT_NEAR(0, s(1), 1e-12);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_EIGEN_H
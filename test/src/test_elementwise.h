@@ -0,0 +1,129 @@
+#ifndef MATRIX_TEST_ELEMENTWISE_H
+#define MATRIX_TEST_ELEMENTWISE_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+// the distance between a and the exact value b, in units of the last place
+inline double ulps(double a, double b) {
+  if (a == b || (a != a && b != b)) return 0;
+  const double ulp = std::nextafter(std::fabs(b),
+                                    std::numeric_limits<double>::infinity()) -
+                     std::fabs(b);
+  return std::fabs(a - b) / ulp;
+}
+
+TEST(ElementwiseTest, KernelsAccuracy) {
+  const std::size_t n = 200000;
+  vec x(n), y(n);
+  RandomStream rng(3);
+  randu(x, rng, -745.0, 709.0);
+  exp(x, y);
+  double worst = 0;
+  for (std::size_t i = 0; i != n; ++i)
+    worst = std::max(worst, ulps(y(i), std::exp(x(i))));
+  EXPECT_LE(worst, 2);
+
+  // log over the whole range of exponents, subnormal numbers included
+  vec l(n);
+  for (std::size_t i = 0; i != n; ++i)
+    x(i) = std::exp((i % 1450) - 744.5 + 0.37 * (i % 7));
+  log(x, l);
+  worst = 0;
+  for (std::size_t i = 0; i != n; ++i)
+    worst = std::max(worst, ulps(l(i), std::log(x(i))));
+  EXPECT_LE(worst, 2);
+
+  randu(x, rng, -25.0, 25.0);
+  x(0) = 1e-300;
+  x(1) = -3e-9;
+  vec t = tanh(x);
+  worst = 0;
+  for (std::size_t i = 0; i != n; ++i)
+    worst = std::max(worst, ulps(t(i), std::tanh(x(i))));
+  EXPECT_LE(worst, 4);
+
+  vec b(n);
+  randu(x, rng, 0.0, 10.0);
+  randu(b, rng, -8.0, 8.0);
+  // the error of pow grows with |b log x|, here up to 18
+  vec p = pow(x, b);
+  for (std::size_t i = 0; i != n; ++i) {
+    const double exact = std::pow(x(i), b(i));
+    ASSERT_NEAR(exact, p(i), 1e-14 * exact);
+  }
+
+  vec s = sqrt(x);
+  for (std::size_t i = 0; i < n; i += 101) EXPECT_EQ(std::sqrt(x(i)), s(i));
+}
+
+TEST(ElementwiseTest, SpecialValues) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  vec x = {0, -0.0, inf, -inf, nan, 1, -1, 710, -746, 4.9e-324};
+  vec e = exp(x), l = log(x), t = tanh(x);
+  // exact where the argument or the result is zero, infinite or NaN, which
+  // covers overflow and underflow, and within 2 ulps on the other finite
+  // values, whose rounding depends on the use of FMA
+  for (std::size_t i = 0; i != x.size(); ++i) {
+    const double res[] = {e(i), t(i), l(i)};
+    const double ref[] = {std::exp(x(i)), std::tanh(x(i)), std::log(x(i))};
+    for (std::size_t k = 0; k != 3; ++k) {
+      if (x(i) == 0 || !std::isfinite(x(i)) || ref[k] == 0 ||
+          !std::isfinite(ref[k]))
+        EXPECT_EQ(0, ulps(res[k], ref[k])) << x(i);
+      else
+        EXPECT_LE(ulps(res[k], ref[k]), 2) << x(i);
+    }
+  }
+  EXPECT_TRUE(std::signbit(tanh(x)(1)));
+
+  vec base = {-2, -2, -2, 0, 0, 1, nan, -0.0, 2, -0.0, -0.0, -0.0,
+              -inf, -inf, -inf, -inf, -1, -1, -0.5, 1, inf};
+  vec expo = {3, 2, 0.5, 2, -1, nan, 0, 3, -1100, 0.5, -0.5, -3,
+              0.5, -0.5, 3, -3, inf, -inf, inf, -inf, nan};
+  vec p = pow(base, expo);
+  for (std::size_t i = 0; i != base.size(); ++i) {
+    const double ref = std::pow(base(i), expo(i));
+    EXPECT_LE(ulps(p(i), ref), 2) << base(i) << "^" << expo(i);
+    // the sign of a NaN result is unspecified
+    EXPECT_TRUE(ref != ref || std::signbit(ref) == std::signbit(p(i)))
+        << base(i) << "^" << expo(i);
+  }
+}
+
+TEST(ElementwiseTest, ShapesAndModes) {
+  mat m = {{0, 1, 2}, {3, 4, 5}};
+  mat e = exp(m, math_mode::high_accuracy);
+  EXPECT_EQ(std::exp(4.0), e(1, 1));
+  mat fast = exp(m, math_mode::enhanced_performance);
+  EXPECT_NEAR(std::exp(5.0), fast(1, 2), 1e-12);
+
+  // in place, on a strided block
+  mat a = m;
+  log(exp(a), a);
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t j = 0; j != 3; ++j) EXPECT_NEAR(m(i, j), a(i, j), 1e-14);
+  MatrixRef<double, 2> cols = a(slice(0, 2), slice(0, 2, 2));
+  pow(cols, 2.0, cols);
+  EXPECT_DOUBLE_EQ(4, a(0, 2));
+  EXPECT_DOUBLE_EQ(25, a(1, 2));
+  EXPECT_DOUBLE_EQ(4, a(1, 1));
+  Matrix<double, 2> r = sqrt(cols);
+  EXPECT_DOUBLE_EQ(5, r(1, 1));
+
+  // single precision
+  Matrix<float, 1> f = {-1.5f, 0.25f, 80.0f, -90.0f};
+  Matrix<float, 1> ef = exp(f), tf = tanh(f);
+  for (std::size_t i = 0; i != f.size(); ++i) {
+    EXPECT_FLOAT_EQ(std::exp(f(i)), ef(i));
+    EXPECT_FLOAT_EQ(std::tanh(f(i)), tf(i));
+  }
+  EXPECT_FLOAT_EQ(8.0f, pow(Matrix<float, 1>({2.0f}), 3.0f)(0));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_ELEMENTWISE_H
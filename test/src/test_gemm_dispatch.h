@@ -0,0 +1,171 @@
+#ifndef MATRIX_TEST_GEMM_DISPATCH_H
+#define MATRIX_TEST_GEMM_DISPATCH_H
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+namespace {
+
+mat naive_matmul(const mat &a, const mat &b) {
+  mat c(a.n_rows(), b.n_cols());
+  for (std::size_t i = 0; i != a.n_rows(); ++i)
+    for (std::size_t j = 0; j != b.n_cols(); ++j)
+      for (std::size_t p = 0; p != a.n_cols(); ++p)
+        c(i, j) += a(i, p) * b(p, j);
+  return c;
+}
+
+mat sequence_matrix(std::size_t m, std::size_t n, double scale) {
+  mat a(m, n);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j)
+      a(i, j) = scale * ((i * n + j) % 7) - 1.0;
+  return a;
+}
+
+} // namespace
+
+TEST(GemmDispatchTest, ProfileRoundTrip) {
+  GemmProfile p;
+  p.threads = 3;
+  p.single_precision = {100, 200, 300};
+  p.double_precision = {400, 500, 600};
+
+  const std::string path = "gemm_profile_test.txt";
+  ASSERT_TRUE(p.save(path));
+
+  GemmProfile q;
+  ASSERT_TRUE(q.load(path));
+  std::remove(path.c_str());
+
+  EXPECT_EQ(3, q.threads);
+  EXPECT_EQ(100, q.thresholds<float>().small_max);
+  EXPECT_EQ(200, q.thresholds<float>().sequential_max);
+  EXPECT_EQ(300, q.thresholds<float>().work_per_thread);
+  EXPECT_EQ(400, q.thresholds<double>().small_max);
+  EXPECT_EQ(500, q.thresholds<double>().sequential_max);
+  EXPECT_EQ(600, q.thresholds<double>().work_per_thread);
+
+  EXPECT_FALSE(q.load("no/such/gemm_profile"));
+}
+
+TEST(GemmDispatchTest, SelectStrategy) {
+  GemmProfile p;
+  p.double_precision = {1000, 100000, 50000};
+
+  GemmDispatcher d;
+  d.set_profile(p);
+  d.set_thread_budget(4);
+
+  int threads = 0;
+  EXPECT_EQ(gemm_strategy::small_kernel, d.select<double>(10, 10, 10, 1, threads));
+  EXPECT_EQ(1, threads);
+  EXPECT_EQ(gemm_strategy::sequential, d.select<double>(40, 40, 40, 1, threads));
+  EXPECT_EQ(1, threads);
+  EXPECT_EQ(gemm_strategy::threaded, d.select<double>(100, 100, 100, 1, threads));
+  EXPECT_EQ(4, threads);
+  EXPECT_EQ(gemm_strategy::threaded, d.select<double>(50, 50, 50, 1, threads));
+  EXPECT_EQ(2, threads);
+  EXPECT_EQ(gemm_strategy::batched, d.select<double>(10, 10, 10, 8, threads));
+  EXPECT_EQ(1, threads);
+
+  d.set_thread_budget(1);
+  EXPECT_EQ(gemm_strategy::sequential, d.select<double>(100, 100, 100, 1, threads));
+  EXPECT_EQ(gemm_strategy::small_kernel, d.select<double>(10, 10, 10, 8, threads));
+}
+
+TEST(GemmDispatchTest, SelectUnderAnotherBudget) {
+  GemmProfile p;
+  p.double_precision = {1000, 100000, 50000};
+  p.threads = 2;
+
+  GemmDispatcher d;
+  d.set_profile(p);
+  d.set_thread_budget(2);
+  int threads = 0;
+  EXPECT_EQ(gemm_strategy::threaded, d.select<double>(100, 100, 100, 1, threads));
+  EXPECT_EQ(2, threads);
+
+  // the tuned crossovers to threaded BLAS are replaced by the defaults, the
+  // single-threaded small_max is kept
+  d.set_thread_budget(4);
+  const GemmThresholds defaults = GemmProfile().thresholds<double>();
+  EXPECT_EQ(gemm_strategy::sequential, d.select<double>(100, 100, 100, 1, threads));
+  EXPECT_EQ(1, threads);
+  EXPECT_EQ(gemm_strategy::sequential, d.select<double>(11, 11, 11, 1, threads));
+  EXPECT_EQ(gemm_strategy::small_kernel, d.select<double>(10, 10, 10, 1, threads));
+  EXPECT_EQ(gemm_strategy::threaded, d.select<double>(200, 200, 200, 1, threads));
+  EXPECT_EQ(std::min(4.0, 8e6 / defaults.work_per_thread), threads);
+  EXPECT_EQ(gemm_strategy::batched, d.select<double>(100, 100, 100, 8, threads));
+}
+
+TEST(GemmDispatchTest, MatmulAcrossStrategies) {
+  GemmDispatcher &d = GemmDispatcher::instance();
+  const GemmProfile saved = d.profile();
+
+  // force each strategy in turn for a 30 x 20 by 20 x 25 product
+  GemmProfile p;
+  const double thresholds[][3] = {
+      {1e9, 1e9, 1e9},  // small kernel
+      {0, 1e9, 1e9},    // sequential BLAS
+      {0, 0, 1000}      // threaded BLAS
+  };
+
+  mat a = sequence_matrix(30, 20, 0.5);
+  mat b = sequence_matrix(20, 25, 0.25);
+  mat expected = naive_matmul(a, b);
+
+  for (const auto &t : thresholds) {
+    p.double_precision = {t[0], t[1], t[2]};
+    d.set_profile(p);
+
+    mat c = matmul(a, b);
+    ASSERT_EQ(30, c.n_rows());
+    ASSERT_EQ(25, c.n_cols());
+    for (std::size_t i = 0; i != c.size(); ++i)
+      EXPECT_NEAR(expected.data()[i], c.data()[i], 1e-12);
+  }
+
+  d.set_profile(saved);
+}
+
+TEST(GemmDispatchTest, MatmulBatch) {
+  std::vector<mat> a, b;
+  for (std::size_t i = 1; i <= 6; ++i) {
+    a.push_back(sequence_matrix(i + 2, i, 1.0));
+    b.push_back(sequence_matrix(i, 2 * i, 0.5));
+  }
+
+  std::vector<mat> c = matmul_batch(a, b);
+  ASSERT_EQ(6, c.size());
+  for (std::size_t i = 0; i != c.size(); ++i) {
+    mat expected = naive_matmul(a[i], b[i]);
+    ASSERT_EQ(expected.n_rows(), c[i].n_rows());
+    ASSERT_EQ(expected.n_cols(), c[i].n_cols());
+    for (std::size_t j = 0; j != expected.size(); ++j)
+      EXPECT_NEAR(expected.data()[j], c[i].data()[j], 1e-12);
+  }
+}
+
+TEST(GemmDispatchTest, Tune) {
+  GemmDispatcher &d = GemmDispatcher::instance();
+  const GemmProfile saved = d.profile();
+
+  GemmProfile p = gemm_tune(std::string(), 16);
+  EXPECT_EQ(d.thread_budget(), p.threads);
+  EXPECT_LE(p.thresholds<double>().small_max,
+            p.thresholds<double>().sequential_max);
+  EXPECT_LE(p.thresholds<float>().small_max,
+            p.thresholds<float>().sequential_max);
+  EXPECT_EQ(p.thresholds<double>().small_max,
+            d.profile().thresholds<double>().small_max);
+
+  d.set_profile(saved);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_GEMM_DISPATCH_H
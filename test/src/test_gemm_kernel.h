@@ -0,0 +1,109 @@
+#ifndef MATRIX_TEST_GEMM_KERNEL_H
+#define MATRIX_TEST_GEMM_KERNEL_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+namespace {
+
+// C = op(A) * op(B) through the reference BLAS call for the same key
+void reference_gemm(const GemmKey &key, const double *a, const double *b,
+                    double *c) {
+  cblas_dgemm(key.layout, key.transa, key.transb, key.m, key.n, key.k, 1.0,
+              a, key.lda, b, key.ldb, 0.0, c, key.ldc);
+}
+
+} // namespace
+
+TEST(GemmKernelTest, MatchesBlas) {
+  // unrolled kernels, then kernels of a compile-time shape
+  const int shapes[][3] = {{16, 16, 64}, {32, 8, 32}, {5, 3, 7}, {1, 9, 2},
+                           {2, 2, 2}, {3, 4, 2}, {4, 3, 3}, {2, 4, 4}};
+  const CBLAS_LAYOUT layouts[] = {CblasRowMajor, CblasColMajor};
+  const CBLAS_TRANSPOSE trans[] = {CblasNoTrans, CblasTrans};
+
+  for (const auto &s : shapes)
+    for (CBLAS_LAYOUT layout : layouts)
+      for (CBLAS_TRANSPOSE ta : trans)
+        for (CBLAS_TRANSPOSE tb : trans) {
+          const int m = s[0], n = s[1], k = s[2];
+          const bool row = (layout == CblasRowMajor);
+          // leading dimensions of the stored (untransposed) arrays, plus padding
+          const int lda = ((row == (ta == CblasNoTrans)) ? k : m) + 1;
+          const int ldb = ((row == (tb == CblasNoTrans)) ? n : k) + 2;
+          const int ldc = (row ? n : m) + 3;
+          const GemmKey key(layout, ta, tb, m, n, k, lda, ldb, ldc);
+
+          std::vector<double> a(std::max(m, k) * lda), b(std::max(k, n) * ldb);
+          for (std::size_t i = 0; i != a.size(); ++i) a[i] = double(i % 11) - 5;
+          for (std::size_t i = 0; i != b.size(); ++i) b[i] = double(i % 5) * 0.5;
+
+          std::vector<double> c(std::max(m, n) * ldc, -1), expected(c);
+          gemm_kernel<double>(key)(a.data(), b.data(), c.data());
+          reference_gemm(key, a.data(), b.data(), expected.data());
+
+          for (std::size_t i = 0; i != c.size(); ++i)
+            ASSERT_NEAR(expected[i], c[i], 1e-12);
+        }
+}
+
+TEST(GemmKernelTest, CachedPerKey) {
+  const GemmKernel<float> *k1 = &gemm_kernel<float>(GemmKey(16, 16, 64));
+  const GemmKernel<float> *k2 = &gemm_kernel<float>(GemmKey(32, 8, 32));
+  const std::size_t size = GemmKernelCache<float>::instance().size();
+
+  EXPECT_EQ(k1, &gemm_kernel<float>(GemmKey(16, 16, 64)));
+  EXPECT_EQ(k2, &gemm_kernel<float>(GemmKey(32, 8, 32)));
+  EXPECT_NE(k1, k2);
+  EXPECT_EQ(GemmKey(16, 16, 64), k1->key());
+
+  // more shapes than the per-thread front cache holds
+  for (int n = 1; n <= 8; ++n) gemm_kernel<float>(GemmKey(3, n, 29));
+  EXPECT_EQ(k1, &gemm_kernel<float>(GemmKey(16, 16, 64)));
+  EXPECT_EQ(size + 8, GemmKernelCache<float>::instance().size());
+
+  // the same kernel is shared by all threads
+  const int nthreads = 8;
+  std::vector<const GemmKernel<float> *> seen(nthreads);
+#pragma omp parallel for num_threads(nthreads)
+  for (int i = 0; i < nthreads; ++i)
+    seen[i] = &gemm_kernel<float>(GemmKey(7, 7, 7));
+  for (int i = 1; i < nthreads; ++i) EXPECT_EQ(seen[0], seen[i]);
+}
+
+TEST(GemmKernelTest, LeastRecentlyUsedEvicted) {
+  GemmKernelCache<double> &cache = GemmKernelCache<double>::instance();
+  const std::size_t capacity = cache.capacity();
+  EXPECT_EQ(GemmKernelCache<double>::default_capacity, capacity);
+  cache.set_capacity(4);
+  EXPECT_LE(cache.size(), 4);
+
+  // a kernel dropped by the cache stays valid while it is held
+  auto k1 = cache.get(GemmKey(2, 3, 101));
+  for (int n = 1; n <= 6; ++n) gemm_kernel<double>(GemmKey(2, n, 102));
+  EXPECT_EQ(4, cache.size());
+  auto again = cache.get(GemmKey(2, 3, 101));
+  EXPECT_NE(k1, again);
+  EXPECT_EQ(k1->key(), again->key());
+  std::vector<double> a(2 * 101, 1.0), b(101 * 3, 2.0), c(2 * 3);
+  (*k1)(a.data(), b.data(), c.data());
+  EXPECT_EQ(202, c[5]);
+
+  // a lookup makes a kernel the most recently used
+  auto k2 = cache.get(GemmKey(2, 1, 103));
+  cache.get(GemmKey(2, 2, 103));
+  cache.get(GemmKey(2, 3, 103));
+  EXPECT_EQ(k2, cache.get(GemmKey(2, 1, 103)));
+  cache.get(GemmKey(2, 4, 103));
+  cache.get(GemmKey(2, 5, 103));
+  EXPECT_EQ(k2, cache.get(GemmKey(2, 1, 103)));
+  EXPECT_EQ(4, cache.size());
+
+  cache.set_capacity(capacity);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_GEMM_KERNEL_H
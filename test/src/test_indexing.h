@@ -0,0 +1,103 @@
+#ifndef MATRIX_TEST_INDEXING_H
+#define MATRIX_TEST_INDEXING_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(IndexingTest, TakeAlongAxes) {
+  mat m = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}};
+  uvec rows = {3, 0, 3};
+  mat r = take(m, rows);
+  ASSERT_EQ(3, r.n_rows());
+  ASSERT_EQ(3, r.n_cols());
+  EXPECT_EQ(10, r(0, 0));
+  EXPECT_EQ(3, r(1, 2));
+  EXPECT_EQ(12, r(2, 2));
+
+  ivec cols = {2, 1};
+  mat c = take(m, cols, 1);
+  ASSERT_EQ(4, c.n_rows());
+  ASSERT_EQ(2, c.n_cols());
+  EXPECT_EQ(3, c(0, 0));
+  EXPECT_EQ(11, c(3, 1));
+
+  // a strided view, and an empty index vector
+  MatrixRef<double, 2> v = m(slice(0, 2, 2), slice(1, 2));
+  ivec one = {1};
+  mat t = take(v, one);
+  ASSERT_EQ(1, t.n_rows());
+  EXPECT_EQ(8, t(0, 0));
+  EXPECT_EQ(9, t(0, 1));
+  EXPECT_EQ(0, take(m, ivec(0)).n_rows());
+
+  vec x = {5, 6, 7};
+  vec y = take(x, ivec{2, 2, 0});
+  EXPECT_EQ(7, y(0));
+  EXPECT_EQ(5, y(2));
+
+  Matrix<int, 3> a(2, 3, 4);
+  std::iota(a.begin(), a.end(), 0);
+  Matrix<int, 3> b = take(a, ivec{2, 0}, 1);
+  ASSERT_EQ(2, b.extent(1));
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t j = 0; j != 4; ++j) {
+      EXPECT_EQ(a(i, 2, j), b(i, 0, j));
+      EXPECT_EQ(a(i, 0, j), b(i, 1, j));
+    }
+}
+
+TEST(IndexingTest, PutAndScatterAdd) {
+  mat m(4, 3);
+  std::fill(m.begin(), m.end(), 0.0);
+  mat v = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  uvec rows = {2, 0, 2};
+  put(m, rows, v);
+  EXPECT_EQ(4, m(0, 0));
+  EXPECT_EQ(0, m(1, 1));
+  EXPECT_EQ(9, m(2, 2));  // the last of a repeated index
+
+  std::fill(m.begin(), m.end(), 0.0);
+  scatter_add(m, rows, v);
+  EXPECT_EQ(4, m(0, 0));
+  EXPECT_EQ(8, m(2, 0));
+  EXPECT_EQ(12, m(2, 2));
+
+  // columns of a view
+  mat w = {{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+  scatter_add(m(slice(0, 4), slice(1, 2)), ivec{1, 1}, w, 1);
+  EXPECT_EQ(8, m(0, 2));
+  EXPECT_EQ(18, m(2, 2));
+  EXPECT_EQ(10, m(2, 1));
+  put(m.row(3), ivec{0}, vec{-1});
+  EXPECT_EQ(-1, m(3, 0));
+}
+
+TEST(IndexingTest, LargeMiniBatch) {
+  const std::size_t n = 2000, p = 64, b = 1500;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j) x(i, j) = i * 1000.0 + j;
+  Matrix<std::size_t, 1> idx(b);
+  for (std::size_t k = 0; k != b; ++k) idx(k) = (k * 7919) % n;
+  mat batch = take(x, idx);
+  for (std::size_t k = 0; k != b; ++k)
+    for (std::size_t j = 0; j != p; ++j)
+      ASSERT_EQ(x(idx(k), j), batch(k, j));
+
+  // every row gathered with multiplicity; scatter back the counts
+  mat counts(n, p);
+  std::fill(counts.begin(), counts.end(), 0.0);
+  mat ones(b, p);
+  std::fill(ones.begin(), ones.end(), 1.0);
+  for (std::size_t k = 0; k != b; ++k) idx(k) = k % 100;
+  scatter_add(counts, idx, ones);
+  EXPECT_EQ(15, counts(0, 0));
+  EXPECT_EQ(15, counts(99, p - 1));
+  EXPECT_EQ(0, counts(100, 0));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_INDEXING_H
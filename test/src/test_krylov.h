@@ -0,0 +1,149 @@
+#ifndef MATRIX_TEST_KRYLOV_H
+#define MATRIX_TEST_KRYLOV_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+// the 5-point Laplacian on a g x g grid, plus c times the centered first
+// difference in x, which makes it nonsymmetric
+inline SparseMatrix<double> laplacian_2d(std::size_t g, double c = 0) {
+  const std::size_t n = g * g;
+  SparseBuilder<double> builder(n, n);
+  for (std::size_t i = 0; i != g; ++i)
+    for (std::size_t j = 0; j != g; ++j) {
+      const std::size_t k = i * g + j;
+      builder.add(k, k, 4);
+      if (i > 0) builder.add(k, k - g, -1);
+      if (i + 1 < g) builder.add(k, k + g, -1);
+      if (j > 0) builder.add(k, k - 1, -1 - c);
+      if (j + 1 < g) builder.add(k, k + 1, -1 + c);
+    }
+  return builder.build();
+}
+
+inline double relative_residual(const SparseMatrix<double> &a, const vec &b,
+                                const vec &x) {
+  vec r = matmul(a, x);
+  blas_axpy(-1.0, b, r);
+  return blas_nrm2(r) / blas_nrm2(b);
+}
+
+TEST(KrylovTest, ConjugateGradientsWithPreconditioners) {
+  const SparseMatrix<double> a = laplacian_2d(40);
+  vec b(a.n_rows());
+  for (std::size_t i = 0; i != b.size(); ++i) b(i) = std::sin(0.01 * i) + 1;
+
+  KrylovOptions opts;
+  opts.tol = 1e-10;
+  vec x;
+  KrylovResult plain = cg(a, b, x, opts);
+  EXPECT_EQ(0, plain.info);
+  EXPECT_LE(plain.residual, 1e-10);
+  EXPECT_LT(relative_residual(a, b, x), 1e-9);
+
+  vec xj;
+  KrylovResult jacobi = cg(a, b, xj, JacobiPreconditioner<double>(a), opts);
+  EXPECT_EQ(0, jacobi.info);
+  EXPECT_LT(relative_residual(a, b, xj), 1e-9);
+
+  IncompleteCholesky<double> ic(a);
+  ASSERT_EQ(0, ic.info());
+  EXPECT_EQ((a.nnz() + a.n_rows()) / 2, ic.lower().nnz());
+  vec xi;
+  KrylovResult ichol = cg(a, b, xi, ic, opts);
+  EXPECT_EQ(0, ichol.info);
+  EXPECT_LT(relative_residual(a, b, xi), 1e-9);
+  EXPECT_LT(ichol.iterations, plain.iterations * 2 / 3);
+
+  // a starting point at the solution converges at once
+  KrylovResult again = cg(a, b, xi, ic, opts);
+  EXPECT_EQ(0, again.iterations);
+
+  // not enough iterations
+  opts.max_iter = 5;
+  vec x5;
+  EXPECT_EQ(1, cg(a, b, x5, opts).info);
+
+  // a zero pivot in the incomplete factorization
+  SparseMatrix<double> indefinite(mat({{1, 2}, {2, 1}}));
+  EXPECT_EQ(2, IncompleteCholesky<double>(indefinite).info());
+}
+
+TEST(KrylovTest, DenseBandAndMatrixFreeOperators) {
+  mat a = {{4, 1, 0, 0}, {1, 5, 2, 0}, {0, 2, 6, 1}, {0, 0, 1, 3}};
+  vec b = {1, 2, 3, 4};
+  vec expected = solve(a, b);
+
+  vec x;
+  EXPECT_EQ(0, cg(a, b, x).info);
+  for (std::size_t i = 0; i != 4; ++i) EXPECT_NEAR(expected(i), x(i), 1e-10);
+
+  // the leading 2 x 2 block of a larger matrix
+  mat big = {{4, 1, 9}, {1, 3, 9}, {9, 9, 9}};
+  vec b2 = {1, 2};
+  vec x2;
+  EXPECT_EQ(0, cg(big(slice(0, 2), slice(0, 2)), b2, x2).info);
+  EXPECT_NEAR(1.0 / 11, x2(0), 1e-12);
+  EXPECT_NEAR(7.0 / 11, x2(1), 1e-12);
+
+  BandMatrix<double> band(a, 1, 1);
+  vec xb;
+  EXPECT_EQ(0, gmres(band, b, xb).info);
+  for (std::size_t i = 0; i != 4; ++i) EXPECT_NEAR(expected(i), xb(i), 1e-8);
+
+  // a matrix-free tridiagonal operator of order 200000
+  const std::size_t n = 200000;
+  auto op = [n](const vec &v, vec &y) {
+    for (std::size_t i = 0; i != n; ++i) {
+      double s = 3 * v(i);
+      if (i > 0) s -= v(i - 1);
+      if (i + 1 < n) s -= v(i + 1);
+      y(i) = s;
+    }
+  };
+  vec ones(n), rhs(n), xf;
+  std::fill(ones.begin(), ones.end(), 1.0);
+  op(ones, rhs);
+  KrylovResult free = cg(op, rhs, xf);
+  EXPECT_EQ(0, free.info);
+  for (std::size_t i = 0; i < n; i += 997) ASSERT_NEAR(1.0, xf(i), 1e-6);
+}
+
+TEST(KrylovTest, NonsymmetricSolvers) {
+  const SparseMatrix<double> a = laplacian_2d(30, 0.4);
+  vec b(a.n_rows());
+  for (std::size_t i = 0; i != b.size(); ++i) b(i) = (i % 3) - 1.0;
+
+  KrylovOptions opts;
+  opts.tol = 1e-10;
+  vec x;
+  KrylovResult bicg = bicgstab(a, b, x, opts);
+  EXPECT_EQ(0, bicg.info);
+  EXPECT_LT(relative_residual(a, b, x), 1e-9);
+
+  vec xp;
+  EXPECT_EQ(0, bicgstab(a, b, xp, JacobiPreconditioner<double>(a), opts).info);
+  EXPECT_LT(relative_residual(a, b, xp), 1e-9);
+
+  opts.restart = 40;
+  vec xg;
+  KrylovResult gm = gmres(a, b, xg, opts);
+  EXPECT_EQ(0, gm.info);
+  EXPECT_GT(gm.iterations, 40);  // at least one restart
+  EXPECT_LT(relative_residual(a, b, xg), 1e-9);
+
+  vec xgp;
+  EXPECT_EQ(0, gmres(a, b, xgp, JacobiPreconditioner<double>(a), opts).info);
+  EXPECT_LT(relative_residual(a, b, xgp), 1e-9);
+
+  vec zero(a.n_rows()), x0 = b;
+  KrylovResult trivial = gmres(a, zero, x0);
+  EXPECT_EQ(0, trivial.iterations);
+  EXPECT_EQ(0, blas_nrm2(x0));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_KRYLOV_H
@@ -0,0 +1,440 @@
+#ifndef MATRIX_TEST_LAPACK_H
+#define MATRIX_TEST_LAPACK_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(LAPACKTest, GETRS) {
+  mat a = {
+      {2, 1, -1},
+      {-3, -1, 2},
+      {-2, 1, 2}
+  };
+  vec b = {8, -11, -3};
+  ivec ipiv;
+
+  EXPECT_EQ(0, lapack_getrf(a, ipiv));
+  EXPECT_EQ(0, lapack_getrs(a, ipiv, b));
+
+  EXPECT_NEAR(2, b(0), 1e-12);
+  EXPECT_NEAR(3, b(1), 1e-12);
+  EXPECT_NEAR(-1, b(2), 1e-12);
+}
+
+TEST(LinearSolveTest, SolveLU) {
+  mat a = {
+      {2, 1, -1},
+      {-3, -1, 2},
+      {-2, 1, 2}
+  };
+  mat b = {
+      {8, 1},
+      {-11, 0},
+      {-3, 4}
+  };
+  mat x;
+
+  EXPECT_EQ(0, solve(a, b, x));
+
+  EXPECT_NEAR(2, x(0, 0), 1e-12);
+  EXPECT_NEAR(3, x(1, 0), 1e-12);
+  EXPECT_NEAR(-1, x(2, 0), 1e-12);
+  EXPECT_NEAR(0, x(0, 1), 1e-12);
+  EXPECT_NEAR(2, x(1, 1), 1e-12);
+  EXPECT_NEAR(1, x(2, 1), 1e-12);
+}
+
+TEST(LinearSolveTest, SolveSingular) {
+  mat a = {
+      {1, 2},
+      {2, 4}
+  };
+  vec b = {1, 1};
+  vec x;
+
+  EXPECT_GT(solve(a, b, x), 0);
+  EXPECT_EQ(0, solve(a, b).size());
+}
+
+TEST(LinearSolveTest, SolveMixedPrecision) {
+  const std::size_t n = 50;
+  mat a(n, n);
+  vec x0(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    x0(i) = 1.0 + 1.0 / (i + 1);
+    for (std::size_t j = 0; j != n; ++j)
+      a(i, j) = 1.0 / (i + j + 1) + (i == j ? 1.0 : 0.0);
+  }
+  vec b = matmul(a, x0);
+
+  vec x;
+  int iter = 0;
+  EXPECT_EQ(0, solve_mixed(a, b, x, iter));
+  EXPECT_GE(iter, 0);
+  for (std::size_t i = 0; i != n; ++i)
+    EXPECT_NEAR(x0(i), x(i), 1e-13);
+
+  vec y = solve(a, b, solve_method::mixed_precision);
+  for (std::size_t i = 0; i != n; ++i)
+    EXPECT_NEAR(x0(i), y(i), 1e-13);
+
+  // a zero right-hand side next to the other one: its solution is zero
+  mat bz(n, 2), xz;
+  for (std::size_t i = 0; i != n; ++i) {
+    bz(i, 0) = 0.0;
+    bz(i, 1) = b(i);
+  }
+  EXPECT_EQ(0, solve_mixed(a, bz, xz, iter));
+  EXPECT_GE(iter, 0);
+  for (std::size_t i = 0; i != n; ++i) {
+    EXPECT_EQ(0, xz(i, 0));
+    EXPECT_NEAR(x0(i), xz(i, 1), 1e-13);
+  }
+
+  // empty systems and no right-hand side
+  iter = -1;
+  vec e;
+  EXPECT_EQ(0, solve_mixed(mat(0, 0), vec(), e, iter));
+  EXPECT_EQ(0, iter);
+  EXPECT_EQ(0, e.size());
+  EXPECT_EQ(0, solve_mixed(mat(0, 0), mat(0, 3), xz, iter));
+  EXPECT_EQ(0, xz.n_rows());
+  EXPECT_EQ(3, xz.n_cols());
+  EXPECT_EQ(0, solve_mixed(a, mat(n, 0), xz, iter));
+  EXPECT_EQ(n, xz.n_rows());
+  EXPECT_EQ(0, xz.n_cols());
+}
+
+TEST(LinearSolveTest, SolveMixedPrecisionFallback) {
+  // the Hilbert matrix is far too ill-conditioned for a single precision LU
+  const std::size_t n = 10;
+  mat a(n, n);
+  vec x0(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    x0(i) = 1.0;
+    for (std::size_t j = 0; j != n; ++j)
+      a(i, j) = 1.0 / (i + j + 1);
+  }
+  mat b(n, 1);
+  vec ax = matmul(a, x0);
+  for (std::size_t i = 0; i != n; ++i) b(i, 0) = ax(i);
+
+  mat x;
+  int iter = 0;
+  EXPECT_EQ(0, solve_mixed(a, b, x, iter));
+  EXPECT_LT(iter, 0);
+  for (std::size_t i = 0; i != n; ++i)
+    EXPECT_NEAR(1.0, x(i, 0), 1e-3);
+}
+
+TEST(LUTest, SolveReusesFactors) {
+  mat a = {
+      {2, 1, -1},
+      {-3, -1, 2},
+      {-2, 1, 2}
+  };
+  LU<double> lu(a);
+  ASSERT_TRUE(lu.ok());
+
+  vec x;
+  EXPECT_EQ(0, lu.solve(vec{8, -11, -3}, x));
+  EXPECT_NEAR(2, x(0), 1e-12);
+  EXPECT_NEAR(3, x(1), 1e-12);
+  EXPECT_NEAR(-1, x(2), 1e-12);
+
+  // a second right-hand side, solved into the same storage
+  const double *p = x.data();
+  EXPECT_EQ(0, lu.solve(vec{1, 0, 4}, x));
+  EXPECT_EQ(p, x.data());
+  EXPECT_NEAR(0, x(0), 1e-12);
+  EXPECT_NEAR(2, x(1), 1e-12);
+  EXPECT_NEAR(1, x(2), 1e-12);
+
+  // A' x = b
+  vec y = lu.solve(vec{8, -11, -3}, blas_trans::trans);
+  vec r = matmul(transpose(a), y);
+  EXPECT_NEAR(8, r(0), 1e-12);
+  EXPECT_NEAR(-11, r(1), 1e-12);
+  EXPECT_NEAR(-3, r(2), 1e-12);
+
+  mat b = {
+      {8, 1},
+      {-11, 0},
+      {-3, 4}
+  };
+  mat xb = lu.solve(b);
+  EXPECT_NEAR(2, xb(0, 0), 1e-12);
+  EXPECT_NEAR(1, xb(2, 1), 1e-12);
+}
+
+TEST(LUTest, DetInverseRcond) {
+  mat a = {
+      {4, 3, 0},
+      {6, 3, 1},
+      {0, 2, 5}
+  };
+  LU<double> lu(a);
+
+  // 4 (15 - 2) - 3 (30 - 0)
+  EXPECT_NEAR(-38, lu.det(), 1e-12);
+
+  mat inv = lu.inverse();
+  mat id = matmul(a, inv);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, id(i, j), 1e-12);
+
+  // 1 / (||A|| ||inv(A)||), the estimate is exact for such a small matrix
+  double inv1 = 0, inv_inf = 0;
+  for (std::size_t j = 0; j != 3; ++j) {
+    double col = 0, row = 0;
+    for (std::size_t i = 0; i != 3; ++i) {
+      col += std::abs(inv(i, j));
+      row += std::abs(inv(j, i));
+    }
+    inv1 = std::max(inv1, col);
+    inv_inf = std::max(inv_inf, row);
+  }
+  EXPECT_NEAR(1 / (10 * inv1), lu.rcond(), 1e-12);
+  EXPECT_NEAR(1 / (10 * inv_inf), lu.rcond(lapack_norm::inf), 1e-12);
+}
+
+TEST(LUTest, Singular) {
+  mat a = {
+      {1, 2},
+      {2, 4}
+  };
+  LU<double> lu(a);
+
+  EXPECT_FALSE(lu.ok());
+  EXPECT_EQ(2, lu.info());
+  EXPECT_EQ(0, lu.det());
+  EXPECT_EQ(0, lu.rcond());
+  EXPECT_EQ(0, lu.inverse().size());
+  EXPECT_EQ(0, lu.solve(vec{1, 1}).size());
+
+  // refactoring reuses the pivots
+  const int *p = lu.pivots().data();
+  EXPECT_EQ(0, lu.factor(mat{{1, 2}, {3, 4}}));
+  EXPECT_EQ(p, lu.pivots().data());
+  EXPECT_NEAR(-2, lu.det(), 1e-12);
+}
+
+TEST(CholeskyTest, SolveDetInverse) {
+  mat a = {
+      {4, 2, -2},
+      {2, 10, 2},
+      {-2, 2, 6}
+  };
+  Cholesky<double> chol(a);
+  ASSERT_TRUE(chol.ok());
+
+  // L = {{2, 0, 0}, {1, 3, 0}, {-1, 1, 2}}
+  const mat &l = chol.lower();
+  EXPECT_NEAR(2, l(0, 0), 1e-12);
+  EXPECT_NEAR(1, l(1, 0), 1e-12);
+  EXPECT_NEAR(3, l(1, 1), 1e-12);
+  EXPECT_NEAR(-1, l(2, 0), 1e-12);
+  EXPECT_NEAR(1, l(2, 1), 1e-12);
+  EXPECT_NEAR(2, l(2, 2), 1e-12);
+  EXPECT_EQ(0, l(0, 2));
+
+  EXPECT_NEAR(144, chol.det(), 1e-10);
+  EXPECT_NEAR(std::log(144.0), chol.log_det(), 1e-12);
+
+  mat x0 = {
+      {1, 0},
+      {-1, 2},
+      {2, 1}
+  };
+  mat b = matmul(a, x0);
+  mat x;
+  EXPECT_EQ(0, chol.solve(b, x));
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 2; ++j)
+      EXPECT_NEAR(x0(i, j), x(i, j), 1e-12);
+
+  vec y = solve(a, vec{4, -4, 0}, solve_method::cholesky);
+  EXPECT_NEAR(2, y(0), 1e-12);
+  EXPECT_NEAR(-1, y(1), 1e-12);
+  EXPECT_NEAR(1, y(2), 1e-12);
+
+  mat inv = chol.inverse();
+  mat id = matmul(a, inv);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j) {
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, id(i, j), 1e-12);
+      EXPECT_EQ(inv(i, j), inv(j, i));
+    }
+}
+
+TEST(CholeskyTest, NotPositiveDefinite) {
+  mat a = {
+      {1, 2},
+      {2, 1}
+  };
+  Cholesky<double> chol(a);
+
+  EXPECT_FALSE(chol.ok());
+  EXPECT_EQ(2, chol.info());
+  EXPECT_EQ(0, chol.det());
+  EXPECT_EQ(0, chol.inverse().size());
+
+  vec x;
+  EXPECT_EQ(2, chol.solve(vec{1, 1}, x));
+  EXPECT_EQ(2, solve(a, vec{1, 1}, x, solve_method::cholesky));
+}
+
+TEST(QRTest, FactorsAndImplicitQ) {
+  mat a = {
+      {12, -51, 4},
+      {6, 167, -68},
+      {-4, 24, -41},
+      {1, 2, 3}
+  };
+  QR<double> qr(a);
+  ASSERT_EQ(0, qr.info());
+
+  mat q = qr.q();
+  mat r = qr.r();
+  ASSERT_EQ(4, q.n_rows());
+  ASSERT_EQ(3, q.n_cols());
+  ASSERT_EQ(3, r.n_rows());
+  EXPECT_EQ(0, r(2, 0));
+
+  mat qr_prod = matmul(q, r);
+  for (std::size_t i = 0; i != 4; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      EXPECT_NEAR(a(i, j), qr_prod(i, j), 1e-10);
+
+  // Q' Q = I
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      EXPECT_NEAR(i == j ? 1.0 : 0.0, blas_dot(q.col(i), q.col(j)), 1e-12);
+
+  // Q' A = [R; 0] without forming Q
+  mat c = a;
+  EXPECT_EQ(0, qr.apply_q(c, blas_trans::trans));
+  for (std::size_t j = 0; j != 3; ++j) {
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(r(i, j), c(i, j), 1e-10);
+    EXPECT_NEAR(0, c(3, j), 1e-10);
+  }
+  EXPECT_EQ(0, qr.apply_q(c));
+  for (std::size_t i = 0; i != 4; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      EXPECT_NEAR(a(i, j), c(i, j), 1e-10);
+}
+
+TEST(QRTest, LeastSquares) {
+  // y = 1 + 2 t, fitted at t = 0..4 with the residuals (1, -1, 0, 1, -1) / 10
+  mat a(5, 2);
+  vec y(5);
+  const double noise[] = {0.1, -0.1, 0, 0.1, -0.1};
+  for (std::size_t t = 0; t != 5; ++t) {
+    a(t, 0) = 1;
+    a(t, 1) = t;
+    y(t) = 1 + 2 * t + noise[t];
+  }
+  // the normal equations give the exact fit: intercept 1.04, slope 1.98
+  QR<double> qr(a);
+  vec x = qr.solve(y);
+  EXPECT_NEAR(1.04, x(0), 1e-12);
+  EXPECT_NEAR(1.98, x(1), 1e-12);
+
+  vec x_qr = lstsq(a, y);
+  vec x_svd = lstsq(a, y, lstsq_method::svd);
+  for (std::size_t i = 0; i != 2; ++i) {
+    EXPECT_NEAR(x(i), x_qr(i), 1e-12);
+    EXPECT_NEAR(x(i), x_svd(i), 1e-12);
+  }
+
+  // two right-hand sides, and the design matrix as a block of a larger one
+  mat big(7, 4);
+  big(slice{1, 5}, slice{1, 2}) = a;
+  mat b(5, 2);
+  for (std::size_t t = 0; t != 5; ++t) {
+    b(t, 0) = y(t);
+    b(t, 1) = 3.0 - t;
+  }
+  mat xb;
+  EXPECT_EQ(0, lstsq(big(slice{1, 5}, slice{1, 2}), b, xb));
+  EXPECT_NEAR(1.04, xb(0, 0), 1e-12);
+  EXPECT_NEAR(1.98, xb(1, 0), 1e-12);
+  EXPECT_NEAR(3, xb(0, 1), 1e-12);
+  EXPECT_NEAR(-1, xb(1, 1), 1e-12);
+
+  QR<double> qr_block(big(slice{1, 5}, slice{1, 2}));
+  vec xr = qr_block.solve(y);
+  EXPECT_NEAR(1.04, xr(0), 1e-12);
+
+  // right-hand sides that are views: a column and a block of columns
+  for (std::size_t t = 0; t != 5; ++t) {
+    big(t + 1, 0) = b(t, 1);
+    big(t + 1, 3) = b(t, 0);
+  }
+  vec xc = lstsq(a, b.col(1));
+  EXPECT_NEAR(3, xc(0), 1e-12);
+  EXPECT_NEAR(-1, xc(1), 1e-12);
+  EXPECT_EQ(0, lstsq(a, big.col(3)(slice{1, 5}), xc, lstsq_method::svd));
+  EXPECT_NEAR(1.98, xc(1), 1e-12);
+  mat xv = qr.solve(big(slice{1, 5}, slice{0, 2, 3}));
+  ASSERT_EQ(2, xv.n_cols());
+  EXPECT_NEAR(3, xv(0, 0), 1e-12);
+  EXPECT_NEAR(1.98, xv(1, 1), 1e-12);
+  EXPECT_EQ(0, qr.solve(b.col(0), xc));
+  EXPECT_NEAR(1.04, xc(0), 1e-12);
+}
+
+TEST(QRTest, MinimumNormAndRankDeficient) {
+  // x1 + x2 = 2: the minimum norm solution is (1, 1)
+  mat wide = {{1, 1}};
+  vec x = lstsq(wide, vec{2});
+  ASSERT_EQ(2, x.size());
+  EXPECT_NEAR(1, x(0), 1e-12);
+  EXPECT_NEAR(1, x(1), 1e-12);
+
+  // the second column is twice the first
+  mat a = {
+      {1, 2},
+      {1, 2},
+      {1, 2}
+  };
+  vec b = {5, 5, 5};
+  vec y;
+  int rank = 0;
+  EXPECT_EQ(0, lstsq(a, b, y, lstsq_method::svd, &rank));
+  EXPECT_EQ(1, rank);
+  EXPECT_NEAR(1, y(0), 1e-12);
+  EXPECT_NEAR(2, y(1), 1e-12);
+
+  // an exactly singular R
+  mat z = {
+      {1, 0},
+      {1, 0},
+      {1, 0}
+  };
+  EXPECT_EQ(2, lstsq(z, b, y));
+  EXPECT_EQ(0, lstsq(z, b).size());
+
+  // no equations: the minimum norm solution is 0, by either method
+  mat none(0, 3);
+  for (lstsq_method method : {lstsq_method::qr, lstsq_method::svd}) {
+    y = vec{7, 7};
+    rank = -1;
+    EXPECT_EQ(0, lstsq(none, vec(0), y, method, &rank));
+    EXPECT_EQ(0, rank);
+    ASSERT_EQ(3, y.size());
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_EQ(0, y(i));
+    mat xm;
+    EXPECT_EQ(0, lstsq(none, mat(0, 2), xm, method));
+    ASSERT_EQ(3, xm.n_rows());
+    ASSERT_EQ(2, xm.n_cols());
+    EXPECT_EQ(6, std::count(xm.begin(), xm.end(), 0.0));
+  }
+}
+
+}
+
+#endif //MATRIX_TEST_LAPACK_H
@@ -0,0 +1,128 @@
+#ifndef MATRIX_TEST_MASK_H
+#define MATRIX_TEST_MASK_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(MaskTest, Comparisons) {
+  mat m = {{1, -2, 3}, {-4, 5, 0}};
+  Mask<2> neg = m < 0.0;
+  EXPECT_EQ(6, neg.size());
+  EXPECT_FALSE(neg(0, 0));
+  EXPECT_TRUE(neg(0, 1));
+  EXPECT_TRUE(neg(1, 0));
+  EXPECT_EQ(2, neg.count());
+  EXPECT_EQ(3, (m > 0.0).count());
+  EXPECT_EQ(4, (m >= 0.0).count());
+  EXPECT_EQ(1, (m == 0.0).count());
+  EXPECT_EQ(5, (0.0 != m).count());
+  EXPECT_EQ(3, (1.0 <= m).count());
+
+  // masks combine, and the bits past the elements stay clear
+  EXPECT_EQ(6, (neg | (m >= 0.0)).count());
+  EXPECT_TRUE((neg | (m >= 0.0)).all());
+  EXPECT_FALSE((neg & (m > 0.0)).any());
+  EXPECT_EQ(4, (~neg).count());
+  EXPECT_EQ(3, (neg ^ (m != 0.0)).count());
+
+  // matrices of the same extents, and a strided view
+  mat z = {{0, 0, 3}, {0, 5, 1}};
+  EXPECT_EQ(2, (m == z).count());
+  EXPECT_EQ(3, (m < z).count());
+  Mask<1> c = m.col(1) > 0.0;
+  ASSERT_EQ(2, c.size());
+  EXPECT_FALSE(c(0));
+  EXPECT_TRUE(c(1));
+
+  // more than a word, in a column view
+  Matrix<int, 2> big(100, 3);
+  std::iota(big.begin(), big.end(), 0);
+  Mask<1> odd = big.col(1) > 150;
+  EXPECT_EQ(50, odd.count());
+  EXPECT_TRUE(odd(50));
+  EXPECT_FALSE(odd(49));
+}
+
+TEST(MaskTest, AssignSelectWhere) {
+  mat x = {{1, -2, 3}, {-4, 5, -6}};
+  masked_assign(x, x < 0.0, 0.0);
+  EXPECT_EQ(0, x(0, 1));
+  EXPECT_EQ(0, x(1, 2));
+  EXPECT_EQ(5, x(1, 1));
+
+  mat y = {{10, 20, 30}, {40, 50, 60}};
+  masked_assign(x, x == 0.0, y);
+  EXPECT_EQ(20, x(0, 1));
+  EXPECT_EQ(60, x(1, 2));
+  EXPECT_EQ(1, x(0, 0));
+
+  // into a column of a matrix
+  masked_assign(y.col(0), y.col(0) > 15.0, -1.0);
+  EXPECT_EQ(10, y(0, 0));
+  EXPECT_EQ(-1, y(1, 0));
+  EXPECT_EQ(50, y(1, 1));
+
+  vec s = select(x, x > 10.0);
+  ASSERT_EQ(3, s.size());
+  EXPECT_EQ(20, s(0));
+  EXPECT_EQ(60, s(2));
+  EXPECT_EQ(0, select(x, x > 100.0).size());
+
+  mat w = where(x > 10.0, x, y);
+  EXPECT_EQ(10, w(0, 0));
+  EXPECT_EQ(20, w(0, 1));
+  mat v = where(x > 10.0, x, 0.0);
+  EXPECT_EQ(0, v(0, 0));
+  EXPECT_EQ(60, v(1, 2));
+  mat u = where(x > 10.0, 1.0, x);
+  EXPECT_EQ(1, u(1, 2));
+  EXPECT_EQ(3, u(0, 2));
+
+  // the rows where a column exceeds a threshold
+  mat m = {{1, 0.5}, {2, 0.1}, {3, 0.9}};
+  mat r = select(m, m.col(1) > 0.4, 0);
+  ASSERT_EQ(2, r.n_rows());
+  EXPECT_EQ(1, r(0, 0));
+  EXPECT_EQ(3, r(1, 0));
+  mat c = select(m, vec{1, 0} > 0.5, 1);
+  ASSERT_EQ(1, c.n_cols());
+  EXPECT_EQ(2, c(1, 0));
+}
+
+TEST(MaskTest, LargeCleaningPass) {
+  const std::size_t n = 300, p = 257;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j) x(i, j) = std::sin(0.37 * (i * p + j));
+  std::size_t neg = 0;
+  for (double v : x) neg += v < 0;
+
+  Mask<2> mask = x < 0.0;
+  EXPECT_EQ(neg, mask.count());
+  vec s = select(x, mask);
+  ASSERT_EQ(neg, s.size());
+  EXPECT_TRUE(std::all_of(s.begin(), s.end(), [](double v) { return v < 0; }));
+  mat clipped = where(mask, 0.0, x);
+  masked_assign(x, mask, 0.0);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j) {
+      ASSERT_GE(x(i, j), 0);
+      ASSERT_EQ(x(i, j), clipped(i, j));
+    }
+
+  // a strided view, gathered a word at a time
+  MatrixRef<double, 2> view = x(slice(1, 200), slice(3, 100));
+  Mask<2> zero = view == 0.0;
+  std::size_t expected = 0;
+  for (std::size_t i = 0; i != 200; ++i)
+    for (std::size_t j = 0; j != 100; ++j) expected += view(i, j) == 0;
+  EXPECT_EQ(expected, zero.count());
+  masked_assign(view, zero, -1.0);
+  EXPECT_EQ(expected, (x == -1.0).count());
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_MASK_H
@@ -29,6 +29,27 @@ TEST(MatrixOperationTest, MatTranspose) {
   EXPECT_EQ(9, m2(2, 2));
 }
 
+TEST(MatrixOperationTest, MatTransposeNonSquare) {
+  mat m1 = {
+      {1, 2, 3},
+      {4, 5, 6}
+  };
+  mat m2 = transpose(m1);
+
+  EXPECT_EQ(3, m2.n_rows());
+  EXPECT_EQ(2, m2.n_cols());
+  EXPECT_EQ(4, m2(0, 1));
+  EXPECT_EQ(3, m2(2, 0));
+  EXPECT_EQ(6, m2(2, 1));
+
+  mat tall(70, 33);
+  for (std::size_t i = 0; i != 70; ++i)
+    for (std::size_t j = 0; j != 33; ++j) tall(i, j) = 100 * i + j;
+  mat t = transpose(tall);
+  for (std::size_t i = 0; i != 70; ++i)
+    for (std::size_t j = 0; j != 33; ++j) ASSERT_EQ(tall(i, j), t(j, i));
+}
+
 TEST(MatrixOperationTest, IntMatVecProd) {
   imat m1 = {
       {8, 4, 7},
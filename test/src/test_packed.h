@@ -0,0 +1,115 @@
+#ifndef MATRIX_TEST_PACKED_H
+#define MATRIX_TEST_PACKED_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(PackedMatrixTest, TriangularStorageAndConversions) {
+  // packed row by row
+  TriangularMatrix<double> l(3, {1, 2, 3, 4, 5, 6});
+  TriangularMatrix<double> u(3, {1, 2, 3, 4, 5, 6}, lapack_uplo::upper);
+  EXPECT_EQ(6, l.size());
+
+  mat ld = l.dense();
+  mat ud = u.dense();
+  mat l_expected = {{1, 0, 0}, {2, 3, 0}, {4, 5, 6}};
+  mat u_expected = {{1, 2, 3}, {0, 4, 5}, {0, 0, 6}};
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 3; ++j) {
+      EXPECT_EQ(l_expected(i, j), ld(i, j));
+      EXPECT_EQ(u_expected(i, j), ud(i, j));
+    }
+
+  TriangularMatrix<double> l2(l_expected);
+  EXPECT_TRUE(std::equal(l.begin(), l.end(), l2.begin()));
+  l2(2, 1) = 7;
+  EXPECT_EQ(7, l2(2, 1));
+
+  const TriangularMatrix<double> unit(l_expected, lapack_uplo::lower, true);
+  EXPECT_EQ(1, unit(2, 2));
+  EXPECT_EQ(0, unit(0, 2));
+}
+
+TEST(PackedMatrixTest, TriangularProductAndSolve) {
+  mat dense = {{2, 0, 0}, {1, 3, 0}, {-1, 2, 4}};
+  vec x = {1, -2, 3};
+
+  for (lapack_uplo uplo : {lapack_uplo::lower, lapack_uplo::upper}) {
+    mat a = (uplo == lapack_uplo::lower) ? dense : mat(transpose(dense));
+    TriangularMatrix<double> t(a, uplo);
+
+    for (blas_trans trans : {blas_trans::no_trans, blas_trans::trans}) {
+      vec y = x;
+      blas_tpmv(t, y, trans);
+      vec expected = matmul(trans == blas_trans::no_trans ? a : mat(transpose(a)), x);
+      for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(expected(i), y(i), 1e-14);
+
+      blas_tpsv(t, y, trans);
+      for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(x(i), y(i), 1e-14);
+    }
+  }
+
+  // a unit diagonal is not read
+  TriangularMatrix<double> t(dense, lapack_uplo::lower, true);
+  vec y = matmul(t, x);
+  EXPECT_NEAR(1, y(0), 1e-14);
+  EXPECT_NEAR(1 - 2, y(1), 1e-14);
+  EXPECT_NEAR(-1 - 4 + 3, y(2), 1e-14);
+}
+
+TEST(PackedMatrixTest, SymmetricProductRankOneAndCholesky) {
+  mat dense = {
+      {4, 12, -16},
+      {12, 37, -43},
+      {-16, -43, 98}
+  };
+  vec x = {1, 2, 3};
+
+  for (lapack_uplo uplo : {lapack_uplo::lower, lapack_uplo::upper}) {
+    SymmetricMatrix<double> s(dense, uplo);
+    EXPECT_EQ(6, s.size());
+    EXPECT_EQ(12, s(0, 1));
+    EXPECT_EQ(12, s(1, 0));
+
+    vec y = matmul(s, x);
+    vec expected = matmul(dense, x);
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(expected(i), y(i), 1e-12);
+
+    // y := 2 * A * x - y
+    blas_spmv(2.0, s, x, -1.0, y);
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(expected(i), y(i), 1e-12);
+
+    SymmetricMatrix<double> r = s;
+    blas_spr(0.5, x, r);
+    mat rd = r.dense();
+    for (std::size_t i = 0; i != 3; ++i)
+      for (std::size_t j = 0; j != 3; ++j)
+        EXPECT_NEAR(dense(i, j) + 0.5 * x(i) * x(j), rd(i, j), 1e-12);
+
+    // A = L * L' with L = {{2, 0, 0}, {6, 1, 0}, {-8, 5, 3}}
+    ASSERT_EQ(0, lapack_pptrf(s));
+    const double l00 = s(0, 0), l10 = s(1, 0), l22 = s(2, 2);
+    EXPECT_NEAR(2, l00, 1e-12);
+    EXPECT_NEAR(6, l10, 1e-12);
+    EXPECT_NEAR(3, l22, 1e-12);
+
+    vec b = matmul(dense, x);
+    ASSERT_EQ(0, lapack_pptrs(s, b));
+    for (std::size_t i = 0; i != 3; ++i) EXPECT_NEAR(x(i), b(i), 1e-10);
+
+    mat xb = {{1, 0}, {2, 1}, {3, -1}};
+    mat bb = matmul(dense, xb);
+    ASSERT_EQ(0, lapack_pptrs(s, bb));
+    for (std::size_t i = 0; i != 3; ++i)
+      for (std::size_t j = 0; j != 2; ++j) EXPECT_NEAR(xb(i, j), bb(i, j), 1e-10);
+  }
+
+  SymmetricMatrix<double> indefinite(2, {1, 2, 1});
+  EXPECT_EQ(2, lapack_pptrf(indefinite));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_PACKED_H
@@ -0,0 +1,173 @@
+#ifndef MATRIX_TEST_QUANTILE_H
+#define MATRIX_TEST_QUANTILE_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(QuantileTest, ExactAlongAxes) {
+  mat m = {{1, 8, 3}, {4, 2, 6}, {7, 5, 9}, {10, 11, 0}};
+  mat q = quantile(m, {0.5, 0, 1, 0.25}, 0);
+  ASSERT_EQ(4, q.n_rows());
+  ASSERT_EQ(3, q.n_cols());
+  EXPECT_EQ(5.5, q(0, 0));  // between 4 and 7
+  EXPECT_EQ(1, q(1, 0));
+  EXPECT_EQ(10, q(2, 0));
+  EXPECT_EQ(3.25, q(3, 0));  // 3/4 of the way from 1 to 4
+  EXPECT_EQ(6.5, q(0, 1));
+  EXPECT_EQ(4.5, q(0, 2));
+
+  vec med = median(m, 1);
+  ASSERT_EQ(4, med.size());
+  EXPECT_EQ(3, med(0));
+  EXPECT_EQ(4, med(1));
+  EXPECT_EQ(10, med(3));
+
+  // a strided view, and NaN
+  mat odd = quantile(m(slice(0, 2, 2), slice(0, 3)), {0.5}, 1);
+  ASSERT_EQ(2, odd.n_rows());
+  EXPECT_EQ(3, odd(0, 0));
+  EXPECT_EQ(7, odd(1, 0));
+  vec v = {1, std::numeric_limits<double>::quiet_NaN(), 2};
+  EXPECT_TRUE(std::isnan(median(v, 0)()));
+
+  // many columns in parallel
+  const std::size_t n = 1001, p = 64;
+  mat big(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j) big(i, j) = (i * 37 + j) % n;
+  mat deciles = quantile(big, {0.1, 0.9}, 0);
+  for (std::size_t j = 0; j != p; ++j) {
+    EXPECT_EQ(100, deciles(0, j));
+    EXPECT_EQ(900, deciles(1, j));
+  }
+}
+
+TEST(QuantileTest, TDigest) {
+  const std::size_t n = 200000;
+  vec x(n);
+  RandomStream rng(9);
+  randn(x, rng);
+  vec sorted = sort(x);
+
+  // four digests of parts, merged
+  std::vector<TDigest<double>> parts(4);
+#pragma omp parallel for
+  for (int t = 0; t < 4; ++t)
+    parts[t].add(x(slice(t * n / 4, n / 4)));
+  TDigest<double> digest;
+  for (const TDigest<double> &d : parts) digest.merge(d);
+  EXPECT_EQ(n, digest.count());
+  EXPECT_LT(digest.size(), 200);
+  EXPECT_EQ(sorted(0), digest.min());
+  EXPECT_EQ(sorted(n - 1), digest.quantile(1));
+  for (double q : {0.001, 0.01, 0.1, 0.5, 0.9, 0.99, 0.999}) {
+    const double exact = sorted(static_cast<std::size_t>(q * (n - 1)));
+    // the error is measured on the quantile scale
+    const double got = digest.quantile(q);
+    const double rank = std::lower_bound(sorted.begin(), sorted.end(), got) -
+                        sorted.begin();
+    EXPECT_NEAR(q, rank / n, 0.002 + 0.02 * std::min(q, 1 - q)) << q;
+    EXPECT_NEAR(exact, got, 0.05) << q;
+  }
+
+  mat m(n / 4, 4);
+  std::copy(x.begin(), x.end(), m.begin());
+  mat approx = quantile(m, {0.5}, 0, quantile_method::tdigest);
+  mat exact = quantile(m, {0.5}, 0);
+  for (std::size_t j = 0; j != 4; ++j)
+    EXPECT_NEAR(exact(0, j), approx(0, j), 0.02);
+
+  TDigest<float> empty;
+  EXPECT_TRUE(std::isnan(empty.quantile(0.5)));
+}
+
+TEST(HistogramTest, FixedAndAdaptiveBins) {
+  vec x = {0, 0.5, 1, 1.5, 2, 2.5, 3, 10, -1};
+  Histogram<double> h = histogram(x, 3, 0.0, 3.0);
+  ASSERT_EQ(4, h.edges.size());
+  ASSERT_EQ(3, h.counts.size());
+  EXPECT_EQ(2, h.counts(0));
+  EXPECT_EQ(2, h.counts(1));
+  EXPECT_EQ(3, h.counts(2));  // the last bin is closed
+
+  Histogram<double> uneven = histogram(x, vec({-5, 1, 2, 20}));
+  EXPECT_EQ(3, uneven.counts(0));
+  EXPECT_EQ(2, uneven.counts(1));
+  EXPECT_EQ(4, uneven.counts(2));
+
+  // per column
+  mat m = {{0, 5}, {1, 6}, {2, 7}, {2.5, 0}};
+  Matrix<std::size_t, 2> per_col = histogram(m, vec({0, 2, 8}), 0);
+  ASSERT_EQ(2, per_col.n_rows());
+  EXPECT_EQ(2, per_col(0, 0));
+  EXPECT_EQ(2, per_col(1, 0));
+  EXPECT_EQ(1, per_col(0, 1));
+  EXPECT_EQ(3, per_col(1, 1));
+
+  // adaptive bins on a large sample, counted in parallel
+  const std::size_t n = 100000;
+  vec y(n);
+  RandomStream rng(4);
+  randn(y, rng);
+  vec freq = histogram_edges(y, bin_rule::equal_frequency, 4);
+  ASSERT_EQ(5, freq.size());
+  Histogram<double> hf = histogram(y, freq);
+  for (std::size_t b = 0; b != 4; ++b) EXPECT_NEAR(n / 4, hf.counts(b), 1);
+  vec fd = histogram_edges(y, bin_rule::freedman_diaconis);
+  EXPECT_GT(fd.size(), 20);
+  Histogram<double> hd = histogram(y, fd);
+  EXPECT_EQ(n, std::accumulate(hd.counts.begin(), hd.counts.end(),
+                               std::size_t(0)));
+  vec uni = histogram_edges(y, bin_rule::uniform, 7);
+  EXPECT_EQ(min(y), uni(0));
+  EXPECT_EQ(max(y), uni(7));
+}
+
+TEST(HistogramTest, EdgesIgnoreNaNAndOutliers) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  vec x = {nan, 1, 2, 3, 4, nan, 5, 6, 7, 8};
+  vec freq = histogram_edges(x, bin_rule::equal_frequency, 2);
+  ASSERT_EQ(3, freq.size());
+  EXPECT_EQ(1, freq(0));
+  EXPECT_EQ(4.5, freq(1));
+  EXPECT_EQ(8, freq(2));
+  vec uni = histogram_edges(x, bin_rule::uniform, 7);
+  EXPECT_EQ(1, uni(0));
+  EXPECT_EQ(8, uni(7));
+  vec none = histogram_edges(vec{nan, nan}, bin_rule::equal_frequency, 2);
+  EXPECT_EQ(-0.5, none(0));
+  EXPECT_EQ(0.5, none(2));
+
+  // an outlier far from a narrow IQR: no more bins than values
+  vec y(1000);
+  for (std::size_t i = 0; i != y.size(); ++i) y(i) = 1.0 + 1e-9 * (i % 7);
+  y(0) = 1e12;
+  vec fd = histogram_edges(y, bin_rule::freedman_diaconis);
+  EXPECT_EQ(1001, fd.size());
+  Histogram<double> h = histogram(y, fd);
+  EXPECT_EQ(999, h.counts(0));
+  EXPECT_EQ(1, h.counts(999));
+}
+
+TEST(HistogramTest, IntegerValues) {
+  Matrix<int, 1> x = {5, 15, 25, 35, 45, 55, 65, 75, 85, 95};
+  Histogram<int> h = histogram(x, 10, 0, 100);
+  ASSERT_EQ(10, h.counts.size());
+  for (std::size_t b = 0; b != 10; ++b) EXPECT_EQ(1, h.counts(b));
+
+  // integer edges are rounded down: 0 3 6 10
+  Matrix<int, 1> y(11);
+  std::iota(y.begin(), y.end(), 0);
+  Histogram<int> g = histogram(y, 3, 0, 10);
+  EXPECT_EQ(3, g.edges(1));
+  EXPECT_EQ(6, g.edges(2));
+  EXPECT_EQ(3, g.counts(0));
+  EXPECT_EQ(3, g.counts(1));
+  EXPECT_EQ(5, g.counts(2));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_QUANTILE_H
@@ -0,0 +1,101 @@
+#ifndef MATRIX_TEST_RANDOM_H
+#define MATRIX_TEST_RANDOM_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(RandomTest, PhiloxKnownAnswer) {
+  // from the Random123 known answer tests
+  const matrix_impl::philox_block zero =
+      matrix_impl::philox4x32({{0, 0, 0, 0}}, {{0, 0}});
+  EXPECT_EQ(0x6627e8d5u, zero[0]);
+  EXPECT_EQ(0xe169c58du, zero[1]);
+  EXPECT_EQ(0xbc57ac4cu, zero[2]);
+  EXPECT_EQ(0x9b00dbd8u, zero[3]);
+  const matrix_impl::philox_block ones = matrix_impl::philox4x32(
+      {{0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}},
+      {{0xffffffffu, 0xffffffffu}});
+  EXPECT_EQ(0x408f276du, ones[0]);
+  EXPECT_EQ(0x41c83b0eu, ones[1]);
+  EXPECT_EQ(0xa20bc7c6u, ones[2]);
+  EXPECT_EQ(0x6d5451fdu, ones[3]);
+}
+
+TEST(RandomTest, Distributions) {
+  RandomStream rng(42);
+  const std::size_t n = 1000000;
+  vec x(n);
+  randn(x, rng, 2.0, 3.0);
+  EXPECT_NEAR(2.0, mean(x), 0.02);
+  EXPECT_NEAR(9.0, var(x), 0.05);
+  std::size_t within = 0;
+  for (std::size_t i = 0; i != n; ++i) within += std::abs(x(i) - 2) < 3;
+  EXPECT_NEAR(0.6827, double(within) / n, 0.002);
+
+  Matrix<float, 2> u(1000, 1000);
+  randu(u, rng, -1.0f, 1.0f);
+  EXPECT_GT(min(u), -1.0f);
+  EXPECT_LT(max(u), 1.0f);
+  EXPECT_NEAR(0, mean(u), 0.005);
+  EXPECT_NEAR(1.0 / 3, var(u), 0.005);
+
+  Matrix<int, 1> k(60000);
+  randint(k, rng, -3, 2);
+  std::array<std::size_t, 6> counts = {{0, 0, 0, 0, 0, 0}};
+  for (std::size_t i = 0; i != k.size(); ++i) {
+    ASSERT_LE(-3, k(i));
+    ASSERT_GE(2, k(i));
+    ++counts[k(i) + 3];
+  }
+  for (std::size_t c : counts) EXPECT_NEAR(10000, c, 500);
+}
+
+TEST(RandomTest, Reproducible) {
+  const std::size_t n = 100003;  // not a multiple of the tile
+  vec a(n), b(n);
+  RandomStream ra(7), rb(7);
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  randn(a, ra);
+  omp_set_num_threads(4);
+  randn(b, rb);
+  omp_set_num_threads(threads);
+#else
+  randn(a, ra);
+  randn(b, rb);
+#endif
+  for (std::size_t i = 0; i != n; ++i) ASSERT_EQ(a(i), b(i));
+  EXPECT_EQ(ra.position(), rb.position());
+
+  // the next fill gives new numbers, and skipping reaches the same ones
+  randn(a, ra);
+  EXPECT_NE(a(0), b(0));
+  RandomStream rc(7);
+  rc.skip(n);
+  randn(b, rc);
+  EXPECT_EQ(a(n - 1), b(n - 1));
+
+  // another seed
+  RandomStream rd(8);
+  randn(b, rd);
+  EXPECT_NE(a(0), b(0));
+
+  // a strided block gets the numbers of a matrix of its shape
+  mat m(4, 6), block(3, 2);
+  std::fill(m.begin(), m.end(), 0.0);
+  RandomStream re(11), rf(11);
+  randu(m(slice(1, 3), slice(1, 2, 3)), re);
+  randu(block, rf);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 2; ++j)
+      EXPECT_EQ(block(i, j), m(i + 1, 1 + 3 * j));
+  EXPECT_EQ(0, m(0, 1));
+  EXPECT_EQ(0, m(1, 2));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_RANDOM_H
@@ -0,0 +1,124 @@
+#ifndef MATRIX_TEST_REDUCTION_H
+#define MATRIX_TEST_REDUCTION_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(ReductionTest, AlongEachAxis) {
+  mat m = {{1, 2, 3}, {4, 5, 6}};
+  EXPECT_EQ(21, sum(m));
+  EXPECT_EQ(720, prod(m));
+  EXPECT_EQ(1, min(m));
+  EXPECT_EQ(6, max(m));
+  EXPECT_EQ(3.5, mean(m));
+  EXPECT_DOUBLE_EQ(35.0 / 12, var(m));
+
+  vec cols = sum(m, 0);
+  ASSERT_EQ(3, cols.size());
+  EXPECT_EQ(5, cols(0));
+  EXPECT_EQ(9, cols(2));
+  vec rows = sum(m, 1);
+  ASSERT_EQ(2, rows.size());
+  EXPECT_EQ(6, rows(0));
+  EXPECT_EQ(15, rows(1));
+  EXPECT_EQ(18, prod(m, 0)(2));
+  EXPECT_EQ(4, min(m, 1)(1));
+  EXPECT_EQ(3, max(m, 1)(0));
+  EXPECT_EQ(2.5, mean(m, 0)(0));
+  EXPECT_EQ(2.25, var(m, 0)(1));
+  EXPECT_EQ(4.5, var(m, 0, 1)(1));
+  EXPECT_TRUE(std::isnan(var(m, 0, 2)(1)));  // no degree of freedom left
+  EXPECT_TRUE(std::isnan(var(m, 0, 5)(0)));
+  EXPECT_DOUBLE_EQ(2.0 / 3, var(m, 1)(0));
+
+  // a vector reduces to a scalar
+  vec v = {3, -1, 2};
+  Matrix<double, 0> s = sum(v, 0);
+  EXPECT_EQ(4, s());
+  EXPECT_EQ(-1, min(v));
+
+  // order 3: the middle axis
+  Matrix<int, 3> c(2, 3, 2);
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      for (std::size_t k = 0; k != 2; ++k) c(i, j, k) = 100 * i + 10 * j + k;
+  Matrix<int, 2> cs = sum(c, 1);
+  ASSERT_EQ(2, cs.n_rows());
+  ASSERT_EQ(2, cs.n_cols());
+  EXPECT_EQ(30, cs(0, 0));
+  EXPECT_EQ(333, cs(1, 1));
+  EXPECT_EQ(121, max(c, 0)(2, 1));
+
+  // a block of columns and a block of rows, read in place, and a view with
+  // strided rows, which is copied
+  MatrixRef<double, 2> block = m(slice(0, 2), slice(1, 2));
+  EXPECT_EQ(16, sum(block));
+  EXPECT_EQ(7, sum(block, 0)(0));
+  EXPECT_EQ(11, sum(block, 1)(1));
+  EXPECT_EQ(30, prod(block, 1)(1));
+  EXPECT_DOUBLE_EQ(2.5, var(block));
+  EXPECT_EQ(2.25, var(block, 0)(1));
+  EXPECT_EQ(0.25, var(block, 1)(0));
+  EXPECT_EQ(9, sum(m(slice(0, 2), slice(2, 1))));
+  EXPECT_EQ(15, sum(m(slice(1, 1), slice(0, 3))));
+  MatrixRef<double, 2> corners = m(slice(0, 2), slice(0, 2, 2));
+  EXPECT_EQ(14, sum(corners));
+  EXPECT_EQ(9, sum(corners, 0)(1));
+}
+
+TEST(ReductionTest, LargeParallelReductions) {
+  // column sums of a tall matrix, row sums of a wide one
+  const std::size_t m = 200000, n = 7;
+  mat tall(m, n);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) tall(i, j) = 0.1 * j + (i % 3);
+  vec cs = sum(tall, 0);
+  vec cm = mean(tall, 0);
+  vec cv = var(tall, 0);
+  for (std::size_t j = 0; j != n; ++j) {
+    const double expected = (0.1 * j + 1) * m - 1;  // 200000 = 3 * 66666 + 2
+    EXPECT_NEAR(expected, cs(j), 1e-7);
+    EXPECT_NEAR(expected / m, cm(j), 1e-12);
+    EXPECT_NEAR(2.0 / 3, cv(j), 1e-5);
+  }
+
+  mat wide(3, 100000);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 100000; ++j) wide(i, j) = i + 0.5 * (j % 2);
+  // the same sums on a block of columns of a wider matrix
+  mat wider(m, n + 3);
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n + 3; ++j) wider(i, j) = tall(i, j % n);
+  MatrixRef<double, 2> cols = wider(slice(0, m), slice(1, n));
+  vec bs = sum(cols, 0);
+  vec bv = var(cols, 0);
+  vec br = sum(cols, 1);
+  for (std::size_t j = 0; j != n; ++j) {
+    EXPECT_DOUBLE_EQ(cs((j + 1) % n), bs(j));
+    EXPECT_DOUBLE_EQ(cv((j + 1) % n), bv(j));
+  }
+  EXPECT_NEAR(sum(tall), sum(cols), 1e-6);
+  EXPECT_NEAR(var(tall), var(cols), 1e-12);
+  ASSERT_EQ(m, br.size());
+  EXPECT_DOUBLE_EQ(2.1, br(0));
+  EXPECT_DOUBLE_EQ(9.1, br(m - 1));
+
+  vec rs = sum(wide, 1);
+  ASSERT_EQ(3, rs.size());
+  for (std::size_t i = 0; i != 3; ++i)
+    EXPECT_DOUBLE_EQ(100000.0 * i + 25000, rs(i));
+  EXPECT_DOUBLE_EQ(2.6, max(tall));
+  EXPECT_EQ(0, min(tall, 0)(0));
+
+  // pairwise summation of 10^7 copies of 0.1 in single precision
+  Matrix<float, 1> x(10000000);
+  std::fill(x.begin(), x.end(), 0.1f);
+  EXPECT_NEAR(1e6, sum(x), 1);
+  EXPECT_NEAR(0.1, mean(x), 1e-6);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_REDUCTION_H
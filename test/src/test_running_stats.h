@@ -0,0 +1,104 @@
+#ifndef MATRIX_TEST_RUNNING_STATS_H
+#define MATRIX_TEST_RUNNING_STATS_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+inline void expect_stats_of(const mat &x, const RunningStats<double> &s,
+                            double tol) {
+  const std::size_t p = x.n_cols();
+  ASSERT_EQ(x.n_rows(), s.count());
+  vec mu = mean(x, 0), v = var(x, 0, 1), lo = min(x, 0), hi = max(x, 0);
+  vec sv = s.var();
+  for (std::size_t j = 0; j != p; ++j) {
+    EXPECT_NEAR(mu(j), s.mean()(j), tol);
+    EXPECT_NEAR(v(j), sv(j), tol);
+    EXPECT_EQ(lo(j), s.min()(j));
+    EXPECT_EQ(hi(j), s.max()(j));
+  }
+  if (!s.has_covariance()) return;
+  mat c = cov(x), sc = s.cov();
+  mat r = corr(x), sr = s.corr();
+  for (std::size_t i = 0; i != p; ++i)
+    for (std::size_t j = 0; j != p; ++j) {
+      EXPECT_NEAR(c(i, j), sc(i, j), tol);
+      EXPECT_NEAR(r(i, j), sr(i, j), tol);
+    }
+}
+
+TEST(RunningStatsTest, BatchesMatchTheWholeData) {
+  const std::size_t n = 1000, p = 5;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j)
+      x(i, j) = 1e4 * j + std::sin(0.37 * i * (j + 1)) + 0.001 * i;
+
+  // batches of uneven sizes, some of them strided views
+  RunningStats<double> s(p), d(p, false);
+  const std::size_t cuts[] = {0, 1, 7, 300, 301, 640, 1000};
+  for (std::size_t k = 0; k + 1 != 7; ++k) {
+    MatrixRef<double, 2> batch =
+        x(slice(cuts[k], cuts[k + 1] - cuts[k]), slice(0, p));
+    s.add(batch);
+    d.add(batch);
+  }
+  expect_stats_of(x, s, 1e-9);
+  expect_stats_of(x, d, 1e-9);
+
+  // every other column, which are not contiguous
+  RunningStats<double> even(2);
+  even.add(x(slice(0, n), slice(2, 2, 2)));
+  EXPECT_NEAR(s.mean()(4), even.mean()(1), 1e-9);
+  EXPECT_NEAR(s.cov()(2, 4), even.cov()(0, 1), 1e-9);
+
+  // rebuilt from its state, with the variances only or the covariances
+  mat m2 = s.comoments();
+  EXPECT_EQ(m2(1, 3), m2(3, 1));
+  RunningStats<double> copy(s.count(), s.mean(), m2, s.min(), s.max());
+  EXPECT_EQ(s.cov()(1, 3), copy.cov()(1, 3));
+  EXPECT_EQ(s.cov()(3, 1), copy.cov()(3, 1));
+  vec ss = d.squared_deviations();
+  EXPECT_NEAR(m2(2, 2), ss(2), 1e-9 * m2(2, 2));
+  RunningStats<double> dcopy(d.count(), d.mean(), ss, d.min(), d.max());
+  EXPECT_FALSE(dcopy.has_covariance());
+  EXPECT_EQ(d.var()(2), dcopy.var()(2));
+
+  s.clear();
+  EXPECT_EQ(0, s.count());
+  s.add(x);
+  expect_stats_of(x, s, 1e-9);
+}
+
+TEST(RunningStatsTest, MergeThreadAccumulators) {
+  const std::size_t n = 20000, p = 4, batch = 1000;
+  mat x(n, p);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != p; ++j)
+      x(i, j) = ((i * 7919 + j * 104729) % 1000) * 0.01 + j;
+
+  RunningStats<double> total(p);
+  const std::ptrdiff_t nb = n / batch;
+#pragma omp parallel
+  {
+    RunningStats<double> local(p);
+#pragma omp for schedule(dynamic)
+    for (std::ptrdiff_t b = 0; b < nb; ++b)
+      local.add(x(slice(b * batch, batch), slice(0, p)));
+#pragma omp critical
+    total.merge(local);
+  }
+  expect_stats_of(x, total, 1e-9);
+
+  // merging an empty accumulator changes nothing
+  RunningStats<double> empty(p);
+  total.merge(empty);
+  empty.merge(total);
+  EXPECT_EQ(n, empty.count());
+  EXPECT_EQ(total.cov()(0, 1), empty.cov()(0, 1));
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_RUNNING_STATS_H
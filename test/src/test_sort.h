@@ -0,0 +1,131 @@
+#ifndef MATRIX_TEST_SORT_H
+#define MATRIX_TEST_SORT_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(SortTest, SortAndArgsortAlongAxes) {
+  mat m = {{3, 1, 2}, {0, 5, -1}};
+  mat rows = sort(m);
+  EXPECT_EQ(1, rows(0, 0));
+  EXPECT_EQ(3, rows(0, 2));
+  EXPECT_EQ(-1, rows(1, 0));
+  mat cols = sort(m, 0);
+  EXPECT_EQ(0, cols(0, 0));
+  EXPECT_EQ(3, cols(1, 0));
+  EXPECT_EQ(-1, cols(0, 2));
+
+  Matrix<std::size_t, 2> order = argsort(m);
+  EXPECT_EQ(1, order(0, 0));
+  EXPECT_EQ(0, order(0, 2));
+  EXPECT_EQ(2, order(1, 0));
+  Matrix<std::size_t, 2> col_order = argsort(m, 0);
+  EXPECT_EQ(1, col_order(0, 0));
+  EXPECT_EQ(0, col_order(0, 1));
+
+  // NaN last, ties in order
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  vec v = {2, nan, 1, 2, -3};
+  vec s = sort(v);
+  EXPECT_EQ(-3, s(0));
+  EXPECT_EQ(2, s(3));
+  EXPECT_TRUE(std::isnan(s(4)));
+  Matrix<std::size_t, 1> vi = argsort(v);
+  const std::size_t expected[] = {4, 2, 0, 3, 1};
+  for (std::size_t i = 0; i != 5; ++i) EXPECT_EQ(expected[i], vi(i));
+
+  // the columns of a strided view of an order 3 matrix
+  Matrix<int, 3> c(2, 4, 3);
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t j = 0; j != 4; ++j)
+      for (std::size_t k = 0; k != 3; ++k)
+        c(i, j, k) = (7 * i + 5 * j + 3 * k) % 11;
+  Matrix<int, 3> sc = sort(c, 1);
+  for (std::size_t i = 0; i != 2; ++i)
+    for (std::size_t k = 0; k != 3; ++k)
+      for (std::size_t j = 1; j != 4; ++j)
+        EXPECT_LE(sc(i, j - 1, k), sc(i, j, k));
+  MatrixRef<double, 2> block = m(slice(0, 2), slice(0, 2, 2));
+  mat sb = sort(block, 0);
+  EXPECT_EQ(-1, sb(0, 1));
+  EXPECT_EQ(2, sb(1, 1));
+}
+
+TEST(SortTest, ArgmaxAndArgmin) {
+  mat m = {{3, 7, 7}, {9, -2, 4}, {1, 1, 0}};
+  Matrix<std::size_t, 1> r = argmax(m, 1);
+  EXPECT_EQ(1, r(0));  // the first of equal maxima
+  EXPECT_EQ(0, r(1));
+  EXPECT_EQ(0, r(2));
+  Matrix<std::size_t, 1> c = argmin(m, 0);
+  EXPECT_EQ(2, c(0));
+  EXPECT_EQ(1, c(1));
+  EXPECT_EQ(2, c(2));
+  EXPECT_EQ(3, argmax(m));
+  EXPECT_EQ(4, argmin(m));
+  EXPECT_EQ(2, argmin(m(slice(0, 2), slice(1, 2))));
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  vec v = {1, nan, 5};
+  EXPECT_EQ(1, argmax(v));
+  EXPECT_EQ(0, argmin(v));
+
+  // a wide matrix along both axes
+  mat w(300, 500);
+  for (std::size_t i = 0; i != 300; ++i)
+    for (std::size_t j = 0; j != 500; ++j)
+      w(i, j) = std::sin(0.1 * i + 0.37 * j) + (i == j ? 3 : 0);
+  Matrix<std::size_t, 1> wc = argmax(w, 0), wr = argmax(w, 1);
+  for (std::size_t i = 0; i != 300; ++i) {
+    EXPECT_EQ(i, wc(i));
+    EXPECT_EQ(i, wr(i));
+  }
+}
+
+TEST(SortTest, TopK) {
+  mat m = {{4, 9, 1, 9, 3}, {0, -1, 2, 8, 5}};
+  TopKResult<double, 2> t = topk(m, 3);
+  ASSERT_EQ(3, t.values.n_cols());
+  EXPECT_EQ(9, t.values(0, 0));
+  EXPECT_EQ(1, t.indices(0, 0));
+  EXPECT_EQ(3, t.indices(0, 1));
+  EXPECT_EQ(4, t.values(0, 2));
+  EXPECT_EQ(3, t.indices(1, 0));
+  EXPECT_EQ(2, t.indices(1, 2));
+
+  TopKResult<double, 2> low = topk(m, 1, 0, false);
+  ASSERT_EQ(1, low.values.n_rows());
+  EXPECT_EQ(0, low.values(0, 0));
+  EXPECT_EQ(1, low.indices(0, 1));
+  EXPECT_EQ(1, low.indices(0, 3));
+
+  // long rows against a full sort, on 1 and 4 threads
+  const std::size_t n = 300000, k = 10;
+  mat scores(2, n);
+  RandomStream rng(5);
+  randn(scores, rng);
+  Matrix<std::size_t, 2> order = argsort(scores);
+  for (int threads : {1, 4}) {
+#ifdef _OPENMP
+    const int saved = omp_get_max_threads();
+    omp_set_num_threads(threads);
+#endif
+    TopKResult<double, 2> best = topk(scores, k);
+    TopKResult<double, 2> half = topk(scores, n / 2, 1, false);
+#ifdef _OPENMP
+    omp_set_num_threads(saved);
+#endif
+    for (std::size_t i = 0; i != 2; ++i) {
+      for (std::size_t j = 0; j != k; ++j)
+        EXPECT_EQ(order(i, n - 1 - j), best.indices(i, j)) << threads;
+      for (std::size_t j = 0; j < n / 2; j += 1009)
+        EXPECT_EQ(order(i, j), half.indices(i, j));
+    }
+  }
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_SORT_H
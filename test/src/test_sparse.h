@@ -0,0 +1,221 @@
+#ifndef MATRIX_TEST_SPARSE_H
+#define MATRIX_TEST_SPARSE_H
+
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(SparseMatrixTest, BuilderAndConversions) {
+  SparseBuilder<double> builder(4, 5);
+  builder.add(2, 4, 1.5);
+  builder.add(0, 1, 2);
+  builder.add(3, 0, -1);
+  builder.add(0, 1, 3);  // summed with the other (0, 1)
+  builder.add(2, 0, 4);
+  builder.add(0, 3, -2);
+  EXPECT_EQ(6, builder.size());
+
+  SparseMatrix<double> a = builder.build();
+  EXPECT_EQ(4, a.n_rows());
+  EXPECT_EQ(5, a.n_cols());
+  EXPECT_EQ(5, a.nnz());
+  EXPECT_EQ(std::vector<int>({0, 2, 2, 4, 5}),
+            std::vector<int>(a.ptr().begin(), a.ptr().end()));
+  EXPECT_EQ(std::vector<int>({1, 3, 0, 4, 0}),
+            std::vector<int>(a.indices().begin(), a.indices().end()));
+  EXPECT_EQ(5, a(0, 1));
+  EXPECT_EQ(0, a(1, 1));
+  EXPECT_EQ(1.5, a(2, 4));
+
+  mat dense = a.dense();
+  EXPECT_EQ(-2, dense(0, 3));
+  EXPECT_EQ(-1, dense(3, 0));
+  EXPECT_EQ(0, dense(1, 2));
+
+  SparseMatrix<double> csc = a.convert(sparse_format::csc);
+  EXPECT_EQ(sparse_format::csc, csc.format());
+  EXPECT_EQ(std::vector<int>({0, 2, 3, 3, 4, 5}),
+            std::vector<int>(csc.ptr().begin(), csc.ptr().end()));
+  EXPECT_EQ(std::vector<int>({2, 3, 0, 0, 2}),
+            std::vector<int>(csc.indices().begin(), csc.indices().end()));
+  SparseMatrix<double> built_csc = builder.build(sparse_format::csc);
+  EXPECT_EQ(csc.ptr(), built_csc.ptr());
+  EXPECT_EQ(csc.indices(), built_csc.indices());
+  EXPECT_EQ(csc.values(), built_csc.values());
+
+  SparseMatrix<double> from_dense(dense, sparse_format::csc);
+  EXPECT_EQ(csc.ptr(), from_dense.ptr());
+  EXPECT_EQ(csc.values(), from_dense.values());
+
+  SparseMatrix<double> back = csc.convert(sparse_format::csr);
+  EXPECT_EQ(a.ptr(), back.ptr());
+  EXPECT_EQ(a.indices(), back.indices());
+  EXPECT_EQ(a.values(), back.values());
+
+  SparseMatrix<double> at = a.transpose();
+  EXPECT_EQ(5, at.n_rows());
+  EXPECT_EQ(4, at.n_cols());
+  for (std::size_t i = 0; i != 4; ++i)
+    for (std::size_t j = 0; j != 5; ++j) EXPECT_EQ(a(i, j), at(j, i));
+}
+
+TEST(SparseMatrixTest, ParallelBuilderInChunks) {
+  // every thread adds every position of a 300 x 200 grid twice, out of
+  // order, with the values of column 7 cancelling out
+  const std::size_t m = 300, n = 200;
+  SparseBuilder<double> builder(m, n, 1000);
+  EXPECT_EQ(1000, builder.chunk_size());
+#pragma omp parallel
+  {
+    builder.reserve(2 * m * n);
+#pragma omp for schedule(static)
+    for (std::ptrdiff_t k = 0; k < std::ptrdiff_t(m * n); ++k) {
+      const std::size_t i = m - 1 - k % m, j = k / m;
+      const double v = (j == 7) ? ((k % 2) ? 1.0 : -1.0) : double(i + j);
+      builder.add(i, j, v);
+      builder.add(i, j, (j == 7) ? -v : 1.0);
+    }
+  }
+  EXPECT_EQ(2 * m * n, builder.size());
+
+  SparseMatrix<double> a = builder.build();
+  EXPECT_EQ(m * n, a.nnz());
+  EXPECT_EQ(0, a(5, 7));
+  SparseMatrix<double> dropped = builder.build(sparse_format::csc, true);
+  EXPECT_EQ(sparse_format::csc, dropped.format());
+  EXPECT_EQ(m * (n - 1), dropped.nnz());
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) {
+      const double expected = (j == 7) ? 0.0 : double(i + j + 1);
+      ASSERT_EQ(expected, a(i, j));
+      ASSERT_EQ(expected, dropped(i, j));
+    }
+
+  builder.clear();
+  EXPECT_EQ(0, builder.size());
+  builder.add(1, 2, 3);
+  SparseMatrix<double> one = builder.build();
+  EXPECT_EQ(1, one.nnz());
+  EXPECT_EQ(3, one(1, 2));
+}
+
+TEST(SparseMatrixTest, InterleavedBuilders) {
+  // two builders fed alternately by the same threads, each thread keeping
+  // a buffer in each
+  const std::size_t m = 500, n = 40;
+  SparseBuilder<double> a(m, n, 700), b(n, m, 700);
+#pragma omp parallel for schedule(static)
+  for (std::ptrdiff_t k = 0; k < std::ptrdiff_t(m * n); ++k) {
+    const std::size_t i = k % m, j = k / m;
+    a.add(i, j, 1.0);
+    b.add(j, i, 2.0);
+    a.add(i, j, double(i));
+  }
+  EXPECT_EQ(2 * m * n, a.size());
+  EXPECT_EQ(m * n, b.size());
+  SparseMatrix<double> sa = a.build(), sb = b.build();
+  EXPECT_EQ(m * n, sa.nnz());
+  EXPECT_EQ(m * n, sb.nnz());
+  for (std::size_t i = 0; i != m; ++i)
+    for (std::size_t j = 0; j != n; ++j) {
+      ASSERT_EQ(i + 1.0, sa(i, j));
+      ASSERT_EQ(2.0, sb(j, i));
+    }
+}
+
+TEST(SparseMatrixTest, TallBuilderInSmallChunks) {
+  // far more rows than a chunk holds: chunks are sorted by comparison, and
+  // merged into blocks of rows
+  const std::size_t m = 200000, n = 50, count = 60000;
+  SparseBuilder<double> builder(m, n, 512);
+  std::map<std::pair<std::size_t, std::size_t>, double> expected;
+  for (std::size_t k = 0; k != count; ++k) {
+    const std::size_t i = (k * 7919) % m, j = (k * 31) % n;
+    const double v = double(k % 5) - 2.0;
+    builder.add(i, j, v);
+    builder.add(i / 3, j, 1.0);
+    expected[std::make_pair(i, j)] += v;
+    expected[std::make_pair(i / 3, j)] += 1.0;
+  }
+
+  SparseMatrix<double> a = builder.build(sparse_format::csr, true);
+  std::size_t nonzero = 0;
+  for (const auto &e : expected) {
+    if (e.second == 0) continue;
+    ++nonzero;
+    ASSERT_EQ(e.second, a(e.first.first, e.first.second));
+  }
+  EXPECT_EQ(nonzero, a.nnz());
+
+  // triplets added after a build go to the same matrix
+  builder.add(m - 1, n - 1, 5.0);
+  EXPECT_EQ(nonzero + 1, builder.build(sparse_format::csr, true).nnz());
+}
+
+TEST(SparseMatrixTest, ProductsMatchDense) {
+  mat dense = {
+      {0, 2, 0, -1},
+      {0, 0, 0, 0},
+      {3, 0, 1, 0},
+      {0, -4, 0, 5},
+      {1, 0, 0, 2}
+  };
+  vec x = {1, -2, 0.5, 3};
+  mat b = {{1, 2}, {0, -1}, {3, 1}, {-2, 4}};
+  vec y = matmul(dense, x);
+  mat c = matmul(dense, b);
+
+  for (sparse_format f : {sparse_format::csr, sparse_format::csc}) {
+    SparseMatrix<double> a(dense, f);
+    EXPECT_EQ(8, a.nnz());
+    vec ys = matmul(a, x);
+    ASSERT_EQ(5, ys.size());
+    for (std::size_t i = 0; i != 5; ++i) EXPECT_DOUBLE_EQ(y(i), ys(i));
+    mat cs = matmul(a, b);
+    for (std::size_t i = 0; i != 5; ++i)
+      for (std::size_t j = 0; j != 2; ++j) EXPECT_DOUBLE_EQ(c(i, j), cs(i, j));
+  }
+}
+
+TEST(SparseMatrixTest, ParallelProductsOnLargeMatrix) {
+  // a 20000 x 20000 pentadiagonal matrix with a dense first row, so that the
+  // row blocks of equal nnz differ in length
+  const std::size_t n = 20000;
+  SparseBuilder<double> builder(n, n);
+  builder.reserve(6 * n);
+  for (std::size_t j = 0; j != n; ++j) builder.add(0, j, 1);
+  for (std::size_t i = 1; i != n; ++i)
+    for (std::size_t j = (i < 2 ? 0 : i - 2); j <= std::min(n - 1, i + 2); ++j)
+      builder.add(i, j, (i == j) ? 4.0 : -1.0);
+  SparseMatrix<double> a = builder.build();
+  EXPECT_EQ(n + 5 * (n - 1) - 4, a.nnz());
+
+  vec x(n);
+  for (std::size_t i = 0; i != n; ++i) x(i) = double(i % 7) - 3;
+  vec y = matmul(a, x);
+  vec yc = matmul(a.convert(sparse_format::csc), x);
+
+  double row0 = 0;
+  for (std::size_t j = 0; j != n; ++j) row0 += x(j);
+  EXPECT_DOUBLE_EQ(row0, y(0));
+  for (std::size_t i = 1; i != n; ++i) {
+    double expected = 0;
+    for (std::size_t j = (i < 2 ? 0 : i - 2); j <= std::min(n - 1, i + 2); ++j)
+      expected += ((i == j) ? 4.0 : -1.0) * x(j);
+    ASSERT_DOUBLE_EQ(expected, y(i)) << "row " << i;
+  }
+  for (std::size_t i = 0; i != n; ++i) ASSERT_NEAR(y(i), yc(i), 1e-9);
+
+  mat b(n, 3);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != 3; ++j) b(i, j) = x(i) * double(j + 1);
+  mat c = matmul(a, b);
+  for (std::size_t i = 0; i != n; ++i)
+    for (std::size_t j = 0; j != 3; ++j)
+      ASSERT_NEAR(y(i) * double(j + 1), c(i, j), 1e-9);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_SPARSE_H
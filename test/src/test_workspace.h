@@ -0,0 +1,100 @@
+#ifndef MATRIX_TEST_WORKSPACE_H
+#define MATRIX_TEST_WORKSPACE_H
+
+#include <cstdint>
+#include <gtest/gtest.h>
+#include "slab/matrix.h"
+
+namespace slab {
+
+TEST(WorkspaceTest, GrowsToHighWaterMark) {
+  WorkspacePool &pool = WorkspacePool::local();
+  pool.release();
+  pool.reset_stats();
+
+  {
+    WorkspaceScope outer;
+    double *a = outer.get<double>(100);
+    EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(a) % WorkspacePool::alignment);
+    {
+      WorkspaceScope inner;
+      int *b = inner.get<int>(1000);
+      EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(b) % WorkspacePool::alignment);
+      b[999] = 1;
+    }
+    a[99] = 1.0;
+  }
+
+  // both buffers were allocated separately, then merged into one block
+  WorkspaceStats stats = pool.stats();
+  EXPECT_EQ(3u, stats.allocations);
+  EXPECT_EQ(2u, stats.requests);
+  EXPECT_EQ(832u + 4032u, stats.peak_bytes);
+  EXPECT_EQ(stats.peak_bytes, stats.capacity_bytes);
+
+  for (int i = 0; i != 3; ++i) {
+    WorkspaceScope outer;
+    outer.get<double>(100);
+    WorkspaceScope inner;
+    inner.get<int>(1000);
+  }
+  EXPECT_EQ(3u, pool.stats().allocations);
+  EXPECT_EQ(8u, pool.stats().requests);
+
+  pool.release();
+  EXPECT_EQ(0u, pool.stats().capacity_bytes);
+}
+
+TEST(WorkspaceTest, FactorizationsDoNotAllocateInSteadyState) {
+  mat a = {
+      {4, 12, -16},
+      {12, 37, -43},
+      {-16, -43, 98}
+  };
+  mat b = {
+      {1, 2},
+      {3, 4},
+      {5, 6}
+  };
+  mat tall = {
+      {1, 1},
+      {1, 2},
+      {1, 3},
+      {1, 4}
+  };
+  vec y = {6, 5, 7, 10};
+
+  LU<double> lu;
+  Cholesky<double> chol;
+  QR<double> qr;
+  mat x, u, vt;
+  vec w, s, c;
+  auto run = [&]() {
+    lu.factor(a);
+    lu.solve(b, x);
+    lu.rcond();
+    chol.factor(a);
+    chol.solve(b, x);
+    qr.factor(tall);
+    qr.solve(y, c);
+    lstsq(tall, y, c, lstsq_method::svd);
+    eig_sym(a, w);
+    svd(tall, u, s, vt);
+    solve(a, b, x, solve_method::mixed_precision);
+  };
+
+  run();
+  const std::size_t allocations = workspace_stats().allocations;
+  for (int i = 0; i != 5; ++i) run();
+  EXPECT_EQ(allocations, workspace_stats().allocations);
+
+  EXPECT_NEAR(3.5, c(0), 1e-12);
+  EXPECT_NEAR(1.4, c(1), 1e-12);
+  mat ax = matmul(a, x);
+  for (std::size_t i = 0; i != 3; ++i)
+    for (std::size_t j = 0; j != 2; ++j) EXPECT_NEAR(b(i, j), ax(i, j), 1e-10);
+}
+
+} // namespace slab
+
+#endif // MATRIX_TEST_WORKSPACE_H